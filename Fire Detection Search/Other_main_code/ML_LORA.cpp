@@ -28,7 +28,8 @@
 // DIO1 pin:  2-2
 // NRST pin:  3-14
 // BUSY pin:  9-0
-SX1262 radio = new Module(5, 2, 14, 4);
+#define LORA_DIO1 2
+SX1262 radio = new Module(5, LORA_DIO1, 14, 4);
 
 
 // save transmission state between loops
@@ -50,8 +51,14 @@ void setFlag(void) {
   transmittedFlag = true;
 }
 
+// outcome of an uplink, as returned by lora_send()
+typedef struct {
+  int16_t state;      // RadioLib status code
+  uint32_t airtimeUs; // time between the start of the transmission and DIO1
+} loraTxResult;
+
 void lora_setup();
-void lora_send(String str);
+loraTxResult lora_send(String str);
 
 // counter to keep track of transmitted packets
 int count = 0;
@@ -142,14 +149,20 @@ void lora_setup() {
   }
 }
 
-void lora_send(String str) {
+loraTxResult lora_send(String str) {
   // set the function that will be called
   // when packet transmission is finished
   radio.setPacketSentAction(setFlag);
+  transmittedFlag = false;
 
   // start transmitting the first packet
   Serial.print(F("[SX1262] Sending first packet ... "));
 
+  // sleep until DIO1 signals the end of the transmission instead of
+  // spinning at full current for the whole time on air
+  uint32_t timeoutUs = radio.getTimeOnAir(str.length()) + 50000;
+  int64_t startUs = esp_timer_get_time();
+
   // you can transmit C-string or Arduino string up to
   // 256 characters long
   transmissionState = radio.startTransmit(str);
@@ -160,29 +173,60 @@ void lora_send(String str) {
                       0x89, 0xAB, 0xCD, 0xEF};
     state = radio.startTransmit(byteArr, 8);
   */
- while(transmittedFlag == false){
- }
- // reset flag
-    transmittedFlag = false;
-
-    if (transmissionState == RADIOLIB_ERR_NONE) {
-      // packet was successfully sent
-      Serial.println(F("transmission finished!"));
+  loraTxResult result = {(int16_t)transmissionState, 0};
+
+  // nothing is on air when the start failed, there is nothing to wait for
+  if (transmissionState == RADIOLIB_ERR_NONE) {
+    // DIO1 stays high until finishTransmit(), the level wakeup also catches
+    // a transmission that completed before sleeping. It makes the pin
+    // interrupt level triggered too, so setFlag is detached and the loop
+    // reads the pin instead
+    radio.clearPacketSentAction();
+    gpio_wakeup_enable((gpio_num_t)LORA_DIO1, GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    Serial.flush();
+    while (transmittedFlag == false && digitalRead(LORA_DIO1) == LOW) {
+      int64_t elapsedUs = esp_timer_get_time() - startUs;
+      if (elapsedUs >= timeoutUs) {
+        result.state = RADIOLIB_ERR_TX_TIMEOUT;
+        break;
+      }
+      esp_sleep_enable_timer_wakeup(timeoutUs - elapsedUs);
+      esp_light_sleep_start();
+    }
+    // esp_timer keeps counting through light sleep
+    result.airtimeUs = (uint32_t)(esp_timer_get_time() - startUs);
+
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    gpio_wakeup_disable((gpio_num_t)LORA_DIO1);
+    // gpio_wakeup_disable() leaves the level type, back to the rising edge of setPacketSentAction()
+    gpio_set_intr_type((gpio_num_t)LORA_DIO1, GPIO_INTR_POSEDGE);
+    // re-arm the regular deep sleep timer
+    esp_sleep_enable_timer_wakeup(TIME_TO_SLEEP * uS_TO_S_FACTOR);
+  }
+  // reset flag
+  transmittedFlag = false;
 
-      // NOTE: when using interrupt-driven transmit method,
-      //       it is not possible to automatically measure
-      //       transmission data rate using getDataRate()
+  if (result.state == RADIOLIB_ERR_NONE) {
+    // packet was successfully sent
+    Serial.print(F("transmission finished in "));
+    Serial.print(result.airtimeUs);
+    Serial.println(F(" us"));
 
-    } else {
-      Serial.print(F("failed, code "));
-      Serial.println(transmissionState);
+    // NOTE: when using interrupt-driven transmit method,
+    //       it is not possible to automatically measure
+    //       transmission data rate using getDataRate()
 
-    }
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(result.state);
 
-    // clean up after transmission is finished
-    // this will ensure transmitter is disabled,
-    // RF switch is powered down etc.
-    radio.finishTransmit();
-}
+  }
 
+  // clean up after transmission is finished
+  // this will ensure transmitter is disabled,
+  // RF switch is powered down etc.
+  radio.finishTransmit();
 
+  return result;
+}
@@ -0,0 +1,44 @@
+/*
+  Sleep planner for the node firmware
+
+  Turns the time left until BSEC needs the next call into a sleep decision.
+  The node wakes up a margin before the scheduled heater step, light sleeps
+  through short gaps and only deep sleeps when the gap is long enough to pay
+  for the boot and warm start.
+*/
+
+#ifndef SLEEP_PLANNER_H
+#define SLEEP_PLANNER_H
+
+#include <stdint.h>
+
+typedef enum
+{
+	SLEEP_NONE,
+	SLEEP_LIGHT,
+	SLEEP_DEEP
+} sleepMode;
+
+typedef struct
+{
+	uint32_t lightSleepMarginMs; /* Wake-up latency of light sleep */
+	uint32_t deepSleepMarginMs;	 /* Boot and warm start time after deep sleep */
+	uint32_t minLightSleepMs;	 /* Shorter gaps are spent awake */
+	uint32_t minDeepSleepMs;	 /* Gaps at least this long are spent in deep sleep */
+} sleepPlannerConfig;
+
+typedef struct
+{
+	sleepMode mode;
+	uint64_t durationUs;
+} sleepPlan;
+
+/**
+ * @brief : Chooses how and how long to sleep before the next BSEC call
+ * @param[in] config           : Margins and thresholds of the planner
+ * @param[in] timeToNextCallMs : Time left until the next call, from Bsec2::getTimeToNextCallMs()
+ * @return Sleep mode and duration, SLEEP_NONE if the node should stay awake
+ */
+sleepPlan planSleep(const sleepPlannerConfig &config, int64_t timeToNextCallMs);
+
+#endif /* SLEEP_PLANNER_H */
@@ -0,0 +1,149 @@
+/*
+  Wear-leveled journal for the BSEC state blob
+
+  Records are appended to fixed size slots, each with a header holding a
+  format version, a sequence number, the payload length and a CRC32 of the
+  payload. The newest valid record wins on load. When a sector is full the
+  journal moves on to the next one and erases it, so erases are spread over
+  every sector of the partition and the previous record always survives a
+  torn write. Saving a blob identical to the newest record writes nothing.
+
+  The journal talks to flash through JournalFlash. PartitionFlash maps it to
+  an ESP32 data partition, SimulatedFlash keeps everything in RAM with NOR
+  semantics and per sector erase counters, to study wear on a host.
+*/
+
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_partition.h>
+#endif
+
+#define JOURNAL_RECORD_MAGIC UINT16_C(0x4A53)
+#define JOURNAL_RECORD_VERSION UINT8_C(1)
+#define JOURNAL_MAX_PAYLOAD 256
+
+typedef struct
+{
+	uint16_t magic;
+	uint8_t version;
+	uint8_t reserved;
+	uint32_t sequence;
+	uint16_t length;
+	uint16_t reserved2;
+	uint32_t crc;
+} journalRecordHeader;
+
+/* Flash device as seen by the journal: erase works on whole sectors, writes can only clear bits */
+class JournalFlash
+{
+public:
+	virtual ~JournalFlash() {}
+	virtual uint32_t sectorSize() = 0;
+	virtual uint32_t sectorCount() = 0;
+	virtual bool read(uint32_t offset, void *data, size_t length) = 0;
+	virtual bool write(uint32_t offset, const void *data, size_t length) = 0;
+	virtual bool eraseSector(uint32_t sector) = 0;
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+/* Raw data partition, declared in partitions.csv */
+class PartitionFlash : public JournalFlash
+{
+public:
+	PartitionFlash(const char *label);
+	uint32_t sectorSize();
+	uint32_t sectorCount();
+	bool read(uint32_t offset, void *data, size_t length);
+	bool write(uint32_t offset, const void *data, size_t length);
+	bool eraseSector(uint32_t sector);
+
+private:
+	const char *label;
+	const esp_partition_t *partition;
+	bool find();
+};
+#endif
+
+/* RAM backed flash for host runs, counts erases per sector */
+class SimulatedFlash : public JournalFlash
+{
+public:
+	SimulatedFlash(uint32_t sectorSize, uint32_t sectorCount);
+	~SimulatedFlash();
+	uint32_t sectorSize();
+	uint32_t sectorCount();
+	bool read(uint32_t offset, void *data, size_t length);
+	bool write(uint32_t offset, const void *data, size_t length);
+	bool eraseSector(uint32_t sector);
+
+	uint32_t eraseCount(uint32_t sector);
+	uint32_t maxEraseCount();
+	/* Writes that tried to set a bit back to 1 without an erase */
+	uint32_t violations;
+
+private:
+	uint32_t size;
+	uint32_t count;
+	uint8_t *memory;
+	uint32_t *erases;
+};
+
+class StateJournal
+{
+public:
+	StateJournal(JournalFlash &flash, size_t slotPayload);
+
+	/**
+	 * @brief : Scans the flash for the newest valid record, done on first use by load and save
+	 * @return true if the flash could be read
+	 */
+	bool mount();
+
+	/**
+	 * @brief : Reads the newest valid record
+	 * @param[out] data   : Destination of the payload
+	 * @param[in] maxLen  : Size of the destination
+	 * @param[out] length : Length of the payload
+	 * @return true if a record was found
+	 */
+	bool load(uint8_t *data, size_t maxLen, size_t &length);
+
+	/**
+	 * @brief : Appends a record unless the newest one already holds the same payload
+	 * @param[in] data   : Payload
+	 * @param[in] length : Payload length, up to the slot payload size
+	 * @return true if the payload is stored, whether or not a write was needed
+	 */
+	bool save(const uint8_t *data, size_t length);
+
+	/* Number of saves skipped because the payload did not change */
+	uint32_t skippedWrites;
+
+private:
+	JournalFlash &flash;
+	uint32_t slotSize;
+	uint32_t slotsPerSector;
+	bool mounted;
+	bool hasRecord;
+	uint32_t lastSequence;
+	uint32_t lastOffset;
+	uint32_t lastCrc;
+	uint16_t lastLength;
+	uint32_t currentSector;
+	uint32_t nextSlot;
+
+	uint32_t slotOffset(uint32_t sector, uint32_t slot);
+	bool sameAsLast(const uint8_t *data, size_t length, uint32_t crc);
+};
+
+/**
+ * @brief : CRC-32 (IEEE 802.3) of a buffer
+ */
+uint32_t journalCrc32(const uint8_t *data, size_t length);
+
+#endif /* STATE_JOURNAL_H */
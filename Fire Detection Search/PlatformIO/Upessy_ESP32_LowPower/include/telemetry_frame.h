@@ -0,0 +1,100 @@
+/*
+  Compact binary telemetry frame for the LoRa uplink
+
+  Every frame has the same fixed layout, all multi-byte fields little endian:
+
+  offset  size  field
+  0       1     frame format version (TELEMETRY_FRAME_VERSION)
+  1       2     node id
+  3       2     sequence number
+  5       2     temperature  in 0.01 degC   (int16)
+  7       2     humidity     in 0.01 %rH    (int16)
+  9       2     pressure     in 0.1 hPa     (int16)
+  11      4     class probabilities, 0..255 maps to 0..1
+  15      1     BSEC accuracy (0..3)
+
+  The codec only works on caller provided buffers and does not depend on
+  Arduino, so the same sources decode frames on a host machine.
+*/
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_FRAME_VERSION UINT8_C(1)
+#define TELEMETRY_FRAME_SIZE 16
+#define TELEMETRY_NUM_CLASSES 4
+
+#define TELEMETRY_TEMPERATURE_SCALE 100.0f
+#define TELEMETRY_HUMIDITY_SCALE 100.0f
+#define TELEMETRY_PRESSURE_SCALE 10.0f
+#define TELEMETRY_PROBABILITY_SCALE 255.0f
+
+typedef struct
+{
+	uint16_t nodeId;
+	uint16_t sequence;
+	int16_t temperature;
+	int16_t humidity;
+	int16_t pressure;
+	uint8_t classProb[TELEMETRY_NUM_CLASSES];
+	uint8_t accuracy;
+} telemetryFrame;
+
+/**
+ * @brief : Scales a physical value to a saturated int16 fixed point value
+ * @param[in] value : Value in its physical unit
+ * @param[in] scale : Number of counts per unit
+ * @return Rounded value clamped to the int16 range, 0 for NaN
+ */
+int16_t telemetryScale(float value, float scale);
+
+/**
+ * @brief : Quantizes a class probability in the range 0..1 to one byte
+ * @param[in] probability : Probability reported by BSEC
+ * @return Quantized probability, 255 being 100%
+ */
+uint8_t telemetryQuantizeProbability(float probability);
+
+/**
+ * @brief : Serializes a frame into a caller provided buffer
+ * @param[in] frame   : Frame to encode
+ * @param[out] buffer : Destination buffer
+ * @param[in] length  : Size of the destination buffer
+ * @return Number of bytes written, 0 if the buffer is too small
+ */
+size_t telemetryEncode(const telemetryFrame &frame, uint8_t *buffer, size_t length);
+
+/**
+ * @brief : Parses a received frame
+ * @param[in] buffer : Received bytes
+ * @param[in] length : Number of received bytes
+ * @param[out] frame : Decoded frame
+ * @return true if the frame has the expected size and version
+ */
+bool telemetryDecode(const uint8_t *buffer, size_t length, telemetryFrame &frame);
+
+/* Conversion helpers back to physical units for the receiving side */
+inline float telemetryTemperature(const telemetryFrame &frame)
+{
+	return frame.temperature / TELEMETRY_TEMPERATURE_SCALE;
+}
+
+inline float telemetryHumidity(const telemetryFrame &frame)
+{
+	return frame.humidity / TELEMETRY_HUMIDITY_SCALE;
+}
+
+inline float telemetryPressure(const telemetryFrame &frame)
+{
+	return frame.pressure / TELEMETRY_PRESSURE_SCALE;
+}
+
+inline float telemetryProbability(const telemetryFrame &frame, uint8_t index)
+{
+	return frame.classProb[index] / TELEMETRY_PROBABILITY_SCALE;
+}
+
+#endif /* TELEMETRY_FRAME_H */
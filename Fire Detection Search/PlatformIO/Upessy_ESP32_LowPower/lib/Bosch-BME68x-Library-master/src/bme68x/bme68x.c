@@ -37,7 +37,9 @@
 */
 
 #include "bme68x.h"
+#include "bme68x_comp.h"
 #include <stdio.h>
+#include <string.h>
 
 /* This internal API is used to read the calibration coefficients */
 static int8_t get_calib_data(struct bme68x_dev *dev);
@@ -48,6 +50,12 @@ static int8_t read_variant_id(struct bme68x_dev *dev);
 /* This internal API is used to calculate the gas wait */
 static uint8_t calc_gas_wait(uint16_t dur);
 
+/* This internal API is used to empty the heater resistance table for the current ambient temperature */
+static void clear_res_heat_table(struct bme68x_dev *dev);
+
+/* This internal API is used to get the heater resistance value from the table */
+static uint8_t get_res_heat(uint16_t temp, struct bme68x_dev *dev);
+
 #ifndef BME68X_USE_FPU
 
 /* This internal API is used to calculate the temperature in integer */
@@ -93,8 +101,27 @@ static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
 /* This internal API is used to read a single data of the sensor */
 static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bme68x_dev *dev);
 
-/* This internal API is used to read all data fields of the sensor */
-static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme68x_dev *dev);
+/* This internal API is used to read the status of a data field from its registers */
+static void parse_field_status(const uint8_t *buff, struct bme68x_data *data, const struct bme68x_dev *dev);
+
+/* This internal API is used to compensate a data field from its registers */
+static void compensate_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev);
+
+/* This internal API is used to compensate and sort the 3 data fields from their registers */
+static int8_t get_all_field_data(const uint8_t *buff, struct bme68x_data *data, uint8_t *n_data,
+                                 struct bme68x_dev *dev);
+
+/* This internal API is used to read registers from the interface */
+static int8_t read_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
+
+/* This internal API is used to fill the copy of the configuration registers */
+static int8_t fill_shadow(struct bme68x_dev *dev);
+
+/* This internal API is used to check if a register can be served from the copy */
+static uint8_t in_shadow(uint8_t reg_addr, const struct bme68x_dev *dev);
+
+/* This internal API is used to keep the copy of the configuration registers up to date */
+static void update_shadow(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
 
 /* This internal API is used to switch between SPI memory pages */
 static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev);
@@ -161,6 +188,12 @@ int8_t bme68x_init(struct bme68x_dev *dev)
                     /* Get the Calibration data */
                     rslt = get_calib_data(dev);
                 }
+
+                if (rslt == BME68X_OK)
+                {
+                    /* Heater resistance values of the new calibration, computed on their first use */
+                    clear_res_heat_table(dev);
+                }
             }
             else
             {
@@ -182,6 +215,7 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
     /* Length of the temporary buffer is 2*(length of register)*/
     uint8_t tmp_buff[BME68X_LEN_INTERLEAVE_BUFF] = { 0 };
     uint16_t index;
+    uint16_t write_len = 0;
 
     /* Check for null pointer in the device structure*/
     rslt = null_ptr_check(dev);
@@ -189,31 +223,45 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
     {
         if ((len > 0) && (len <= (BME68X_LEN_INTERLEAVE_BUFF / 2)))
         {
-            /* Interleave the 2 arrays */
-            for (index = 0; index < len; index++)
+            /* Interleave the 2 arrays, leaving out the registers that already hold the value */
+            for (index = 0; (index < len) && (rslt == BME68X_OK); index++)
             {
+                if (in_shadow(reg_addr[index], dev) &&
+                    (dev->reg_shadow[reg_addr[index] - BME68X_REG_IDAC_HEAT0] == reg_data[index]))
+                {
+                    dev->intf_skipped_writes++;
+                    continue;
+                }
+
                 if (dev->intf == BME68X_SPI_INTF)
                 {
                     /* Set the memory page */
                     rslt = set_mem_page(reg_addr[index], dev);
-                    tmp_buff[(2 * index)] = reg_addr[index] & BME68X_SPI_WR_MSK;
+                    tmp_buff[(2 * write_len)] = reg_addr[index] & BME68X_SPI_WR_MSK;
                 }
                 else
                 {
-                    tmp_buff[(2 * index)] = reg_addr[index];
+                    tmp_buff[(2 * write_len)] = reg_addr[index];
                 }
 
-                tmp_buff[(2 * index) + 1] = reg_data[index];
+                tmp_buff[(2 * write_len) + 1] = reg_data[index];
+                write_len++;
             }
 
             /* Write the interleaved array */
-            if (rslt == BME68X_OK)
+            if ((rslt == BME68X_OK) && (write_len > 0))
             {
-                dev->intf_rslt = dev->write(tmp_buff[0], &tmp_buff[1], (2 * len) - 1, dev->intf_ptr);
+                dev->intf_rslt = dev->write(tmp_buff[0], &tmp_buff[1], (2 * write_len) - 1, dev->intf_ptr);
+                dev->intf_transactions++;
+                dev->intf_bytes += 2 * write_len;
                 if (dev->intf_rslt != 0)
                 {
                     rslt = BME68X_E_COM_FAIL;
                 }
+                else
+                {
+                    update_shadow(reg_addr, reg_data, len, dev);
+                }
             }
         }
         else
@@ -235,25 +283,47 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
 int8_t bme68x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
 {
     int8_t rslt;
+    uint32_t index;
+    uint8_t cached;
 
     /* Check for null pointer in the device structure*/
     rslt = null_ptr_check(dev);
     if ((rslt == BME68X_OK) && reg_data)
     {
-        if (dev->intf == BME68X_SPI_INTF)
+        cached = (reg_addr >= BME68X_REG_IDAC_HEAT0) && (len > 0) &&
+                 (reg_addr + len <= BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW);
+        if (cached && !dev->reg_shadow_valid)
         {
-            /* Set the memory page */
-            rslt = set_mem_page(reg_addr, dev);
-            if (rslt == BME68X_OK)
+            /* A fresh copy holds the current value of every register */
+            rslt = fill_shadow(dev);
+        }
+        else
+        {
+            for (index = 0; (index < len) && cached; index++)
             {
-                reg_addr = reg_addr | BME68X_SPI_RD_MSK;
+                cached = in_shadow((uint8_t)(reg_addr + index), dev);
             }
         }
 
-        dev->intf_rslt = dev->read(reg_addr, reg_data, len, dev->intf_ptr);
-        if (dev->intf_rslt != 0)
+        if ((rslt == BME68X_OK) && cached)
         {
-            rslt = BME68X_E_COM_FAIL;
+            memcpy(reg_data, &dev->reg_shadow[reg_addr - BME68X_REG_IDAC_HEAT0], len);
+        }
+        else if (rslt == BME68X_OK)
+        {
+            rslt = read_regs(reg_addr, reg_data, len, dev);
+            if ((rslt == BME68X_OK) && dev->reg_shadow_valid)
+            {
+                /* The sensor may have changed the mode bits on its own */
+                for (index = 0; index < len; index++)
+                {
+                    if ((reg_addr + index >= BME68X_REG_IDAC_HEAT0) &&
+                        (reg_addr + index < BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW))
+                    {
+                        dev->reg_shadow[reg_addr + index - BME68X_REG_IDAC_HEAT0] = reg_data[index];
+                    }
+                }
+            }
         }
     }
     else
@@ -540,13 +610,8 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev)
 {
     int8_t rslt;
-    uint8_t i = 0, j = 0, new_fields = 0;
-    struct bme68x_data *field_ptr[3] = { 0 };
-    struct bme68x_data field_data[3] = { { 0 } };
-
-    field_ptr[0] = &field_data[0];
-    field_ptr[1] = &field_data[1];
-    field_ptr[2] = &field_data[2];
+    uint8_t new_fields = 0;
+    uint8_t buff[BME68X_LEN_FIELD * 3] = { 0 };
 
     rslt = null_ptr_check(dev);
     if ((rslt == BME68X_OK) && (data != NULL))
@@ -570,36 +635,11 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
         }
         else if ((op_mode == BME68X_PARALLEL_MODE) || (op_mode == BME68X_SEQUENTIAL_MODE))
         {
-            /* Read the 3 fields and count the number of new data fields */
-            rslt = read_all_field_data(field_ptr, dev);
-
-            new_fields = 0;
-            for (i = 0; (i < 3) && (rslt == BME68X_OK); i++)
-            {
-                if (field_ptr[i]->status & BME68X_NEW_DATA_MSK)
-                {
-                    new_fields++;
-                }
-            }
-
-            /* Sort the sensor data in parallel & sequential modes*/
-            for (i = 0; (i < 2) && (rslt == BME68X_OK); i++)
-            {
-                for (j = i + 1; j < 3; j++)
-                {
-                    sort_sensor_data(i, j, field_ptr);
-                }
-            }
-
-            /* Copy the sorted data */
-            for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
+            /* Read the 3 fields in one burst */
+            rslt = bme68x_get_regs(BME68X_REG_FIELD0, buff, (uint32_t) BME68X_LEN_FIELD * 3, dev);
+            if (rslt == BME68X_OK)
             {
-                data[i] = *field_ptr[i];
-            }
-
-            if (new_fields == 0)
-            {
-                rslt = BME68X_W_NO_NEW_DATA;
+                rslt = get_all_field_data(buff, data, &new_fields, dev);
             }
         }
         else
@@ -624,6 +664,56 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
     return rslt;
 }
 
+/*
+ * @brief This API compensates the data fields read by the caller from
+ * BME68X_REG_FIELD0 and stores them in the bme68x_data structure instance
+ * passed by the user.
+ */
+int8_t bme68x_get_field_data(uint8_t op_mode, const uint8_t *field_regs, struct bme68x_data *data, uint8_t *n_data,
+                             struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t new_fields = 0;
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (field_regs != NULL) && (data != NULL) && (n_data != NULL))
+    {
+        if (op_mode == BME68X_FORCED_MODE)
+        {
+            parse_field_status(field_regs, data, dev);
+            if (data->status & BME68X_NEW_DATA_MSK)
+            {
+                rslt = fill_shadow(dev);
+                if (rslt == BME68X_OK)
+                {
+                    compensate_field_data(field_regs, data, dev);
+                    new_fields = 1;
+                }
+            }
+            else
+            {
+                rslt = BME68X_W_NO_NEW_DATA;
+            }
+        }
+        else if ((op_mode == BME68X_PARALLEL_MODE) || (op_mode == BME68X_SEQUENTIAL_MODE))
+        {
+            rslt = get_all_field_data(field_regs, data, &new_fields, dev);
+        }
+        else
+        {
+            rslt = BME68X_W_DEFINE_OP_MODE;
+        }
+
+        *n_data = new_fields;
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API is used to set the gas configuration of the sensor.
  */
@@ -739,6 +829,10 @@ int8_t bme68x_selftest_check(const struct bme68x_dev *dev)
     t_dev.intf = dev->intf;
     t_dev.delay_us = dev->delay_us;
     t_dev.intf_ptr = dev->intf_ptr;
+    t_dev.reg_shadow_valid = 0;
+    t_dev.intf_transactions = 0;
+    t_dev.intf_bytes = 0;
+    t_dev.intf_skipped_writes = 0;
     rslt = bme68x_init(&t_dev);
     if (rslt == BME68X_OK)
     {
@@ -820,353 +914,165 @@ int8_t bme68x_selftest_check(const struct bme68x_dev *dev)
 }
 
 /*****************************INTERNAL APIs***********************************************/
-#ifndef BME68X_USE_FPU
+#ifdef BME68X_COMP_FLOAT
 
 /* @brief This internal API is used to calculate the temperature value. */
-static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
 {
-    int64_t var1;
-    int64_t var2;
-    int64_t var3;
-    int16_t calc_temp;
-
-    /*lint -save -e701 -e702 -e704 */
-    var1 = ((int32_t)temp_adc >> 3) - ((int32_t)dev->calib.par_t1 << 1);
-    var2 = (var1 * (int32_t)dev->calib.par_t2) >> 11;
-    var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
-    var3 = ((var3) * ((int32_t)dev->calib.par_t3 << 4)) >> 14;
-    dev->calib.t_fine = (int32_t)(var2 + var3);
-    calc_temp = (int16_t)(((dev->calib.t_fine * 5) + 128) >> 8);
-
-    /*lint -restore */
-    return calc_temp;
+    return bme68x_comp_temp_float(temp_adc, &dev->calib, &dev->calib.t_fine);
 }
 
 /* @brief This internal API is used to calculate the pressure value. */
-static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
 {
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t pressure_comp;
-
-    /* This value is used to check precedence to multiplication or division
-     * in the pressure compensation equation to achieve least loss of precision and
-     * avoiding overflows.
-     * i.e Comparing value, pres_ovf_check = (1 << 31) >> 1
-     */
-    const int32_t pres_ovf_check = INT32_C(0x40000000);
-
-    /*lint -save -e701 -e702 -e713 */
-    var1 = (((int32_t)dev->calib.t_fine) >> 1) - 64000;
-    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)dev->calib.par_p6) >> 2;
-    var2 = var2 + ((var1 * (int32_t)dev->calib.par_p5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)dev->calib.par_p4 << 16);
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)dev->calib.par_p3 << 5)) >> 3) +
-           (((int32_t)dev->calib.par_p2 * var1) >> 1);
-    var1 = var1 >> 18;
-    var1 = ((32768 + var1) * (int32_t)dev->calib.par_p1) >> 15;
-    pressure_comp = 1048576 - pres_adc;
-    pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
-    if (pressure_comp >= pres_ovf_check)
-    {
-        pressure_comp = ((pressure_comp / var1) << 1);
-    }
-    else
-    {
-        pressure_comp = ((pressure_comp << 1) / var1);
-    }
-
-    var1 = ((int32_t)dev->calib.par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
-    var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)dev->calib.par_p8) >> 13;
-    var3 =
-        ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
-         (int32_t)dev->calib.par_p10) >> 17;
-    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)dev->calib.par_p7 << 7)) >> 4);
-
-    /*lint -restore */
-    return (uint32_t)pressure_comp;
+    return bme68x_comp_pres_float(pres_adc, dev->calib.t_fine, &dev->calib);
 }
 
-/* This internal API is used to calculate the humidity in integer */
-static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+/* This internal API is used to calculate the humidity value in float */
+static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
 {
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t var4;
-    int32_t var5;
-    int32_t var6;
-    int32_t temp_scaled;
-    int32_t calc_hum;
-
-    /*lint -save -e702 -e704 */
-    temp_scaled = (((int32_t)dev->calib.t_fine * 5) + 128) >> 8;
-    var1 = (int32_t)(hum_adc - ((int32_t)((int32_t)dev->calib.par_h1 * 16))) -
-           (((temp_scaled * (int32_t)dev->calib.par_h3) / ((int32_t)100)) >> 1);
-    var2 =
-        ((int32_t)dev->calib.par_h2 *
-         (((temp_scaled * (int32_t)dev->calib.par_h4) / ((int32_t)100)) +
-          (((temp_scaled * ((temp_scaled * (int32_t)dev->calib.par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
-          (int32_t)(1 << 14))) >> 10;
-    var3 = var1 * var2;
-    var4 = (int32_t)dev->calib.par_h6 << 7;
-    var4 = ((var4) + ((temp_scaled * (int32_t)dev->calib.par_h7) / ((int32_t)100))) >> 4;
-    var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
-    var6 = (var4 * var5) >> 1;
-    calc_hum = (((var3 + var6) >> 10) * ((int32_t)1000)) >> 12;
-    if (calc_hum > 100000) /* Cap at 100%rH */
-    {
-        calc_hum = 100000;
-    }
-    else if (calc_hum < 0)
-    {
-        calc_hum = 0;
-    }
-
-    /*lint -restore */
-    return (uint32_t)calc_hum;
+    return bme68x_comp_hum_float(hum_adc, dev->calib.t_fine, &dev->calib);
 }
 
-/* This internal API is used to calculate the gas resistance low */
-static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
+/* This internal API is used to calculate the gas resistance low value in float */
+static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
 {
-    int64_t var1;
-    uint64_t var2;
-    int64_t var3;
-    uint32_t calc_gas_res;
-    uint32_t lookup_table1[16] = {
-        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
-        UINT32_C(2147483647)
-    };
-    uint32_t lookup_table2[16] = {
-        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
-        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
-            4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
-    };
-
-    /*lint -save -e704 */
-    var1 = (int64_t)((1340 + (5 * (int64_t)dev->calib.range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
-    var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
-    var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
-    calc_gas_res = (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
-
-    /*lint -restore */
-    return calc_gas_res;
+    return bme68x_comp_gas_low_float(gas_res_adc, gas_range, &dev->calib);
 }
 
-/* This internal API is used to calculate the gas resistance */
-static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
+/* This internal API is used to calculate the gas resistance value in float */
+static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
 {
-    uint32_t calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
-    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
-
-    var2 *= INT32_C(3);
-    var2 = INT32_C(4096) + var2;
-
-    /* multiplying 10000 then dividing then multiplying by 100 instead of multiplying by 1000000 to prevent overflow */
-    calc_gas_res = (UINT32_C(10000) * var1) / (uint32_t)var2;
-    calc_gas_res = calc_gas_res * 100;
-
-    return calc_gas_res;
+    return bme68x_comp_gas_high_float(gas_res_adc, gas_range);
 }
 
 /* This internal API is used to calculate the heater resistance value using float */
 static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
 {
-    uint8_t heatr_res;
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t var4;
-    int32_t var5;
-    int32_t heatr_res_x100;
-
-    if (temp > 400) /* Cap temperature */
-    {
-        temp = 400;
-    }
-
-    var1 = (((int32_t)dev->amb_temp * dev->calib.par_gh3) / 1000) * 256;
-    var2 = (dev->calib.par_gh1 + 784) * (((((dev->calib.par_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
-    var3 = var1 + (var2 / 2);
-    var4 = (var3 / (dev->calib.res_heat_range + 4));
-    var5 = (131 * dev->calib.res_heat_val) + 65536;
-    heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
-    heatr_res = (uint8_t)((heatr_res_x100 + 50) / 100);
-
-    return heatr_res;
+    return bme68x_comp_res_heat_float(temp, dev->amb_temp, &dev->calib);
 }
 
-#else
+#elif defined(BME68X_USE_FPU)
+
+/* Float data from the fixed-point kernels. t_fine keeps the integer value, which
+ * a float holds exactly over the temperature range of the sensor */
 
 /* @brief This internal API is used to calculate the temperature value. */
 static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
 {
-    float var1;
-    float var2;
-    float calc_temp;
-
-    /* calculate var1 data */
-    var1 = ((((float)temp_adc / 16384.0f) - ((float)dev->calib.par_t1 / 1024.0f)) * ((float)dev->calib.par_t2));
-
-    /* calculate var2 data */
-    var2 =
-        (((((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f)) *
-          (((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f))) * ((float)dev->calib.par_t3 * 16.0f));
+    int32_t t_fine;
+    int16_t calc_temp = bme68x_comp_temp_fixed(temp_adc, &dev->calib, &t_fine);
 
-    /* t_fine value*/
-    dev->calib.t_fine = (var1 + var2);
+    dev->calib.t_fine = (float)t_fine;
 
-    /* compensated temperature data*/
-    calc_temp = ((dev->calib.t_fine) / 5120.0f);
-
-    return calc_temp;
+    return (float)calc_temp / 100.0f;
 }
 
 /* @brief This internal API is used to calculate the pressure value. */
 static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
 {
-    float var1;
-    float var2;
-    float var3;
-    float calc_pres;
-
-    var1 = (((float)dev->calib.t_fine / 2.0f) - 64000.0f);
-    var2 = var1 * var1 * (((float)dev->calib.par_p6) / (131072.0f));
-    var2 = var2 + (var1 * ((float)dev->calib.par_p5) * 2.0f);
-    var2 = (var2 / 4.0f) + (((float)dev->calib.par_p4) * 65536.0f);
-    var1 = (((((float)dev->calib.par_p3 * var1 * var1) / 16384.0f) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
-    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)dev->calib.par_p1));
-    calc_pres = (1048576.0f - ((float)pres_adc));
-
-    /* Avoid exception caused by division by zero */
-    if ((int)var1 != 0)
-    {
-        calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
-        var1 = (((float)dev->calib.par_p9) * calc_pres * calc_pres) / 2147483648.0f;
-        var2 = calc_pres * (((float)dev->calib.par_p8) / 32768.0f);
-        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (dev->calib.par_p10 / 131072.0f));
-        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)dev->calib.par_p7 * 128.0f)) / 16.0f);
-    }
-    else
-    {
-        calc_pres = 0;
-    }
-
-    return calc_pres;
+    return (float)bme68x_comp_pres_fixed(pres_adc, (int32_t)dev->calib.t_fine, &dev->calib);
 }
 
-/* This internal API is used to calculate the humidity in integer */
+/* This internal API is used to calculate the humidity value in float */
 static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
 {
-    float calc_hum;
-    float var1;
-    float var2;
-    float var3;
-    float var4;
-    float temp_comp;
-
-    /* compensated temperature data*/
-    temp_comp = ((dev->calib.t_fine) / 5120.0f);
-    var1 = (float)((float)hum_adc) -
-           (((float)dev->calib.par_h1 * 16.0f) + (((float)dev->calib.par_h3 / 2.0f) * temp_comp));
-    var2 = var1 *
-           ((float)(((float)dev->calib.par_h2 / 262144.0f) *
-                    (1.0f + (((float)dev->calib.par_h4 / 16384.0f) * temp_comp) +
-                     (((float)dev->calib.par_h5 / 1048576.0f) * temp_comp * temp_comp))));
-    var3 = (float)dev->calib.par_h6 / 16384.0f;
-    var4 = (float)dev->calib.par_h7 / 2097152.0f;
-    calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
-    if (calc_hum > 100.0f)
-    {
-        calc_hum = 100.0f;
-    }
-    else if (calc_hum < 0.0f)
-    {
-        calc_hum = 0.0f;
-    }
-
-    return calc_hum;
+    return (float)bme68x_comp_hum_fixed(hum_adc, (int32_t)dev->calib.t_fine, &dev->calib) / 1000.0f;
 }
 
 /* This internal API is used to calculate the gas resistance low value in float */
 static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
 {
-    float calc_gas_res;
-    float var1;
-    float var2;
-    float var3;
-    float gas_res_f = gas_res_adc;
-    float gas_range_f = (1U << gas_range); /*lint !e790 / Suspicious truncation, integral to float */
-    const float lookup_k1_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
-    };
-    const float lookup_k2_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
-    };
-
-    var1 = (1340.0f + (5.0f * dev->calib.range_sw_err));
-    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
-    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
-    calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
-
-    return calc_gas_res;
+    return (float)bme68x_comp_gas_low_fixed(gas_res_adc, gas_range, &dev->calib);
 }
 
 /* This internal API is used to calculate the gas resistance value in float */
 static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
 {
-    float calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
-    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+    return (float)bme68x_comp_gas_high_fixed(gas_res_adc, gas_range);
+}
 
-    var2 *= INT32_C(3);
-    var2 = INT32_C(4096) + var2;
+/* This internal API is used to calculate the heater resistance value using integer */
+static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+{
+    return bme68x_comp_res_heat_fixed(temp, dev->amb_temp, &dev->calib);
+}
 
-    calc_gas_res = 1000000.0f * (float)var1 / (float)var2;
+#else
 
-    return calc_gas_res;
+/* @brief This internal API is used to calculate the temperature value. */
+static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+{
+    return bme68x_comp_temp_fixed(temp_adc, &dev->calib, &dev->calib.t_fine);
 }
 
-/* This internal API is used to calculate the heater resistance value */
+/* @brief This internal API is used to calculate the pressure value. */
+static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+{
+    return bme68x_comp_pres_fixed(pres_adc, dev->calib.t_fine, &dev->calib);
+}
+
+/* This internal API is used to calculate the humidity in integer */
+static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+{
+    return bme68x_comp_hum_fixed(hum_adc, dev->calib.t_fine, &dev->calib);
+}
+
+/* This internal API is used to calculate the gas resistance low */
+static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
+{
+    return bme68x_comp_gas_low_fixed(gas_res_adc, gas_range, &dev->calib);
+}
+
+/* This internal API is used to calculate the gas resistance */
+static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
+{
+    return bme68x_comp_gas_high_fixed(gas_res_adc, gas_range);
+}
+
+/* This internal API is used to calculate the heater resistance value using integer */
 static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
 {
-    float var1;
-    float var2;
-    float var3;
-    float var4;
-    float var5;
-    uint8_t res_heat;
-
-    if (temp > 400) /* Cap temperature */
-    {
-        temp = 400;
-    }
-
-    var1 = (((float)dev->calib.par_gh1 / (16.0f)) + 49.0f);
-    var2 = ((((float)dev->calib.par_gh2 / (32768.0f)) * (0.0005f)) + 0.00235f);
-    var3 = ((float)dev->calib.par_gh3 / (1024.0f));
-    var4 = (var1 * (1.0f + (var2 * (float)temp)));
-    var5 = (var4 + (var3 * (float)dev->amb_temp));
-    res_heat =
-        (uint8_t)(3.4f *
-                  ((var5 * (4 / (4 + (float)dev->calib.res_heat_range)) *
-                    (1 / (1 + ((float)dev->calib.res_heat_val * 0.002f)))) -
-                   25));
-
-    return res_heat;
+    return bme68x_comp_res_heat_fixed(temp, dev->amb_temp, &dev->calib);
 }
 
 #endif
 
+/* This internal API is used to empty the heater resistance table for the current ambient temperature */
+static void clear_res_heat_table(struct bme68x_dev *dev)
+{
+    memset(dev->res_heat_filled, 0, sizeof(dev->res_heat_filled));
+    dev->res_heat_amb_temp = dev->amb_temp;
+}
+
+/* This internal API is used to get the heater resistance value from the table */
+static uint8_t get_res_heat(uint16_t temp, struct bme68x_dev *dev)
+{
+    if (temp > BME68X_MAX_HEATR_TEMP) /* Cap temperature */
+    {
+        temp = BME68X_MAX_HEATR_TEMP;
+    }
+
+    /* The table holds the values of one ambient temperature, start over once that changes */
+    if (dev->res_heat_amb_temp != dev->amb_temp)
+    {
+        clear_res_heat_table(dev);
+    }
+
+    /* An entry is computed on the first lookup of its temperature */
+    if (!(dev->res_heat_filled[temp / 8] & (1 << (temp % 8))))
+    {
+        dev->res_heat_table[temp] = calc_res_heat(temp, dev);
+        dev->res_heat_filled[temp / 8] |= (uint8_t)(1 << (temp % 8));
+    }
+
+    return dev->res_heat_table[temp];
+}
+
 /* This internal API is used to calculate the gas wait */
 static uint8_t calc_gas_wait(uint16_t dur)
 {
-    uint8_t factor = 0;
+    uint8_t factor;
     uint8_t durval;
 
     if (dur >= 0xfc0)
@@ -1175,13 +1081,9 @@ static uint8_t calc_gas_wait(uint16_t dur)
     }
     else
     {
-        while (dur > 0x3F)
-        {
-            dur = dur / 4;
-            factor += 1;
-        }
-
-        durval = (uint8_t)(dur + (factor * 64));
+        /* Multiplication factor of 1, 4, 16 or 64, the smallest that fits the duration in 6 bits */
+        factor = (dur > 0x3F) + (dur > 0xFF) + (dur > 0x3FF);
+        durval = (uint8_t)((dur >> (2 * factor)) + (factor * 64));
     }
 
     return durval;
@@ -1192,11 +1094,6 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
 {
     int8_t rslt = BME68X_OK;
     uint8_t buff[BME68X_LEN_FIELD] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
-    uint32_t adc_temp;
-    uint32_t adc_pres;
-    uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
     uint8_t tries = 5;
 
     while ((tries) && (rslt == BME68X_OK))
@@ -1211,55 +1108,14 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
             break;
         }
 
-        data->status = buff[0] & BME68X_NEW_DATA_MSK;
-        data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
-        data->meas_index = buff[1];
-
-        /* read the raw data from the sensor */
-        adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
-        adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
-        adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
-        adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
-        adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
-        gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data->status |= buff[16] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
-        }
-        else
-        {
-            data->status |= buff[14] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
-        }
+        parse_field_status(buff, data, dev);
 
         if ((data->status & BME68X_NEW_DATA_MSK) && (rslt == BME68X_OK))
         {
-            rslt = bme68x_get_regs(BME68X_REG_RES_HEAT0 + data->gas_index, &data->res_heat, 1, dev);
+            rslt = fill_shadow(dev);
             if (rslt == BME68X_OK)
             {
-                rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0 + data->gas_index, &data->idac, 1, dev);
-            }
-
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_get_regs(BME68X_REG_GAS_WAIT0 + data->gas_index, &data->gas_wait, 1, dev);
-            }
-
-            if (rslt == BME68X_OK)
-            {
-                data->temperature = calc_temperature(adc_temp, dev);
-                data->pressure = calc_pressure(adc_pres, dev);
-                data->humidity = calc_humidity(adc_hum, dev);
-                if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-                {
-                    data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
-                }
-                else
-                {
-                    data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
-                }
+                compensate_field_data(buff, data, dev);
 
                 break;
             }
@@ -1276,84 +1132,206 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
     return rslt;
 }
 
-/* This internal API is used to read all data fields of the sensor */
-static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme68x_dev *dev)
+/* This internal API is used to read the status of a data field from its registers */
+static void parse_field_status(const uint8_t *buff, struct bme68x_data *data, const struct bme68x_dev *dev)
+{
+    data->status = buff[0] & BME68X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        data->status |= buff[16] & BME68X_GASM_VALID_MSK;
+        data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
+    }
+    else
+    {
+        data->status |= buff[14] & BME68X_GASM_VALID_MSK;
+        data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
+    }
+}
+
+/* This internal API is used to compensate a data field from its registers */
+static void compensate_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev)
 {
-    int8_t rslt = BME68X_OK;
-    uint8_t buff[BME68X_LEN_FIELD * 3] = { 0 };
     uint8_t gas_range_l, gas_range_h;
     uint32_t adc_temp;
     uint32_t adc_pres;
     uint16_t adc_hum;
     uint16_t adc_gas_res_low, adc_gas_res_high;
-    uint8_t off;
-    uint8_t set_val[30] = { 0 }; /* idac, res_heat, gas_wait */
-    uint8_t i;
 
-    if (!data[0] && !data[1] && !data[2])
+    /* read the raw data from the sensor */
+    adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
+    adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
+    adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
+    adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
+    adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
+    gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
+    gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
+
+    /* The heater set-points only change with a configuration write, take them from the copy */
+    if (data->gas_index < BME68X_LEN_HEATR_REGS / 3)
+    {
+        data->idac = dev->reg_shadow[data->gas_index];
+        data->res_heat = dev->reg_shadow[10 + data->gas_index];
+        data->gas_wait = dev->reg_shadow[20 + data->gas_index];
+    }
+
+    data->temperature = calc_temperature(adc_temp, dev);
+    data->pressure = calc_pressure(adc_pres, dev);
+    data->humidity = calc_humidity(adc_hum, dev);
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
     {
-        rslt = BME68X_E_NULL_PTR;
+        data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+    }
+    else
+    {
+        data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
     }
+}
 
-    if (rslt == BME68X_OK)
+/* This internal API is used to compensate and sort the 3 data fields from their registers */
+static int8_t get_all_field_data(const uint8_t *buff, struct bme68x_data *data, uint8_t *n_data,
+                                 struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t i = 0, j = 0, new_fields = 0;
+    struct bme68x_data *field_ptr[3] = { 0 };
+    struct bme68x_data field_data[3] = { { 0 } };
+
+    field_ptr[0] = &field_data[0];
+    field_ptr[1] = &field_data[1];
+    field_ptr[2] = &field_data[2];
+
+    rslt = fill_shadow(dev);
+
+    for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
     {
-        rslt = bme68x_get_regs(BME68X_REG_FIELD0, buff, (uint32_t) BME68X_LEN_FIELD * 3, dev);
+        parse_field_status(&buff[i * BME68X_LEN_FIELD], field_ptr[i], dev);
+        compensate_field_data(&buff[i * BME68X_LEN_FIELD], field_ptr[i], dev);
+
+        /* Count the number of new data fields */
+        if (field_ptr[i]->status & BME68X_NEW_DATA_MSK)
+        {
+            new_fields++;
+        }
     }
 
-    if (rslt == BME68X_OK)
+    /* Sort the sensor data in parallel & sequential modes*/
+    for (i = 0; (i < 2) && (rslt == BME68X_OK); i++)
     {
-        rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, set_val, 30, dev);
+        for (j = i + 1; j < 3; j++)
+        {
+            sort_sensor_data(i, j, field_ptr);
+        }
     }
 
+    /* Copy the sorted data */
     for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
     {
-        off = (uint8_t)(i * BME68X_LEN_FIELD);
-        data[i]->status = buff[off] & BME68X_NEW_DATA_MSK;
-        data[i]->gas_index = buff[off] & BME68X_GAS_INDEX_MSK;
-        data[i]->meas_index = buff[off + 1];
-
-        /* read the raw data from the sensor */
-        adc_pres =
-            (uint32_t) (((uint32_t) buff[off + 2] * 4096) | ((uint32_t) buff[off + 3] * 16) |
-                        ((uint32_t) buff[off + 4] / 16));
-        adc_temp =
-            (uint32_t) (((uint32_t) buff[off + 5] * 4096) | ((uint32_t) buff[off + 6] * 16) |
-                        ((uint32_t) buff[off + 7] / 16));
-        adc_hum = (uint16_t) (((uint32_t) buff[off + 8] * 256) | (uint32_t) buff[off + 9]);
-        adc_gas_res_low = (uint16_t) ((uint32_t) buff[off + 13] * 4 | (((uint32_t) buff[off + 14]) / 64));
-        adc_gas_res_high = (uint16_t) ((uint32_t) buff[off + 15] * 4 | (((uint32_t) buff[off + 16]) / 64));
-        gas_range_l = buff[off + 14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[off + 16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+        data[i] = *field_ptr[i];
+    }
+
+    if ((rslt == BME68X_OK) && (new_fields == 0))
+    {
+        rslt = BME68X_W_NO_NEW_DATA;
+    }
+
+    *n_data = new_fields;
+
+    return rslt;
+}
+
+/* This internal API is used to read registers from the interface */
+static int8_t read_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+
+    if (dev->intf == BME68X_SPI_INTF)
+    {
+        /* Set the memory page */
+        rslt = set_mem_page(reg_addr, dev);
+        if (rslt == BME68X_OK)
         {
-            data[i]->status |= buff[off + 16] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 16] & BME68X_HEAT_STAB_MSK;
+            reg_addr = reg_addr | BME68X_SPI_RD_MSK;
         }
-        else
+    }
+
+    dev->intf_rslt = dev->read(reg_addr, reg_data, len, dev->intf_ptr);
+    dev->intf_transactions++;
+    dev->intf_bytes += len + 1;
+    if (dev->intf_rslt != 0)
+    {
+        rslt = BME68X_E_COM_FAIL;
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to fill the copy of the configuration registers */
+static int8_t fill_shadow(struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+
+    if (!dev->reg_shadow_valid)
+    {
+        rslt = read_regs(BME68X_REG_IDAC_HEAT0, dev->reg_shadow, BME68X_LEN_SHADOW, dev);
+        if (rslt == BME68X_OK)
         {
-            data[i]->status |= buff[off + 14] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 14] & BME68X_HEAT_STAB_MSK;
+            dev->reg_shadow_valid = 1;
         }
+    }
 
-        data[i]->idac = set_val[data[i]->gas_index];
-        data[i]->res_heat = set_val[10 + data[i]->gas_index];
-        data[i]->gas_wait = set_val[20 + data[i]->gas_index];
-        data[i]->temperature = calc_temperature(adc_temp, dev);
-        data[i]->pressure = calc_pressure(adc_pres, dev);
-        data[i]->humidity = calc_humidity(adc_hum, dev);
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    return rslt;
+}
+
+/* This internal API is used to check if a register can be served from the copy */
+static uint8_t in_shadow(uint8_t reg_addr, const struct bme68x_dev *dev)
+{
+    uint8_t rslt = 0;
+
+    if (dev->reg_shadow_valid && (reg_addr >= BME68X_REG_IDAC_HEAT0) &&
+        (reg_addr < BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW))
+    {
+        rslt = 1;
+
+        /* The sensor goes back to sleep on its own, the mode is only known while sleeping */
+        if ((reg_addr == BME68X_REG_CTRL_MEAS) &&
+            ((dev->reg_shadow[BME68X_REG_CTRL_MEAS - BME68X_REG_IDAC_HEAT0] & BME68X_MODE_MSK) != BME68X_SLEEP_MODE))
         {
-            data[i]->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+            rslt = 0;
         }
-        else
+
+        /* Over SPI this address is the memory page register, which changes outside bme68x_set_regs */
+        if ((reg_addr == (BME68X_REG_MEM_PAGE & BME68X_SPI_WR_MSK)) && (dev->intf == BME68X_SPI_INTF))
         {
-            data[i]->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+            rslt = 0;
         }
     }
 
     return rslt;
 }
 
+/* This internal API is used to keep the copy of the configuration registers up to date */
+static void update_shadow(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if ((reg_addr[i] == BME68X_REG_SOFT_RESET) && (reg_data[i] == BME68X_SOFT_RESET_CMD))
+        {
+            /* The registers are back to their reset values */
+            dev->reg_shadow_valid = 0;
+        }
+        else if ((reg_addr[i] >= BME68X_REG_IDAC_HEAT0) &&
+                 (reg_addr[i] < BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW))
+        {
+            dev->reg_shadow[reg_addr[i] - BME68X_REG_IDAC_HEAT0] = reg_data[i];
+        }
+    }
+}
+
 /* This internal API is used to switch between SPI memory pages */
 static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev)
 {
@@ -1378,6 +1356,8 @@ static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev)
         {
             dev->mem_page = mem_page;
             dev->intf_rslt = dev->read(BME68X_REG_MEM_PAGE | BME68X_SPI_RD_MSK, &reg, 1, dev->intf_ptr);
+            dev->intf_transactions++;
+            dev->intf_bytes += 2;
             if (dev->intf_rslt != 0)
             {
                 rslt = BME68X_E_COM_FAIL;
@@ -1388,6 +1368,8 @@ static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev)
                 reg = reg & (~BME68X_MEM_PAGE_MSK);
                 reg = reg | (dev->mem_page & BME68X_MEM_PAGE_MSK);
                 dev->intf_rslt = dev->write(BME68X_REG_MEM_PAGE & BME68X_SPI_WR_MSK, &reg, 1, dev->intf_ptr);
+                dev->intf_transactions++;
+                dev->intf_bytes += 2;
                 if (dev->intf_rslt != 0)
                 {
                     rslt = BME68X_E_COM_FAIL;
@@ -1410,6 +1392,8 @@ static int8_t get_mem_page(struct bme68x_dev *dev)
     if (rslt == BME68X_OK)
     {
         dev->intf_rslt = dev->read(BME68X_REG_MEM_PAGE | BME68X_SPI_RD_MSK, &reg, 1, dev->intf_ptr);
+        dev->intf_transactions++;
+        dev->intf_bytes += 2;
         if (dev->intf_rslt != 0)
         {
             rslt = BME68X_E_COM_FAIL;
@@ -1478,7 +1462,7 @@ static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, ui
     {
         case BME68X_FORCED_MODE:
             rh_reg_addr[0] = BME68X_REG_RES_HEAT0;
-            rh_reg_data[0] = calc_res_heat(conf->heatr_temp, dev);
+            rh_reg_data[0] = get_res_heat(conf->heatr_temp, dev);
             gw_reg_addr[0] = BME68X_REG_GAS_WAIT0;
             gw_reg_data[0] = calc_gas_wait(conf->heatr_dur);
             (*nb_conv) = 0;
@@ -1494,7 +1478,7 @@ static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, ui
             for (i = 0; i < conf->profile_len; i++)
             {
                 rh_reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
-                rh_reg_data[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
+                rh_reg_data[i] = get_res_heat(conf->heatr_temp_prof[i], dev);
                 gw_reg_addr[i] = BME68X_REG_GAS_WAIT0 + i;
                 gw_reg_data[i] = calc_gas_wait(conf->heatr_dur_prof[i]);
             }
@@ -1517,7 +1501,7 @@ static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, ui
             for (i = 0; i < conf->profile_len; i++)
             {
                 rh_reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
-                rh_reg_data[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
+                rh_reg_data[i] = get_res_heat(conf->heatr_temp_prof[i], dev);
                 gw_reg_addr[i] = BME68X_REG_GAS_WAIT0 + i;
                 gw_reg_data[i] = (uint8_t) conf->heatr_dur_prof[i];
             }
@@ -225,6 +225,31 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
  */
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_get_field_data bme68x_get_field_data
+ * \code
+ * int8_t bme68x_get_field_data(uint8_t op_mode, const uint8_t *field_regs, struct bme68x_data *data, uint8_t *n_data,
+ *                              struct bme68x_dev *dev);
+ * \endcode
+ * @details This API compensates the data fields the caller read from
+ * BME68X_REG_FIELD0 on its own and stores them in the bme68x_data structure
+ * instance passed by the user, as bme68x_get_data does after its read.
+ *
+ * @param[in]  op_mode    : Expected operation mode.
+ * @param[in]  field_regs : BME68X_LEN_FIELD registers in forced mode, BME68X_LEN_FIELD * 3 in parallel and
+ *                          sequential mode.
+ * @param[out] data       : Structure instance to hold the data, 3 in parallel and sequential mode.
+ * @param[out] n_data     : Number of data instances available.
+ * @param[in,out] dev     : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_get_field_data(uint8_t op_mode, const uint8_t *field_regs, struct bme68x_data *data, uint8_t *n_data,
+                             struct bme68x_dev *dev);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiConfig Configuration
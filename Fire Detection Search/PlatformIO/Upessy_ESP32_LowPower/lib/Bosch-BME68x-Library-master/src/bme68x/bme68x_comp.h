@@ -0,0 +1,402 @@
+/**
+* Copyright (c) 2021 Bosch Sensortec GmbH. All rights reserved.
+*
+* BSD-3-Clause
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+* IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+* @file       bme68x_comp.h
+* @date       2026-10-17
+* @version    v4.4.7
+*
+*/
+
+
+/*!
+ * Compensation kernels of the BME68X, fixed-point and float.
+ *
+ * Both sets are always available and take the calibration data and the
+ * intermediate temperature t_fine as arguments, so one build can run either.
+ * bme68x.c picks one of them, see BME68X_COMP_FLOAT in bme68x_defs.h.
+ */
+
+#ifndef BME68X_COMP_H_
+#define BME68X_COMP_H_
+
+#include "bme68x_defs.h"
+
+/*************************** Fixed-point kernels *****************************/
+
+
+/* Temperature in degree Celsius x100, t_fine gets the intermediate value used by pressure and humidity */
+static inline int16_t bme68x_comp_temp_fixed(uint32_t temp_adc, const struct bme68x_calib_data *calib, int32_t *t_fine)
+{
+    int64_t var1;
+    int64_t var2;
+    int64_t var3;
+    int16_t calc_temp;
+
+    /*lint -save -e701 -e702 -e704 */
+    var1 = ((int32_t)temp_adc >> 3) - ((int32_t)calib->par_t1 << 1);
+    var2 = (var1 * (int32_t)calib->par_t2) >> 11;
+    var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
+    var3 = ((var3) * ((int32_t)calib->par_t3 << 4)) >> 14;
+    *t_fine = (int32_t)(var2 + var3);
+    calc_temp = (int16_t)(((*t_fine * 5) + 128) >> 8);
+
+    /*lint -restore */
+    return calc_temp;
+}
+
+/* Pressure in Pascal */
+static inline uint32_t bme68x_comp_pres_fixed(uint32_t pres_adc, int32_t t_fine, const struct bme68x_calib_data *calib)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t pressure_comp;
+
+    /* This value is used to check precedence to multiplication or division
+     * in the pressure compensation equation to achieve least loss of precision and
+     * avoiding overflows.
+     * i.e Comparing value, pres_ovf_check = (1 << 31) >> 1
+     */
+    const int32_t pres_ovf_check = INT32_C(0x40000000);
+
+    /*lint -save -e701 -e702 -e713 */
+    var1 = (t_fine >> 1) - 64000;
+    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calib->par_p6) >> 2;
+    var2 = var2 + ((var1 * (int32_t)calib->par_p5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)calib->par_p4 << 16);
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)calib->par_p3 << 5)) >> 3) +
+           (((int32_t)calib->par_p2 * var1) >> 1);
+    var1 = var1 >> 18;
+    var1 = ((32768 + var1) * (int32_t)calib->par_p1) >> 15;
+    pressure_comp = 1048576 - pres_adc;
+    pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
+    if (pressure_comp >= pres_ovf_check)
+    {
+        pressure_comp = ((pressure_comp / var1) << 1);
+    }
+    else
+    {
+        pressure_comp = ((pressure_comp << 1) / var1);
+    }
+
+    var1 = ((int32_t)calib->par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)calib->par_p8) >> 13;
+
+    /* The cube times par_p10 leaves 32 bits above about 106 kPa */
+    var3 =
+        (int32_t)(((int64_t)((pressure_comp >> 8) * (pressure_comp >> 8) * (pressure_comp >> 8)) *
+                   (int32_t)calib->par_p10) >> 17);
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)calib->par_p7 << 7)) >> 4);
+
+    /*lint -restore */
+    return (uint32_t)pressure_comp;
+}
+
+/* Humidity in % relative humidity x1000 */
+static inline uint32_t bme68x_comp_hum_fixed(uint16_t hum_adc, int32_t t_fine, const struct bme68x_calib_data *calib)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    int32_t var6;
+    int32_t temp_scaled;
+    int32_t calc_hum;
+
+    /*lint -save -e702 -e704 */
+    temp_scaled = ((t_fine * 5) + 128) >> 8;
+    var1 = (int32_t)(hum_adc - ((int32_t)((int32_t)calib->par_h1 * 16))) -
+           (((temp_scaled * (int32_t)calib->par_h3) / ((int32_t)100)) >> 1);
+    var2 =
+        ((int32_t)calib->par_h2 *
+         (((temp_scaled * (int32_t)calib->par_h4) / ((int32_t)100)) +
+          (((temp_scaled * ((temp_scaled * (int32_t)calib->par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
+          (int32_t)(1 << 14))) >> 10;
+    var3 = var1 * var2;
+    var4 = (int32_t)calib->par_h6 << 7;
+    var4 = ((var4) + ((temp_scaled * (int32_t)calib->par_h7) / ((int32_t)100))) >> 4;
+    var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
+    var6 = (var4 * var5) >> 1;
+    calc_hum = (((var3 + var6) >> 10) * ((int32_t)1000)) >> 12;
+    if (calc_hum > 100000) /* Cap at 100%rH */
+    {
+        calc_hum = 100000;
+    }
+    else if (calc_hum < 0)
+    {
+        calc_hum = 0;
+    }
+
+    /*lint -restore */
+    return (uint32_t)calc_hum;
+}
+
+/* Gas resistance in Ohms of BME68X_VARIANT_GAS_LOW */
+static inline uint32_t bme68x_comp_gas_low_fixed(uint16_t gas_res_adc,
+                                                 uint8_t gas_range,
+                                                 const struct bme68x_calib_data *calib)
+{
+    int64_t var1;
+    uint64_t var2;
+    int64_t var3;
+    uint32_t calc_gas_res;
+    static const uint32_t lookup_table1[16] = {
+        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
+        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
+        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
+        UINT32_C(2147483647)
+    };
+    static const uint32_t lookup_table2[16] = {
+        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
+        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
+            4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
+    };
+
+    /*lint -save -e704 */
+    var1 = (int64_t)((1340 + (5 * (int64_t)calib->range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
+    var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
+    var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
+    calc_gas_res = (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
+
+    /*lint -restore */
+    return calc_gas_res;
+}
+
+/* Gas resistance in Ohms of BME68X_VARIANT_GAS_HIGH */
+static inline uint32_t bme68x_comp_gas_high_fixed(uint16_t gas_res_adc, uint8_t gas_range)
+{
+    uint32_t calc_gas_res;
+    uint32_t var1 = UINT32_C(262144) >> gas_range;
+    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+
+    var2 *= INT32_C(3);
+    var2 = INT32_C(4096) + var2;
+
+    /* multiplying 10000 then dividing then multiplying by 100 instead of multiplying by 1000000 to prevent overflow */
+    calc_gas_res = (UINT32_C(10000) * var1) / (uint32_t)var2;
+    calc_gas_res = calc_gas_res * 100;
+
+    return calc_gas_res;
+}
+
+/* res_heat register value of a heater temperature in degree Celsius at an ambient temperature */
+static inline uint8_t bme68x_comp_res_heat_fixed(uint16_t temp, int8_t amb_temp, const struct bme68x_calib_data *calib)
+{
+    uint8_t heatr_res;
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    int32_t heatr_res_x100;
+
+    if (temp > 400) /* Cap temperature */
+    {
+        temp = 400;
+    }
+
+    var1 = (((int32_t)amb_temp * calib->par_gh3) / 1000) * 256;
+    var2 = (calib->par_gh1 + 784) * (((((calib->par_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
+    var3 = var1 + (var2 / 2);
+    var4 = (var3 / (calib->res_heat_range + 4));
+    var5 = (131 * calib->res_heat_val) + 65536;
+    heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
+    heatr_res = (uint8_t)((heatr_res_x100 + 50) / 100);
+
+    return heatr_res;
+}
+
+/****************************** Float kernels ********************************/
+
+
+/* Temperature in degree Celsius, t_fine gets the intermediate value used by pressure and humidity */
+static inline float bme68x_comp_temp_float(uint32_t temp_adc, const struct bme68x_calib_data *calib, float *t_fine)
+{
+    float var1;
+    float var2;
+    float calc_temp;
+
+    /* calculate var1 data */
+    var1 = ((((float)temp_adc / 16384.0f) - ((float)calib->par_t1 / 1024.0f)) * ((float)calib->par_t2));
+
+    /* calculate var2 data */
+    var2 =
+        (((((float)temp_adc / 131072.0f) - ((float)calib->par_t1 / 8192.0f)) *
+          (((float)temp_adc / 131072.0f) - ((float)calib->par_t1 / 8192.0f))) * ((float)calib->par_t3 * 16.0f));
+
+    /* t_fine value*/
+    *t_fine = (var1 + var2);
+
+    /* compensated temperature data*/
+    calc_temp = ((*t_fine) / 5120.0f);
+
+    return calc_temp;
+}
+
+/* Pressure in Pascal */
+static inline float bme68x_comp_pres_float(uint32_t pres_adc, float t_fine, const struct bme68x_calib_data *calib)
+{
+    float var1;
+    float var2;
+    float var3;
+    float calc_pres;
+
+    var1 = ((t_fine / 2.0f) - 64000.0f);
+    var2 = var1 * var1 * (((float)calib->par_p6) / (131072.0f));
+    var2 = var2 + (var1 * ((float)calib->par_p5) * 2.0f);
+    var2 = (var2 / 4.0f) + (((float)calib->par_p4) * 65536.0f);
+    var1 = (((((float)calib->par_p3 * var1 * var1) / 16384.0f) + ((float)calib->par_p2 * var1)) / 524288.0f);
+    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)calib->par_p1));
+    calc_pres = (1048576.0f - ((float)pres_adc));
+
+    /* Avoid exception caused by division by zero */
+    if ((int)var1 != 0)
+    {
+        calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
+        var1 = (((float)calib->par_p9) * calc_pres * calc_pres) / 2147483648.0f;
+        var2 = calc_pres * (((float)calib->par_p8) / 32768.0f);
+        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (calib->par_p10 / 131072.0f));
+        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)calib->par_p7 * 128.0f)) / 16.0f);
+    }
+    else
+    {
+        calc_pres = 0;
+    }
+
+    return calc_pres;
+}
+
+/* Humidity in % relative humidity */
+static inline float bme68x_comp_hum_float(uint16_t hum_adc, float t_fine, const struct bme68x_calib_data *calib)
+{
+    float calc_hum;
+    float var1;
+    float var2;
+    float var3;
+    float var4;
+    float temp_comp;
+
+    /* compensated temperature data*/
+    temp_comp = (t_fine / 5120.0f);
+    var1 = (float)((float)hum_adc) -
+           (((float)calib->par_h1 * 16.0f) + (((float)calib->par_h3 / 2.0f) * temp_comp));
+    var2 = var1 *
+           ((float)(((float)calib->par_h2 / 262144.0f) *
+                    (1.0f + (((float)calib->par_h4 / 16384.0f) * temp_comp) +
+                     (((float)calib->par_h5 / 1048576.0f) * temp_comp * temp_comp))));
+    var3 = (float)calib->par_h6 / 16384.0f;
+    var4 = (float)calib->par_h7 / 2097152.0f;
+    calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
+    if (calc_hum > 100.0f)
+    {
+        calc_hum = 100.0f;
+    }
+    else if (calc_hum < 0.0f)
+    {
+        calc_hum = 0.0f;
+    }
+
+    return calc_hum;
+}
+
+/* Gas resistance in Ohms of BME68X_VARIANT_GAS_LOW */
+static inline float bme68x_comp_gas_low_float(uint16_t gas_res_adc,
+                                              uint8_t gas_range,
+                                              const struct bme68x_calib_data *calib)
+{
+    float calc_gas_res;
+    float var1;
+    float var2;
+    float var3;
+    float gas_res_f = gas_res_adc;
+    float gas_range_f = (1U << gas_range); /*lint !e790 / Suspicious truncation, integral to float */
+    static const float lookup_k1_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
+    };
+    static const float lookup_k2_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+    };
+
+    var1 = (1340.0f + (5.0f * calib->range_sw_err));
+    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
+    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
+    calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
+
+    return calc_gas_res;
+}
+
+/* Gas resistance in Ohms of BME68X_VARIANT_GAS_HIGH */
+static inline float bme68x_comp_gas_high_float(uint16_t gas_res_adc, uint8_t gas_range)
+{
+    float calc_gas_res;
+    uint32_t var1 = UINT32_C(262144) >> gas_range;
+    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+
+    var2 *= INT32_C(3);
+    var2 = INT32_C(4096) + var2;
+
+    calc_gas_res = 1000000.0f * (float)var1 / (float)var2;
+
+    return calc_gas_res;
+}
+
+/* res_heat register value of a heater temperature in degree Celsius at an ambient temperature */
+static inline uint8_t bme68x_comp_res_heat_float(uint16_t temp, int8_t amb_temp, const struct bme68x_calib_data *calib)
+{
+    float var1;
+    float var2;
+    float var3;
+    float var4;
+    float var5;
+    uint8_t res_heat;
+
+    if (temp > 400) /* Cap temperature */
+    {
+        temp = 400;
+    }
+
+    var1 = (((float)calib->par_gh1 / (16.0f)) + 49.0f);
+    var2 = ((((float)calib->par_gh2 / (32768.0f)) * (0.0005f)) + 0.00235f);
+    var3 = ((float)calib->par_gh3 / (1024.0f));
+    var4 = (var1 * (1.0f + (var2 * (float)temp)));
+    var5 = (var4 + (var3 * (float)amb_temp));
+    res_heat =
+        (uint8_t)(3.4f *
+                  ((var5 * (4 / (4 + (float)calib->res_heat_range)) *
+                    (1 / (1 + ((float)calib->res_heat_val * 0.002f)))) -
+                   25));
+
+    return res_heat;
+}
+
+#endif /* BME68X_COMP_H_ */
@@ -92,6 +92,13 @@
 #define BME68X_USE_FPU
 #endif
 
+/* Compensation kernels of bme68x_comp.h. BME68X_USE_FPU selects the float ones, define
+ * BME68X_COMP_FIXED_POINT to keep its float data but compute it with the fixed-point
+ * kernels, e.g. on cores without an FPU */
+#if defined(BME68X_USE_FPU) && !defined(BME68X_COMP_FIXED_POINT)
+#define BME68X_COMP_FLOAT
+#endif
+
 /* Period between two polls (value can be given by user) */
 #ifndef BME68X_PERIOD_POLL
 #define BME68X_PERIOD_POLL                        UINT32_C(10000)
@@ -339,6 +346,21 @@
 /* Length of the interleaved buffer */
 #define BME68X_LEN_INTERLEAVE_BUFF                UINT8_C(20)
 
+/* Length of the idac_heat, res_heat and gas_wait registers */
+#define BME68X_LEN_HEATR_REGS                     UINT8_C(30)
+
+/* Length of the configuration registers from idac_heat_0 (0x50) up to config (0x75) */
+#define BME68X_LEN_SHADOW                         UINT8_C(38)
+
+/* Highest heater temperature in degree Celsius, higher set-points are capped to it */
+#define BME68X_MAX_HEATR_TEMP                     UINT16_C(400)
+
+/* Length of the heater resistance table, one entry per degree from 0 up to BME68X_MAX_HEATR_TEMP */
+#define BME68X_LEN_RES_HEAT_TABLE                 (BME68X_MAX_HEATR_TEMP + 1)
+
+/* Length of the bitmap of the heater resistance table entries already computed */
+#define BME68X_LEN_RES_HEAT_FILLED                ((BME68X_LEN_RES_HEAT_TABLE + 7) / 8)
+
 /* Coefficient index macros */
 
 /* Coefficient T2 LSB position */
@@ -966,6 +988,38 @@ struct bme68x_dev
 
     /*! Store the info messages */
     uint8_t info_msg;
+
+    /*!
+     * Copy of the configuration registers from idac_heat_0 up to config, kept
+     * up to date by bme68x_set_regs. Reads are served from it and writes of
+     * unchanged values are dropped
+     */
+    uint8_t reg_shadow[BME68X_LEN_SHADOW];
+
+    /*! reg_shadow holds the register values, cleared by a soft reset */
+    uint8_t reg_shadow_valid;
+
+    /*!
+     * res_heat register values for heater temperatures of 0 up to BME68X_MAX_HEATR_TEMP,
+     * computed from the calibration data for the ambient temperature res_heat_amb_temp
+     * on the first use of each temperature
+     */
+    uint8_t res_heat_table[BME68X_LEN_RES_HEAT_TABLE];
+
+    /*! One bit per entry of res_heat_table already computed, cleared by bme68x_init */
+    uint8_t res_heat_filled[BME68X_LEN_RES_HEAT_FILLED];
+
+    /*! Ambient temperature of the entries of res_heat_table */
+    int8_t res_heat_amb_temp;
+
+    /*! Number of read and write transactions on the interface */
+    uint32_t intf_transactions;
+
+    /*! Number of register address and data bytes on the interface */
+    uint32_t intf_bytes;
+
+    /*! Number of register writes dropped because the register already held the value */
+    uint32_t intf_skipped_writes;
 };
 
 #endif /* BME68X_DEFS_H_ */
@@ -0,0 +1,331 @@
+/**
+ * Copyright (c) 2021 Bosch Sensortec GmbH. All rights reserved.
+ *
+ * BSD-3-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file    bme68xAsync.cpp
+ * @date    17 Oct 2026
+ * @version 1.1.40407
+ *
+ */
+
+#include "bme68xAsync.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#define ASYNC_LOCK()    portENTER_CRITICAL(&lock)
+#define ASYNC_UNLOCK()  portEXIT_CRITICAL(&lock)
+#else
+#define ASYNC_LOCK()
+#define ASYNC_UNLOCK()
+#endif
+
+Bme68xAsync::Bme68xAsync(Bme68xAsyncBus &bus, bme68x_delay_us_fptr_t idleTask)
+{
+	this->bus = &bus;
+	this->idleTask = idleTask;
+	memset(queue, 0, sizeof(queue));
+	head = 0;
+	count = 0;
+	error = BME68X_OK;
+	memset(prefetchBuff, 0, sizeof(prefetchBuff));
+	prefetchAddr = 0;
+	prefetchLen = 0;
+	prefetchState = PREFETCH_NONE;
+	prefetchCallback = NULL;
+	prefetchCtx = NULL;
+#ifdef ARDUINO_ARCH_ESP32
+	portMUX_INITIALIZE(&lock);
+#endif
+}
+
+/**
+ * @brief Read callback for Bme68x::begin
+ */
+BME68X_INTF_RET_TYPE Bme68xAsync::read(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	Bme68xAsync *self = (Bme68xAsync *) intfPtr;
+	bme68xAsyncXfer xfer;
+
+	if (!self || !regData)
+		return BME68X_E_NULL_PTR;
+
+	if (self->fromPrefetch(regAddr, regData, length))
+		return self->takeError();
+
+	memset(&xfer, 0, sizeof(xfer));
+	xfer.regAddr = regAddr;
+	xfer.read = 1;
+	xfer.rxData = regData;
+	xfer.length = length;
+
+	/* A full queue drains before taking the read */
+	while (!self->submit(xfer))
+		self->bus->wait();
+
+	return self->waitIdle();
+}
+
+/**
+ * @brief Write callback for Bme68x::begin
+ */
+BME68X_INTF_RET_TYPE Bme68xAsync::write(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	Bme68xAsync *self = (Bme68xAsync *) intfPtr;
+
+	if (!self || !regData)
+		return BME68X_E_NULL_PTR;
+
+	if (length > BME68X_ASYNC_MAX_WRITE)
+		return BME68X_E_INVALID_LENGTH;
+
+	while (!self->writeAsync(regAddr, regData, length))
+		self->bus->wait();
+
+	/* Report the error of an earlier write */
+	return self->takeError();
+}
+
+/**
+ * @brief Delay callback for Bme68x::begin
+ */
+void Bme68xAsync::delayUs(uint32_t periodUs, void *intfPtr)
+{
+	Bme68xAsync *self = (Bme68xAsync *) intfPtr;
+
+	if (self)
+	{
+		while (!self->isIdle())
+			self->bus->wait();
+
+		if (self->idleTask)
+			self->idleTask(periodUs, intfPtr);
+	}
+}
+
+/**
+ * @brief Function to queue the read of the field registers
+ */
+bool Bme68xAsync::fetchDataAsync(uint8_t opMode, bme68xAsyncCallback callback, void *ctx)
+{
+	bme68xAsyncXfer xfer;
+
+	if (prefetchState == PREFETCH_PENDING)
+		return false;
+
+	/* Forced mode reads field 0 only, the other modes the three fields in one burst */
+	prefetchAddr = BME68X_REG_FIELD0;
+	prefetchLen = (opMode == BME68X_FORCED_MODE) ? BME68X_LEN_FIELD : BME68X_ASYNC_PREFETCH_LEN;
+	prefetchCallback = callback;
+	prefetchCtx = ctx;
+	prefetchState = PREFETCH_PENDING;
+
+	memset(&xfer, 0, sizeof(xfer));
+	xfer.regAddr = prefetchAddr;
+	xfer.read = 1;
+	xfer.rxData = prefetchBuff;
+	xfer.length = prefetchLen;
+	xfer.callback = prefetchDone;
+	xfer.ctx = this;
+
+	if (!submit(xfer))
+	{
+		prefetchState = PREFETCH_NONE;
+		return false;
+	}
+
+	return true;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+static void notifyTask(int8_t rslt, void *ctx)
+{
+	(void) rslt;
+	xTaskNotifyGive((TaskHandle_t) ctx);
+}
+
+/**
+ * @brief Function to queue the read of the field registers and notify a task
+ */
+bool Bme68xAsync::fetchDataAsync(uint8_t opMode, TaskHandle_t task)
+{
+	return fetchDataAsync(opMode, notifyTask, (void *) task);
+}
+#endif
+
+/**
+ * @brief Function to queue a write
+ */
+bool Bme68xAsync::writeAsync(uint8_t regAddr, const uint8_t *regData, uint32_t length,
+		bme68xAsyncCallback callback, void *ctx)
+{
+	bme68xAsyncXfer xfer;
+
+	if (!regData || (length > BME68X_ASYNC_MAX_WRITE))
+		return false;
+
+	/* The register is about to change, a prefetch of it would be stale */
+	if ((prefetchState == PREFETCH_READY) && (regAddr >= prefetchAddr) && (regAddr < prefetchAddr + prefetchLen))
+		prefetchState = PREFETCH_NONE;
+
+	xfer.regAddr = regAddr;
+	xfer.read = 0;
+	xfer.rxData = NULL;
+	memcpy(xfer.txData, regData, length);
+	xfer.length = length;
+	xfer.callback = callback;
+	xfer.ctx = ctx;
+
+	return submit(xfer);
+}
+
+/**
+ * @brief Function to check whether the bus is done with every queued transfer
+ */
+bool Bme68xAsync::isIdle(void)
+{
+	return count == 0;
+}
+
+/**
+ * @brief Function to wait until the bus is done with every queued transfer
+ */
+int8_t Bme68xAsync::waitIdle(void)
+{
+	while (!isIdle())
+		bus->wait();
+
+	return takeError();
+}
+
+/**
+ * @brief Function called by the bus once the transfer it was given is done
+ */
+void Bme68xAsync::complete(int8_t rslt)
+{
+	bme68xAsyncCallback callback;
+	void *ctx;
+	bool next;
+
+	ASYNC_LOCK();
+	callback = queue[head].callback;
+	ctx = queue[head].ctx;
+	if ((rslt != BME68X_OK) && (error == BME68X_OK))
+		error = rslt;
+	ASYNC_UNLOCK();
+
+	/* Called before the slot is released, so callbacks run in queue order */
+	if (callback)
+		callback(rslt, ctx);
+
+	ASYNC_LOCK();
+	head = (head + 1) % BME68X_ASYNC_QUEUE_LEN;
+	count--;
+	next = (count > 0);
+	ASYNC_UNLOCK();
+
+	if (next)
+		bus->start(queue[head], *this);
+}
+
+/**
+ * @brief Function to get and clear the first error of the transfers
+ */
+int8_t Bme68xAsync::takeError(void)
+{
+	int8_t rslt;
+
+	ASYNC_LOCK();
+	rslt = error;
+	error = BME68X_OK;
+	ASYNC_UNLOCK();
+
+	return rslt;
+}
+
+/**
+ * @brief Function to add a transfer to the queue and start it if the bus is idle
+ */
+bool Bme68xAsync::submit(const bme68xAsyncXfer &xfer)
+{
+	bool startNow;
+	uint8_t tail;
+
+	ASYNC_LOCK();
+	if (count >= BME68X_ASYNC_QUEUE_LEN)
+	{
+		ASYNC_UNLOCK();
+		return false;
+	}
+
+	tail = (head + count) % BME68X_ASYNC_QUEUE_LEN;
+	queue[tail] = xfer;
+	count++;
+	startNow = (count == 1);
+	ASYNC_UNLOCK();
+
+	if (startNow)
+		bus->start(queue[head], *this);
+
+	return true;
+}
+
+/**
+ * @brief Function to serve a read from the prefetched field registers
+ */
+bool Bme68xAsync::fromPrefetch(uint8_t regAddr, uint8_t *regData, uint32_t length)
+{
+	if ((prefetchState == PREFETCH_NONE) || (regAddr < prefetchAddr) ||
+			(regAddr + length > prefetchAddr + prefetchLen))
+		return false;
+
+	while (prefetchState == PREFETCH_PENDING)
+		bus->wait();
+
+	if (prefetchState != PREFETCH_READY)
+		return false;
+
+	/* A prefetch serves one fetch, the next one needs new data */
+	memcpy(regData, &prefetchBuff[regAddr - prefetchAddr], length);
+	prefetchState = PREFETCH_NONE;
+
+	return true;
+}
+
+/**
+ * @brief Function called once the prefetch is done
+ */
+void Bme68xAsync::prefetchDone(int8_t rslt, void *ctx)
+{
+	Bme68xAsync *self = (Bme68xAsync *) ctx;
+
+	self->prefetchState = (rslt == BME68X_OK) ? PREFETCH_READY : PREFETCH_NONE;
+	if (self->prefetchCallback)
+		self->prefetchCallback(rslt, self->prefetchCtx);
+}
@@ -0,0 +1,352 @@
+/**
+ * Copyright (c) 2021 Bosch Sensortec GmbH. All rights reserved.
+ *
+ * BSD-3-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file    bme68xAsync.h
+ * @date    17 Oct 2026
+ * @version 1.1.40407
+ *
+ */
+
+#ifndef BME68X_ASYNC_H
+#define BME68X_ASYNC_H
+
+#include "bme68xLibrary.h"
+#include "bme68xTransport.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#endif
+
+/*
+ * Queued access to the BME68x bus.
+ *
+ * Bme68xAsync sits between the C API and a bus that runs transfers in the
+ * background. Writes are queued and return at once, so a configuration is
+ * sent while the caller goes on. Reads wait for the queue to drain, unless
+ * they are served by a prefetch: fetchDataAsync queues the read of the field
+ * registers and calls back once they are in RAM, after which fetchData
+ * decodes them without touching the bus.
+ *
+ *   Bme68xTaskBus<Bme68xI2cTransport> bus(Bme68xI2cTransport(0x77, Wire));
+ *   Bme68xAsync async(bus);
+ *   bus.begin();
+ *   sensor.begin(BME68X_I2C_INTF, Bme68xAsync::read, Bme68xAsync::write, Bme68xAsync::delayUs, &async);
+ *   ...
+ *   async.fetchDataAsync(BME68X_FORCED_MODE, onFields, ctx);
+ *   // BSEC work, or sleep, while the bus is busy
+ *   sensor.fetchData();
+ *
+ * The error of a queued write is reported by the next access.
+ */
+
+/* Depth of the transfer queue */
+#ifndef BME68X_ASYNC_QUEUE_LEN
+#define BME68X_ASYNC_QUEUE_LEN      8
+#endif
+
+/* Largest write, bme68x_set_regs sends at most this many bytes after the first address */
+#define BME68X_ASYNC_MAX_WRITE      BME68X_LEN_INTERLEAVE_BUFF
+
+/* Field registers of the three fields, read by one prefetch */
+#define BME68X_ASYNC_PREFETCH_LEN   (BME68X_LEN_FIELD * 3)
+
+class Bme68xAsync;
+
+/**
+ * @brief Function called once a queued transfer is done
+ * @param rslt : 0 if successful, an error code otherwise
+ * @param ctx  : Pointer given with the transfer
+ */
+typedef void (*bme68xAsyncCallback)(int8_t rslt, void *ctx);
+
+/**
+ * Datatype of a queued transfer
+ */
+typedef struct
+{
+    uint8_t regAddr;
+    uint8_t read;
+    uint8_t *rxData;
+    uint8_t txData[BME68X_ASYNC_MAX_WRITE];
+    uint32_t length;
+    bme68xAsyncCallback callback;
+    void *ctx;
+} bme68xAsyncXfer;
+
+/**
+ * Bus running one transfer at a time in the background
+ */
+class Bme68xAsyncBus
+{
+public:
+    virtual ~Bme68xAsyncBus(void)
+    {
+    }
+
+    /**
+     * @brief Function to start a transfer, the bus calls owner.complete() once it is done,
+     *        possibly before returning
+     * @param xfer  : Transfer, read data goes to xfer.rxData, write data comes from xfer.txData
+     * @param owner : Queue the transfer belongs to
+     */
+    virtual void start(bme68xAsyncXfer &xfer, Bme68xAsync &owner) = 0;
+
+    /**
+     * @brief Function called while a read waits for the transfer in flight, it returns once
+     *        the transfer made progress or after a short time
+     */
+    virtual void wait(void) = 0;
+};
+
+class Bme68xAsync
+{
+public:
+    /**
+     * @brief Constructor
+     * @param bus      : Bus running the transfers
+     * @param idleTask : Delay function called by delayUs once the queued writes are done
+     */
+    Bme68xAsync(Bme68xAsyncBus &bus, bme68x_delay_us_fptr_t idleTask = bme68xDelayUs);
+
+    /**
+     * @brief Read callback for Bme68x::begin, with the Bme68xAsync object as interface pointer
+     */
+    static BME68X_INTF_RET_TYPE read(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr);
+
+    /**
+     * @brief Write callback for Bme68x::begin, the write is queued
+     */
+    static BME68X_INTF_RET_TYPE write(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr);
+
+    /**
+     * @brief Delay callback for Bme68x::begin. The driver times the sensor from the end of
+     *        its writes, so the delay starts once they are done
+     */
+    static void delayUs(uint32_t periodUs, void *intfPtr);
+
+    /**
+     * @brief Function to queue the read of the field registers, which the next fetchData uses
+     * @param opMode   : Operation mode the data will be fetched in
+     * @param callback : Function called once the registers are in RAM, may be NULL
+     * @param ctx      : Pointer handed to the callback
+     * @return true if the read is queued
+     */
+    bool fetchDataAsync(uint8_t opMode, bme68xAsyncCallback callback = NULL, void *ctx = NULL);
+
+#ifdef ARDUINO_ARCH_ESP32
+    /**
+     * @brief Function to queue the read of the field registers and notify a task once they are in RAM
+     * @param opMode : Operation mode the data will be fetched in
+     * @param task   : Task given a notification, e.g. the caller taking it with ulTaskNotifyTake
+     * @return true if the read is queued
+     */
+    bool fetchDataAsync(uint8_t opMode, TaskHandle_t task);
+#endif
+
+    /**
+     * @brief Function to queue a write, as the write callback does
+     * @return true if the write is queued
+     */
+    bool writeAsync(uint8_t regAddr, const uint8_t *regData, uint32_t length,
+            bme68xAsyncCallback callback = NULL, void *ctx = NULL);
+
+    /**
+     * @brief Function to check whether the bus is done with every queued transfer
+     */
+    bool isIdle(void);
+
+    /**
+     * @brief Function to wait until the bus is done with every queued transfer
+     * @return 0 if every transfer since the last call succeeded, the first error otherwise
+     */
+    int8_t waitIdle(void);
+
+    /**
+     * @brief Function called by the bus once the transfer it was given is done
+     * @param rslt : 0 if successful, an error code otherwise
+     */
+    void complete(int8_t rslt);
+
+private:
+    enum
+    {
+        PREFETCH_NONE,
+        PREFETCH_PENDING,
+        PREFETCH_READY
+    };
+
+    int8_t takeError(void);
+    bool submit(const bme68xAsyncXfer &xfer);
+    bool fromPrefetch(uint8_t regAddr, uint8_t *regData, uint32_t length);
+    static void prefetchDone(int8_t rslt, void *ctx);
+
+    Bme68xAsyncBus *bus;
+    bme68x_delay_us_fptr_t idleTask;
+
+    bme68xAsyncXfer queue[BME68X_ASYNC_QUEUE_LEN];
+    volatile uint8_t head;
+    volatile uint8_t count;
+    volatile int8_t error;
+
+    uint8_t prefetchBuff[BME68X_ASYNC_PREFETCH_LEN];
+    uint8_t prefetchAddr;
+    uint32_t prefetchLen;
+    volatile uint8_t prefetchState;
+    bme68xAsyncCallback prefetchCallback;
+    void *prefetchCtx;
+
+#ifdef ARDUINO_ARCH_ESP32
+    portMUX_TYPE lock;
+#endif
+};
+
+/* Stack of the bus task in bytes */
+#ifndef BME68X_ASYNC_TASK_STACK_SIZE
+#define BME68X_ASYNC_TASK_STACK_SIZE 2048
+#endif
+
+/**
+ * Bus running the transfers of a transport of bme68xTransport.h.
+ * On ESP32 a task runs them, so the caller keeps the CPU while the bus is busy and
+ * the waits block instead of spinning. Elsewhere the transfers run when started.
+ */
+template <typename Transport>
+class Bme68xTaskBus : public Bme68xAsyncBus
+{
+public:
+    Bme68xTaskBus(const Transport &transport = Transport()) : bus(transport)
+    {
+    }
+
+#ifdef ARDUINO_ARCH_ESP32
+    /**
+     * @brief Function to start the bus task
+     * @param priority : Priority of the task
+     * @param core     : Core running the task, tskNO_AFFINITY for any
+     * @return true for success
+     */
+    bool begin(UBaseType_t priority = 2, BaseType_t core = tskNO_AFFINITY)
+    {
+        bus.begin();
+        requests = xQueueCreateStatic(1, sizeof(request), requestsMem, &requestsQueue);
+        done = xSemaphoreCreateBinaryStatic(&doneMem);
+        task = xTaskCreateStaticPinnedToCore(run, "bme68xBus", BME68X_ASYNC_TASK_STACK_SIZE, this, priority,
+                taskStack, &taskMem, core);
+
+        return task != NULL;
+    }
+
+    void start(bme68xAsyncXfer &xfer, Bme68xAsync &owner)
+    {
+        request r = { &xfer, &owner };
+        xQueueSend(requests, &r, portMAX_DELAY);
+    }
+
+    void wait(void)
+    {
+        xSemaphoreTake(done, 1);
+    }
+#else
+    bool begin(void)
+    {
+        bus.begin();
+        return true;
+    }
+
+    void start(bme68xAsyncXfer &xfer, Bme68xAsync &owner)
+    {
+        owner.complete(execute(xfer));
+    }
+
+    void wait(void)
+    {
+    }
+#endif
+
+    /**
+     * @brief Function to get the transport
+     */
+    Transport &getTransport(void)
+    {
+        return bus;
+    }
+
+private:
+    Transport bus;
+
+    int8_t execute(bme68xAsyncXfer &xfer)
+    {
+        if (xfer.read)
+        {
+            return bus.read(xfer.regAddr, xfer.rxData, xfer.length);
+        }
+
+        return bus.write(xfer.regAddr, xfer.txData, xfer.length);
+    }
+
+#ifdef ARDUINO_ARCH_ESP32
+    typedef struct
+    {
+        bme68xAsyncXfer *xfer;
+        Bme68xAsync *owner;
+    } request;
+
+    QueueHandle_t requests;
+    StaticQueue_t requestsQueue;
+    uint8_t requestsMem[sizeof(request)];
+    SemaphoreHandle_t done;
+    StaticSemaphore_t doneMem;
+    TaskHandle_t task;
+    StaticTask_t taskMem;
+    StackType_t taskStack[BME68X_ASYNC_TASK_STACK_SIZE];
+
+    static void run(void *arg)
+    {
+        Bme68xTaskBus *self = (Bme68xTaskBus *) arg;
+        request r;
+
+        for (;;)
+        {
+            if (xQueueReceive(self->requests, &r, portMAX_DELAY) == pdTRUE)
+            {
+                r.owner->complete(self->execute(*r.xfer));
+                xSemaphoreGive(self->done);
+            }
+        }
+    }
+#endif
+};
+
+#endif /* BME68X_ASYNC_H */
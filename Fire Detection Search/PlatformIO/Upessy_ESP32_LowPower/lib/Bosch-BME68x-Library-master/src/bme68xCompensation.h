@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2021 Bosch Sensortec GmbH. All rights reserved.
+ *
+ * BSD-3-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file    bme68xCompensation.h
+ * @date    17 Oct 2026
+ * @version 1.1.40407
+ *
+ */
+
+#ifndef BME68X_COMPENSATION_H
+#define BME68X_COMPENSATION_H
+
+#include "bme68x/bme68x_comp.h"
+
+/*
+ * Compensation of raw BME68x readouts with the kernels of bme68x_comp.h,
+ * picked by a template parameter:
+ *
+ *   Bme68xCompensation<Bme68xFixedPoint>::Sample out;
+ *   Bme68xCompensation<Bme68xFixedPoint>::compensate(raw, calib, variantId, out);
+ *
+ * Bme68xBuildCompensation is the one bme68x.c is built with, see
+ * BME68X_COMP_FLOAT in bme68x_defs.h. The driver keeps its own choice, this
+ * is for code working on raw readouts, e.g. to compare the kernels.
+ */
+
+/**
+ * Datatype of a raw readout of one field
+ */
+typedef struct
+{
+    uint32_t tempAdc;
+    uint32_t presAdc;
+    uint16_t humAdc;
+    uint16_t gasAdc;
+    uint8_t gasRange;
+} bme68xRawSample;
+
+/**
+ * Fixed-point kernels, in degree Celsius x100, Pascal, % relative humidity x1000 and Ohms
+ */
+struct Bme68xFixedPoint
+{
+    typedef int32_t TFine;
+    typedef int16_t Temperature;
+    typedef uint32_t Pressure;
+    typedef uint32_t Humidity;
+    typedef uint32_t GasResistance;
+
+    static Temperature temperature(uint32_t adc, const bme68x_calib_data &calib, TFine &tFine)
+    {
+        return bme68x_comp_temp_fixed(adc, &calib, &tFine);
+    }
+
+    static Pressure pressure(uint32_t adc, TFine tFine, const bme68x_calib_data &calib)
+    {
+        return bme68x_comp_pres_fixed(adc, tFine, &calib);
+    }
+
+    static Humidity humidity(uint16_t adc, TFine tFine, const bme68x_calib_data &calib)
+    {
+        return bme68x_comp_hum_fixed(adc, tFine, &calib);
+    }
+
+    static GasResistance gasResistanceHigh(uint16_t adc, uint8_t range)
+    {
+        return bme68x_comp_gas_high_fixed(adc, range);
+    }
+
+    static GasResistance gasResistanceLow(uint16_t adc, uint8_t range, const bme68x_calib_data &calib)
+    {
+        return bme68x_comp_gas_low_fixed(adc, range, &calib);
+    }
+
+    /* Scale of the temperature and humidity to degree Celsius and % relative humidity */
+    static float celsius(Temperature temp)
+    {
+        return temp / 100.0f;
+    }
+
+    static float percentRh(Humidity hum)
+    {
+        return hum / 1000.0f;
+    }
+};
+
+/**
+ * Float kernels, in degree Celsius, Pascal, % relative humidity and Ohms
+ */
+struct Bme68xFloat
+{
+    typedef float TFine;
+    typedef float Temperature;
+    typedef float Pressure;
+    typedef float Humidity;
+    typedef float GasResistance;
+
+    static Temperature temperature(uint32_t adc, const bme68x_calib_data &calib, TFine &tFine)
+    {
+        return bme68x_comp_temp_float(adc, &calib, &tFine);
+    }
+
+    static Pressure pressure(uint32_t adc, TFine tFine, const bme68x_calib_data &calib)
+    {
+        return bme68x_comp_pres_float(adc, tFine, &calib);
+    }
+
+    static Humidity humidity(uint16_t adc, TFine tFine, const bme68x_calib_data &calib)
+    {
+        return bme68x_comp_hum_float(adc, tFine, &calib);
+    }
+
+    static GasResistance gasResistanceHigh(uint16_t adc, uint8_t range)
+    {
+        return bme68x_comp_gas_high_float(adc, range);
+    }
+
+    static GasResistance gasResistanceLow(uint16_t adc, uint8_t range, const bme68x_calib_data &calib)
+    {
+        return bme68x_comp_gas_low_float(adc, range, &calib);
+    }
+
+    static float celsius(Temperature temp)
+    {
+        return temp;
+    }
+
+    static float percentRh(Humidity hum)
+    {
+        return hum;
+    }
+};
+
+template <typename Kernel>
+struct Bme68xCompensation
+{
+    /**
+     * Datatype of a compensated field, in the units of the kernel
+     */
+    struct Sample
+    {
+        typename Kernel::Temperature temperature;
+        typename Kernel::Pressure pressure;
+        typename Kernel::Humidity humidity;
+        typename Kernel::GasResistance gasResistance;
+    };
+
+    /**
+     * @brief Function to compensate a raw readout, as bme68x_get_data does
+     * @param raw       : Raw readout
+     * @param calib     : Calibration data of the sensor
+     * @param variantId : BME68X_VARIANT_GAS_LOW or BME68X_VARIANT_GAS_HIGH
+     * @param out       : Compensated field
+     */
+    static void compensate(const bme68xRawSample &raw, const bme68x_calib_data &calib, uint32_t variantId,
+            Sample &out)
+    {
+        typename Kernel::TFine tFine;
+
+        out.temperature = Kernel::temperature(raw.tempAdc, calib, tFine);
+        out.pressure = Kernel::pressure(raw.presAdc, tFine, calib);
+        out.humidity = Kernel::humidity(raw.humAdc, tFine, calib);
+        if (variantId == BME68X_VARIANT_GAS_HIGH)
+        {
+            out.gasResistance = Kernel::gasResistanceHigh(raw.gasAdc, raw.gasRange);
+        }
+        else
+        {
+            out.gasResistance = Kernel::gasResistanceLow(raw.gasAdc, raw.gasRange, calib);
+        }
+    }
+};
+
+#ifdef BME68X_COMP_FLOAT
+typedef Bme68xCompensation<Bme68xFloat> Bme68xBuildCompensation;
+#else
+typedef Bme68xCompensation<Bme68xFixedPoint> Bme68xBuildCompensation;
+#endif
+
+#endif /* BME68X_COMPENSATION_H */
@@ -40,6 +40,14 @@
 
 #include "bme68xLibrary.h"
 
+#if defined(ARDUINO_ARCH_ESP32) && !defined(BME68X_LIGHT_SLEEP)
+#define BME68X_LIGHT_SLEEP
+#endif
+
+#ifdef BME68X_LIGHT_SLEEP
+#include "esp_sleep.h"
+#endif
+
 /* Maximum transaction size. Field size 17 x 3 */
 #define BME68X_MAX_READ_LENGTH 51
 
@@ -112,6 +120,11 @@ Bme68x::Bme68x(void)
 	nFields = 0;
 	iFields = 0;
 	lastOpMode = BME68X_SLEEP_MODE;
+	memset(&callStart, 0, sizeof(callStart));
+	waitStrategy = BME68X_WAIT_DRIVER;
+	pollUs = BME68X_PERIOD_POLL;
+	measStartUs = 0;
+	measPending = false;
 }
 
 /**
@@ -128,6 +141,7 @@ void Bme68x::begin(bme68xIntf intf, bme68x_read_fptr_t read, bme68x_write_fptr_t
 	bme6.intf_ptr = intfPtr;
 	bme6.amb_temp = 25;
 
+	startCall();
 	status = bme68x_init(&bme6);
 }
 
@@ -145,6 +159,7 @@ void Bme68x::begin(uint8_t i2cAddr, TwoWire &i2c, bme68x_delay_us_fptr_t idleTas
 	bme6.intf_ptr = &comm;
 	bme6.amb_temp = 25;
 
+	startCall();
 	status = bme68x_init(&bme6);
 }
 
@@ -168,6 +183,7 @@ void Bme68x::begin(uint8_t chipSelect, SPIClass &spi, bme68x_delay_us_fptr_t idl
 	bme6.intf_ptr = &comm;
 	bme6.amb_temp = 25;
 
+	startCall();
 	status = bme68x_init(&bme6);
 }
 
@@ -186,6 +202,7 @@ uint8_t Bme68x::readReg(uint8_t regAddr)
  */
 void Bme68x::readReg(uint8_t regAddr, uint8_t *regData, uint32_t length)
 {
+	startCall();
 	status = bme68x_get_regs(regAddr, regData, length, &bme6);
 }
 
@@ -194,6 +211,7 @@ void Bme68x::readReg(uint8_t regAddr, uint8_t *regData, uint32_t length)
  */
 void Bme68x::writeReg(uint8_t regAddr, uint8_t regData)
 {
+	startCall();
 	status = bme68x_set_regs(&regAddr, &regData, 1, &bme6);
 }
 
@@ -202,6 +220,7 @@ void Bme68x::writeReg(uint8_t regAddr, uint8_t regData)
  */
 void Bme68x::writeReg(uint8_t *regAddr, const uint8_t *regData, uint32_t length)
 {
+	startCall();
 	status = bme68x_set_regs(regAddr, regData, length, &bme6);
 }
 
@@ -210,6 +229,7 @@ void Bme68x::writeReg(uint8_t *regAddr, const uint8_t *regData, uint32_t length)
  */
 void Bme68x::softReset(void)
 {
+	startCall();
 	status = bme68x_soft_reset(&bme6);
 }
 
@@ -237,9 +257,13 @@ uint32_t Bme68x::getMeasDur(uint8_t opMode)
  */
 void Bme68x::setOpMode(uint8_t opMode)
 {
+	startCall();
 	status = bme68x_set_op_mode(opMode, &bme6);
 	if ((status == BME68X_OK) && (opMode != BME68X_SLEEP_MODE))
 		lastOpMode = opMode;
+
+	measPending = (status == BME68X_OK) && (opMode == BME68X_FORCED_MODE);
+	measStartUs = micros();
 }
 
 /**
@@ -248,6 +272,7 @@ void Bme68x::setOpMode(uint8_t opMode)
 uint8_t Bme68x::getOpMode(void)
 {
 	uint8_t opMode;
+	startCall();
 	status = bme68x_get_op_mode(&opMode, &bme6);
 	return opMode;
 }
@@ -257,6 +282,7 @@ uint8_t Bme68x::getOpMode(void)
  */
 void Bme68x::getTPH(uint8_t &osHum, uint8_t &osTemp, uint8_t &osPres)
 {
+	startCall();
 	status = bme68x_get_conf(&conf, &bme6);
 
 	if (status == BME68X_OK)
@@ -272,6 +298,7 @@ void Bme68x::getTPH(uint8_t &osHum, uint8_t &osTemp, uint8_t &osPres)
  */
 void Bme68x::setTPH(uint8_t osTemp, uint8_t osPres, uint8_t osHum)
 {
+	startCall();
 	status = bme68x_get_conf(&conf, &bme6);
 
 	if (status == BME68X_OK)
@@ -289,6 +316,7 @@ void Bme68x::setTPH(uint8_t osTemp, uint8_t osPres, uint8_t osHum)
  */
 uint8_t Bme68x::getFilter(void)
 {
+	startCall();
 	status = bme68x_get_conf(&conf, &bme6);
 
 	return conf.filter;
@@ -299,6 +327,7 @@ uint8_t Bme68x::getFilter(void)
  */
 void Bme68x::setFilter(uint8_t filter)
 {
+	startCall();
 	status = bme68x_get_conf(&conf, &bme6);
 
 	if (status == BME68X_OK)
@@ -314,6 +343,7 @@ void Bme68x::setFilter(uint8_t filter)
  */
 uint8_t Bme68x::getSeqSleep(void)
 {
+	startCall();
 	status = bme68x_get_conf(&conf, &bme6);
 
 	return conf.odr;
@@ -324,6 +354,7 @@ uint8_t Bme68x::getSeqSleep(void)
  */
 void Bme68x::setSeqSleep(uint8_t odr)
 {
+	startCall();
 	status = bme68x_get_conf(&conf, &bme6);
 
 	if (status == BME68X_OK)
@@ -343,6 +374,7 @@ void Bme68x::setHeaterProf(uint16_t temp, uint16_t dur)
 	heatrConf.heatr_temp = temp;
 	heatrConf.heatr_dur = dur;
 
+	startCall();
 	status = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatrConf, &bme6);
 }
 
@@ -356,6 +388,7 @@ void Bme68x::setHeaterProf(uint16_t *temp, uint16_t *dur, uint8_t profileLen)
 	heatrConf.heatr_dur_prof = dur;
 	heatrConf.profile_len = profileLen;
 
+	startCall();
 	status = bme68x_set_heatr_conf(BME68X_SEQUENTIAL_MODE, &heatrConf, &bme6);
 
 }
@@ -371,14 +404,28 @@ void Bme68x::setHeaterProf(uint16_t *temp, uint16_t *mul, uint16_t sharedHeatrDu
 	heatrConf.shared_heatr_dur = sharedHeatrDur;
 	heatrConf.profile_len = profileLen;
 
+	startCall();
 	status = bme68x_set_heatr_conf(BME68X_PARALLEL_MODE, &heatrConf, &bme6);
 }
 
+/**
+ * @brief Function to select how fetchData waits for a forced mode measurement
+ */
+void Bme68x::setWaitStrategy(bme68xWaitStrategy strategy, uint32_t pollUs)
+{
+	waitStrategy = strategy;
+	this->pollUs = pollUs ? pollUs : BME68X_PERIOD_POLL;
+}
+
 /**
  * @brief Function to fetch data from the sensor into the local buffer
  */
 uint8_t Bme68x::fetchData(void)
 {
+	startCall();
+	if ((lastOpMode == BME68X_FORCED_MODE) && measPending)
+		waitMeasurement();
+
 	nFields = 0;
 	status = bme68x_get_data(lastOpMode, sensorData, &nFields, &bme6);
 	iFields = 0;
@@ -458,6 +505,36 @@ BME68X_INTF_RET_TYPE Bme68x::intfError(void)
 	return bme6.intf_rslt;
 }
 
+/**
+ * @brief Function to get the number of interface transactions
+ */
+uint32_t Bme68x::getTransactionCount(void)
+{
+	return bme6.intf_transactions;
+}
+
+/**
+ * @brief Function to get the number of bytes on the interface
+ */
+uint32_t Bme68x::getBusBytes(void)
+{
+	return bme6.intf_bytes;
+}
+
+/**
+ * @brief Function to get the interface traffic of the last call that accessed the sensor
+ */
+bme68xBusStats Bme68x::getCallStats(void)
+{
+	bme68xBusStats stats;
+
+	stats.transactions = bme6.intf_transactions - callStart.transactions;
+	stats.bytes = bme6.intf_bytes - callStart.bytes;
+	stats.skippedWrites = bme6.intf_skipped_writes - callStart.skippedWrites;
+
+	return stats;
+}
+
 /**
  * @brief Function to check if an error / warning has occurred
  */
@@ -477,6 +554,54 @@ int8_t Bme68x::checkStatus(void)
 	}
 }
 
+/**
+ * @brief Function to mark the start of a call for getCallStats
+ */
+void Bme68x::startCall(void)
+{
+	callStart.transactions = bme6.intf_transactions;
+	callStart.bytes = bme6.intf_bytes;
+	callStart.skippedWrites = bme6.intf_skipped_writes;
+}
+
+/**
+ * @brief Function to wait for the forced mode measurement started by setOpMode
+ */
+void Bme68x::waitMeasurement(void)
+{
+	uint32_t durUs = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &bme6);
+	uint32_t elapsedUs = micros() - measStartUs;
+	uint32_t maxPolls;
+	uint8_t opMode = BME68X_FORCED_MODE;
+
+	measPending = false;
+	if (heatrConf.enable)
+		durUs += (uint32_t) heatrConf.heatr_dur * 1000;
+
+	switch (waitStrategy)
+	{
+	case BME68X_WAIT_SCHEDULED:
+		if (elapsedUs < durUs)
+			bme6.delay_us(durUs - elapsedUs, bme6.intf_ptr);
+		break;
+	case BME68X_WAIT_POLL:
+		/* The sensor goes back to sleep once the measurement is done. Reading the
+		 * mode leaves the new data flag, which some parts clear on read, to the fetch.
+		 * Give up after twice the expected duration, the driver then reports the missing data */
+		maxPolls = (2 * durUs) / pollUs + 1;
+		while (maxPolls--)
+		{
+			if ((bme68x_get_op_mode(&opMode, &bme6) != BME68X_OK) || (opMode == BME68X_SLEEP_MODE))
+				break;
+
+			bme6.delay_us(pollUs, bme6.intf_ptr);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 /**
  * @brief Function to get a brief text description of the error
  */
@@ -524,6 +649,48 @@ void bme68xDelayUs(uint32_t periodUs, void *intfPtr) {
     delayMicroseconds(periodUs);
 }
 
+/**
+ * @brief Delay callback that yields the whole milliseconds to the scheduler
+ */
+void bme68xYieldDelayUs(uint32_t periodUs, void *intfPtr)
+{
+	(void) intfPtr;
+	if (periodUs >= 1000)
+		delay(periodUs / 1000);
+	delayMicroseconds(periodUs % 1000);
+}
+
+/**
+ * @brief Delay callback that spends the delay in light sleep
+ */
+void bme68xLightSleepDelayUs(uint32_t periodUs, void *intfPtr)
+{
+#ifdef BME68X_LIGHT_SLEEP
+	uint32_t startUs = micros();
+	uint32_t elapsedUs = 0;
+
+	(void) intfPtr;
+
+	/* Other wakeup sources may end the sleep early, sleep again for the rest */
+	while (periodUs - elapsedUs >= BME68X_LIGHT_SLEEP_MIN_US)
+	{
+		esp_sleep_enable_timer_wakeup(periodUs - elapsedUs);
+		if (esp_light_sleep_start() != ESP_OK)
+			break;
+
+		elapsedUs = micros() - startUs;
+		if (elapsedUs >= periodUs)
+			break;
+	}
+	esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+
+	if (elapsedUs < periodUs)
+		delayMicroseconds(periodUs - elapsedUs);
+#else
+	bme68xYieldDelayUs(periodUs, intfPtr);
+#endif
+}
+
 /**
  * @brief Function that implements the default SPI write transaction
  */
@@ -73,6 +73,35 @@ typedef enum   bme68x_intf          bme68xIntf;
 typedef struct bme68x_conf          bme68xConf;
 typedef struct bme68x_heatr_conf    bme68xHeatrConf;
 
+/**
+ * Datatype to hold the interface traffic of a call
+ */
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t skippedWrites;
+} bme68xBusStats;
+
+/**
+ * Ways for fetchData to wait for the end of a forced mode measurement,
+ * the time itself passes in the idle task given to begin
+ */
+typedef enum
+{
+    /*! No wait, the driver polls the new data bit every BME68X_PERIOD_POLL, up to 5 times */
+    BME68X_WAIT_DRIVER,
+    /*! One call of the idle task for the rest of the measurement duration */
+    BME68X_WAIT_SCHEDULED,
+    /*! Polls the operation mode at a given interval until the sensor is back to sleep, with the idle task between polls */
+    BME68X_WAIT_POLL
+} bme68xWaitStrategy;
+
+/* Shortest wait that bme68xLightSleepDelayUs spends in light sleep, shorter ones busy-wait */
+#ifndef BME68X_LIGHT_SLEEP_MIN_US
+#define BME68X_LIGHT_SLEEP_MIN_US   UINT32_C(1000)
+#endif
+
 /**
  * @brief Function that implements the default microsecond delay callback
  * @param periodUs : Duration of the delay in microseconds
@@ -80,6 +109,22 @@ typedef struct bme68x_heatr_conf    bme68xHeatrConf;
  */
 void bme68xDelayUs(uint32_t periodUs, void *intfPtr);
 
+/**
+ * @brief Delay callback that hands the whole milliseconds to the scheduler with delay(),
+ *        which blocks the task on ESP32, and busy-waits the rest
+ * @param periodUs : Duration of the delay in microseconds
+ * @param intfPtr  : Pointer to the interface descriptor
+ */
+void bme68xYieldDelayUs(uint32_t periodUs, void *intfPtr);
+
+/**
+ * @brief Delay callback that spends the delay in light sleep, woken by the timer. Without
+ *        BME68X_LIGHT_SLEEP, defined on ESP32, it behaves as bme68xYieldDelayUs
+ * @param periodUs : Duration of the delay in microseconds
+ * @param intfPtr  : Pointer to the interface descriptor
+ */
+void bme68xLightSleepDelayUs(uint32_t periodUs, void *intfPtr);
+
 /**
  * @brief Function that implements the default SPI write transaction
  * @param regAddr : Register address of the sensor
@@ -284,7 +329,15 @@ public:
     void setHeaterProf(uint16_t *temp, uint16_t *mul, uint16_t sharedHeatrDur, uint8_t profileLen);
 
     /**
-     * @brief Function to fetch data from the sensor into the local buffer
+     * @brief Function to select how fetchData waits for a forced mode measurement
+     * @param strategy : Wait strategy
+     * @param pollUs   : Interval between two polls of BME68X_WAIT_POLL in microseconds
+     */
+    void setWaitStrategy(bme68xWaitStrategy strategy, uint32_t pollUs = BME68X_PERIOD_POLL);
+
+    /**
+     * @brief Function to fetch data from the sensor into the local buffer. In forced mode
+     *        it first waits for the measurement, see setWaitStrategy
      * @return Number of new data fields
      */
     uint8_t fetchData(void);
@@ -319,6 +372,24 @@ public:
      */
     BME68X_INTF_RET_TYPE intfError(void);
 
+    /**
+     * @brief Function to get the number of interface transactions
+     * @return Number of read and write transactions
+     */
+    uint32_t getTransactionCount(void);
+
+    /**
+     * @brief Function to get the number of bytes on the interface
+     * @return Number of register address and data bytes
+     */
+    uint32_t getBusBytes(void);
+
+    /**
+     * @brief Function to get the interface traffic of the last call that accessed the sensor
+     * @return Transactions, bytes and register writes dropped by the register copy
+     */
+    bme68xBusStats getCallStats(void);
+
     /**
      * @brief Function to check if an error / warning has occurred
      * @return -1 if an error occurred, 1 if warning occured else 0
@@ -331,7 +402,17 @@ public:
      */
     String statusString(void);
 
-private:
+protected:
+    /**
+     * @brief Function to mark the start of a call for getCallStats
+     */
+    void startCall(void);
+
+    /**
+     * @brief Function to wait for the forced mode measurement started by setOpMode
+     */
+    void waitMeasurement(void);
+
     /** Datatype to keep consistent with camel casing
      * Datastructure to hold sensor settings
      */
@@ -342,6 +423,11 @@ private:
     bme68xData sensorData[3];
     uint8_t nFields, iFields;
     uint8_t lastOpMode;
+    bme68xBusStats callStart;
+    bme68xWaitStrategy waitStrategy;
+    uint32_t pollUs;
+    uint32_t measStartUs;
+    bool measPending;
 };
 
 #endif /* BME68X_CLASS_H */
@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2021 Bosch Sensortec GmbH. All rights reserved.
+ *
+ * BSD-3-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file    bme68xT.h
+ * @date    17 Oct 2026
+ * @version 1.1.40407
+ *
+ */
+
+#ifndef BME68X_T_H
+#define BME68X_T_H
+
+#include "bme68xLibrary.h"
+#include "bme68xTransport.h"
+
+/**
+ * Bme68x bound at compile time to a transport of bme68xTransport.h.
+ *
+ * readReg and the field burst read of fetchData call the transport directly,
+ * so the access is inlined instead of going through the function pointers of
+ * bme68x_dev. fetchData then compensates the fields with
+ * bme68x_get_field_data. Register writes and reads of the configuration
+ * registers still go through the C API, which keeps the register copy of
+ * bme68x_dev and the SPI memory page up to date. The C API reaches the
+ * transport through static functions of this class.
+ *
+ * The C API keeps a pointer to the transport, so the object must not be
+ * copied or moved after begin().
+ */
+template <typename Transport>
+class Bme68xT : public Bme68x
+{
+public:
+    Bme68xT(const Transport &transport = Transport()) : bus(transport)
+    {
+    }
+
+    /**
+     * @brief Function to initialize the sensor on the transport
+     */
+    void begin(void)
+    {
+        bus.begin();
+        Bme68x::begin(Transport::intf, intfRead, intfWrite, intfDelay, &bus);
+    }
+
+    /**
+     * @brief Function to get the transport
+     * @return Transport the sensor is bound to
+     */
+    Transport &getTransport(void)
+    {
+        return bus;
+    }
+
+    /**
+     * @brief Function to read a register
+     * @param regAddr : Register address
+     * @return Data at that register
+     */
+    uint8_t readReg(uint8_t regAddr)
+    {
+        uint8_t regData = 0;
+        readReg(regAddr, &regData, 1);
+        return regData;
+    }
+
+    /**
+     * @brief Function to read multiple registers
+     * @param regAddr : Start register address
+     * @param regData : Pointer to store the data
+     * @param length  : Number of registers to read
+     */
+    void readReg(uint8_t regAddr, uint8_t *regData, uint32_t length)
+    {
+        uint8_t page = (regAddr > 0x7f) ? BME68X_MEM_PAGE1 : BME68X_MEM_PAGE0;
+
+        /* The register copy and the page switch live in the C API */
+        if (!regData || (length == 0) ||
+            ((regAddr < BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW) && (regAddr + length > BME68X_REG_IDAC_HEAT0)) ||
+            ((Transport::intf == BME68X_SPI_INTF) && (page != bme6.mem_page)))
+        {
+            Bme68x::readReg(regAddr, regData, length);
+            return;
+        }
+
+        startCall();
+        status = busRead(regAddr, regData, length);
+    }
+
+    /**
+     * @brief Function to fetch data from the sensor into the local buffer
+     * @return Number of new data fields
+     */
+    uint8_t fetchData(void)
+    {
+        uint8_t fieldRegs[BME68X_LEN_FIELD * 3];
+        bool forced = (lastOpMode == BME68X_FORCED_MODE);
+        uint32_t length = forced ? BME68X_LEN_FIELD : BME68X_LEN_FIELD * 3;
+        uint8_t tries = forced ? 5 : 1;
+
+        /* The other modes and the page switch live in the C API */
+        if ((!forced && (lastOpMode != BME68X_PARALLEL_MODE) && (lastOpMode != BME68X_SEQUENTIAL_MODE)) ||
+            ((Transport::intf == BME68X_SPI_INTF) && (bme6.mem_page != BME68X_MEM_PAGE0)))
+        {
+            return Bme68x::fetchData();
+        }
+
+        startCall();
+        if (forced && measPending)
+        {
+            waitMeasurement();
+        }
+
+        nFields = 0;
+        iFields = 0;
+        do
+        {
+            /* A forced mode field is polled until the sensor sets its new data bit, as bme68x_get_data does */
+            if ((tries < 5) && forced)
+            {
+                bus.delayUs(BME68X_PERIOD_POLL);
+            }
+            tries--;
+
+            status = busRead(BME68X_REG_FIELD0, fieldRegs, length);
+            if (status == BME68X_OK)
+            {
+                status = bme68x_get_field_data(lastOpMode, fieldRegs, sensorData, &nFields, &bme6);
+            }
+        } while ((status == BME68X_W_NO_NEW_DATA) && tries);
+
+        return nFields;
+    }
+
+private:
+    Transport bus;
+
+    /* Register read on the current SPI memory page or on I2C, with the accounting of the C API */
+    int8_t busRead(uint8_t regAddr, uint8_t *regData, uint32_t length)
+    {
+        if (Transport::intf == BME68X_SPI_INTF)
+        {
+            regAddr |= BME68X_SPI_RD_MSK;
+        }
+
+        bme6.intf_rslt = bus.read(regAddr, regData, length);
+        bme6.intf_transactions++;
+        bme6.intf_bytes += length + 1;
+
+        return (bme6.intf_rslt == 0) ? BME68X_OK : BME68X_E_COM_FAIL;
+    }
+
+    static BME68X_INTF_RET_TYPE intfRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+    {
+        return ((Transport *) intfPtr)->read(regAddr, regData, length);
+    }
+
+    static BME68X_INTF_RET_TYPE intfWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+    {
+        return ((Transport *) intfPtr)->write(regAddr, regData, length);
+    }
+
+    static void intfDelay(uint32_t periodUs, void *intfPtr)
+    {
+        ((Transport *) intfPtr)->delayUs(periodUs);
+    }
+};
+
+#endif /* BME68X_T_H */
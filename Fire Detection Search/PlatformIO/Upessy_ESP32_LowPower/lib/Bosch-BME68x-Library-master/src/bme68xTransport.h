@@ -0,0 +1,245 @@
+/**
+ * Copyright (c) 2021 Bosch Sensortec GmbH. All rights reserved.
+ *
+ * BSD-3-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file    bme68xTransport.h
+ * @date    17 Oct 2026
+ * @version 1.1.40407
+ *
+ */
+
+#ifndef BME68X_TRANSPORT_H
+#define BME68X_TRANSPORT_H
+
+#include <string.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+
+#include "bme68x/bme68x.h"
+
+/*
+ * Transport policies of Bme68xT. A transport provides:
+ *   static const bme68x_intf intf;
+ *   void begin(void);
+ *   int8_t read(uint8_t regAddr, uint8_t *regData, uint32_t length);
+ *   int8_t write(uint8_t regAddr, const uint8_t *regData, uint32_t length);
+ *   void delayUs(uint32_t periodUs);
+ * The register address is the one on the wire, the SPI read and write masks
+ * are already applied. read and write return 0 if successful.
+ */
+
+/**
+ * Transport over the Wire library
+ */
+class Bme68xI2cTransport
+{
+public:
+    static const bme68x_intf intf = BME68X_I2C_INTF;
+
+    Bme68xI2cTransport(uint8_t i2cAddr = BME68X_I2C_ADDR_HIGH, TwoWire &i2c = Wire) : wireobj(&i2c), addr(i2cAddr)
+    {
+    }
+
+    void begin(void)
+    {
+    }
+
+    int8_t read(uint8_t regAddr, uint8_t *regData, uint32_t length)
+    {
+        uint32_t i;
+
+        wireobj->beginTransmission(addr);
+        wireobj->write(regAddr);
+        if (wireobj->endTransmission())
+        {
+            return BME68X_E_COM_FAIL;
+        }
+
+        wireobj->requestFrom((int) addr, (int) length);
+        for (i = 0; (i < length) && wireobj->available(); i++)
+        {
+            regData[i] = wireobj->read();
+        }
+
+        return BME68X_OK;
+    }
+
+    int8_t write(uint8_t regAddr, const uint8_t *regData, uint32_t length)
+    {
+        uint32_t i;
+
+        wireobj->beginTransmission(addr);
+        wireobj->write(regAddr);
+        for (i = 0; i < length; i++)
+        {
+            wireobj->write(regData[i]);
+        }
+
+        return wireobj->endTransmission() ? BME68X_E_COM_FAIL : BME68X_OK;
+    }
+
+    void delayUs(uint32_t periodUs)
+    {
+        delayMicroseconds(periodUs);
+    }
+
+private:
+    TwoWire *wireobj;
+    uint8_t addr;
+};
+
+/**
+ * Transport over the SPI library, with a GPIO as chip select
+ */
+class Bme68xSpiTransport
+{
+public:
+    static const bme68x_intf intf = BME68X_SPI_INTF;
+
+    Bme68xSpiTransport(uint8_t chipSelect, SPIClass &spi = SPI) : spiobj(&spi), cs(chipSelect)
+    {
+    }
+
+    /**
+     * @brief Function to switch the sensor to SPI with a dummy transaction
+     */
+    void begin(void)
+    {
+        pinMode(cs, OUTPUT);
+        digitalWrite(cs, HIGH);
+        delay(1);
+        digitalWrite(cs, LOW);
+        delay(1);
+        digitalWrite(cs, HIGH);
+    }
+
+    int8_t read(uint8_t regAddr, uint8_t *regData, uint32_t length)
+    {
+        digitalWrite(cs, LOW);
+        spiobj->transfer(regAddr);
+        memset(regData, 0xFF, length);
+        spiobj->transfer(regData, length);
+        digitalWrite(cs, HIGH);
+
+        return BME68X_OK;
+    }
+
+    int8_t write(uint8_t regAddr, const uint8_t *regData, uint32_t length)
+    {
+        uint32_t i;
+
+        digitalWrite(cs, LOW);
+        spiobj->transfer(regAddr);
+        for (i = 0; i < length; i++)
+        {
+            spiobj->transfer(regData[i]);
+        }
+        digitalWrite(cs, HIGH);
+
+        return BME68X_OK;
+    }
+
+    void delayUs(uint32_t periodUs)
+    {
+        delayMicroseconds(periodUs);
+    }
+
+private:
+    SPIClass *spiobj;
+    uint8_t cs;
+};
+
+/**
+ * Transport backed by a register map in RAM, for host tests and benchmarks.
+ * It answers with the BME688 chip and variant IDs and counts the transactions
+ */
+class Bme68xMockTransport
+{
+public:
+    static const bme68x_intf intf = BME68X_I2C_INTF;
+
+    Bme68xMockTransport(void) : reads(0), writes(0)
+    {
+        memset(regs, 0, sizeof(regs));
+        regs[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+        regs[BME68X_REG_VARIANT_ID] = BME68X_VARIANT_GAS_HIGH;
+    }
+
+    void begin(void)
+    {
+    }
+
+    int8_t read(uint8_t regAddr, uint8_t *regData, uint32_t length)
+    {
+        uint32_t i;
+
+        for (i = 0; i < length; i++)
+        {
+            regData[i] = regs[(uint8_t)(regAddr + i)];
+        }
+        reads++;
+
+        return BME68X_OK;
+    }
+
+    int8_t write(uint8_t regAddr, const uint8_t *regData, uint32_t length)
+    {
+        uint32_t i;
+
+        /* Burst writes interleave the register addresses with the data, as bme68x_set_regs sends them */
+        regs[regAddr] = regData[0];
+        for (i = 1; i + 1 < length; i += 2)
+        {
+            regs[regData[i]] = regData[i + 1];
+        }
+
+        /* The soft reset command is not a register value */
+        regs[BME68X_REG_SOFT_RESET] = 0;
+        writes++;
+
+        return BME68X_OK;
+    }
+
+    void delayUs(uint32_t periodUs)
+    {
+        (void) periodUs;
+    }
+
+    /*! Register map seen by the driver */
+    uint8_t regs[256];
+
+    /*! Number of read and write transactions */
+    uint32_t reads;
+    uint32_t writes;
+};
+
+#endif /* BME68X_TRANSPORT_H */
@@ -0,0 +1,123 @@
+/*!
+ * @file	ai_prediction_format.h
+ *
+ * @brief	dataBlock rows of the .aipredictions files
+ *
+ * bsecDataLogger formats each BSEC output into one buffer and hands it to the
+ * SD log task in a single write, instead of printing it field by field. The
+ * text is the one the field by field prints gave: integers in decimal, floats
+ * with 2 decimals as Print formats them, null for outputs that are not
+ * subscribed, and "\r\n" where println was used.
+ */
+
+#ifndef AI_PREDICTION_FORMAT_H
+#define AI_PREDICTION_FORMAT_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Longest row with its separator, floats of up to 38 digits included */
+#define AI_PREDICTION_ROW_MAX			UINT16_C(384)
+#define AI_PREDICTION_TARGETS			UINT8_C(4)
+
+/* No IAQ accuracy, the output was not subscribed */
+#define AI_PREDICTION_NO_ACCURACY		UINT8_C(0xFF)
+
+/* End of the JSON document, after the last row or without rows */
+#define AI_PREDICTION_ROWS_END			"\n\t\t]\n\t}\n}\r\n"
+#define AI_PREDICTION_NO_ROWS_END		"\t\t]\r\n\t}\r\n}\r\n"
+
+/*!
+ * @brief : One BSEC output, the columns of a dataBlock row
+ */
+typedef struct
+{
+	uint8_t sensor_num;
+	uint32_t sensor_id;
+	uint32_t start_time_since_power_on;
+	uint32_t end_time_since_power_on;
+
+	/*! class or target estimates, NAN if not subscribed */
+	float prediction[AI_PREDICTION_TARGETS];
+
+	/*! false if no estimate is subscribed, the accuracy is null then */
+	bool has_predictions;
+
+	/*! 2 bits of accuracy per estimate */
+	uint8_t prediction_accuracy;
+
+	/*! NAN if not subscribed */
+	float iaq;
+	uint8_t iaq_accuracy;
+	int32_t code;
+	uint16_t ground_truth;
+} ai_prediction_row;
+
+/*!
+ * @brief : Appends formatted text to a row, the text is cut at AI_PREDICTION_ROW_MAX
+ */
+static inline uint16_t ai_prediction_append(char *buff, uint16_t len, const char *format, ...)
+{
+	va_list args;
+	int n;
+
+	va_start(args, format);
+	n = vsnprintf(buff + len, AI_PREDICTION_ROW_MAX - len, format, args);
+	va_end(args);
+
+	/* vsnprintf returns the length the text would have had */
+	if ((n < 0) || (len + n >= AI_PREDICTION_ROW_MAX))
+	{
+		return AI_PREDICTION_ROW_MAX - 1;
+	}
+	return len + (uint16_t)n;
+}
+
+/*!
+ * @brief : Appends a float with 2 decimals, or null for NAN, and the column separator
+ */
+static inline uint16_t ai_prediction_append_float(char *buff, uint16_t len, float value)
+{
+	return isnan(value) ? ai_prediction_append(buff, len, "null,\n\t\t\t\t")
+						: ai_prediction_append(buff, len, "%.2f,\n\t\t\t\t", (double)value);
+}
+
+/*!
+ * @brief : Appends an accuracy, or null for AI_PREDICTION_NO_ACCURACY, and the column separator
+ */
+static inline uint16_t ai_prediction_append_accuracy(char *buff, uint16_t len, uint8_t accuracy)
+{
+	return (accuracy == AI_PREDICTION_NO_ACCURACY) ? ai_prediction_append(buff, len, "null,\n\t\t\t\t")
+												   : ai_prediction_append(buff, len, "%u,\n\t\t\t\t", (unsigned)accuracy);
+}
+
+/*!
+ * @brief : Formats a dataBlock row
+ *
+ * @param[in] row		: BSEC output to format
+ * @param[in] first		: true for the first row of the file, the others start with the separator
+ * @param[out] buff		: AI_PREDICTION_ROW_MAX bytes, the text is terminated
+ *
+ * @return  length of the text
+ */
+static inline uint16_t ai_prediction_format_row(const ai_prediction_row& row, bool first, char *buff)
+{
+	uint16_t len = ai_prediction_append(buff, 0, "%s\t\t\t[\n\t\t\t\t%u,\n\t\t\t\t%lu,\n\t\t\t\t%lu,\n\t\t\t\t%lu,\n\t\t\t\t",
+										first ? "" : ",\r\n", (unsigned)row.sensor_num, (unsigned long)row.sensor_id,
+										(unsigned long)row.start_time_since_power_on,
+										(unsigned long)row.end_time_since_power_on);
+
+	for (uint8_t i = 0; i < AI_PREDICTION_TARGETS; i++)
+	{
+		len = ai_prediction_append_float(buff, len, row.prediction[i]);
+	}
+	len = row.has_predictions ? ai_prediction_append(buff, len, "%u,\n\t\t\t\t", (unsigned)row.prediction_accuracy)
+							  : ai_prediction_append(buff, len, "null,\n\t\t\t\t");
+	len = ai_prediction_append_float(buff, len, row.iaq);
+	len = ai_prediction_append_accuracy(buff, len, row.iaq_accuracy);
+	return ai_prediction_append(buff, len, "%ld,\n\t\t\t\t%u\r\n\t\t\t]", (long)row.code, (unsigned)row.ground_truth);
+}
+
+#endif
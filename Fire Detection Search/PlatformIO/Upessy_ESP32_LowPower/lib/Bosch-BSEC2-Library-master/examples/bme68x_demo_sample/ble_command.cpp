@@ -0,0 +1,341 @@
+/*!
+ * @file	ble_command.cpp
+ *
+ * @brief	Commands received over BLE, see ble_command.h
+ */
+
+/* own header include */
+#include "ble_command.h"
+
+#include <stdio.h>
+
+const bleCommand::ble_cmd		bleCommand::cmd_list[] = {
+	{"setlabel", &bleCommand::parse_cmd_set_label, bleCommand::SET_LABEL},
+	{"setlabelinfo", &bleCommand::parse_cmd_set_label_info, bleCommand::SET_LABEL_INFO},
+	{"getlabelinfo", &bleCommand::parse_cmd_get_label_info, bleCommand::GET_LABEL_INFO},
+	{"setrtctime", &bleCommand::parse_cmd_set_rtc_time, bleCommand::SET_RTC_TIME},
+	{"getrtctime", &bleCommand::parse_cmd_get_rtc_time, bleCommand::GET_RTC_TIME},
+	{"start", &bleCommand::parse_cmd_start_streaming, bleCommand::START_STREAMING},
+	{"stop", &bleCommand::parse_cmd_stop_streaming, bleCommand::STOP_STREAMING},
+	{"readconfig", &bleCommand::parse_cmd_read_config, bleCommand::READ_CONFIG},
+	{"setappmode", &bleCommand::parse_cmd_set_appmode, bleCommand::SET_APPMODE},
+	{"getappmode", &bleCommand::parse_cmd_get_appmode, bleCommand::GET_APPMODE},
+	{"setgroundtruth", &bleCommand::parse_cmd_set_groundtruth, bleCommand::SET_GROUNDTRUTH},
+	{"getfwversion", &bleCommand::parse_cmd_get_fw_version, bleCommand::GET_FW_VERSION},
+	{"setstreammode", &bleCommand::parse_cmd_set_stream_mode, bleCommand::SET_STREAM_MODE},
+	};
+
+/*!
+ * @brief : This function copies a field into a terminated string, up to max characters or the first zero
+ */
+static void copy_field(char *dest, size_t size, const char *field, size_t len, size_t max)
+{
+	const char *zero = (const char*)memchr(field, '\0', len);
+
+	if (zero != nullptr)
+	{
+		len = zero - field;
+	}
+	memset(dest, 0, size);
+	memcpy(dest, field, (len > max) ? max : len);
+}
+
+/*!
+ * @brief : This function fetches the RTC time which is requested through ble command
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_get_rtc_time(bleCmdReader& reader, ble_msg& msg)
+{
+	return CMD_VALID;
+}
+
+/*!
+ * @brief : This function parses the RTC time received from the ble device and updates
+ *        	the RTC time to the ble structure
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_set_rtc_time(bleCmdReader& reader, ble_msg& msg)
+{
+	uint32_t rtc;
+
+	if (reader.read_uint(rtc))
+	{
+		msg.rtc_time = rtc;
+		return CMD_VALID;
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function updates the received label to the ble structure
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_set_label(bleCmdReader& reader, ble_msg& msg)
+{
+	uint32_t label;
+
+	if (reader.read_uint(label))
+	{
+		msg.label = label;
+		return CMD_VALID;
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function fetches the current label information
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_get_label_info(bleCmdReader& reader, ble_msg& msg)
+{
+	return CMD_VALID;
+}
+
+/*!
+ * @brief : This function updates the received label information to the ble structure
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_set_label_info(bleCmdReader& reader, ble_msg& msg)
+{
+	uint32_t label;
+	const char *lbl_name, *lbl_desc;
+	size_t name_len, desc_len;
+
+	if (reader.read_uint(label))
+	{
+		msg.label_info.label = label;
+
+		/* read label name until comma */
+		if (reader.read_until(',', lbl_name, name_len))
+		{
+			/* the separator after the label */
+			if (name_len)
+			{
+				lbl_name++;
+				name_len--;
+			}
+
+			if (name_len > LABEL_NAME_SIZE)
+			{
+				return MAX_LABEL_NAME_REACHED;
+			}
+			copy_field(msg.label_info.label_name, (LABEL_NAME_SIZE + 1), lbl_name, name_len, (LABEL_NAME_SIZE - 1));
+
+			/* read label description until dot */
+			if (reader.read_until('.', lbl_desc, desc_len))
+			{
+
+				if (desc_len > LABEL_DESC_SIZE)
+				{
+					return MAX_LABEL_DESCRIPTION_REACHED;
+				}
+				copy_field(msg.label_info.label_desc, (LABEL_DESC_SIZE + 1), lbl_desc, desc_len, (LABEL_DESC_SIZE - 1));
+				return CMD_VALID;
+			}
+		}
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function launches sensor data or sensor data and BSEC output streaming through ble
+ *			based on the app mode
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_start_streaming(bleCmdReader& reader, ble_msg& msg)
+{
+	int32_t sensor_num, sample_rate, output_id;
+
+	if (reader.read_int(sensor_num))
+	{
+		msg.bsec.selected_sensor = static_cast<uint8_t>(sensor_num);
+
+		if (reader.read_int(sample_rate))
+		{
+			msg.bsec.sample_rate = static_cast<uint8_t>(sample_rate);
+			msg.bsec.len = 0;
+
+			while ((msg.bsec.len < BSEC_NUMBER_OUTPUTS) && reader.read_int(output_id))
+			{
+				msg.bsec.output_id[msg.bsec.len++] = static_cast<uint8_t>(output_id);
+			}
+
+			if (reader.read_int(output_id))
+			{
+				return BSEC_OUTPUT_EXCESS_ERROR;
+			}
+			return CMD_VALID;
+		}
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function stops ble streaming
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_stop_streaming(bleCmdReader& reader, ble_msg& msg)
+{
+	return CMD_VALID;
+}
+
+/*!
+ * @brief : This function launches the config file data through ble
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_read_config(bleCmdReader& reader, ble_msg& msg)
+{
+	int32_t file_type;
+
+	if (reader.read_int(file_type))
+	{
+		msg.file_type = static_cast<config_file>(file_type);
+		return CMD_VALID;
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function updates the current Appmode
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_set_appmode(bleCmdReader& reader, ble_msg& msg)
+{
+	int32_t mode;
+
+	if (reader.read_int(mode))
+	{
+		msg.mode = static_cast<uint8_t>(mode);
+		return CMD_VALID;
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function retrieves the current Appmode through ble
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_get_appmode(bleCmdReader& reader, ble_msg& msg)
+{
+	return CMD_VALID;
+}
+
+/*!
+ * @brief : This function updates the Groundtruth
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_set_groundtruth(bleCmdReader& reader, ble_msg& msg)
+{
+	int32_t	ground_truth;
+
+	if (reader.read_int(ground_truth))
+	{
+		msg.ground_truth = static_cast<uint32_t>(ground_truth);
+		return CMD_VALID;
+	}
+	return CMD_INVALID;
+}
+
+/*!
+* @brief : This function retrieves the current firmware version through ble
+*/
+bleCommand::cmd_status bleCommand::parse_cmd_get_fw_version(bleCmdReader& reader, ble_msg& msg)
+{
+	return CMD_VALID;
+}
+
+/*!
+ * @brief : This function updates the stream mode to the ble structure
+ */
+bleCommand::cmd_status bleCommand::parse_cmd_set_stream_mode(bleCmdReader& reader, ble_msg& msg)
+{
+	int32_t mode;
+
+	if (reader.read_int(mode))
+	{
+		msg.stream_mode = static_cast<uint8_t>(mode);
+		return CMD_VALID;
+	}
+	return CMD_INVALID;
+}
+
+/*!
+ * @brief : This function parses a command text
+ */
+bool bleCommand::parse(const char *data, size_t len, ble_msg& msg, cmd_status& status, const char *&name,
+					   size_t& name_len)
+{
+	bleCmdReader reader(data, len);
+
+	if (!reader.read_token(name, name_len))
+	{
+		return false;
+	}
+
+	status = CMD_INVALID;
+	for (auto& cmd : cmd_list)
+	{
+
+		if ((strlen(cmd.name) == name_len) && (memcmp(cmd.name, name, name_len) == 0))
+		{
+			status = cmd.parse(reader, msg);
+
+			if (status == CMD_VALID)
+			{
+				msg.name = cmd.name;
+				msg.id = cmd.id;
+			}
+			break;
+		}
+	}
+	return true;
+}
+
+/*!
+ * @brief : This function formats the reply to a command that is not queued
+ */
+uint8_t bleCommand::format_reply(const char *name, size_t name_len, cmd_status status, char *buff)
+{
+	/* Room kept for the closing quote, the status and the brace */
+	const uint8_t name_end = BLE_CMD_REPLY_SIZE - 16;
+	const char *zero = (const char*)memchr(name, '\0', name_len);
+	uint8_t len = 0;
+
+	if (zero != nullptr)
+	{
+		name_len = zero - name;
+	}
+
+	buff[len++] = '{';
+	buff[len++] = '"';
+	for (size_t i = 0; i < name_len; i++)
+	{
+		char c = name[i], esc[7];
+		uint8_t esc_len = 2;
+
+		/* The escapes of a JSON string */
+		switch (c)
+		{
+			case '"':	esc[1] = '"'; break;
+			case '\\':	esc[1] = '\\'; break;
+			case '\b':	esc[1] = 'b'; break;
+			case '\f':	esc[1] = 'f'; break;
+			case '\n':	esc[1] = 'n'; break;
+			case '\r':	esc[1] = 'r'; break;
+			case '\t':	esc[1] = 't'; break;
+			default:
+				if ((uint8_t)c < 0x20)
+				{
+					esc_len = (uint8_t)snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)c);
+				}
+				else
+				{
+					esc[0] = c;
+					esc_len = 1;
+				}
+			break;
+		}
+		if (esc_len == 2)
+		{
+			esc[0] = '\\';
+		}
+
+		if (len + esc_len > name_end)
+		{
+			break;
+		}
+		memcpy(&buff[len], esc, esc_len);
+		len += esc_len;
+	}
+
+	return len + (uint8_t)snprintf(&buff[len], BLE_CMD_REPLY_SIZE - len, "\":%d}", (int)status);
+}
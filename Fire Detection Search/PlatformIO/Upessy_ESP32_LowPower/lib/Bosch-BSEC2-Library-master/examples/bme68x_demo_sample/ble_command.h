@@ -0,0 +1,476 @@
+/*!
+ * @file	ble_command.h
+ *
+ * @brief	Commands received over BLE, parsed and queued without heap allocations
+ *
+ * The command text is read in place from the characteristic value. A
+ * bleCmdReader reads it the way the std::stringstream did before: the
+ * command name and the integers after leading white space, an integer up
+ * to the first character that is not a digit, a field up to a delimiter,
+ * and once a read failed all later reads fail. The parsed messages go from
+ * the BLE task (onWrite) to the loop through a lock-free queue with a
+ * single producer and a single consumer.
+ */
+
+#ifndef BLE_COMMAND_H
+#define BLE_COMMAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#include "label_provider.h"
+#include "demo_app.h"
+
+/* Messages waiting for the loop, a burst of commands from the app fits */
+#define BLE_MSG_QUEUE_LEN			UINT8_C(16)
+/* Reply to a command that is not queued, {"<name>":<status>} */
+#define BLE_CMD_REPLY_SIZE			UINT8_C(96)
+
+/*!
+ * @brief Class reading the tokens of a command text that is not terminated
+ */
+class bleCmdReader
+{
+private:
+	const char *_pos, *_end;
+	bool _failed;
+
+	static bool is_space(char c)
+	{
+		return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+	}
+
+	/*!
+	 * @brief : This function skips the white space, it fails at the end of the text
+	 */
+	bool skip_space()
+	{
+		while ((_pos < _end) && is_space(*_pos))
+		{
+			_pos++;
+		}
+		return fail_if(_pos == _end);
+	}
+
+	bool fail_if(bool failed)
+	{
+		_failed = _failed || failed;
+		return !_failed;
+	}
+
+	/*!
+	 * @brief : This function reads the sign and the digits of an integer
+	 *
+	 * @param[out] negative		: true if a minus sign was read
+	 * @param[out] magnitude	: value without the sign, at most max
+	 */
+	bool read_digits(bool& negative, uint32_t& magnitude, uint32_t max)
+	{
+		uint64_t value = 0;
+		const char *digits;
+
+		if (_failed || !skip_space())
+		{
+			return false;
+		}
+
+		negative = (*_pos == '-');
+		if ((*_pos == '-') || (*_pos == '+'))
+		{
+			_pos++;
+		}
+
+		digits = _pos;
+		while ((_pos < _end) && (*_pos >= '0') && (*_pos <= '9'))
+		{
+			/* The digits are read to the end even past the limit, the value then fails */
+			if (value <= max)
+			{
+				value = value * 10 + (*_pos - '0');
+			}
+			_pos++;
+		}
+		magnitude = (uint32_t)value;
+		return fail_if((_pos == digits) || (value > max));
+	}
+
+public:
+	bleCmdReader(const char *data, size_t len) : _pos(data), _end(data + len), _failed(false)
+	{}
+
+	/*!
+	 * @brief : This function reads a token up to the next white space
+	 *
+	 * @param[out] token	: start of the token in the text
+	 * @param[out] len		: length of the token
+	 */
+	bool read_token(const char *&token, size_t& len)
+	{
+		if (_failed || !skip_space())
+		{
+			return false;
+		}
+
+		token = _pos;
+		while ((_pos < _end) && !is_space(*_pos))
+		{
+			_pos++;
+		}
+		len = _pos - token;
+		return true;
+	}
+
+	/*!
+	 * @brief : This function reads a signed integer
+	 */
+	bool read_int(int32_t& value)
+	{
+		bool negative;
+		uint32_t magnitude;
+
+		if (!read_digits(negative, magnitude, UINT32_C(2147483648)) ||
+			!fail_if(!negative && (magnitude == UINT32_C(2147483648))))
+		{
+			return false;
+		}
+		value = negative ? (int32_t)(0u - magnitude) : (int32_t)magnitude;
+		return true;
+	}
+
+	/*!
+	 * @brief : This function reads an unsigned integer, a negative one wraps around as strtoul does
+	 */
+	bool read_uint(uint32_t& value)
+	{
+		bool negative;
+		uint32_t magnitude;
+
+		if (!read_digits(negative, magnitude, UINT32_MAX))
+		{
+			return false;
+		}
+		value = negative ? (0u - magnitude) : magnitude;
+		return true;
+	}
+
+	/*!
+	 * @brief : This function reads a field up to a delimiter or the end of the text, the delimiter is skipped
+	 *
+	 * @param[in] delim		: delimiter
+	 * @param[out] field	: start of the field in the text
+	 * @param[out] len		: length of the field without the delimiter
+	 */
+	bool read_until(char delim, const char *&field, size_t& len)
+	{
+		const char *found;
+
+		if (_failed || !fail_if(_pos == _end))
+		{
+			return false;
+		}
+
+		field = _pos;
+		found = (const char*)memchr(_pos, delim, _end - _pos);
+		len = (found != nullptr) ? (size_t)(found - _pos) : (size_t)(_end - _pos);
+		_pos += (found != nullptr) ? len + 1 : len;
+		return true;
+	}
+};
+
+/*!
+ * @brief Class holding the BLE commands, their messages and their parsers
+ */
+class bleCommand
+{
+public:
+	/*!
+	 * @brief ble communication status
+	 */
+	enum cmd_status
+	{
+		CMD_VALID,
+		CMD_INVALID,
+		CONTROLLER_QUEUE_FULL,
+		LABEL_INVALID,
+		BSEC_SELECTED_SENSOR_INVALID,
+		BSEC_CONFIG_FILE_ERROR,
+		BSEC_INIT_ERROR,
+		BSEC_SET_CONFIG_ERROR,
+		BSEC_UPDATE_SUBSCRIPTION_ERROR,
+		BSEC_RUN_ERROR,
+		BSEC_OUTPUT_EXCESS_ERROR,
+		SENSOR_CONFIG_MISSING,
+		SENSOR_INITIALIZATION_FAILED,
+		SD_CARD_INIT_ERROR,
+		CONFIG_FILE_ERROR,
+		APP_ALREADY_IN_STREAMING_MODE,
+		SENSOR_READ_ERROR,
+		BSEC_CONFIG_FILE_MISSING,
+		AI_CONFIG_FILE_MISSING,
+		LABEL_INFO_FILE_MISSING,
+		INVALID_APP_MODE,
+		LABEL_FILE_OPEN_FAILED,
+		MAX_LABEL_NAME_REACHED,
+		MAX_LABEL_DESCRIPTION_REACHED,
+		FILE_OPEN_ERROR,
+		DESERIALIZATION_FAILED,
+		LABEL_NOT_FOUND,
+		AI_CONFIG_AND_SUBSCRIPTION_MISSMATCH,
+		STREAM_MTU_TOO_SMALL
+	};
+
+	/*!
+	 * @brief bsec sample rate enumeration
+	 */
+	enum bsec_sample_rate
+	{
+		ULP,
+		LP,
+		HP
+	};
+
+	/*!
+	 * @brief config file type enumeration
+	 */
+	enum config_file
+	{
+		BMECONFIG,
+		AICONFIG
+	};
+
+	/*!
+	 * @brief bluetooth message id enumeration
+	 */
+	enum ble_msg_id
+	{
+		GET_LABEL_INFO,
+		SET_LABEL_INFO,
+		SET_LABEL,
+		GET_RTC_TIME,
+		SET_RTC_TIME,
+		START_STREAMING,
+		STOP_STREAMING,
+		READ_CONFIG,
+		SET_APPMODE,
+		GET_APPMODE,
+		SET_GROUNDTRUTH,
+		GET_FW_VERSION,
+		SET_STREAM_MODE
+	};
+
+	/*!
+	 * @brief bluetooth bsec message
+	 */
+	struct ble_bsec_msg
+	{
+		uint8_t	 	selected_sensor;
+		uint8_t		sample_rate;
+		uint8_t		len;
+		uint8_t	 	output_id[BSEC_NUMBER_OUTPUTS];
+	};
+
+	/*!
+	 * @brief label information
+	 */
+	struct ble_label_info
+	{
+		uint32_t	 	label;
+		char label_name[LABEL_NAME_SIZE + 1];
+		char label_desc[LABEL_DESC_SIZE + 1];
+	};
+
+	/*!
+	 * @brief bluetooth message structure
+	 */
+	struct ble_msg
+	{
+		const char *name;
+		ble_msg_id id;
+		union
+		{
+			ble_bsec_msg	bsec;
+			uint32_t	 	label;
+			uint32_t		rtc_time;
+			config_file		file_type;
+			uint8_t			mode;
+			uint8_t			stream_mode;
+			ble_label_info 	label_info;
+			uint32_t		ground_truth;
+		};
+	};
+
+	/*!
+	 * @brief bluetooth command structure
+	 */
+	struct ble_cmd
+	{
+		const char *name;
+		cmd_status (*parse)(bleCmdReader& reader, ble_msg& msg);
+		ble_msg_id id;
+	};
+
+	/*!
+	 * @brief : This function parses a command text
+	 *
+	 * @param[in] data		: command text, it needs no terminating zero
+	 * @param[in] len		: length of the text
+	 * @param[out] msg		: message of the command, complete if the status is CMD_VALID
+	 * @param[out] status	: CMD_VALID or the error of the command
+	 * @param[out] name		: command name as received, for the reply
+	 * @param[out] name_len	: length of the command name
+	 *
+	 * @return false if the text holds no command name, no reply is due then
+	 */
+	static bool parse(const char *data, size_t len, ble_msg& msg, cmd_status& status, const char *&name,
+					  size_t& name_len);
+
+	/*!
+	 * @brief : This function formats the reply to a command that is not queued, {"<name>":<status>}
+	 *
+	 * @param[in] name		: command name as received, it ends at the first zero as the JSON key did
+	 * @param[in] name_len	: length of the command name
+	 * @param[in] status	: error of the command
+	 * @param[out] buff		: BLE_CMD_REPLY_SIZE bytes, a name too long for it is cut
+	 *
+	 * @return length of the reply
+	 */
+	static uint8_t format_reply(const char *name, size_t name_len, cmd_status status, char *buff);
+
+private:
+	static const ble_cmd			cmd_list[];
+
+	/*!
+	 * @brief : This function fetches the RTC time which is requested through ble command
+	 */
+	static cmd_status parse_cmd_get_rtc_time(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function parses the RTC time received from the ble device and updates
+	 *        	the RTC time to the ble structure
+	 */
+	static cmd_status parse_cmd_set_rtc_time(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function fetches the current label information from the .bmelabelinfo file
+	 */
+	static cmd_status parse_cmd_get_label_info(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function updates the received label information to the ble structure
+	 */
+	static cmd_status parse_cmd_set_label_info(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function updates the received label to the ble structure
+	 */
+	static cmd_status parse_cmd_set_label(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function launches sensor data or sensor data and BSEC output streaming through ble
+	 *			based on the app mode
+	 */
+	static cmd_status parse_cmd_start_streaming(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function stops ble streaming
+	 */
+	static cmd_status parse_cmd_stop_streaming(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function launches the config file data through ble
+	 */
+	static cmd_status parse_cmd_read_config(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function updates the current Appmode
+	 */
+	static cmd_status parse_cmd_set_appmode(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function retrieves the current Appmode through ble
+	 */
+	static cmd_status parse_cmd_get_appmode(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function updates the Groundtruth through ble
+	 */
+	static cmd_status parse_cmd_set_groundtruth(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function retrieves the current firmware version through ble
+	 */
+	static cmd_status parse_cmd_get_fw_version(bleCmdReader& reader, ble_msg& msg);
+
+	/*!
+	 * @brief : This function updates the stream mode to the ble structure
+	 */
+	static cmd_status parse_cmd_set_stream_mode(bleCmdReader& reader, ble_msg& msg);
+};
+
+/*!
+ * @brief Class queuing the messages from one producer task to one consumer task without a lock,
+ *		  the producer only moves the head and the consumer only the tail
+ */
+template <uint8_t DEPTH>
+class bleMsgQueue
+{
+private:
+	/* One slot stays free to tell a full queue from an empty one */
+	bleCommand::ble_msg				_msgs[DEPTH + 1];
+	std::atomic<uint8_t>			_head, _tail;
+	std::atomic<uint32_t>			_dropped;
+
+public:
+	bleMsgQueue() : _head(0), _tail(0), _dropped(0)
+	{}
+
+	/*!
+	 * @brief : This function queues a message, from the producer
+	 *
+	 * @return false if the queue is full, the message is dropped
+	 */
+	bool push(const bleCommand::ble_msg& msg)
+	{
+		uint8_t head = _head.load(std::memory_order_relaxed);
+		uint8_t next = (head == DEPTH) ? 0 : head + 1;
+
+		if (next == _tail.load(std::memory_order_acquire))
+		{
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		_msgs[head] = msg;
+		_head.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/*!
+	 * @brief : This function takes the oldest message, from the consumer
+	 *
+	 * @return false if the queue is empty
+	 */
+	bool pop(bleCommand::ble_msg& msg)
+	{
+		uint8_t tail = _tail.load(std::memory_order_relaxed);
+
+		if (tail == _head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		msg = _msgs[tail];
+		_tail.store((tail == DEPTH) ? 0 : tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*!
+	 * @brief : This function gets the number of messages dropped because the queue was full
+	 */
+	uint32_t get_dropped()
+	{
+		return _dropped.load(std::memory_order_relaxed);
+	}
+};
+
+#endif
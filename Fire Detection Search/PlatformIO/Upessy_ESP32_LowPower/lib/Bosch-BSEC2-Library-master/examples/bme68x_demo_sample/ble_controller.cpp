@@ -42,24 +42,75 @@
 /* own header include */
 #include "ble_controller.h"
 
-bleController::ble_cmd		bleController::cmd_list[] = {
-    {"setlabel", &bleController::parse_cmd_set_label, bleController::SET_LABEL},
-  	{"setlabelinfo", &bleController::parse_cmd_set_label_info, bleController::SET_LABEL_INFO},
-  	{"getlabelinfo", &bleController::parse_cmd_get_label_info, bleController::GET_LABEL_INFO},
-  	{"setrtctime", &bleController::parse_cmd_set_rtc_time, bleController::SET_RTC_TIME},
-  	{"getrtctime", &bleController::parse_cmd_get_rtc_time, bleController::GET_RTC_TIME},
-  	{"start", &bleController::parse_cmd_start_streaming, bleController::START_STREAMING},
-  	{"stop", &bleController::parse_cmd_stop_streaming, bleController::STOP_STREAMING},
-  	{"readconfig", &bleController::parse_cmd_read_config, bleController::READ_CONFIG},
-  	{"setappmode", &bleController::parse_cmd_set_appmode, bleController::SET_APPMODE},
-  	{"getappmode", &bleController::parse_cmd_get_appmode, bleController::GET_APPMODE},
-  	{"setgroundtruth", &bleController::parse_cmd_set_groundtruth, bleController::SET_GROUNDTRUTH},
-  	{"getfwversion", &bleController::parse_cmd_get_fw_version, bleController::GET_FW_VERSION},
-	};
-
-QueueHandle_t 			bleController::msg_queue = nullptr; 
+bleMsgQueue<BLE_MSG_QUEUE_LEN>	bleController::msg_queue;
+StaticJsonDocument<BLE_JSON_DOC_SIZE>	bleController::response_doc;
 BLECharacteristic		*bleController::ble_char_tx = nullptr, *bleController::ble_char_rx = nullptr;
 BLEServer 				*bleController::pServer = nullptr;
+bleStreamQueue			bleController::stream_queue;
+SemaphoreHandle_t		bleController::stream_lock = nullptr;
+SemaphoreHandle_t		bleController::tx_lock = nullptr;
+volatile bleController::stream_mode	bleController::cur_stream_mode = bleController::STREAM_JSON;
+volatile uint16_t		bleController::link_mtu = BLE_DEFAULT_MTU_SIZE;
+volatile uint16_t		bleController::conn_interval_ms = BLE_DEFAULT_CONN_INTERVAL_MS;
+uint8_t					bleController::stream_buff[BLE_STREAM_FRAME_MAX];
+
+/*!
+ * @brief Print sink that cuts a serialized JSON document into notifications of the payload size,
+ *		  the document is not held in memory as a whole
+ */
+class notificationWriter : public Print
+{
+public:
+	notificationWriter(BLECharacteristic *characteristic, uint16_t payload_size) :
+		_characteristic(characteristic), _payload_size(payload_size), _len(0)
+	{}
+
+	size_t write(uint8_t c) override
+	{
+		return write(&c, 1);
+	}
+
+	size_t write(const uint8_t *buffer, size_t size) override
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			_buff[_len++] = buffer[i];
+
+			if (_len == _payload_size)
+			{
+				flush();
+			}
+		}
+		return size;
+	}
+
+	void flush() override
+	{
+		if (_len)
+		{
+			_characteristic->setValue(_buff, _len);
+			_characteristic->notify();
+			_len = 0;
+		}
+	}
+
+private:
+	BLECharacteristic	*_characteristic;
+	uint16_t			_payload_size;
+	uint16_t			_len;
+	uint8_t				_buff[BLE_MAX_MTU_SIZE - BLE_NOTIF_HEADER_SIZE];
+};
+
+/*!
+ * @brief Function to follow the connection parameter updates of the central
+ */
+static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
+{
+	if (event == ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT)
+	{
+		bleController::set_conn_interval(param->update_conn_params.conn_int);
+	}
+}
 
 /*!
  * @brief bleController class Constructor
@@ -74,10 +125,14 @@ demo_ret_code bleController::begin()
 {
 	demo_ret_code ret_code = EDK_OK;
 	
-	msg_queue = xQueueCreate(BLE_MSG_QUEUE_LEN, sizeof(ble_msg));
+	stream_lock = xSemaphoreCreateMutex();
+	tx_lock = xSemaphoreCreateMutex();
 
 	/* Initialize BLE with Device name */
 	BLEDevice::init("BME688 Development Kit");
+	/* The MTU the central may negotiate, the notifications are cut to the negotiated one */
+	BLEDevice::setMTU(BLE_MAX_MTU_SIZE);
+	BLEDevice::setCustomGapHandler(gap_event_handler);
 	/* Create Server */
 	pServer = BLEDevice::createServer();
 	pServer->setCallbacks(new serverCallbacks());
@@ -105,305 +160,235 @@ demo_ret_code bleController::begin()
 }
 
 /*!
- * @brief : This function fetches the RTC time which is requested through ble command
+ * @brief function gets called when data is received from a bluetooth device.
+ * 		  It will read in the sent bluetooth command
  */
-bleController::cmd_status bleController::parse_cmd_get_rtc_time(std::stringstream& ss, ble_msg& msg)
+void bleController::onWrite(BLECharacteristic *pCharacteristic)
 {
-	return CMD_VALID;
+	const char *cmd_name;
+	size_t name_len;
+	cmd_status status;
+	ble_msg msg;
+
+	/* The command is read in place from the value of the characteristic */
+	if (parse((const char*)pCharacteristic->getData(), pCharacteristic->getLength(), msg, status, cmd_name, name_len))
+	{
+		char reply[BLE_CMD_REPLY_SIZE];
+		notificationWriter writer(ble_char_tx, get_payload_size());
+
+		if (status == CMD_VALID)
+		{
+
+			if (msg_queue.push(msg))
+			{
+				return;
+			}
+			status = CONTROLLER_QUEUE_FULL;
+		}
+
+		uint8_t len = format_reply(cmd_name, name_len, status, reply);
+
+		xSemaphoreTake(tx_lock, portMAX_DELAY);
+		writer.write((const uint8_t*)reply, len);
+		writer.flush();
+		xSemaphoreGive(tx_lock);
+	}
 }
 
 /*!
- * @brief : This function parses the RTC time received from the ble device and updates
- *        	the RTC time to the ble structure
+ * @brief : This function checks the ble connection status, restarts advertising if disconnected
  */
-bleController::cmd_status bleController::parse_cmd_set_rtc_time(std::stringstream& ss, ble_msg& msg)
+void bleController::check_ble_connection_sts()
 {
-	uint32_t rtc;
-
-	if (ss >> rtc)
+	/* disconnecting */
+  if (!device_connected && old_device_connected)
+	{
+    pServer->startAdvertising(); /* restart advertising, when ble is disconnected */
+    old_device_connected = device_connected;
+  }
+  /* connecting */
+  if (device_connected && !old_device_connected)
 	{
-		msg.rtc_time = rtc;
-		return CMD_VALID;
+    old_device_connected = device_connected;
 	}
-	return CMD_INVALID;
 }
 
-/*!
- * @brief : This function updates the received label to the ble structure
+/**
+ * @brief function dequeues the last received ble message. The ble callBack is
+ * 		  called if a new message is available.
  */
-bleController::cmd_status bleController::parse_cmd_set_label(std::stringstream& ss, ble_msg& msg)
+bool bleController::dequeue_ble_msg(void)
 {
-	uint32_t label;
+	ble_msg msg;
 
-	if (ss >> label)
+	if (msg_queue.pop(msg))
 	{
-		msg.label = label;
-		return CMD_VALID;
+
+		if (_callBack != nullptr)
+		{
+			response_doc.clear();
+			_callBack(msg, response_doc);
+		
+			send_notification(response_doc);
+		}		
+		return true;
 	}
-	return CMD_INVALID;
+	return false;
 }
 
 /*!
- * @brief : This function fetches the current label information
+ * @brief function to send a json formatted notification
  */
-bleController::cmd_status bleController::parse_cmd_get_label_info(std::stringstream& ss, ble_msg& msg)
+void bleController::send_notification(JsonDocument& jsonDoc)
 {
-	return CMD_VALID;
+	notificationWriter writer(ble_char_tx, get_payload_size());
+
+	/* One document at a time, its chunks follow each other on the link */
+	xSemaphoreTake(tx_lock, portMAX_DELAY);
+	serializeJson(jsonDoc, writer);
+	writer.flush();
+	xSemaphoreGive(tx_lock);
 }
 
 /*!
- * @brief : This function updates the received label information to the ble structure
+ * @brief function to set the format of the streamed data
  */
-bleController::cmd_status bleController::parse_cmd_set_label_info(std::stringstream& ss, ble_msg& msg)
+bool bleController::set_stream_mode(stream_mode mode)
 {
-	uint32_t label;
-	std::string lbl_name, lbl_desc;
-
-	if (ss >> label)
+	if ((mode == STREAM_BINARY) && (get_payload_size() < BLE_STREAM_MIN_PAYLOAD))
 	{
-		msg.label_info.label = label;
-
-		/* read label name until comma */
-		if (std::getline(ss, lbl_name, ','))
-		{
-			lbl_name.erase(lbl_name.begin());
-
-			if (lbl_name.length() > LABEL_NAME_SIZE)
-			{
-				return MAX_LABEL_NAME_REACHED;
-			}
-			memset(msg.label_info.label_name, 0, (LABEL_NAME_SIZE + 1));
-			strncpy(msg.label_info.label_name, lbl_name.c_str(), (LABEL_NAME_SIZE - 1));
-
-			/* read label description until dot */
-			if(std::getline(ss, lbl_desc, '.'))
-			{
-
-				if (lbl_desc.length() > LABEL_DESC_SIZE)
-				{
-					return MAX_LABEL_DESCRIPTION_REACHED;
-				}
-				memset(msg.label_info.label_desc, 0, (LABEL_DESC_SIZE + 1));
-				strncpy(msg.label_info.label_desc, lbl_desc.c_str(), (LABEL_DESC_SIZE - 1));
-				return CMD_VALID;
-			}
-		}
+		return false;
 	}
-	return CMD_INVALID;
+
+	cur_stream_mode = mode;
+	reset_stream();
+	return true;
 }
 
 /*!
- * @brief : This function launches sensor data or sensor data and BSEC output streaming through ble
- *			based on the app mode
+ * @brief function to get the format of the streamed data
  */
-bleController::cmd_status bleController::parse_cmd_start_streaming(std::stringstream& ss, ble_msg& msg)
+bleController::stream_mode bleController::get_stream_mode()
 {
-	int32_t sensor_num, sample_rate, output_id;
-
-	if (ss >> sensor_num)
-	{
-		msg.bsec.selected_sensor = static_cast<uint8_t>(sensor_num);
-
-		if (ss >> sample_rate)
-		{
-			msg.bsec.sample_rate = static_cast<uint8_t>(sample_rate);
-			msg.bsec.len = 0;
-			
-			while ((msg.bsec.len < BSEC_NUMBER_OUTPUTS) && (ss >> output_id))
-			{
-				msg.bsec.output_id[msg.bsec.len++] = static_cast<uint8_t>(output_id);
-			}
-			
-			if (ss >> output_id)
-			{
-				return BSEC_OUTPUT_EXCESS_ERROR;
-			}	
-			return CMD_VALID;
-		}
-	}
-  return CMD_INVALID;
+	return cur_stream_mode;
 }
 
 /*!
- * @brief : This function stops ble streaming
+ * @brief function to restart the binary stream
  */
-bleController::cmd_status bleController::parse_cmd_stop_streaming(std::stringstream& ss, ble_msg& msg)
+void bleController::reset_stream()
 {
-	return CMD_VALID;
+	xSemaphoreTake(stream_lock, portMAX_DELAY);
+	stream_queue.reset();
+	xSemaphoreGive(stream_lock);
 }
 
 /*!
- * @brief : This function launches the config file data through ble
+ * @brief function to add the bme68x data to the binary stream
  */
-bleController::cmd_status bleController::parse_cmd_read_config(std::stringstream& ss, ble_msg& msg)
+bool bleController::stream_bme68x_data(const bme68x_data& data, uint8_t sens_num)
 {
-	int32_t file_type;
-
-	if (ss >> file_type)
+	if (!check_stream_payload())
 	{
-		msg.file_type = static_cast<config_file>(file_type);
-		return CMD_VALID;
+		return false;
 	}
-	return CMD_INVALID;
+
+	xSemaphoreTake(stream_lock, portMAX_DELAY);
+	stream_queue.set_payload_size(get_payload_size());
+	stream_queue.add_bme68x(sens_num, data.gas_index, data.temperature, data.pressure, data.humidity,
+							data.gas_resistance);
+	xSemaphoreGive(stream_lock);
+	return true;
 }
 
 /*!
- * @brief : This function updates the current Appmode
+ * @brief function to add the BSEC outputs to the binary stream
  */
-bleController::cmd_status bleController::parse_cmd_set_appmode(std::stringstream& ss, ble_msg& msg)
+bool bleController::stream_bsec_output(const bsecOutputs& outputs, uint8_t sens_num)
 {
-	int32_t mode;
+	if (!check_stream_payload())
+	{
+		return false;
+	}
+
+	xSemaphoreTake(stream_lock, portMAX_DELAY);
+	stream_queue.set_payload_size(get_payload_size());
 
-	if (ss >> mode)
+	for (uint8_t i = 0; i < outputs.nOutputs; i++)
 	{
-		msg.mode = static_cast<uint8_t>(mode);
-		return CMD_VALID;
+		const bsec_output_t& output = outputs.output[i];
+
+		stream_queue.add_bsec(sens_num, output.sensor_id, output.accuracy, output.signal);
 	}
-	return CMD_INVALID;
+	xSemaphoreGive(stream_lock);
+	return true;
 }
 
 /*!
- * @brief : This function retrieves the current Appmode through ble
+ * @brief function to send the next frame of the binary stream, at most one per connection interval
  */
-bleController::cmd_status bleController::parse_cmd_get_appmode(std::stringstream& ss, ble_msg& msg)
+void bleController::send_stream()
 {
-	return CMD_VALID;
-}
+	uint16_t len;
 
+	if (cur_stream_mode != STREAM_BINARY)
+	{
+		return;
+	}
 
-/*!
- * @brief : This function updates the Groundtruth
- */
-bleController::cmd_status bleController::parse_cmd_set_groundtruth(std::stringstream& ss, ble_msg& msg)
-{
-	int32_t	ground_truth;
+	xSemaphoreTake(stream_lock, portMAX_DELAY);
+	len = stream_queue.take_frame(millis(), conn_interval_ms, stream_buff);
+	xSemaphoreGive(stream_lock);
 
-	if (ss >> ground_truth)
+	/* Frames taken while no central listens are lost, the sequence numbers show it */
+	if (len && device_connected)
 	{
-		msg.ground_truth = static_cast<uint32_t>(ground_truth);
-		return CMD_VALID;
+		xSemaphoreTake(tx_lock, portMAX_DELAY);
+		ble_char_tx->setValue(stream_buff, len);
+		ble_char_tx->notify();
+		xSemaphoreGive(tx_lock);
 	}
-	return CMD_INVALID;
-}
-
-/*!
-* @brief : This function retrieves the current firmware version through ble
-*/
-bleController::cmd_status bleController::parse_cmd_get_fw_version(std::stringstream& ss, ble_msg& msg)
-{
-	return CMD_VALID;
 }
 
 /*!
- * @brief function gets called when data is received from a bluetooth device.
- * 		  It will read in the sent bluetooth command
+ * @brief function to get the payload size of a notification
  */
-void bleController::onWrite(BLECharacteristic *pCharacteristic)
+uint16_t bleController::get_payload_size()
 {
-	std::string rx_value = pCharacteristic->getValue(), cmd_name;
-	std::stringstream ss(rx_value);
-	cmd_status status = CMD_INVALID;
-	ble_msg msg;
-	
-	if (ss >> cmd_name)
-	{
-		StaticJsonDocument<BLE_JSON_DOC_SIZE> jsonDoc;
-		
-		for (auto& cmd : cmd_list)
-		{
+	uint16_t mtu = link_mtu;
 
-			if (cmd_name == cmd.name)
-			{
-				status = cmd.parse(ss, msg);
-
-				if (status == CMD_VALID)
-				{
-					msg.name = cmd.name;
-					msg.id = cmd.id;
-					
-					if (xQueueSendFromISR(msg_queue, (const void*)&msg, 0) == pdPASS)
-					{
-						return;
-					}
-					else
-					{
-						status = CONTROLLER_QUEUE_FULL;
-					}
-				}
-				break;
-			}
-		}
-		
-		jsonDoc[cmd_name.c_str()] = status;
-		send_notification(jsonDoc);
-	}
+	return ((mtu > BLE_MAX_MTU_SIZE) ? BLE_MAX_MTU_SIZE : mtu) - BLE_NOTIF_HEADER_SIZE;
 }
 
 /*!
- * @brief : This function checks the ble connection status, restarts advertising if disconnected
+ * @brief function to update the ATT MTU of the link
  */
-void bleController::check_ble_connection_sts()
+void bleController::set_link_mtu(uint16_t mtu)
 {
-	/* disconnecting */
-  if (!device_connected && old_device_connected)
-	{
-    pServer->startAdvertising(); /* restart advertising, when ble is disconnected */
-    old_device_connected = device_connected;
-  }
-  /* connecting */
-  if (device_connected && !old_device_connected)
-	{
-    old_device_connected = device_connected;
-	}
+	link_mtu = (mtu < BLE_DEFAULT_MTU_SIZE) ? BLE_DEFAULT_MTU_SIZE : mtu;
+	(void) check_stream_payload();
 }
 
-/**
- * @brief function dequeues the last received ble message. The ble callBack is
- * 		  called if a new message is available.
+/*!
+ * @brief function to fall back to the JSON stream once the binary frames no longer fit the link
  */
-bool bleController::dequeue_ble_msg(void)
+bool bleController::check_stream_payload()
 {
-	ble_msg msg;
-
-	if (xQueueReceive(msg_queue, &msg, 0) == pdPASS)
+	if ((cur_stream_mode == STREAM_BINARY) && (get_payload_size() < BLE_STREAM_MIN_PAYLOAD))
 	{
-		StaticJsonDocument<BLE_JSON_DOC_SIZE> jsonDoc;
-
-		if (_callBack != nullptr)
-		{
-			_callBack(msg, jsonDoc);
-		
-			send_notification(jsonDoc);
-		}		
-		return true;
+		cur_stream_mode = STREAM_JSON;
 	}
-	return false;
+
+	return (cur_stream_mode == STREAM_BINARY);
 }
 
 /*!
- * @brief function to send a json formatted notification
+ * @brief function to update the connection interval of the link
  */
-void bleController::send_notification(JsonDocument& jsonDoc)
+void bleController::set_conn_interval(uint16_t interval)
 {
-	String notif, msg;
-	
-	serializeJson(jsonDoc, notif);
-	
-	size_t not_len = notif.length(), begin_msg = 0, end_msg = BLE_CONTROLLER_NOTIF_SIZE;
+	/* 1.25 ms units, rounded up */
+	uint16_t interval_ms = (interval * 5 + 3) / 4;
 
-	while (begin_msg < not_len)
-	{
-
-		if (end_msg > not_len)
-		{
-			end_msg = not_len;
-		}
-		msg = notif.substring(begin_msg, end_msg);
-		
-		begin_msg += BLE_CONTROLLER_NOTIF_SIZE;
-		end_msg += BLE_CONTROLLER_NOTIF_SIZE;
-		
-		ble_char_tx->setValue((const char*)msg.c_str());
-		ble_char_tx->notify();
-	}
+	conn_interval_ms = interval_ms ? interval_ms : BLE_DEFAULT_CONN_INTERVAL_MS;
 }
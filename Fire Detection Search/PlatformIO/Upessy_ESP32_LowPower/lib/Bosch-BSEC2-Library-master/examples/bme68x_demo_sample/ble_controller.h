@@ -46,7 +46,6 @@
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
-#include <sstream>
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
@@ -55,15 +54,20 @@
 #include <ArduinoJson.h>
 #include "label_provider.h"
 #include "demo_app.h"
+#include "ble_stream_format.h"
+#include "ble_command.h"
 
 /* Bluetooth UART UUID's */
 #define SERVICE_UUID           		"6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
 #define CHARACTERISTIC_UUID_RX 		"6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
 #define CHARACTERISTIC_UUID_TX 		"6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
-#define BLE_MSG_QUEUE_LEN			UINT8_C(3)
 #define BLE_JSON_DOC_SIZE			UINT16_C(2048)
-#define BLE_CONTROLLER_NOTIF_SIZE	UINT16_C(600)
 #define BLE_MAX_MTU_SIZE			UINT16_C(512)
+#define BLE_DEFAULT_MTU_SIZE		UINT16_C(23)
+/* Bytes of a notification that are not payload */
+#define BLE_NOTIF_HEADER_SIZE		UINT8_C(3)
+/* Connection interval assumed until the link reports it */
+#define BLE_DEFAULT_CONN_INTERVAL_MS	UINT8_C(30)
 
 static bool device_connected = false;
 static bool old_device_connected = false;
@@ -71,131 +75,16 @@ static bool old_device_connected = false;
 /*!
  * @brief Class library for the ble controller
  */
-class bleController: public BLECharacteristicCallbacks
+class bleController: public BLECharacteristicCallbacks, public bleCommand
 {
 public:
 	/*!
-	 * @brief ble communication status
+	 * @brief format of the streamed sensor data and BSEC outputs
 	 */
-	enum cmd_status
+	enum stream_mode
 	{
-		CMD_VALID,
-		CMD_INVALID,
-		CONTROLLER_QUEUE_FULL,
-		LABEL_INVALID,
-		BSEC_SELECTED_SENSOR_INVALID,
-		BSEC_CONFIG_FILE_ERROR,
-		BSEC_INIT_ERROR,
-		BSEC_SET_CONFIG_ERROR,
-		BSEC_UPDATE_SUBSCRIPTION_ERROR,
-		BSEC_RUN_ERROR,
-		BSEC_OUTPUT_EXCESS_ERROR,
-		SENSOR_CONFIG_MISSING,
-		SENSOR_INITIALIZATION_FAILED,
-		SD_CARD_INIT_ERROR,
-		CONFIG_FILE_ERROR,
-		APP_ALREADY_IN_STREAMING_MODE,
-		SENSOR_READ_ERROR,
-		BSEC_CONFIG_FILE_MISSING,
-		AI_CONFIG_FILE_MISSING,
-		LABEL_INFO_FILE_MISSING,
-		INVALID_APP_MODE,
-		LABEL_FILE_OPEN_FAILED,
-		MAX_LABEL_NAME_REACHED,
-		MAX_LABEL_DESCRIPTION_REACHED,
-		FILE_OPEN_ERROR,
-		DESERIALIZATION_FAILED,
-		LABEL_NOT_FOUND,
-		AI_CONFIG_AND_SUBSCRIPTION_MISSMATCH
-	};
-	
-	/*!
-	 * @brief bsec sample rate enumeration
-	 */
-	enum bsec_sample_rate
-	{
-		ULP,
-		LP,
-		HP
-	};
-
-	/*!
-	 * @brief config file type enumeration
-	 */
-	enum config_file
-	{
-		BMECONFIG,
-		AICONFIG
-	};
-
-	/*!
-	 * @brief bluetooth message id enumeration
-	 */
-	enum ble_msg_id
-	{
-		GET_LABEL_INFO,
-		SET_LABEL_INFO,
-		SET_LABEL,
-		GET_RTC_TIME,
-		SET_RTC_TIME,
-		START_STREAMING,
-		STOP_STREAMING,
-		READ_CONFIG,
-		SET_APPMODE,
-		GET_APPMODE,
-		SET_GROUNDTRUTH,
-		GET_FW_VERSION
-	};
-	
-	/*!
-	 * @brief bluetooth bsec message
-	 */
-	struct ble_bsec_msg
-	{
-		uint8_t	 	selected_sensor;
-		uint8_t		sample_rate;
-		uint8_t		len;
-		uint8_t	 	output_id[BSEC_NUMBER_OUTPUTS];
-	};
-	
-	/*!
-	 * @brief label information
-	 */
-	struct ble_label_info
-	{
-		uint32_t	 	label;
-		char label_name[LABEL_NAME_SIZE + 1];
-		char label_desc[LABEL_DESC_SIZE + 1];
-	};
-	
-	
-	/*!
-	 * @brief bluetooth message structure
-	 */
-	struct ble_msg
-	{
-		const char *name;
-		ble_msg_id id;
-		union
-		{
-			ble_bsec_msg	bsec;
-			uint32_t	 	label;
-			uint32_t		rtc_time;
-			config_file		file_type;
-			uint8_t			mode;
-			ble_label_info 	label_info;
-			uint32_t		ground_truth;
-		};
-	};
-	
-	/*!
-	 * @brief bluetooth command structure
-	 */
-	struct ble_cmd
-	{
-		const char *name;
-		cmd_status (*parse)(std::stringstream& ss, ble_msg& msg);
-		ble_msg_id id;
+		STREAM_JSON,
+		STREAM_BINARY
 	};
 	
 	typedef void (*bleCallBack)(const ble_msg &msg, JsonDocument& jsonDoc);
@@ -223,92 +112,111 @@ public:
 	bool dequeue_ble_msg(void);
 	
 	/*!
-	 * @brief :  This function send a json formatted notification.
+	 * @brief :  This function send a json formatted notification. The chunks of the document
+	 *		   are not interleaved with other notifications, it may be called from any task.
 	 *
 	 * @param[out] jsonDoc : json formatted message
 	 */
 	void send_notification(JsonDocument& jsonDoc);
 	
 	/*!
-	 * @brief :  This function gets called when data is received from a bluetooth device.
-	 *		   	 It will read in the sent bluetooth command.
+	 * @brief : This function sets the format of the streamed data and restarts the binary stream
+	 *
+	 * @param[in] mode : STREAM_JSON or STREAM_BINARY
+	 *
+	 * @return false if the payload size of the link is below BLE_STREAM_MIN_PAYLOAD for STREAM_BINARY,
+	 *		   the format is then unchanged
 	 */
-	void onWrite(BLECharacteristic *pCharacteristic);
+	bool set_stream_mode(stream_mode mode);
 
 	/*!
-	 * @brief : This function checks the ble connection status, restarts advertising if disconnected
+	 * @brief : This function gets the format of the streamed data
 	 */
-	void check_ble_connection_sts();
-	
-private:
-	bleCallBack						_callBack;
-	
-	static QueueHandle_t 			msg_queue;
-	static ble_cmd					    cmd_list[];
-	static BLECharacteristic	*ble_char_tx, *ble_char_rx;
-	static BLEServer 				  *pServer;
+	stream_mode get_stream_mode();
 
 	/*!
-	 * @brief : This function fetches the RTC time which is requested through ble command
+	 * @brief : This function drops the frames of the binary stream and restarts its sequence numbers
 	 */
-	static cmd_status parse_cmd_get_rtc_time(std::stringstream& ss, ble_msg& msg);
+	void reset_stream();
 
 	/*!
-	 * @brief : This function parses the RTC time received from the ble device and updates 
-	 *        	the RTC time to the ble structure
+	 * @brief : This function adds the bme68x data to the binary stream, see ble_stream_format.h
+	 *
+	 * @param[in] data		: reference to the bme68x data
+	 * @param[in] sens_num	: sensor number
+	 *
+	 * @return false if the stream fell back to STREAM_JSON, the data is to be sent as JSON
 	 */
-	static cmd_status parse_cmd_set_rtc_time(std::stringstream& ss, ble_msg& msg);
+	bool stream_bme68x_data(const bme68x_data& data, uint8_t sens_num);
 
 	/*!
-	 * @brief : This function fetches the current label information from the .bmelabelinfo file
+	 * @brief : This function adds the BSEC outputs to the binary stream, see ble_stream_format.h
+	 *
+	 * @param[in] outputs	: reference to the BSEC outputs
+	 * @param[in] sens_num	: sensor number
+	 *
+	 * @return false if the stream fell back to STREAM_JSON, the outputs are to be sent as JSON
 	 */
-	static cmd_status parse_cmd_get_label_info(std::stringstream& ss, ble_msg& msg);
+	bool stream_bsec_output(const bsecOutputs& outputs, uint8_t sens_num);
 
 	/*!
-	 * @brief : This function updates the received label information to the ble structure
+	 * @brief : This function sends the next frame of the binary stream if one is due, called from the loop
 	 */
-	static cmd_status parse_cmd_set_label_info(std::stringstream& ss, ble_msg& msg);
+	void send_stream();
 
 	/*!
-	 * @brief : This function updates the received label to the ble structure
-	 */
-	static cmd_status parse_cmd_set_label(std::stringstream& ss, ble_msg& msg);
-	
-	/*!
-	 * @brief : This function launches sensor data or sensor data and BSEC output streaming through ble
-	 *			based on the app mode
-	 */
-	static cmd_status parse_cmd_start_streaming(std::stringstream& ss, ble_msg& msg);
-	
-	/*!
-	 * @brief : This function stops ble streaming
+	 * @brief : This function gets the payload size of a notification, the negotiated ATT MTU - 3
 	 */
-	static cmd_status parse_cmd_stop_streaming(std::stringstream& ss, ble_msg& msg);
-	
+	static uint16_t get_payload_size();
+
 	/*!
-	 * @brief : This function launches the config file data through ble
+	 * @brief : This function updates the ATT MTU of the link, from the server callbacks. The binary
+	 *		   stream falls back to STREAM_JSON if its frames no longer fit
 	 */
-	static cmd_status parse_cmd_read_config(std::stringstream& ss, ble_msg& msg);
+	static void set_link_mtu(uint16_t mtu);
 
 	/*!
-	 * @brief : This function updates the current Appmode
+	 * @brief : This function updates the connection interval of the link, in units of 1.25 ms
 	 */
-	static cmd_status parse_cmd_set_appmode(std::stringstream& ss, ble_msg& msg);
+	static void set_conn_interval(uint16_t interval);
 
 	/*!
-	 * @brief : This function retrieves the current Appmode through ble
+	 * @brief :  This function gets called when data is received from a bluetooth device.
+	 *		   	 It will read in the sent bluetooth command.
 	 */
-	static cmd_status parse_cmd_get_appmode(std::stringstream& ss, ble_msg& msg);
+	void onWrite(BLECharacteristic *pCharacteristic);
 
 	/*!
-	 * @brief : This function updates the Groundtruth through ble
+	 * @brief : This function checks the ble connection status, restarts advertising if disconnected
 	 */
-	static cmd_status parse_cmd_set_groundtruth(std::stringstream& ss, ble_msg& msg);
-
+	void check_ble_connection_sts();
+	
+private:
 	/*!
-	 * @brief : This function retrieves the current firmware version through ble
+	 * @brief : This function falls back to STREAM_JSON if the payload size of the link is below
+	 *		   BLE_STREAM_MIN_PAYLOAD
+	 *
+	 * @return true if the stream is binary
 	 */
-	static cmd_status parse_cmd_get_fw_version(std::stringstream& ss, ble_msg& msg);
+	static bool check_stream_payload();
+
+	bleCallBack						_callBack;
+	
+	static bleMsgQueue<BLE_MSG_QUEUE_LEN>	msg_queue;
+	/* Reply of the dequeued message, one at a time from the loop */
+	static StaticJsonDocument<BLE_JSON_DOC_SIZE>	response_doc;
+	static BLECharacteristic	*ble_char_tx, *ble_char_rx;
+	static BLEServer 				  *pServer;
+
+	static bleStreamQueue			stream_queue;
+	static SemaphoreHandle_t		stream_lock;
+	/* Held across every setValue and notify of the TX characteristic, for all the chunks of a message.
+	   The loop, the BLE task and the BSEC runtime tasks all notify. Taken after the output lock of the
+	   BSEC runtime, never before it */
+	static SemaphoreHandle_t		tx_lock;
+	static volatile stream_mode		cur_stream_mode;
+	static volatile uint16_t		link_mtu, conn_interval_ms;
+	static uint8_t					stream_buff[BLE_STREAM_FRAME_MAX];
 };
 
 class serverCallbacks: public BLEServerCallbacks
@@ -318,9 +226,20 @@ class serverCallbacks: public BLEServerCallbacks
 		device_connected = true;
 	}
 
+	void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param)
+	{
+		bleController::set_conn_interval(param->connect.conn_params.interval);
+	}
+
 	void onDisconnect(BLEServer* pServer)
 	{
 		device_connected = false;
+		bleController::set_link_mtu(BLE_DEFAULT_MTU_SIZE);
+	}
+
+	void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param)
+	{
+		bleController::set_link_mtu(param->mtu.mtu);
 	}
 };
 
@@ -0,0 +1,252 @@
+/*!
+ * @file	ble_stream_format.h
+ *
+ * @brief	Binary BLE streaming of the sensor data and BSEC outputs
+ *
+ * With the binary stream mode (setstreammode 1), the bme68x data and the BSEC
+ * outputs are not sent as one JSON notification each, they are packed as
+ * records into frames of the negotiated notification size (ATT MTU - 3). The
+ * controller sends at most one frame per connection interval, the frame that
+ * is full first or, when none is, the records gathered so far. Frames wait in
+ * a queue of BLE_STREAM_FRAMES, when the link cannot keep up the oldest is
+ * dropped. Each frame has a sequence number, a gap in the numbers tells the
+ * client how many frames were lost. All values are little endian.
+ *
+ * Frame header, BLE_STREAM_HEADER_SIZE bytes. The version byte is never '{'
+ * or '[', so the client tells frames from the JSON notifications:
+ * 	version u8, sequence number u16, number of records u8
+ *
+ * Records, a type byte and its payload:
+ * 	BLE_STREAM_BME68X: sensor number u8, gas index u8, temperature f32,
+ * 	                   pressure f32, humidity f32, gas resistance f32
+ * 	BLE_STREAM_BSEC:   sensor number u8, output id u8, accuracy u8, signal f32
+ */
+
+#ifndef BLE_STREAM_FORMAT_H
+#define BLE_STREAM_FORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "raw_data_format.h"
+
+#define BLE_STREAM_VERSION				UINT8_C(1)
+#define BLE_STREAM_HEADER_SIZE			UINT8_C(4)
+
+/* Largest frame, an ATT MTU of 512 less the 3 bytes of the notification */
+#define BLE_STREAM_FRAME_MAX			UINT16_C(509)
+/* Full frames waiting for the link */
+#define BLE_STREAM_FRAMES				UINT8_C(4)
+
+/* Record types and their length with the type byte */
+#define BLE_STREAM_BME68X				UINT8_C(1)
+#define BLE_STREAM_BSEC					UINT8_C(2)
+#define BLE_STREAM_BME68X_SIZE			UINT8_C(19)
+#define BLE_STREAM_BSEC_SIZE			UINT8_C(8)
+
+/* Smallest notification payload that carries a frame, the header and a bme68x record */
+#define BLE_STREAM_MIN_PAYLOAD			(BLE_STREAM_HEADER_SIZE + BLE_STREAM_BME68X_SIZE)
+
+/*!
+ * @brief : Frame being filled or waiting for the link
+ */
+typedef struct
+{
+	uint8_t buff[BLE_STREAM_FRAME_MAX];
+	uint16_t len;
+	uint8_t count;
+} ble_stream_frame;
+
+/*!
+ * @brief Class packing the records into frames and pacing them, the caller sends the frames it takes
+ */
+class bleStreamQueue
+{
+private:
+	ble_stream_frame _frames[BLE_STREAM_FRAMES];
+	ble_stream_frame _current;
+	uint8_t _head = 0, _queued = 0;
+	uint16_t _seq = 0;
+	uint16_t _payload_size = BLE_STREAM_FRAME_MAX;
+	uint32_t _last_ms = 0;
+	bool _sent = false;
+	uint32_t _dropped_frames = 0, _dropped_records = 0;
+
+	/*!
+	 * @brief : This function numbers the current frame and queues it, the oldest frame is dropped if the queue is full
+	 */
+	void close_frame()
+	{
+		if (_queued == BLE_STREAM_FRAMES)
+		{
+			_head = (_head + 1) % BLE_STREAM_FRAMES;
+			_queued--;
+			_dropped_frames++;
+		}
+
+		_current.buff[0] = BLE_STREAM_VERSION;
+		_current.buff[1] = (uint8_t)_seq;
+		_current.buff[2] = (uint8_t)(_seq >> 8);
+		_current.buff[3] = _current.count;
+		_seq++;
+
+		_frames[(_head + _queued) % BLE_STREAM_FRAMES] = _current;
+		_queued++;
+		_current.len = BLE_STREAM_HEADER_SIZE;
+		_current.count = 0;
+	}
+
+	/*!
+	 * @brief : This function makes room for a record, the current frame is queued if it is full
+	 *
+	 * @return  pointer to the record, nullptr if it does not fit in a frame of the payload size
+	 */
+	uint8_t *add_record(uint8_t size)
+	{
+		uint8_t *record;
+
+		if (BLE_STREAM_HEADER_SIZE + size > _payload_size)
+		{
+			_dropped_records++;
+			return nullptr;
+		}
+
+		if ((_current.len + size > _payload_size) || (_current.count == UINT8_MAX))
+		{
+			close_frame();
+		}
+		record = &_current.buff[_current.len];
+		_current.len += size;
+		_current.count++;
+		return record;
+	}
+
+public:
+	bleStreamQueue()
+	{
+		reset();
+	}
+
+	/*!
+	 * @brief : This function drops the frames and restarts the sequence numbers
+	 */
+	void reset()
+	{
+		_head = 0;
+		_queued = 0;
+		_seq = 0;
+		_sent = false;
+		_dropped_frames = 0;
+		_dropped_records = 0;
+		_current.len = BLE_STREAM_HEADER_SIZE;
+		_current.count = 0;
+	}
+
+	/*!
+	 * @brief : This function sets the size of the frames to come, the notification size of the link
+	 *
+	 * @param[in] size : ATT MTU - 3, at most BLE_STREAM_FRAME_MAX
+	 */
+	void set_payload_size(uint16_t size)
+	{
+		_payload_size = (size > BLE_STREAM_FRAME_MAX) ? BLE_STREAM_FRAME_MAX : size;
+
+		/* The records gathered so far go in a frame of their own if they no longer fit */
+		if ((_current.count != 0) && (_current.len > _payload_size))
+		{
+			close_frame();
+		}
+	}
+
+	/*!
+	 * @brief : This function adds a bme68x data record
+	 */
+	void add_bme68x(uint8_t sensor_num, uint8_t gas_index, float temperature, float pressure, float humidity,
+					float gas_resistance)
+	{
+		uint8_t *record = add_record(BLE_STREAM_BME68X_SIZE);
+
+		if (record != nullptr)
+		{
+			*record++ = BLE_STREAM_BME68X;
+			*record++ = sensor_num;
+			*record++ = gas_index;
+			record = raw_data_put_f32(record, temperature);
+			record = raw_data_put_f32(record, pressure);
+			record = raw_data_put_f32(record, humidity);
+			(void)raw_data_put_f32(record, gas_resistance);
+		}
+	}
+
+	/*!
+	 * @brief : This function adds a BSEC output record
+	 */
+	void add_bsec(uint8_t sensor_num, uint8_t output_id, uint8_t accuracy, float signal)
+	{
+		uint8_t *record = add_record(BLE_STREAM_BSEC_SIZE);
+
+		if (record != nullptr)
+		{
+			*record++ = BLE_STREAM_BSEC;
+			*record++ = sensor_num;
+			*record++ = output_id;
+			*record++ = accuracy;
+			(void)raw_data_put_f32(record, signal);
+		}
+	}
+
+	/*!
+	 * @brief : This function takes the frame to send, one per connection interval
+	 *
+	 * @param[in] now_ms		: time in milliseconds
+	 * @param[in] interval_ms	: connection interval in milliseconds
+	 * @param[out] buff			: BLE_STREAM_FRAME_MAX bytes
+	 *
+	 * @return  length of the frame, 0 if none is due
+	 */
+	uint16_t take_frame(uint32_t now_ms, uint32_t interval_ms, uint8_t *buff)
+	{
+		uint16_t len;
+
+		if (_sent && ((uint32_t)(now_ms - _last_ms) < interval_ms))
+		{
+			return 0;
+		}
+
+		/* A partial frame goes once no full frame is waiting, the records wait at most one interval */
+		if ((_queued == 0) && (_current.count != 0))
+		{
+			close_frame();
+		}
+
+		if (_queued == 0)
+		{
+			return 0;
+		}
+		len = _frames[_head].len;
+		memcpy(buff, _frames[_head].buff, len);
+		_head = (_head + 1) % BLE_STREAM_FRAMES;
+		_queued--;
+		_last_ms = now_ms;
+		_sent = true;
+		return len;
+	}
+
+	/*!
+	 * @brief : This function gets the number of frames dropped because the link did not keep up
+	 */
+	uint32_t get_dropped_frames()
+	{
+		return _dropped_frames;
+	}
+
+	/*!
+	 * @brief : This function gets the number of records dropped because the payload size was too small for them
+	 */
+	uint32_t get_dropped_records()
+	{
+		return _dropped_records;
+	}
+};
+
+#endif
@@ -54,7 +54,13 @@ bme68xDataLogger::bme68xDataLogger() : _file_counter(1)
  */
 demo_ret_code bme68xDataLogger::begin(const String& config_name)
 {
+	/* Closes the log file of a previous run before the card is set up again */
+	(void)end();
+	(void)wait_closed();
+
+	sdLogWriter::lockCard();
 	demo_ret_code ret_code = utils::begin();
+	sdLogWriter::unlockCard();
 	
 	_config_name = config_name;
 
@@ -66,58 +72,73 @@ demo_ret_code bme68xDataLogger::begin(const String& config_name)
 
 		if (ret_code >= EDK_OK)
 		{
+			sdLogWriter::lockCard();
 			ret_code = create_label_info_file();
+			sdLogWriter::unlockCard();
 		}
-		_ss.setf(std::ios::fixed, std::ios::floatfield);
 	}
 	return ret_code;
 }
 
 /*!
- * @brief Function which flushes the buffered sensor data to the current log file
+ * @brief Function which checks the writes of the current log file and rotates it at the size limit
  */
 demo_ret_code bme68xDataLogger::flush()
 {
 	demo_ret_code ret_code = EDK_OK;
-	File logFile;
-	std::string txt;
+	uint32_t errors = _writer.getErrors();
 	
-  if (_ss.rdbuf()->in_avail())
+	/* The records are written by the SD log task, the JSON closing brackets are added by the converter */
+	if (!_writer.isOpen() || (errors != _writer_errors))
 	{
-		txt = _ss.str();
-		_ss.str(std::string());
-		
-		if (_file_counter && logFile.open(_log_file_name.c_str(), O_RDWR | O_AT_END))
-		{
-			logFile.seek(_sensor_data_pos);
-			logFile.print(txt.c_str());
-			_sensor_data_pos = logFile.position();
-			logFile.println("\n\t    ]\n\t}\n}");
-			
-			if (logFile.size() >= FILE_SIZE_LIMIT)
-			{
-				logFile.close();
-				++_file_counter;
-				ret_code = create_log_file();
+		_writer_errors = errors;
+		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+	}
+	else if (_writer.size() >= FILE_SIZE_LIMIT)
+	{
+		++_file_counter;
+		ret_code = create_log_file();
 
-				if (ret_code >= EDK_OK)
-				{
-					ret_code = create_label_info_file();
-				}
-			}
-			else
-			{
-				logFile.close();
-			}
-		}
-		else
+		if (ret_code >= EDK_OK)
 		{
-			ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+			sdLogWriter::lockCard();
+			ret_code = create_label_info_file();
+			sdLogWriter::unlockCard();
 		}
 	}
 	return ret_code;
 }
 
+/*!
+ * @brief Function which writes the buffered sensor data and closes the current log file
+ */
+demo_ret_code bme68xDataLogger::end()
+{
+	demo_ret_code ret_code = EDK_OK;
+
+	if (_writer.isOpen() && !_writer.end())
+	{
+		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+	}
+	_writer_errors = _writer.getErrors();
+	return ret_code;
+}
+
+/*!
+ * @brief Function which waits until the log file ended before is closed
+ */
+demo_ret_code bme68xDataLogger::wait_closed()
+{
+	demo_ret_code ret_code = EDK_OK;
+
+	if (!_writer.waitClosed())
+	{
+		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+	}
+	_writer_errors = _writer.getErrors();
+	return ret_code;
+}
+
 /*!
  * @brief Function writes the sensor data to the current log file
  */
@@ -126,42 +147,39 @@ demo_ret_code bme68xDataLogger::write_sensor_data(const uint8_t* num, const uint
                                               gas_label label, demo_ret_code code)
 {
 	demo_ret_code ret_code = EDK_OK;
-	uint32_t rtc_tsp = utils::get_rtc().now().unixtime();
-	uint32_t time_since_power_on = millis();
+	raw_data_record record = {};
+	uint8_t buff[RAW_DATA_RECORD_SIZE + 1];
 
-	if (_end_of_line)
+	record.rtc = utils::get_rtc().now().unixtime();
+	record.time_since_power_on = millis();
+	if (num != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_NUM;
+		record.sensor_num = *num;
+	}
+	if (sensor_id != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_SENSOR_ID;
+		record.sensor_id = *sensor_id;
+	}
+	if (bme68xData != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_DATA;
+		record.temperature = bme68xData->temperature;
+		record.pressure = bme68xData->pressure * .01f;
+		record.humidity = bme68xData->humidity;
+		record.gas_resistance = bme68xData->gas_resistance;
+		record.gas_index = bme68xData->gas_index;
+	}
+	if (scan_cycle_index != nullptr)
 	{
-		_ss << ",\n";
+		record.present |= RAW_DATA_HAS_SCAN_CYCLE;
+		record.scan_cycle_index = *scan_cycle_index;
 	}
-	_ss << "\t\t\t[\n\t\t\t\t";
-	(num != nullptr) ? (_ss << (uint32_t)*num) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	(sensor_id != nullptr) ? (_ss << (uint32_t)*sensor_id) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	_ss << time_since_power_on;
-	_ss << ",\n\t\t\t\t";
-	_ss << rtc_tsp;
-	_ss << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_ss << bme68xData->temperature) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_ss << (bme68xData->pressure * .01f)) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_ss << bme68xData->humidity) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_ss << bme68xData->gas_resistance) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_ss << (uint32_t)bme68xData->gas_index) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	_ss << (bool)(BME68X_PARALLEL_MODE);
-	_ss << ",\n\t\t\t\t";
-	(scan_cycle_index != nullptr) ? (_ss << (uint32_t)(*scan_cycle_index)) : (_ss << "null");
-	_ss << ",\n\t\t\t\t";
-	_ss << (uint32_t)label;
-	_ss << ",\n\t\t\t\t";
-	_ss << (uint32_t)code;
-	_ss << "\n\t\t\t]";
+	record.label = (uint32_t)label;
+	record.code = (int32_t)code;
 
-	_end_of_line = true;
+	(void)_writer.write(buff, raw_data_encode_record(record, buff));
 	return ret_code;
 }
 
@@ -173,6 +191,9 @@ demo_ret_code bme68xDataLogger::set_label_info(int32_t label_tag, const String&
 	demo_ret_code ret_code = EDK_OK;
 		
 	File logFile;
+	
+	/* The SD log task writes to the card meanwhile */
+	sdLogWriter::lockCard();
 
 	if (logFile.open(_label_file_name.c_str(), O_READ))
 	{
@@ -181,6 +202,7 @@ demo_ret_code bme68xDataLogger::set_label_info(int32_t label_tag, const String&
 
 		if (error)
 		{
+			sdLogWriter::unlockCard();
 			Serial.println(error.c_str());
 			return EDK_SENSOR_MANAGER_JSON_DESERIAL_ERROR;
 		}
@@ -205,9 +227,26 @@ demo_ret_code bme68xDataLogger::set_label_info(int32_t label_tag, const String&
 	{
 		ret_code = EDK_DATALOGGER_LABEL_INFO_FILE_ERROR;
 	}
+	sdLogWriter::unlockCard();
 	return ret_code;
 }
 
+/*!
+ * @brief Function which reads a line of a config file under the card lock
+ */
+static bool read_config_line(File& config_file, String& line)
+{
+	sdLogWriter::lockCard();
+	bool available = config_file.available();
+
+	if (available)
+	{
+		line = config_file.readStringUntil('\n');
+	}
+	sdLogWriter::unlockCard();
+	return available;
+}
+
 /*!
  * @brief Function to create a bme68x datalogger output file with .bmerawdata extension
  */
@@ -218,162 +257,170 @@ demo_ret_code bme68xDataLogger::create_log_file()
 	String log_file_base_name = "_Board_" + mac_str + "_PowerOnOff_1_";
 	
 	_log_file_name = utils::get_date_time() + log_file_base_name + utils::get_file_seed() +
-                 "_File_" + String(_file_counter) + BME68X_RAWDATA_FILE_EXT;             
+                 "_File_" + String(_file_counter) + BME68X_RAWDATA_BIN_FILE_EXT;             
 
-	File configFile, logFile;
+	File configFile;
+	bool config_open = true;
+	raw_data_header header = {RAW_DATA_KIND_BME68X, 0};
+	uint8_t header_buff[RAW_DATA_HEADER_SIZE];
 
-	if (_config_name.length() && !configFile.open(_config_name.c_str(), O_RDWR))
+	/* The config file is read under the card lock, the writer task may be waited for in between */
+	if (_config_name.length())
+	{
+		sdLogWriter::lockCard();
+		config_open = configFile.open(_config_name.c_str(), O_RDWR);
+		sdLogWriter::unlockCard();
+	}
+
+	if (!config_open)
 	{
 		ret_code = EDK_DATALOGGER_SENSOR_CONFIG_FILE_ERROR;
 	}
-	else if (!logFile.open(_log_file_name.c_str(), O_RDWR | O_CREAT))
+	else if (!_writer.begin(_log_file_name.c_str(), FILE_SIZE_LIMIT))
 	{
 		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
 	}
 	else
 	{
+		/* The header is written again once the length of the JSON text is known */
+		raw_data_encode_header(header, header_buff);
+		_writer.write(header_buff, sizeof(header_buff));
+
 		if (_config_name.length())
 		{
 			String line_buffer;
 
 			/* read in each line from the config file and copy it to the log file */
-			while (configFile.available())
+			while (read_config_line(configFile, line_buffer))
 			{
-				line_buffer = configFile.readStringUntil('\n');
-
 				/* skip the last closing curly bracket of the JSON document */
 				if (line_buffer == "}")
 				{
-					logFile.println("\t,");
+					_writer.println("\t,");
 					break;
 				}
-				logFile.println(line_buffer);
+				_writer.println(line_buffer);
 			}
+			sdLogWriter::lockCard();
 			configFile.close();
+			sdLogWriter::unlockCard();
 		}
 		else
 		{
-			logFile.println("{");
+			_writer.println("{");
 		}
 
 		/* write data header / skeleton */
 		/* raw data header */
-		logFile.println("\t\"rawDataHeader\": {");
-		logFile.println("\t\t\"counterPowerOnOff\": 1,");
-		logFile.println("\t\t\"seedPowerOnOff\": \"" + utils::get_file_seed() + "\",");
-		logFile.println("\t\t\"counterFileLimit\": " + String(_file_counter) + ",");
-		logFile.println("\t\t\"dateCreated\": \"" + String(utils::get_rtc().now().unixtime()) + "\",");
-		logFile.println("\t\t\"dateCreated_ISO\": \"" + utils::get_rtc().now().timestamp() + "+00:00\",");
-		logFile.println("\t\t\"firmwareVersion\": \"" + String(FIRMWARE_VERSION) + "\",");
-		logFile.println("\t\t\"boardId\": \"" + mac_str + "\"");
-		logFile.println("\t},");
-		logFile.println("\t\"rawDataBody\": {");
-		logFile.println("\t\t\"dataColumns\": [");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Sensor Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"sensor_index\",");
-		logFile.println("\t\t\t\t\"colId\": 1");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Sensor ID\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"sensor_id\",");
-		logFile.println("\t\t\t\t\"colId\": 2");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Time Since PowerOn\",");
-		logFile.println("\t\t\t\t\"unit\": \"Milliseconds\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"timestamp_since_poweron\",");
-		logFile.println("\t\t\t\t\"colId\": 3");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Real time clock\",");
-		logFile.println("\t\t\t\t\"unit\": \"Unix Timestamp: seconds since Jan 01 1970. (UTC); 0 = missing\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"real_time_clock\",");
-		logFile.println("\t\t\t\t\"colId\": 4");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Temperature\",");
-		logFile.println("\t\t\t\t\"unit\": \"DegreesCelcius\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"temperature\",");
-		logFile.println("\t\t\t\t\"colId\": 5");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Pressure\",");
-		logFile.println("\t\t\t\t\"unit\": \"Hectopascals\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"pressure\",");
-		logFile.println("\t\t\t\t\"colId\": 6");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Relative Humidity\",");
-		logFile.println("\t\t\t\t\"unit\": \"Percent\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"relative_humidity\",");
-		logFile.println("\t\t\t\t\"colId\": 7");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Resistance Gassensor\",");
-		logFile.println("\t\t\t\t\"unit\": \"Ohms\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"resistance_gassensor\",");
-		logFile.println("\t\t\t\t\"colId\": 8");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Heater Profile Step Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"heater_profile_step_index\",");
-		logFile.println("\t\t\t\t\"colId\": 9");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Scanning Mode Enabled\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"boolean\",");
-		logFile.println("\t\t\t\t\"key\": \"scanning_enabled\",");
-		logFile.println("\t\t\t\t\"colId\": 10");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Scanning Cycle Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"scanning_cycle_index\",");
-		logFile.println("\t\t\t\t\"colId\": 11");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Label Tag\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"label_tag\",");
-		logFile.println("\t\t\t\t\"colId\": 12");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Error Code\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"error_code\",");
-		logFile.println("\t\t\t\t\"colId\": 13");
-		logFile.println("\t\t\t}");
-		logFile.println("\t\t],");
-		
-		/* data block */
-		logFile.println("\t\t\"dataBlock\": [");
-		/* save position in file, where to write the first data set */
-		_sensor_data_pos = logFile.position();
-		logFile.println("\t\t]");
-		logFile.println("\t}");
-		logFile.println("}");
-		
-		/* close log file */
-		logFile.close();
+		_writer.println("\t\"rawDataHeader\": {");
+		_writer.println("\t\t\"counterPowerOnOff\": 1,");
+		_writer.println("\t\t\"seedPowerOnOff\": \"" + utils::get_file_seed() + "\",");
+		_writer.println("\t\t\"counterFileLimit\": " + String(_file_counter) + ",");
+		_writer.println("\t\t\"dateCreated\": \"" + String(utils::get_rtc().now().unixtime()) + "\",");
+		_writer.println("\t\t\"dateCreated_ISO\": \"" + utils::get_rtc().now().timestamp() + "+00:00\",");
+		_writer.println("\t\t\"firmwareVersion\": \"" + String(FIRMWARE_VERSION) + "\",");
+		_writer.println("\t\t\"boardId\": \"" + mac_str + "\"");
+		_writer.println("\t},");
+		_writer.println("\t\"rawDataBody\": {");
+		_writer.println("\t\t\"dataColumns\": [");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Sensor Index\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"sensor_index\",");
+		_writer.println("\t\t\t\t\"colId\": 1");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Sensor ID\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"sensor_id\",");
+		_writer.println("\t\t\t\t\"colId\": 2");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Time Since PowerOn\",");
+		_writer.println("\t\t\t\t\"unit\": \"Milliseconds\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"timestamp_since_poweron\",");
+		_writer.println("\t\t\t\t\"colId\": 3");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Real time clock\",");
+		_writer.println("\t\t\t\t\"unit\": \"Unix Timestamp: seconds since Jan 01 1970. (UTC); 0 = missing\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"real_time_clock\",");
+		_writer.println("\t\t\t\t\"colId\": 4");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Temperature\",");
+		_writer.println("\t\t\t\t\"unit\": \"DegreesCelcius\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"temperature\",");
+		_writer.println("\t\t\t\t\"colId\": 5");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Pressure\",");
+		_writer.println("\t\t\t\t\"unit\": \"Hectopascals\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"pressure\",");
+		_writer.println("\t\t\t\t\"colId\": 6");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Relative Humidity\",");
+		_writer.println("\t\t\t\t\"unit\": \"Percent\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"relative_humidity\",");
+		_writer.println("\t\t\t\t\"colId\": 7");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Resistance Gassensor\",");
+		_writer.println("\t\t\t\t\"unit\": \"Ohms\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"resistance_gassensor\",");
+		_writer.println("\t\t\t\t\"colId\": 8");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Heater Profile Step Index\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"heater_profile_step_index\",");
+		_writer.println("\t\t\t\t\"colId\": 9");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Scanning Mode Enabled\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"boolean\",");
+		_writer.println("\t\t\t\t\"key\": \"scanning_enabled\",");
+		_writer.println("\t\t\t\t\"colId\": 10");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Scanning Cycle Index\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"scanning_cycle_index\",");
+		_writer.println("\t\t\t\t\"colId\": 11");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Label Tag\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"label_tag\",");
+		_writer.println("\t\t\t\t\"colId\": 12");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Error Code\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"error_code\",");
+		_writer.println("\t\t\t\t\"colId\": 13");
+		_writer.println("\t\t\t}");
+		_writer.println("\t\t],");
 		
-		_end_of_line = false;
+		/* data block, the records follow */
+		_writer.println("\t\t\"dataBlock\": [");
+		header.text_len = _writer.size() - RAW_DATA_HEADER_SIZE;
+		raw_data_encode_header(header, header_buff);
+		_writer.patch(0, header_buff, sizeof(header_buff));
 	}
 	return ret_code;
 }
@@ -50,8 +50,8 @@
 #include "utils.h"
 #include "demo_app.h"
 #include "label_provider.h"
-#include <sstream>
-#include <iostream>
+#include "raw_data_format.h"
+#include <sdLog/sdLogWriter.h>
 #include <ArduinoJson.h>
 
 #define DOC_SIZE	UINT32_C(50000)
@@ -63,13 +63,12 @@ class bme68xDataLogger
 {
 private:
 	String _config_name, _log_file_name, _label_file_name;
-	std::stringstream _ss;
-	uint32_t _sensor_data_pos = 0;
+	sdLogWriter _writer;
+	uint32_t _writer_errors = 0;
 	uint32_t _file_counter = 1;
-	bool _end_of_line = false;
 		
 	/*!
-	 * @brief : This function creates a bme68x datalogger output file with .bmerawdata extension
+	 * @brief : This function creates a bme68x datalogger output file with .bmerawbin extension, see raw_data_format.h
 	 * 
      * @return  bosch error code
 	 */
@@ -100,11 +99,26 @@ public:
 	demo_ret_code begin(const String& configName = "");
 	
 	/*!
-	 * @brief : This function flushes the buffered sensor data to the current log file
+	 * @brief : This function checks the writes of the current log file and starts the next
+	 *			file once the size limit is reached, the data is written by the SD log task
 	 * 
      * @return  bosch error code
 	 */
 	demo_ret_code flush();
+
+	/*!
+	 * @brief : This function writes the buffered sensor data and closes the current log file
+	 * 
+     * @return  bosch error code
+	 */
+	demo_ret_code end();
+
+	/*!
+	 * @brief : This function waits until the log file ended before is closed, e.g. before the SD card is set up again
+	 * 
+     * @return  bosch error code
+	 */
+	demo_ret_code wait_closed();
 	
 	/*!
 	 * @brief : This function writes the sensor data to the current log file.
@@ -56,6 +56,7 @@
 #include "sensor_manager.h"
 #include "ble_controller.h"
 #include <bsec2.h>
+#include <bsec2Runtime.h>
 #include "utils.h"
 
 /* Macros used */
@@ -63,12 +64,20 @@
 #define FILE_DATA_READ_SIZE	    UINT16_C(400)
 
 /*!
- * @brief : This function is called by the BSEC library when a new output is available
+ * @brief : This function is called by the BSEC library when a new output is available,
+ *          from the BSEC runtime worker tasks once streaming has started
  *
  * @param[in] input 	: BME68X data
  * @param[in] outputs	: BSEC output data
+ * @param[in] bsec		: BSEC instance of the sensor
+ * @param[in] userCtx	: sensor number
  */
-void bsecCallBack(const bme68x_data input, const bsecOutputs outputs);
+void bsecCallBack(const bme68x_data &input, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx);
+
+/*!
+ * @brief : This function starts the BSEC runtime on the selected sensors, spread over both cores
+ */
+void start_bsec_runtime();
 
 /*!
  * @brief : This function handles BLE message reception 
@@ -189,6 +198,14 @@ void ble_notify_set_groundtruth(const bleController::ble_msg &msg, JsonDocument&
  */
 void ble_notify_get_fw_version(const bleController::ble_msg &msg, JsonDocument& jsonDoc);
 
+/*!
+ * @brief : This function handles setstreammode BLE command reception (JSON or binary streaming of the data)
+ *
+ * @param[in] msg		 : reference to the new BLE message
+ * @param[inout] jsonDoc : reference to the json formatted BLE response
+ */
+void ble_notify_set_stream_mode(const bleController::ble_msg &msg, JsonDocument& jsonDoc);
+
 /*!
  * @brief : This function handles sensor manager and BME68X datalogger configuration
  *
@@ -242,6 +259,7 @@ void read_sys_time();
 uint8_t 				bsec_config[BSEC_MAX_PROPERTY_BLOB_SIZE];
 char 					config_file_data[FILE_DATA_READ_SIZE];
 Bsec2 					bsec2[NUM_OF_SENS];
+Bsec2Runtime			bsecRuntime;
 bleController  			bleCtlr(bleMessageReceived);
 labelProvider 			labelPvr;
 ledController			ledCtlr;
@@ -257,7 +275,6 @@ bool 					is_bme68x_conf_available, is_bsec_conf_available, is_ai_conf_available
 comm_mux				comm[NUM_OF_SENS];
 uint8_t					bsec_mem_block[NUM_OF_SENS][BSEC_INSTANCE_SIZE];
 uint8_t 				sensor = 0;
-uint8_t 				sensor_num;
 uint32_t				ground_truth;
 static uint8_t 			buff_count = 0;
 static bsecDataLogger::sensor_io_data buff[NUM_OF_SENS];
@@ -284,6 +301,9 @@ void setup()
 
 	/* initialize the ble controller */
 	bleCtlr.begin();
+
+	/* The SD card shares the SPI bus with the sensors, the SD log task takes the bus like the sensors do */
+	sdLogWriter::setBusLock(comm_mux_lock, comm_mux_unlock);
   
   	/* Initializes the SD and RTC module */
 	ret_code = utils::begin();
@@ -323,6 +343,9 @@ void loop()
 
 	while (bleCtlr.dequeue_ble_msg());
 
+	/* Sends the frame of the binary stream due in this connection interval */
+	bleCtlr.send_stream();
+
 	/*checks the ble connection status, restarts advertising if disconnected */
 	bleCtlr.check_ble_connection_sts();
 
@@ -337,6 +360,7 @@ void loop()
 			case DEMO_RECORDING_MODE:
 			{
 				uint8_t i;
+				uint64_t wake_up_time;
                 
 				/* Flushes the buffered sensor data to the current log file */
 				ret_code = bme68xDlog.flush();
@@ -348,11 +372,19 @@ void loop()
 					{
 
 						/* Schedules the next readable sensor */
-						while (sensorMgr.schedule_sensor(i))
+						while (sensorMgr.schedule_sensor(i, wake_up_time))
 						{
 							/* Gets the given sensor raw data and sends via ble and log into the SD card */
 							ret_code = log_sensor_data(i);
 						}
+
+						/* Idles until the next sensor is due instead of polling, at most SCHEDULER_LOOKAHEAD_MS for the BLE messages */
+						uint64_t time_stamp = utils::get_tick_ms();
+
+						if (wake_up_time > time_stamp)
+						{
+							delay((uint32_t)min(wake_up_time - time_stamp, (uint64_t)SCHEDULER_LOOKAHEAD_MS));
+						}
 					}
 					else
 					{
@@ -366,24 +398,11 @@ void loop()
 			   get the outputs in app and logs the data */
 			case DEMO_TEST_ALGORITHM_MODE:
 			{
+				/* The sensors are run by the BSEC runtime tasks, the callbacks fill the buffers under the output lock */
+				bsecRuntime.lockOutputs();
 				/* Flushes the buffered sensor data to the current log file */
 				ret_code = bsecDlog.flush_sensor_data(selected_sensor);
-
-				if (selected_sensor == NUM_OF_SENS)
-				{
-
-					for (sensor_num = 0; sensor_num < NUM_OF_SENS; sensor_num++)
-					{
-						/* Callback from the user to read data from the BME688 sensors using parallel mode/forced mode,
-						process and store outputs */
-						(void) bsec2[sensor_num].run();
-					}
-				}
-				else if (selected_sensor < NUM_OF_SENS)
-				{
-					(void) bsec2[selected_sensor].run();
-					sensor_num = selected_sensor;
-				}
+				bsecRuntime.unlockOutputs();
 			}
 			break;
 			default:
@@ -450,8 +469,29 @@ demo_ret_code log_sensor_data(uint8_t sens_num)
 	return ret;
 }
 
-void bsecCallBack(const bme68x_data input, const bsecOutputs outputs, Bsec2 bsec)
+void start_bsec_runtime()
 {
+	bsecRuntime.clear();
+
+	for (uint8_t i = 0; i < NUM_OF_SENS; i++)
+	{
+
+		if ((selected_sensor == NUM_OF_SENS) || (selected_sensor == i))
+		{
+			(void) bsecRuntime.add(bsec2[i], bsecCallBack, (void*)(uintptr_t)i);
+		}
+	}
+
+	if (!bsecRuntime.start())
+	{
+		ret_code = EDK_SENSOR_INITIALIZATION_FAILED;
+	}
+}
+
+void bsecCallBack(const bme68x_data &input, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx)
+{
+	uint8_t sensor_num = (uint8_t)(uintptr_t)userCtx;
+
 	/* Sending bme raw data via ble */
 	ble_notify_bme68x_data(input, sensor_num);
 	
@@ -533,6 +573,9 @@ void bleMessageReceived(const bleController::ble_msg &msg, JsonDocument& jsonDoc
 		case bleController::GET_FW_VERSION:
 			ble_notify_get_fw_version(msg, jsonDoc);
 		break;
+		case bleController::SET_STREAM_MODE:
+			ble_notify_set_stream_mode(msg, jsonDoc);
+		break;
 		default:
 		break;
 	}
@@ -636,22 +679,29 @@ void ble_notify_start_streaming(const bleController::ble_msg &msg, JsonDocument&
 	bleController::cmd_status ble_ret_code = bleController::CMD_VALID;
 	const bleController::ble_bsec_msg& bsecMsg = msg.bsec;
 
+	/* The sensors are set up again below, the previous run must be over */
+	bsecRuntime.stop();
+
+	/* The sequence numbers of the binary stream start again with each run */
+	bleCtlr.reset_stream();
+
+	//Closing the rawdata file generated during the previous run, before the SD card is set up again
+	if (current_app_mode == DEMO_TEST_ALGORITHM_MODE)
+	{
+		bsecDlog.end();
+		bsecDlog.wait_closed();
+	}
+	else if (current_app_mode == DEMO_RECORDING_MODE)
+	{
+		bme68xDlog.end();
+		bme68xDlog.wait_closed();
+	}
+
 	/* Initializes the SD and RTC module */
 	ret_code = utils::begin();
 
 	if (ret_code >= EDK_OK)
 	{
-
-		//Flushing the contents of the buffer to the rawdata file generated during the previous run
-		if (current_app_mode == DEMO_TEST_ALGORITHM_MODE)
-		{
-			bsecDlog.flush_sensor_data(selected_sensor);
-		}
-		else if (current_app_mode == DEMO_RECORDING_MODE)
-		{
-			bme68xDlog.flush();
-		}
-		
 		if (app_mode == DEMO_TEST_ALGORITHM_MODE)
 		{
 			is_bsec_conf_available = utils::get_file_with_extension(bsec_conf_file_name, BSEC_CONFIG_FILE_EXT);
@@ -700,7 +750,7 @@ void ble_notify_start_streaming(const bleController::ble_msg &msg, JsonDocument&
 						bsec2[i].allocateMemory(bsec_mem_block[i]);
 						
 						/* Whenever new data is available call the newDataCallback function */
-						bsec2[i].attachCallback(bsecCallBack);
+						bsec2[i].attachCallback(bsecCallBack, (void*)(uintptr_t)i);
 						
 						switch (bsecMsg.sample_rate)
 						{
@@ -828,6 +878,11 @@ void ble_notify_start_streaming(const bleController::ble_msg &msg, JsonDocument&
 							current_app_mode = DEMO_TEST_ALGORITHM_MODE;
 						}
 					}
+
+					if ((ble_ret_code == bleController::CMD_VALID) && (current_app_mode == DEMO_TEST_ALGORITHM_MODE))
+					{
+						start_bsec_runtime();
+					}
 				}
 				else
 				{
@@ -878,15 +933,24 @@ void ble_notify_stop_streaming(const bleController::ble_msg &msg, JsonDocument&
 {
 	jsonDoc[msg.name] = bleController::CMD_VALID;
 	
-	//Flushing the contents of the buffer to the rawdata file generated during the previous run
+	bsecRuntime.stop();
+
+	//Writing the buffered data and closing the rawdata file generated during the previous run
 	if (current_app_mode == DEMO_TEST_ALGORITHM_MODE)
 	{
-		bsecDlog.flush_sensor_data(selected_sensor);
+		bsecDlog.end();
 	}
 	else
 	{
-		bme68xDlog.flush();
+		bme68xDlog.end();
 	}
+
+	/* Card write latency of the SD log tasks during the run */
+	Serial.printf("SD write latency: p50 %lu us, p90 %lu us, p99 %lu us, max %lu us, %lu writes\n",
+				  (unsigned long)sdLogWriter::getWriteLatencyUs(50), (unsigned long)sdLogWriter::getWriteLatencyUs(90),
+				  (unsigned long)sdLogWriter::getWriteLatencyUs(99), (unsigned long)sdLogWriter::getWriteLatencyUs(100),
+				  (unsigned long)sdLogWriter::getWriteCount());
+	sdLogWriter::resetWriteLatency();
 	selected_sensor = 0;
 	
 	current_app_mode = DEMO_IDLE_MODE;
@@ -982,6 +1046,12 @@ void ble_notify_set_groundtruth(const bleController::ble_msg &msg, JsonDocument&
 
 void ble_notify_bsec_output(const bsecOutputs& outputs, const uint8_t sens_num)
 {
+	/* The stream falls back to JSON if the link MTU dropped below the binary frames */
+	if ((bleCtlr.get_stream_mode() == bleController::STREAM_BINARY) && bleCtlr.stream_bsec_output(outputs, sens_num))
+	{
+		return;
+	}
+
 	StaticJsonDocument<BLE_JSON_DOC_SIZE> jsonDoc;
 	JsonArray bsecOutputArray = jsonDoc.createNestedArray("bsec");
 		
@@ -1001,6 +1071,11 @@ void ble_notify_bsec_output(const bsecOutputs& outputs, const uint8_t sens_num)
 
 void ble_notify_bme68x_data(const bme68x_data& data, const uint8_t sens_num)
 {
+	if ((bleCtlr.get_stream_mode() == bleController::STREAM_BINARY) && bleCtlr.stream_bme68x_data(data, sens_num))
+	{
+		return;
+	}
+
 	StaticJsonDocument<BLE_JSON_DOC_SIZE> jsonDoc;
 	JsonObject bme68xObj = jsonDoc.createNestedObject("bme68x");
 	
@@ -1020,6 +1095,29 @@ void ble_notify_get_fw_version(const bleController::ble_msg &msg, JsonDocument&
 	jsonDoc["FirmwareVersion"] = FIRMWARE_VERSION;
 }
 
+void ble_notify_set_stream_mode(const bleController::ble_msg &msg, JsonDocument& jsonDoc)
+{
+
+	if (msg.stream_mode <= bleController::STREAM_BINARY)
+	{
+		/* The binary frames need an ATT MTU of at least BLE_STREAM_MIN_PAYLOAD + 3 */
+		if (bleCtlr.set_stream_mode((bleController::stream_mode)msg.stream_mode))
+		{
+			jsonDoc[msg.name] = bleController::CMD_VALID;
+			jsonDoc["streamVersion"] = BLE_STREAM_VERSION;
+		}
+		else
+		{
+			jsonDoc[msg.name] = bleController::STREAM_MTU_TOO_SMALL;
+		}
+		jsonDoc["payloadSize"] = bleCtlr.get_payload_size();
+	}
+	else
+	{
+		jsonDoc[msg.name] = bleController::CMD_INVALID;
+	}
+}
+
 demo_ret_code configure_sensor_logging(const String& bme_config_file)
 {
 	demo_ret_code ret = sensorMgr.begin(bme_config_file);
@@ -1050,8 +1148,17 @@ demo_ret_code config_file_read(const String& config_file)
 	static bool first_time = true;
 	StaticJsonDocument<BLE_JSON_DOC_SIZE> jsonDoc;
 
-	while ((ret = utils::read_file(config_file, FILE_DATA_READ_SIZE, config_file_data)) == EDK_OK)
+	for (;;)
 	{
+		/* The SD log task may be writing to the card meanwhile */
+		sdLogWriter::lockCard();
+		ret = utils::read_file(config_file, FILE_DATA_READ_SIZE, config_file_data);
+		sdLogWriter::unlockCard();
+
+		if (ret != EDK_OK)
+		{
+			break;
+		}
 
 		if (first_time)
 		{
@@ -61,7 +61,13 @@ bsecDataLogger::bsecDataLogger() : _bsec_file_counter(1)
  */
 demo_ret_code bsecDataLogger::begin(const String& config_name, const bsec_version_t& bsec_version, uint8_t sensor_num)
 {
+	/* Closes the log file of a previous run before the card is set up again */
+	(void)end();
+	(void)wait_closed();
+
+	sdLogWriter::lockCard();
 	demo_ret_code ret_code = utils::begin();
+	sdLogWriter::unlockCard();
 	
 	_ai_config_name = config_name;
 	_version = bsec_version;
@@ -69,20 +75,39 @@ demo_ret_code bsecDataLogger::begin(const String& config_name, const bsec_versio
 	if (ret_code >= EDK_OK)
 	{
 		ret_code = create_bsec_file();
+	}
+
+	if (ret_code >= EDK_OK)
+	{
+		ret_code = create_raw_data_file(sensor_num);
 
 		if (ret_code >= EDK_OK)
 		{
-			ret_code = create_raw_data_file(sensor_num);
-
-			if (ret_code >= EDK_OK)
-			{
-				ret_code = create_label_info_file();
-			}
+			sdLogWriter::lockCard();
+			ret_code = create_label_info_file();
+			sdLogWriter::unlockCard();
 		}
 	}
 	return ret_code;
 }
  
+/*!
+ * @brief Function to read a line of the config file under the card lock, the line is then written
+ *		  to a log file without it, the SD log task may need the card before it takes the line
+ */
+static bool read_config_line(File& config_file, String& line)
+{
+	sdLogWriter::lockCard();
+	bool available = config_file.available();
+
+	if (available)
+	{
+		line = config_file.readStringUntil('\n');
+	}
+	sdLogWriter::unlockCard();
+	return available;
+}
+
 /*!
  * @brief This function creates a bsec output file
  */
@@ -95,13 +120,18 @@ demo_ret_code bsecDataLogger::create_bsec_file()
 	_ai_file_name = utils::get_date_time() + ai_file_base_name + utils::get_file_seed() + "_File_" + 
 														String(_bsec_file_counter) + AI_DATA_FILE_EXT;
 	
-	File configFile, logFile;
+	File configFile;
 
-	if (_ai_config_name.length() && !configFile.open(_ai_config_name.c_str(), O_RDWR))
+	sdLogWriter::lockCard();
+	bool config_open = !_ai_config_name.length() || configFile.open(_ai_config_name.c_str(), O_RDWR);
+	sdLogWriter::unlockCard();
+
+	if (!config_open)
 	{
 		ret_code = EDK_DATALOGGER_AI_CONFIG_FILE_ERROR;
 	}
-	else if (!logFile.open(_ai_file_name.c_str(), O_RDWR | O_CREAT))
+	/* Not preallocated and synced on every buffer, a file that is not closed keeps the outputs up to the last buffer */
+	else if (!_ai_writer.begin(_ai_file_name.c_str(), 0, 1))
 	{
 		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
 	}
@@ -113,140 +143,132 @@ demo_ret_code bsecDataLogger::create_bsec_file()
 			String line_buffer;
 
 			/* read in each line from the config file and copy it to the log file */
-			while (configFile.available())
+			while (read_config_line(configFile, line_buffer))
 			{
-				line_buffer = configFile.readStringUntil('\n');
-
 				/* skip the last closing curly bracket of the JSON document */
 				if (line_buffer == "}")
 				{
-					logFile.println("\t,");
+					_ai_writer.println("\t,");
 					break;
 				}
-				logFile.println(line_buffer);
+				_ai_writer.println(line_buffer);
 			}
+			sdLogWriter::lockCard();
 			configFile.close();
+			sdLogWriter::unlockCard();
 		}
 		else
 		{
-			logFile.println("{");
+			_ai_writer.println("{");
 		}
-		logFile.println("\t\"aiPredictionsDataHeader\": {");
-		logFile.println("\t\t\"counterPowerOnOff\": 1,");
-		logFile.println("\t\t\"seedPowerOnOff\": \"" + utils::get_file_seed() + "\",");
-		logFile.println("\t\t\"counterFileLimit\": " + String(_bsec_file_counter) + ",");
-		logFile.println("\t\t\"dateCreated\": \"" + String(utils::get_rtc().now().unixtime()) + "\",");
-		logFile.println("\t\t\"dateCreated_ISO\": \"" + utils::get_rtc().now().timestamp() + "+00:00\",");
-		logFile.println("\t\t\"firmwareVersion\": \"" + String(FIRMWARE_VERSION) + "\",");
-		logFile.println("\t\t\"bsecVersion\": \"" + String(_version.major) + "." + String(_version.minor) + \
+		_ai_writer.println("\t\"aiPredictionsDataHeader\": {");
+		_ai_writer.println("\t\t\"counterPowerOnOff\": 1,");
+		_ai_writer.println("\t\t\"seedPowerOnOff\": \"" + utils::get_file_seed() + "\",");
+		_ai_writer.println("\t\t\"counterFileLimit\": " + String(_bsec_file_counter) + ",");
+		_ai_writer.println("\t\t\"dateCreated\": \"" + String(utils::get_rtc().now().unixtime()) + "\",");
+		_ai_writer.println("\t\t\"dateCreated_ISO\": \"" + utils::get_rtc().now().timestamp() + "+00:00\",");
+		_ai_writer.println("\t\t\"firmwareVersion\": \"" + String(FIRMWARE_VERSION) + "\",");
+		_ai_writer.println("\t\t\"bsecVersion\": \"" + String(_version.major) + "." + String(_version.minor) + \
 							 "." + String(_version.major_bugfix) + "." + String(_version.minor_bugfix) + "\",");
-		logFile.println("\t\t\"boardId\": \"" + mac_str + "\"");
-		logFile.println("\t},");
-		logFile.println("\t\"aiPredictionsDataBody\": {");
-		logFile.println("\t\t\"dataColumns\": [");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Sensor Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"sensor_index\",");
-		logFile.println("\t\t\t\t\"colId\": 1");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Sensor ID\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"sensor_id\",");
-		logFile.println("\t\t\t\t\"colId\": 2");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Start Time Since PowerOn\",");
-		logFile.println("\t\t\t\t\"unit\": \"Milliseconds\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"start_time_since_poweron\",");
-		logFile.println("\t\t\t\t\"colId\": 3");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"End Time Since PowerOn\",");
-		logFile.println("\t\t\t\t\"unit\": \"Milliseconds\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"end_time_since_poweron\",");
-		logFile.println("\t\t\t\t\"colId\": 4");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Class/Target 1 prediction\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"classtarget_1_prediction\",");
-		logFile.println("\t\t\t\t\"colId\": 5");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Class/Target 2 prediction\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"classtarget_2_prediction\",");
-		logFile.println("\t\t\t\t\"colId\": 6");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Class/Target 3 prediction\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"classtarget_3_prediction\",");
-		logFile.println("\t\t\t\t\"colId\": 7");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Class/Target 4 prediction\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"classtarget_4_prediction\",");
-		logFile.println("\t\t\t\t\"colId\": 8");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Prediction accuracy\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"prediction_accuracy\",");
-		logFile.println("\t\t\t\t\"colId\": 9");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"IAQ\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"iaq\",");
-		logFile.println("\t\t\t\t\"colId\": 10");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"IAQ accuracy\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"iaq_accuracy\",");
-		logFile.println("\t\t\t\t\"colId\": 11");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Error code\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"error_code\",");
-		logFile.println("\t\t\t\t\"colId\": 12");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Ground truth\",");
-		logFile.println("\t\t\t\t\"unit\": \"classId\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"ground_truth\",");
-		logFile.println("\t\t\t\t\"colId\": 13");
-		logFile.println("\t\t\t}");
-		logFile.println("\t\t],");
+		_ai_writer.println("\t\t\"boardId\": \"" + mac_str + "\"");
+		_ai_writer.println("\t},");
+		_ai_writer.println("\t\"aiPredictionsDataBody\": {");
+		_ai_writer.println("\t\t\"dataColumns\": [");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Sensor Index\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"sensor_index\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 1");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Sensor ID\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"sensor_id\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 2");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Start Time Since PowerOn\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"Milliseconds\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"start_time_since_poweron\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 3");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"End Time Since PowerOn\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"Milliseconds\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"end_time_since_poweron\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 4");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Class/Target 1 prediction\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"float\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"classtarget_1_prediction\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 5");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Class/Target 2 prediction\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"float\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"classtarget_2_prediction\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 6");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Class/Target 3 prediction\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"float\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"classtarget_3_prediction\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 7");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Class/Target 4 prediction\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"float\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"classtarget_4_prediction\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 8");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Prediction accuracy\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"prediction_accuracy\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 9");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"IAQ\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"float\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"iaq\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 10");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"IAQ accuracy\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"iaq_accuracy\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 11");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Error code\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"error_code\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 12");
+		_ai_writer.println("\t\t\t},");
+		_ai_writer.println("\t\t\t{");
+		_ai_writer.println("\t\t\t\t\"name\": \"Ground truth\",");
+		_ai_writer.println("\t\t\t\t\"unit\": \"classId\",");
+		_ai_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_ai_writer.println("\t\t\t\t\"key\": \"ground_truth\",");
+		_ai_writer.println("\t\t\t\t\"colId\": 13");
+		_ai_writer.println("\t\t\t}");
+		_ai_writer.println("\t\t],");
 		
-		/* data block */
-		logFile.println("\t\t\"dataBlock\": [");
-		/* save position in file, where to write the first data set */
-		_ai_data_pos = logFile.position();
-		logFile.println("\t\t]");
-		logFile.println("\t}");
-		logFile.println("}");
-		
-		/* close log file */
-		logFile.close();
+		/* data block, the outputs follow and end closes the JSON document */
+		_ai_writer.println("\t\t\"dataBlock\": [");
 		
 		_first_line = true;
 	}
@@ -263,142 +285,144 @@ demo_ret_code bsecDataLogger::create_raw_data_file(uint8_t sensor_num)
 	String bme_file_base_name = "_Board_" + mac_str + "_PowerOnOff_1_";
 	
 	_bme_file_name = utils::get_date_time() + bme_file_base_name + utils::get_file_seed() + "_File_" + 
-														String(_bsec_file_counter) + BME68X_RAWDATA_FILE_EXT;
+														String(_bsec_file_counter) + BME68X_RAWDATA_BIN_FILE_EXT;
 	
-	File logFile;
+	raw_data_header header = {RAW_DATA_KIND_BSEC, 0};
+	uint8_t header_buff[RAW_DATA_HEADER_SIZE];
 
-	if (!logFile.open(_bme_file_name.c_str(), O_RDWR | O_CREAT))
+	if (!_writer.begin(_bme_file_name.c_str(), FILE_SIZE_LIMIT))
 	{
 		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
 	}
 	else 
 	{
+		/* The config file is read under the card lock, not the writer which may wait for the card */
+		sdLogWriter::lockCard();
 		ret_code = prepare_config_content(sensor_num);
+		sdLogWriter::unlockCard();
 
 		if (ret_code != EDK_OK)
 		{
 			return ret_code;
 		}
 
+		/* The header is written again once the length of the JSON text is known */
+		raw_data_encode_header(header, header_buff);
+		_writer.write(header_buff, sizeof(header_buff));
+
 		/* Writes the config header and body to the logfile */
-		logFile.print(config_string);
+		_writer.print(config_string);
 		/* write data header / skeleton */
 		/* raw data header */
-		logFile.println("\t,\n\t\"rawDataHeader\": {");
-		logFile.println("\t\t\"counterPowerOnOff\": 1,");
-		logFile.println("\t\t\"seedPowerOnOff\": \"" + utils::get_file_seed() + "\",");
-		logFile.println("\t\t\"counterFileLimit\": " + String(_bsec_file_counter) + ",");
-		logFile.println("\t\t\"dateCreated\": \"" + String(utils::get_rtc().now().unixtime()) + "\",");
-		logFile.println("\t\t\"dateCreated_ISO\": \"" + utils::get_rtc().now().timestamp() + "+00:00\",");
-		logFile.println("\t\t\"firmwareVersion\": \"" + String(FIRMWARE_VERSION) + "\",");
-		logFile.println("\t\t\"boardId\": \"" + mac_str + "\"");
-		logFile.println("\t},");
-		logFile.println("\t\"rawDataBody\": {");
-		logFile.println("\t\t\"dataColumns\": [");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Sensor Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"sensor_index\",");
-		logFile.println("\t\t\t\t\"colId\": 1");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Sensor ID\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"sensor_id\",");
-		logFile.println("\t\t\t\t\"colId\": 2");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Time Since PowerOn\",");
-		logFile.println("\t\t\t\t\"unit\": \"Milliseconds\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"timestamp_since_poweron\",");
-		logFile.println("\t\t\t\t\"colId\": 3");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Real time clock\",");
-		logFile.println("\t\t\t\t\"unit\": \"Unix Timestamp: seconds since Jan 01 1970. (UTC); 0 = missing\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"real_time_clock\",");
-		logFile.println("\t\t\t\t\"colId\": 4");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Temperature\",");
-		logFile.println("\t\t\t\t\"unit\": \"DegreesCelcius\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"temperature\",");
-		logFile.println("\t\t\t\t\"colId\": 5");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Pressure\",");
-		logFile.println("\t\t\t\t\"unit\": \"Hectopascals\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"pressure\",");
-		logFile.println("\t\t\t\t\"colId\": 6");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Relative Humidity\",");
-		logFile.println("\t\t\t\t\"unit\": \"Percent\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"relative_humidity\",");
-		logFile.println("\t\t\t\t\"colId\": 7");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Resistance Gassensor\",");
-		logFile.println("\t\t\t\t\"unit\": \"Ohms\",");
-		logFile.println("\t\t\t\t\"format\": \"float\",");
-		logFile.println("\t\t\t\t\"key\": \"resistance_gassensor\",");
-		logFile.println("\t\t\t\t\"colId\": 8");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Heater Profile Step Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"heater_profile_step_index\",");
-		logFile.println("\t\t\t\t\"colId\": 9");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Scanning Mode Enabled\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"boolean\",");
-		logFile.println("\t\t\t\t\"key\": \"scanning_enabled\",");
-		logFile.println("\t\t\t\t\"colId\": 10");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Scanning Cycle Index\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"scanning_cycle_index\",");
-		logFile.println("\t\t\t\t\"colId\": 11");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Label Tag\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"label_tag\",");
-		logFile.println("\t\t\t\t\"colId\": 12");
-		logFile.println("\t\t\t},");
-		logFile.println("\t\t\t{");
-		logFile.println("\t\t\t\t\"name\": \"Error Code\",");
-		logFile.println("\t\t\t\t\"unit\": \"\",");
-		logFile.println("\t\t\t\t\"format\": \"integer\",");
-		logFile.println("\t\t\t\t\"key\": \"error_code\",");
-		logFile.println("\t\t\t\t\"colId\": 13");
-		logFile.println("\t\t\t}");
-		logFile.println("\t\t],");
+		_writer.println("\t,\n\t\"rawDataHeader\": {");
+		_writer.println("\t\t\"counterPowerOnOff\": 1,");
+		_writer.println("\t\t\"seedPowerOnOff\": \"" + utils::get_file_seed() + "\",");
+		_writer.println("\t\t\"counterFileLimit\": " + String(_bsec_file_counter) + ",");
+		_writer.println("\t\t\"dateCreated\": \"" + String(utils::get_rtc().now().unixtime()) + "\",");
+		_writer.println("\t\t\"dateCreated_ISO\": \"" + utils::get_rtc().now().timestamp() + "+00:00\",");
+		_writer.println("\t\t\"firmwareVersion\": \"" + String(FIRMWARE_VERSION) + "\",");
+		_writer.println("\t\t\"boardId\": \"" + mac_str + "\"");
+		_writer.println("\t},");
+		_writer.println("\t\"rawDataBody\": {");
+		_writer.println("\t\t\"dataColumns\": [");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Sensor Index\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"sensor_index\",");
+		_writer.println("\t\t\t\t\"colId\": 1");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Sensor ID\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"sensor_id\",");
+		_writer.println("\t\t\t\t\"colId\": 2");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Time Since PowerOn\",");
+		_writer.println("\t\t\t\t\"unit\": \"Milliseconds\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"timestamp_since_poweron\",");
+		_writer.println("\t\t\t\t\"colId\": 3");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Real time clock\",");
+		_writer.println("\t\t\t\t\"unit\": \"Unix Timestamp: seconds since Jan 01 1970. (UTC); 0 = missing\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"real_time_clock\",");
+		_writer.println("\t\t\t\t\"colId\": 4");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Temperature\",");
+		_writer.println("\t\t\t\t\"unit\": \"DegreesCelcius\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"temperature\",");
+		_writer.println("\t\t\t\t\"colId\": 5");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Pressure\",");
+		_writer.println("\t\t\t\t\"unit\": \"Hectopascals\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"pressure\",");
+		_writer.println("\t\t\t\t\"colId\": 6");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Relative Humidity\",");
+		_writer.println("\t\t\t\t\"unit\": \"Percent\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"relative_humidity\",");
+		_writer.println("\t\t\t\t\"colId\": 7");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Resistance Gassensor\",");
+		_writer.println("\t\t\t\t\"unit\": \"Ohms\",");
+		_writer.println("\t\t\t\t\"format\": \"float\",");
+		_writer.println("\t\t\t\t\"key\": \"resistance_gassensor\",");
+		_writer.println("\t\t\t\t\"colId\": 8");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Heater Profile Step Index\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"heater_profile_step_index\",");
+		_writer.println("\t\t\t\t\"colId\": 9");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Scanning Mode Enabled\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"boolean\",");
+		_writer.println("\t\t\t\t\"key\": \"scanning_enabled\",");
+		_writer.println("\t\t\t\t\"colId\": 10");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Scanning Cycle Index\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"scanning_cycle_index\",");
+		_writer.println("\t\t\t\t\"colId\": 11");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Label Tag\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"label_tag\",");
+		_writer.println("\t\t\t\t\"colId\": 12");
+		_writer.println("\t\t\t},");
+		_writer.println("\t\t\t{");
+		_writer.println("\t\t\t\t\"name\": \"Error Code\",");
+		_writer.println("\t\t\t\t\"unit\": \"\",");
+		_writer.println("\t\t\t\t\"format\": \"integer\",");
+		_writer.println("\t\t\t\t\"key\": \"error_code\",");
+		_writer.println("\t\t\t\t\"colId\": 13");
+		_writer.println("\t\t\t}");
+		_writer.println("\t\t],");
 		
-		/* data block */
-		logFile.println("\t\t\"dataBlock\": [");
-		/* save position in file, where to write the first data set */
-		_bme_data_pos = logFile.position();
-		logFile.println("\t\t]");
-		logFile.println("\t}");
-		logFile.println("}");
-
-		_end_of_line = false;
-		/* close log file */
-		logFile.close();
+		/* data block, the records follow */
+		_writer.println("\t\t\"dataBlock\": [");
+		header.text_len = _writer.size() - RAW_DATA_HEADER_SIZE;
+		raw_data_encode_header(header, header_buff);
+		_writer.patch(0, header_buff, sizeof(header_buff));
 	}
 	return ret_code;
 }
@@ -789,47 +813,77 @@ demo_ret_code bsecDataLogger::create_label_info_file()
 }
 
 /*!
- * @brief Function which flushes the buffered sensor data to the current log file
+ * @brief Function which checks the writes of the current log files and rotates the raw data file at the size limit
  */
 demo_ret_code bsecDataLogger::flush_sensor_data(uint8_t sensor_num)
 {
 	demo_ret_code ret_code = EDK_OK;
-	File logFile;
-	std::string txt;
+	uint32_t errors = _writer.getErrors();
+	uint32_t ai_errors = _ai_writer.getErrors();
 	
-	if (_bs.rdbuf()->in_avail())
+	/* The records and bsec outputs are written by the SD log tasks, the closing brackets of the raw data
+	   file are added by the converter, the ones of the bsec output file by end */
+	if (!_writer.isOpen() || (errors != _writer_errors) || !_ai_writer.isOpen() || (ai_errors != _ai_writer_errors))
 	{
-		txt = _bs.str();
-		_bs.str(std::string());
-		
-		if (_bme_file_counter && logFile.open(_bme_file_name.c_str(), O_RDWR | O_AT_END))
-		{
-			logFile.seek(_bme_data_pos);
-			logFile.print(txt.c_str());
-			_bme_data_pos = logFile.position();
-			logFile.print("\n\t\t]\n\t}\n}");
-			
-			if (logFile.size() >= FILE_SIZE_LIMIT)
-			{
-				logFile.close();
-				++_bme_file_counter;
-				ret_code = create_raw_data_file(sensor_num);
+		_writer_errors = errors;
+		_ai_writer_errors = ai_errors;
+		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+	}
+	else if (_writer.size() >= FILE_SIZE_LIMIT)
+	{
+		++_bme_file_counter;
+		ret_code = create_raw_data_file(sensor_num);
 
-				if (ret_code >= EDK_OK)
-				{
-					ret_code = create_label_info_file();
-				}
-			}
-			else
-			{
-				logFile.close();
-			}
+		if (ret_code >= EDK_OK)
+		{
+			sdLogWriter::lockCard();
+			ret_code = create_label_info_file();
+			sdLogWriter::unlockCard();
 		}
-		else
+	}
+	return ret_code;
+}
+
+/*!
+ * @brief Function which writes the buffered sensor data and closes the current log file
+ */
+demo_ret_code bsecDataLogger::end()
+{
+	demo_ret_code ret_code = EDK_OK;
+
+	if (_writer.isOpen() && !_writer.end())
+	{
+		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+	}
+
+	if (_ai_writer.isOpen())
+	{
+		/* closes the JSON document of the bsec output file */
+		_ai_writer.print(_first_line ? AI_PREDICTION_NO_ROWS_END : AI_PREDICTION_ROWS_END);
+
+		if (!_ai_writer.end())
 		{
 			ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
 		}
 	}
+	_writer_errors = _writer.getErrors();
+	_ai_writer_errors = _ai_writer.getErrors();
+	return ret_code;
+}
+
+/*!
+ * @brief Function which waits until the log files ended before are closed
+ */
+demo_ret_code bsecDataLogger::wait_closed()
+{
+	demo_ret_code ret_code = EDK_OK;
+
+	if (!_writer.waitClosed() || !_ai_writer.waitClosed())
+	{
+		ret_code = EDK_DATALOGGER_LOG_FILE_ERROR;
+	}
+	_writer_errors = _writer.getErrors();
+	_ai_writer_errors = _ai_writer.getErrors();
 	return ret_code;
 }
 
@@ -838,21 +892,25 @@ demo_ret_code bsecDataLogger::flush_sensor_data(uint8_t sensor_num)
  */
 demo_ret_code bsecDataLogger::write_bsec_output(sensor_io_data& buff_data)
 {
-	demo_ret_code ret_code = EDK_OK;	    
-	File logFile;
+	demo_ret_code ret_code = EDK_OK;
 	
-	if (_bsec_file_counter && logFile.open(_ai_file_name.c_str(), O_RDWR | O_AT_END))
+	/* Called from the BSEC tasks, the row goes to the SD log task of the bsec output file in one write */
+	if (_ai_writer.isOpen())
 	{
-		/* set writing position to end of data block */
-		logFile.seek(_ai_data_pos);
-		
-		float gas_signal[4] = {NAN, NAN, NAN, NAN}, iaq_signal = NAN; 
-		uint8_t iaq_accuracy = 0xFF; //, gasAccuracy = 0xFF; 
+		ai_prediction_row row = {};
 		uint8_t gas_accuracy[4] = {0xFF, 0xFF, 0xFF, 0xFF};
-		uint8_t is_reg_class_subscribe = 0;
-		uint8_t Gas_accuracy = 0;
 		uint8_t index = 0;
 		
+		row.sensor_num = buff_data.sensor_num;
+		row.sensor_id = buff_data.sensor_id;
+		row.start_time_since_power_on = buff_data.start_time_since_power_on;
+		row.end_time_since_power_on = buff_data.end_time_since_power_on;
+		row.prediction[0] = row.prediction[1] = row.prediction[2] = row.prediction[3] = NAN;
+		row.iaq = NAN;
+		row.iaq_accuracy = AI_PREDICTION_NO_ACCURACY;
+		row.code = buff_data.code;
+		row.ground_truth = buff_data.ground_truth;
+		
 		for (uint8_t i = 0; ((buff_data.outputs).output != nullptr) && (i < (buff_data.outputs).nOutputs); i++) 
 		{
 			const bsec_output_t& output = (buff_data.outputs).output[i];
@@ -864,67 +922,32 @@ demo_ret_code bsecDataLogger::write_bsec_output(sensor_io_data& buff_data)
 				case BSEC_OUTPUT_GAS_ESTIMATE_3:
 				case BSEC_OUTPUT_GAS_ESTIMATE_4:
 					index = output.sensor_id - BSEC_OUTPUT_GAS_ESTIMATE_1;
-					gas_signal[index] = output.signal;
+					row.prediction[index] = output.signal;
 					gas_accuracy[index] = (output.accuracy > gas_accuracy[index]) ? gas_accuracy[index] : output.accuracy;
-					Gas_accuracy |= ((gas_accuracy[index] & 0x03) << (index * 2));
-					is_reg_class_subscribe = 1;
+					row.prediction_accuracy |= ((gas_accuracy[index] & 0x03) << (index * 2));
+					row.has_predictions = true;
 				break;
 				case BSEC_OUTPUT_REGRESSION_ESTIMATE_1:
 				case BSEC_OUTPUT_REGRESSION_ESTIMATE_2:
 				case BSEC_OUTPUT_REGRESSION_ESTIMATE_3:
 				case BSEC_OUTPUT_REGRESSION_ESTIMATE_4:
 					index = output.sensor_id -  BSEC_OUTPUT_REGRESSION_ESTIMATE_1;
-					gas_signal[index] = output.signal;
+					row.prediction[index] = output.signal;
 					gas_accuracy[index] = (output.accuracy > gas_accuracy[index]) ? gas_accuracy[index] : output.accuracy;
-					Gas_accuracy |= ((gas_accuracy[index] & 0x03) << (index * 2));
-					is_reg_class_subscribe = 1;
+					row.prediction_accuracy |= ((gas_accuracy[index] & 0x03) << (index * 2));
+					row.has_predictions = true;
 				break;
 				case BSEC_OUTPUT_IAQ:
-					iaq_signal = output.signal;
-					iaq_accuracy = output.accuracy;
+					row.iaq = output.signal;
+					row.iaq_accuracy = output.accuracy;
 				break;
 				default:
 				break;
 			}
 		}
 
-		if (!_first_line)
-		{
-			logFile.println(",");
-		}		
-		logFile.print("\t\t\t[\n\t\t\t\t");
-		logFile.print(buff_data.sensor_num);
-		logFile.print(",\n\t\t\t\t");
-		logFile.print(buff_data.sensor_id);
-		logFile.print(",\n\t\t\t\t");
-		logFile.print(buff_data.start_time_since_power_on);
-		logFile.print(",\n\t\t\t\t");
-		logFile.print(buff_data.end_time_since_power_on);
-		logFile.print(",\n\t\t\t\t");
-		(!isnan(gas_signal[0])) ? logFile.print(gas_signal[0]) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		(!isnan(gas_signal[1])) ? logFile.print(gas_signal[1]) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		(!isnan(gas_signal[2])) ? logFile.print(gas_signal[2]) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		(!isnan(gas_signal[3])) ? logFile.print(gas_signal[3]) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		(is_reg_class_subscribe == 1) ? logFile.print(Gas_accuracy) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		(!isnan(iaq_signal)) ? logFile.print(iaq_signal) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		(iaq_accuracy != 0xFF) ? logFile.print(iaq_accuracy) : logFile.print("null");
-		logFile.print(",\n\t\t\t\t");
-		logFile.print(buff_data.code);
-		logFile.print(",\n\t\t\t\t");
-		logFile.println(buff_data.ground_truth);
-		logFile.print("\t\t\t]");
-		
-		_ai_data_pos = logFile.position();
+		_ai_writer.write((const uint8_t*)_row_buff, ai_prediction_format_row(row, _first_line, _row_buff));
 		_first_line = false;
-		logFile.println("\n\t\t]\n\t}\n}");
-		
-		logFile.close();
 	}
 	else 
 	{
@@ -943,6 +966,8 @@ demo_ret_code bsecDataLogger::write_sensor_data(const uint8_t* num, const uint32
 	demo_ret_code ret_code = EDK_OK;
 	uint32_t rtc_tsp = utils::get_rtc().now().unixtime();
 	uint32_t time_since_power_on = millis();
+	raw_data_record record = {};
+	uint8_t buff[RAW_DATA_RECORD_SIZE + 1];
 
 	//Copying time for sync with aiprediction file
 	if (bme68xData != nullptr)
@@ -958,39 +983,36 @@ demo_ret_code bsecDataLogger::write_sensor_data(const uint8_t* num, const uint32
 		}
 	}
 
-	if (_end_of_line)
-	{
-		_bs << ",\n";
-	}
-	_bs << "\t\t\t[\n\t\t\t\t";
-	(num != nullptr) ? (_bs << (int32_t)*num) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	(sensor_id != nullptr) ? (_bs << (int32_t)*sensor_id) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	_bs << time_since_power_on;
-	_bs << ",\n\t\t\t\t";
-	_bs << rtc_tsp;
-	_bs << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_bs << bme68xData->temperature) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_bs << bme68xData->pressure) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_bs << bme68xData->humidity) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_bs << bme68xData->gas_resistance) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	(bme68xData != nullptr) ? (_bs << (int32_t)bme68xData->gas_index) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	_bs << (bool)(BME68X_PARALLEL_MODE);
-	_bs << ",\n\t\t\t\t";
-	(scan_cycle_index != nullptr) ? (_bs << (int32_t)(*scan_cycle_index)) : (_bs << "null");
-	_bs << ",\n\t\t\t\t";
-	_bs << ground_truth;
-	_bs << ",\n\t\t\t\t";
-	_bs << (int32_t)code;
-	_bs << "\n\t\t\t]";
-
-	_end_of_line = true;
+	if (num != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_NUM;
+		record.sensor_num = *num;
+	}
+	if (sensor_id != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_SENSOR_ID;
+		record.sensor_id = *sensor_id;
+	}
+	if (bme68xData != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_DATA;
+		record.temperature = bme68xData->temperature;
+		record.pressure = bme68xData->pressure;
+		record.humidity = bme68xData->humidity;
+		record.gas_resistance = bme68xData->gas_resistance;
+		record.gas_index = bme68xData->gas_index;
+	}
+	if (scan_cycle_index != nullptr)
+	{
+		record.present |= RAW_DATA_HAS_SCAN_CYCLE;
+		record.scan_cycle_index = *scan_cycle_index;
+	}
+	record.rtc = rtc_tsp;
+	record.time_since_power_on = time_since_power_on;
+	record.label = ground_truth;
+	record.code = (int32_t)code;
+
+	(void)_writer.write(buff, raw_data_encode_record(record, buff));
    
   return ret_code;
 }
@@ -51,8 +51,9 @@
 #include "utils.h"
 #include "demo_app.h"
 #include "label_provider.h"
-#include <sstream>
-#include <iostream>
+#include "raw_data_format.h"
+#include "ai_prediction_format.h"
+#include <sdLog/sdLogWriter.h>
 
 /* Number of sensors to operate*/
 #define NUM_OF_SENS    		UINT8_C(4)
@@ -65,13 +66,14 @@ class bsecDataLogger
 {
 private:
 	String _ai_config_name, _ai_file_name, _bme_file_name, _label_file_name;
-	std::stringstream _bs, _ba;
-	uint32_t _ai_data_pos = 0, _bme_data_pos = 0;
+	sdLogWriter _writer, _ai_writer;
+	uint32_t _writer_errors = 0, _ai_writer_errors = 0;
+	/* Text of one BSEC output, the sensors take turns under the output lock of the BSEC runtime */
+	char _row_buff[AI_PREDICTION_ROW_MAX];
 	uint32_t _bme_file_counter = 1;
 	uint32_t _bsec_file_counter = 1;
 	bool _first_line = false;
 	bsec_version_t _version;
-	bool _end_of_line = false;
 	String config_string;
 	
 	/*!
@@ -82,7 +84,7 @@ private:
 	demo_ret_code create_bsec_file();
 
 	/*!
-	 * @brief	:	This function creates a bme68x datalogger output file
+	 * @brief	:	This function creates a bme68x datalogger output file with .bmerawbin extension, see raw_data_format.h
 	 * 
 	 * @param[in] sensorNum	:	Selected sensor number
 	 *
@@ -151,14 +153,31 @@ public:
 	demo_ret_code begin(const String& config_name, const bsec_version_t& bsec_version, uint8_t sensor_num);
 	
 	/*!
-	 * @brief : This function flushes the buffered sensor data to the current log file
+	 * @brief : This function checks the writes of the current log files and starts the next
+	 *			raw data file once the size limit is reached, the data is written by the SD log tasks
 	 * 
+	 * @param[in] sensorNum	:	Selected sensor number
+	 *
      * @return  bosch error code
 	 */
 	demo_ret_code flush_sensor_data(uint8_t sensor_num);
 
 	/*!
-	 * @brief : This function writes the bsec output to the current log file.
+	 * @brief : This function writes the buffered sensor data and bsec outputs and closes the current log files
+	 * 
+     * @return  bosch error code
+	 */
+	demo_ret_code end();
+
+	/*!
+	 * @brief : This function waits until the log files ended before are closed, e.g. before the SD card is set up again
+	 * 
+     * @return  bosch error code
+	 */
+	demo_ret_code wait_closed();
+
+	/*!
+	 * @brief : This function formats the bsec output and hands it to the SD log task of the bsec output file.
 	 * 
 	 * @param[in] buffData : reference to the buffered data
      * 
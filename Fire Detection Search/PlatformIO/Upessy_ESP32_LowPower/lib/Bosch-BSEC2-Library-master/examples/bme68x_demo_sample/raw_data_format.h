@@ -0,0 +1,204 @@
+/*!
+ * @file	raw_data_format.h
+ *
+ * @brief	Binary format of the bme68x raw data log files
+ *
+ * A file starts with a header, followed by the JSON text the .bmerawdata file
+ * has before its first data row (configuration, rawDataHeader, dataColumns and
+ * the opening of dataBlock). Then come the records, one per sample, each with
+ * a length byte in front so that later versions can append fields. The length
+ * bytes 0x00 and 0xFF are never used, they mark the unwritten end of a file
+ * preallocated by the SD log task that was not closed. All values are little
+ * endian. The host converter src/tools/bmerawdata_json.cpp prints the
+ * records as the dataBlock rows of the .bmerawdata JSON schema.
+ *
+ * Header, RAW_DATA_HEADER_SIZE bytes:
+ * 	magic u32, version u16, kind u8, reserved u8, length of the JSON text u32
+ *
+ * Record payload, RAW_DATA_RECORD_SIZE bytes in version 1:
+ * 	present u8, sensor number u8, gas index u8, sensor id u32,
+ * 	time since power on u32 (ms), real time clock u32 (s), temperature f32,
+ * 	pressure f32, humidity f32, gas resistance f32, scanning cycle index u32,
+ * 	label u32, error code i32
+ */
+
+#ifndef RAW_DATA_FORMAT_H
+#define RAW_DATA_FORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* "BMER" */
+#define RAW_DATA_MAGIC					UINT32_C(0x52454D42)
+#define RAW_DATA_VERSION				UINT16_C(1)
+#define RAW_DATA_HEADER_SIZE			UINT8_C(12)
+#define RAW_DATA_RECORD_SIZE			UINT8_C(43)
+
+/* Logger which wrote the file, the JSON rows of each differ in number formatting */
+#define RAW_DATA_KIND_BME68X			UINT8_C(0)
+#define RAW_DATA_KIND_BSEC				UINT8_C(1)
+
+/* Fields of a record that are present, the others are written as null */
+#define RAW_DATA_HAS_NUM				UINT8_C(0x01)
+#define RAW_DATA_HAS_SENSOR_ID			UINT8_C(0x02)
+#define RAW_DATA_HAS_DATA				UINT8_C(0x04)
+#define RAW_DATA_HAS_SCAN_CYCLE			UINT8_C(0x08)
+
+/*!
+ * @brief : Header of a raw data log file
+ */
+typedef struct
+{
+	/*! logger which wrote the file, RAW_DATA_KIND_BME68X or RAW_DATA_KIND_BSEC */
+	uint8_t kind;
+
+	/*! length of the JSON text after the header */
+	uint32_t text_len;
+} raw_data_header;
+
+/*!
+ * @brief : One sample, the columns of a dataBlock row
+ */
+typedef struct
+{
+	/*! fields present, RAW_DATA_HAS_xxx bits */
+	uint8_t present;
+	uint8_t sensor_num;
+	uint8_t gas_index;
+	uint32_t sensor_id;
+	uint32_t time_since_power_on;
+	uint32_t rtc;
+	float temperature;
+	float pressure;
+	float humidity;
+	float gas_resistance;
+	uint32_t scan_cycle_index;
+	uint32_t label;
+	int32_t code;
+} raw_data_record;
+
+static inline uint8_t *raw_data_put_u32(uint8_t *buff, uint32_t value)
+{
+	buff[0] = (uint8_t)value;
+	buff[1] = (uint8_t)(value >> 8);
+	buff[2] = (uint8_t)(value >> 16);
+	buff[3] = (uint8_t)(value >> 24);
+	return buff + 4;
+}
+
+static inline uint32_t raw_data_get_u32(const uint8_t *buff)
+{
+	return (uint32_t)buff[0] | ((uint32_t)buff[1] << 8) | ((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 24);
+}
+
+static inline uint8_t *raw_data_put_f32(uint8_t *buff, float value)
+{
+	uint32_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	return raw_data_put_u32(buff, bits);
+}
+
+static inline float raw_data_get_f32(const uint8_t *buff)
+{
+	uint32_t bits = raw_data_get_u32(buff);
+	float value;
+
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/*!
+ * @brief : Encodes the file header
+ *
+ * @param[in] header	: header to encode
+ * @param[out] buff		: RAW_DATA_HEADER_SIZE bytes
+ */
+static inline void raw_data_encode_header(const raw_data_header& header, uint8_t *buff)
+{
+	buff = raw_data_put_u32(buff, RAW_DATA_MAGIC);
+	*buff++ = (uint8_t)RAW_DATA_VERSION;
+	*buff++ = (uint8_t)(RAW_DATA_VERSION >> 8);
+	*buff++ = header.kind;
+	*buff++ = 0;
+	(void)raw_data_put_u32(buff, header.text_len);
+}
+
+/*!
+ * @brief : Decodes the file header
+ *
+ * @param[in] buff		: RAW_DATA_HEADER_SIZE bytes
+ * @param[out] header	: decoded header
+ *
+ * @return  true if the magic and the version are known, false otherwise
+ */
+static inline bool raw_data_decode_header(const uint8_t *buff, raw_data_header& header)
+{
+	if ((raw_data_get_u32(buff) != RAW_DATA_MAGIC) || ((buff[4] | (buff[5] << 8)) != RAW_DATA_VERSION))
+	{
+		return false;
+	}
+	header.kind = buff[6];
+	header.text_len = raw_data_get_u32(buff + 8);
+	return true;
+}
+
+/*!
+ * @brief : Encodes a record with its length byte
+ *
+ * @param[in] record	: record to encode
+ * @param[out] buff		: RAW_DATA_RECORD_SIZE + 1 bytes
+ *
+ * @return  number of bytes written
+ */
+static inline uint8_t raw_data_encode_record(const raw_data_record& record, uint8_t *buff)
+{
+	*buff++ = RAW_DATA_RECORD_SIZE;
+	*buff++ = record.present;
+	*buff++ = record.sensor_num;
+	*buff++ = record.gas_index;
+	buff = raw_data_put_u32(buff, record.sensor_id);
+	buff = raw_data_put_u32(buff, record.time_since_power_on);
+	buff = raw_data_put_u32(buff, record.rtc);
+	buff = raw_data_put_f32(buff, record.temperature);
+	buff = raw_data_put_f32(buff, record.pressure);
+	buff = raw_data_put_f32(buff, record.humidity);
+	buff = raw_data_put_f32(buff, record.gas_resistance);
+	buff = raw_data_put_u32(buff, record.scan_cycle_index);
+	buff = raw_data_put_u32(buff, record.label);
+	(void)raw_data_put_u32(buff, (uint32_t)record.code);
+	return RAW_DATA_RECORD_SIZE + 1;
+}
+
+/*!
+ * @brief : Decodes a record payload, the fields of later versions are skipped
+ *
+ * @param[in] buff		: payload, after the length byte
+ * @param[in] len		: length byte of the record
+ * @param[out] record	: decoded record
+ *
+ * @return  true if the payload holds all the fields of this version, false otherwise
+ */
+static inline bool raw_data_decode_record(const uint8_t *buff, uint8_t len, raw_data_record& record)
+{
+	if (len < RAW_DATA_RECORD_SIZE)
+	{
+		return false;
+	}
+	record.present = buff[0];
+	record.sensor_num = buff[1];
+	record.gas_index = buff[2];
+	record.sensor_id = raw_data_get_u32(buff + 3);
+	record.time_since_power_on = raw_data_get_u32(buff + 7);
+	record.rtc = raw_data_get_u32(buff + 11);
+	record.temperature = raw_data_get_f32(buff + 15);
+	record.pressure = raw_data_get_f32(buff + 19);
+	record.humidity = raw_data_get_f32(buff + 23);
+	record.gas_resistance = raw_data_get_f32(buff + 27);
+	record.scan_cycle_index = raw_data_get_u32(buff + 31);
+	record.label = raw_data_get_u32(buff + 35);
+	record.code = (int32_t)raw_data_get_u32(buff + 39);
+	return true;
+}
+
+#endif
@@ -43,14 +43,52 @@
 #include "sensor_manager.h"
 
 bme68x_sensor 	sensorManager::_sensors[NUM_BME68X_UNITS];
+sensorScheduler<NUM_BME68X_UNITS> sensorManager::_scheduler;
 comm_mux comm_setup[NUM_BME68X_UNITS];
 
+/*!
+ * @brief This function returns the scheduler queue of a sensor
+ */
+static uint8_t get_queue(const bme68x_sensor& sensor)
+{
+	if (!sensor.is_configured)
+	{
+		return SCHEDULER_NOT_QUEUED;
+	}
+
+	switch (sensor.mode)
+	{
+		case BME68X_PARALLEL_MODE:
+			return SCHEDULER_QUEUE_PARALLEL;
+		case BME68X_SLEEP_MODE:
+			return SCHEDULER_QUEUE_SLEEP;
+		default:
+			return SCHEDULER_NOT_QUEUED;
+	}
+}
+
 /*!
  * @brief The constructor of the sensorManager class
  */
 sensorManager::sensorManager()
 {}
 
+/*!
+ * @brief This function puts the sensor in the queue of its mode
+ */
+void sensorManager::queue_sensor(uint8_t num)
+{
+	_scheduler.queue(num, get_queue(_sensors[num]), _sensors[num].wake_up_time);
+}
+
+/*!
+ * @brief This function schedules the next readable bme688 sensor
+ */
+bool sensorManager::schedule_sensor(uint8_t& num, uint64_t& wake_up_time)
+{
+	return _scheduler.schedule(utils::get_tick_ms(), num, wake_up_time);
+}
+
 /*!
  * @brief This function initializes the given BME688 sensor
  */
@@ -213,6 +251,7 @@ demo_ret_code sensorManager::begin(const String& config_name)
 	}
 	
 	memset(_sensors, 0, sizeof(_sensors));
+	_scheduler.clear();
 
 	JsonArray devicefigurations = _configDoc["configBody"]["sensorConfigurations"].as<JsonArray>();
 
@@ -255,6 +294,7 @@ demo_ret_code sensorManager::begin(const String& config_name)
 		}	
 		
 		sensor->is_configured = true;
+		queue_sensor(sensor_number);
 	}
 	return EDK_OK;
 }
@@ -279,6 +319,8 @@ demo_ret_code sensorManager::collect_data(uint8_t num, bme68x_data* data[3])
 
 	if (sensor->is_configured && (time_stamp >= sensor->wake_up_time))
 	{
+		/* Keeps the chip select of the sensor until its registers are done */
+		comm_mux_begin_transaction(comm_setup[num]);
 
 		/* Wake up the sensor if necessary */
 		if (sensor->mode == BME68X_SLEEP_MODE)
@@ -344,6 +386,10 @@ demo_ret_code sensorManager::collect_data(uint8_t num, bme68x_data* data[3])
 				sensor->wake_up_time = time_stamp + GAS_WAIT_SHARED;
 			}
 		}
+		comm_mux_end_transaction(comm_setup[num]);
+
+		/* the mode or the wake up time changed, moves the sensor in the scheduler */
+		queue_sensor(num);
 		
 		if (bme68x_rslt < BME68X_OK)
 		{
@@ -53,6 +53,7 @@
 #include "demo_app.h"
 #include <bme68xLibrary.h>
 #include <commMux\commMux.h>
+#include "sensor_scheduler.h"
 
 /* I2C-Expander masks */
 #define I2C_EXPANDER_ADDR 				0x20
@@ -78,6 +79,18 @@ private:
 	bme68x_data 		 _field_data[3];
 
 	StaticJsonDocument<JSON_DOC_SIZE>	_configDoc;
+
+	/* The sensors by wake up time, one min-heap per operation mode */
+	static sensorScheduler<NUM_BME68X_UNITS> _scheduler;
+
+	/*!
+	 * @brief : This function puts the sensor in the queue of its mode, keyed by its wake up time.
+	 *			Unconfigured sensors and sensors in other modes are not scheduled. It is called
+	 *			whenever the sensor manager changes the mode or the wake up time of a sensor
+	 * 
+	 * @param[in] num : Sensor number
+	 */
+	static void queue_sensor(uint8_t num);
 	
 	/*!
 	 * @brief : This function initializes the given BME688 sensor
@@ -130,47 +143,15 @@ public:
 	};
 	
 	/*!
-	 * @brief : This function selects next readable bme688 sensor in given operation mode
+	 * @brief : This function schedules the next readable bme688 sensor. The sensors in parallel mode
+	 *			go first: while one of them is due within SCHEDULER_LOOKAHEAD_MS, the sleeping sensors wait
 	 * 
-	 * @param[inout] num	: Reference to the sensor number
-	 * @param[in] mode		: The sensor operation mode
+	 * @param[out] num			: Reference to the sensor number
+	 * @param[out] wake_up_time	: Earliest wake up time of the sensors when none is due, in ms
      * 
-     * @return  True if available
+     * @return  True if a sensor is due
 	 */
-	static inline bool select_next_sensor(uint64_t& wake_up_time, uint8_t& num, uint8_t mode)
-	{
-		num = (uint8_t)0xFF;
-
-		for (uint8_t i = 0; i < NUM_BME68X_UNITS; i++)
-		{
-
-			if ((_sensors[i].mode == mode) && (_sensors[i].wake_up_time < wake_up_time))
-			{
-				wake_up_time = _sensors[i].wake_up_time;
-				num = i;
-			}
-		}
-		
-		if (num < NUM_BME68X_UNITS)
-		{
-			return true;
-		}
-		return false;
-	}
-	
-	/*!
-	 * @brief : This function schedules the next readable bme688 sensor
-	 * 
-	 * @param[inout] num : Reference to the sensor number
-     * 
-     * @return  True if available
-	 */
-	static inline bool schedule_sensor(uint8_t& num)
-	{
-		uint64_t wake_up_time = utils::get_tick_ms() + 20;
-		return (select_next_sensor(wake_up_time, num, BME68X_PARALLEL_MODE) ||
-		        select_next_sensor(wake_up_time, num, BME68X_SLEEP_MODE));
-	};
+	static bool schedule_sensor(uint8_t& num, uint64_t& wake_up_time);
 	
     /*!
      * @brief : The constructor of the sensorManager class
@@ -0,0 +1,226 @@
+/*!
+ * @file	sensor_scheduler.h
+ *
+ * @brief	Scheduler of the sensor manager, the sensors by wake up time in one min-heap per operation mode
+ *
+ * The sensor manager puts a sensor in the queue of its mode whenever it changes the mode or the wake
+ * up time of the sensor, so scheduling only looks at the tops of the heaps. The scheduler does not
+ * depend on Arduino, the host checks run the same code.
+ */
+
+#ifndef SENSOR_SCHEDULER_H
+#define SENSOR_SCHEDULER_H
+
+#include <stdint.h>
+
+#define SCHEDULER_LOOKAHEAD_MS			UINT8_C(20)
+/* Scheduler queues, one per operation mode the sensor manager runs the sensors in */
+#define SCHEDULER_QUEUE_PARALLEL		UINT8_C(0)
+#define SCHEDULER_QUEUE_SLEEP			UINT8_C(1)
+#define SCHEDULER_NUM_QUEUES			UINT8_C(2)
+#define SCHEDULER_NOT_QUEUED			UINT8_C(0xFF)
+
+/*!
+ * @brief : Class scheduling up to num_sensors sensors
+ */
+template <uint8_t num_sensors>
+class sensorScheduler
+{
+	static_assert(num_sensors <= 127, "the heap positions and their children are 8 bit");
+
+private:
+	/*!
+	 * @brief : Min-heap of sensors keyed by wake up time
+	 */
+	struct sensor_queue
+	{
+		uint8_t 	count;
+		uint8_t 	num[num_sensors];
+		uint64_t 	wake_up_time[num_sensors];
+	};
+
+	sensor_queue 	_queues[SCHEDULER_NUM_QUEUES];
+	/* Queue and heap position of each sensor, SCHEDULER_NOT_QUEUED if it is not scheduled */
+	uint8_t 		_queue_of[num_sensors];
+	uint8_t 		_queue_pos[num_sensors];
+
+	/*!
+	 * @brief : This function swaps two heap entries of a queue
+	 */
+	void swap_entries(sensor_queue& queue, uint8_t a, uint8_t b)
+	{
+		uint8_t num = queue.num[a];
+		uint64_t wake_up_time = queue.wake_up_time[a];
+
+		queue.num[a] = queue.num[b];
+		queue.wake_up_time[a] = queue.wake_up_time[b];
+		queue.num[b] = num;
+		queue.wake_up_time[b] = wake_up_time;
+
+		_queue_pos[queue.num[a]] = a;
+		_queue_pos[queue.num[b]] = b;
+	}
+
+	/*!
+	 * @brief : This function restores the heap order from the given position
+	 */
+	void sift(sensor_queue& queue, uint8_t pos)
+	{
+		/* up, while the entry wakes up before its parent */
+		while ((pos > 0) && (queue.wake_up_time[pos] < queue.wake_up_time[(pos - 1) / 2]))
+		{
+			swap_entries(queue, pos, (pos - 1) / 2);
+			pos = (pos - 1) / 2;
+		}
+
+		/* down, while a child wakes up before the entry */
+		for (;;)
+		{
+			uint8_t first = pos;
+			uint8_t left = 2 * pos + 1;
+			uint8_t right = left + 1;
+
+			if ((left < queue.count) && (queue.wake_up_time[left] < queue.wake_up_time[first]))
+			{
+				first = left;
+			}
+
+			if ((right < queue.count) && (queue.wake_up_time[right] < queue.wake_up_time[first]))
+			{
+				first = right;
+			}
+
+			if (first == pos)
+			{
+				break;
+			}
+			swap_entries(queue, pos, first);
+			pos = first;
+		}
+	}
+
+public:
+	sensorScheduler()
+	{
+		clear();
+	}
+
+	/*!
+	 * @brief : This function removes all the sensors
+	 */
+	void clear()
+	{
+		for (uint8_t q = 0; q < SCHEDULER_NUM_QUEUES; q++)
+		{
+			_queues[q].count = 0;
+		}
+
+		for (uint8_t i = 0; i < num_sensors; i++)
+		{
+			_queue_of[i] = SCHEDULER_NOT_QUEUED;
+		}
+	}
+
+	/*!
+	 * @brief : This function removes the sensor from its queue
+	 *
+	 * @param[in] num : Sensor number
+	 */
+	void dequeue(uint8_t num)
+	{
+		if (_queue_of[num] == SCHEDULER_NOT_QUEUED)
+		{
+			return;
+		}
+
+		sensor_queue& queue = _queues[_queue_of[num]];
+		uint8_t pos = _queue_pos[num];
+
+		swap_entries(queue, pos, queue.count - 1);
+		queue.count--;
+
+		if (pos < queue.count)
+		{
+			sift(queue, pos);
+		}
+		_queue_of[num] = SCHEDULER_NOT_QUEUED;
+	}
+
+	/*!
+	 * @brief : This function moves the sensor to a queue, keyed by its wake up time
+	 *
+	 * @param[in] num			: Sensor number
+	 * @param[in] queue_idx		: Queue of the mode of the sensor, SCHEDULER_NOT_QUEUED to only remove it
+	 * @param[in] wake_up_time	: Wake up time of the sensor, in ms
+	 */
+	void queue(uint8_t num, uint8_t queue_idx, uint64_t wake_up_time)
+	{
+		dequeue(num);
+
+		if (queue_idx >= SCHEDULER_NUM_QUEUES)
+		{
+			return;
+		}
+
+		sensor_queue& queue = _queues[queue_idx];
+		uint8_t pos = queue.count++;
+
+		queue.num[pos] = num;
+		queue.wake_up_time[pos] = wake_up_time;
+		_queue_of[num] = queue_idx;
+		_queue_pos[num] = pos;
+		sift(queue, pos);
+	}
+
+	/*!
+	 * @brief : This function picks the next due sensor. The sensors in parallel mode go first: while one
+	 *			of them is due within SCHEDULER_LOOKAHEAD_MS, the sleeping sensors wait
+	 *
+	 * @param[in] time_stamp	: Current time, in ms
+	 * @param[out] num			: Sensor number
+	 * @param[out] wake_up_time	: Earliest wake up time of the sensors when none is due, in ms
+	 *
+	 * @return  True if a sensor is due
+	 */
+	bool schedule(uint64_t time_stamp, uint8_t& num, uint64_t& wake_up_time) const
+	{
+		const sensor_queue& parallel = _queues[SCHEDULER_QUEUE_PARALLEL];
+		const sensor_queue& sleeping = _queues[SCHEDULER_QUEUE_SLEEP];
+
+		wake_up_time = UINT64_MAX;
+
+		if (parallel.count > 0)
+		{
+			wake_up_time = parallel.wake_up_time[0];
+
+			if (wake_up_time <= time_stamp)
+			{
+				num = parallel.num[0];
+				return true;
+			}
+
+			/* a parallel mode read is close, it goes before the wake up of a sleeping sensor */
+			if (wake_up_time < (time_stamp + SCHEDULER_LOOKAHEAD_MS))
+			{
+				return false;
+			}
+		}
+
+		if (sleeping.count > 0)
+		{
+			if (sleeping.wake_up_time[0] <= time_stamp)
+			{
+				num = sleeping.num[0];
+				return true;
+			}
+
+			if (sleeping.wake_up_time[0] < wake_up_time)
+			{
+				wake_up_time = sleeping.wake_up_time[0];
+			}
+		}
+		return false;
+	}
+};
+
+#endif
@@ -48,6 +48,7 @@
 #include "demo_app.h"
 
 #define BME68X_RAWDATA_FILE_EXT 		".bmerawdata"
+#define BME68X_RAWDATA_BIN_FILE_EXT 	".bmerawbin"
 #define BME68X_LABEL_INFO_FILE_EXT 		".bmelabelinfo"
 #define BME68X_CONFIG_FILE_EXT 			".bmeconfig"
 #define BSEC_CONFIG_FILE_EXT 			".config"
@@ -114,7 +114,12 @@ void loop(void)
      */
     for (sensor = 0; sensor < NUM_OF_SENS; sensor++)
     {
-        if (!envSensor[sensor].run())
+        /* The chip select moves to the next sensor only once this one is done */
+        comm_mux_begin_transaction(communicationSetup[sensor]);
+        bool ok = envSensor[sensor].run();
+        comm_mux_end_transaction(communicationSetup[sensor]);
+
+        if (!ok)
         {
          checkBsecStatus(envSensor[sensor]);
         }
@@ -1,7 +1,29 @@
 Import('env')
 from os.path import join, realpath
 
-env.Append(
-    LIBPATH=[realpath(join('src', env.get('BOARD_MCU')))],
-    LIBS=['algobsec']
-)
+mcu = env.get('BOARD_MCU')
+if mcu:
+    env.Append(
+        LIBPATH=[realpath(join('src', mcu))],
+        LIBS=['algobsec']
+    )
+else:
+    # Host build: link the libalgobsec.a found in custom_bsec_native_lib if the project gives one,
+    # otherwise the project builds with -D BSEC_STANDIN, see src/bsecStandin.h
+    nativeLib = env.GetProjectOption('custom_bsec_native_lib', '')
+    if nativeLib:
+        env.Append(
+            LIBPATH=[realpath(join(env.subst('$PROJECT_DIR'), nativeLib))],
+            LIBS=['algobsec']
+        )
+
+# Report the RAM reserved by the static allocation mode, see BSEC2_STATIC_INSTANCES in bsec2.h
+BSEC_INSTANCE_SIZE = 3272
+BSEC_MAX_WORKBUFFER_SIZE = 4096
+
+for define in env.get('CPPDEFINES', []):
+    if isinstance(define, (list, tuple)) and define[0] == 'BSEC2_STATIC_INSTANCES':
+        instances = int(define[1])
+        poolSize = instances * (BSEC_INSTANCE_SIZE + BSEC_MAX_WORKBUFFER_SIZE)
+        print('Bsec2 static pool: %d instances, %d bytes (+%d bytes shared work buffer)'
+              % (instances, poolSize, BSEC_MAX_WORKBUFFER_SIZE))
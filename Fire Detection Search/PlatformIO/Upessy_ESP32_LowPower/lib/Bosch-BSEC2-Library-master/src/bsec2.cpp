@@ -38,20 +38,106 @@
 
 #include "bsec2.h"
 
-static uint8_t workBuffer[BSEC_MAX_WORKBUFFER_SIZE];
+/* Work buffer of the instances without their own, guarded on ESP32 and in the host benchmarks where instances may
+   run in several tasks */
+static uint8_t sharedWorkBuffer[BSEC_MAX_WORKBUFFER_SIZE];
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+static SemaphoreHandle_t sharedWorkBufferLock = NULL;
+static StaticSemaphore_t sharedWorkBufferLockMem;
+static portMUX_TYPE sharedWorkBufferInit = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+#ifdef BSEC2_STATIC_INSTANCES
+#define BSEC2_STR_(x) #x
+#define BSEC2_STR(x) BSEC2_STR_(x)
+#pragma message("Bsec2 static pool: " BSEC2_STR(BSEC2_STATIC_INSTANCES) " x (" BSEC2_STR(BSEC_INSTANCE_SIZE) " + " \
+        BSEC2_STR(BSEC_MAX_WORKBUFFER_SIZE) ") bytes")
+
+#ifdef BSEC2_STATIC_RAM_BUDGET
+static_assert(BSEC2_STATIC_POOL_SIZE + BSEC_MAX_WORKBUFFER_SIZE <= BSEC2_STATIC_RAM_BUDGET,
+        "Bsec2 static pool and shared work buffer exceed BSEC2_STATIC_RAM_BUDGET");
+#endif
+
+/* Memory blocks and work buffers handed out by begin in place of the heap */
+static uint8_t instancePool[BSEC2_STATIC_INSTANCES][BSEC_INSTANCE_SIZE];
+static uint8_t workBufferPool[BSEC2_STATIC_INSTANCES][BSEC_MAX_WORKBUFFER_SIZE];
+static bool poolUsed[BSEC2_STATIC_INSTANCES];
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+static portMUX_TYPE poolLock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+/**
+ * @brief Function to take a free slot of the static pool
+ * @return slot index, -1 if every slot is in use
+ */
+static int8_t claimPoolSlot(void)
+{
+    int8_t slot = -1;
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    portENTER_CRITICAL(&poolLock);
+#endif
+    for (int8_t i = 0; i < BSEC2_STATIC_INSTANCES; i++)
+    {
+        if (!poolUsed[i])
+        {
+            poolUsed[i] = true;
+            slot = i;
+            break;
+        }
+    }
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    portEXIT_CRITICAL(&poolLock);
+#endif
+
+    return slot;
+}
+
+/**
+ * @brief Function to give a slot back to the static pool
+ */
+static void releasePoolSlot(int8_t slot)
+{
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    portENTER_CRITICAL(&poolLock);
+#endif
+    poolUsed[slot] = false;
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    portEXIT_CRITICAL(&poolLock);
+#endif
+}
+#endif
 
 /**
  * @brief Constructor of Bsec2 class
  */
 Bsec2::Bsec2(void)
 {
-    ovfCounter = 0;
-    lastMillis = 0;
+    clock = nullptr;
+    resumed = false;
     status = BSEC_OK;
     extTempOffset = 0.0f;
     opMode = BME68X_SLEEP_MODE;
+    seqEnabled = false;
+    seqActive = false;
+    seqGasIndex = 0;
+    seqFieldNs = 0;
+    seqProfileLen = 0;
+    seqMeasDurUs = 0;
     newDataCallback = nullptr;
+    newDataRefCallback = nullptr;
+    callbackCtx = nullptr;
     bsecInstance = nullptr;
+    workBuffer = nullptr;
+    ownsInstance = false;
+    poolSlot = -1;
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    portENTER_CRITICAL(&sharedWorkBufferInit);
+    if (sharedWorkBufferLock == NULL)
+        sharedWorkBufferLock = xSemaphoreCreateMutexStatic(&sharedWorkBufferLockMem);
+    portEXIT_CRITICAL(&sharedWorkBufferInit);
+#endif
 
     memset(&version, 0, sizeof(version));
     memset(&bmeConf, 0, sizeof(bmeConf));
@@ -125,39 +211,59 @@ bool Bsec2::updateSubscription(bsecSensor sensorList[], uint8_t nSensors, float
  */
 bool Bsec2::run(void)
 {
-    uint8_t nFieldsLeft = 0;
-    bme68xData data;
     int64_t currTimeNs = getTimeMs() * INT64_C(1000000);
     opMode = bmeConf.op_mode;
     //printf("opMode %d\n", opMode);
     //printf("currTimeNs: %ld ", currTimeNs);
     //printf("bmeConf.next_call: %ld\n", bmeConf.next_call);
-    if (currTimeNs >= bmeConf.next_call)
+    if (currTimeNs >= getNextCallNs())
     {
-        
+        bool seqDrained = seqActive;
+
+        /* The sequential fields were measured before this call, BSEC gets them before it plans the next steps */
+        if (seqActive && !fetchFields(currTimeNs))
+            return false;
+
+        /* The last step of the profile is read, the sensor stops before it measures the next loop. A
+           profile requested again is started over from its first step */
+        if (seqActive && (seqGasIndex >= seqProfileLen))
+        {
+            seqActive = false;
+            sensor.setOpMode(BME68X_SLEEP_MODE);
+            opMode = BME68X_SLEEP_MODE;
+        }
+
         /* Provides the information about the current sensor configuration that is
            necessary to fulfill the input requirements, eg: operation mode, timestamp
            at which the sensor data shall be fetched etc */
         status = bsec_sensor_control_m(bsecInstance ,currTimeNs, &bmeConf);
+        /* In sequential mode the call waits for the fields, later than next_call by design */
+        if (status == BSEC_W_SC_CALL_TIMING_VIOLATION && seqDrained)
+            status = BSEC_OK;
         if (status != BSEC_OK)
             return false;
 
         switch (bmeConf.op_mode)
         {
         case BME68X_FORCED_MODE:
+            seqActive = false;
             setBme68xConfigForced();
             break;
         case BME68X_PARALLEL_MODE:
             //setBme68xConfigForced();
             if (opMode != bmeConf.op_mode)
             {
-                setBme68xConfigParallel();
+                if (seqEnabled)
+                    setBme68xConfigSequential();
+                else
+                    setBme68xConfigParallel();
             }
             break;
 
         case BME68X_SLEEP_MODE:
             if (opMode != bmeConf.op_mode)
             {
+                seqActive = false;
                 sensor.setOpMode(BME68X_SLEEP_MODE);
                 opMode = BME68X_SLEEP_MODE;
             }
@@ -167,36 +273,46 @@ bool Bsec2::run(void)
         if (sensor.checkStatus() == BME68X_ERROR)
             return false;
 
-        if (bmeConf.trigger_measurement && bmeConf.op_mode != BME68X_SLEEP_MODE)
+        if (bmeConf.trigger_measurement && bmeConf.op_mode != BME68X_SLEEP_MODE && !seqActive)
         {
-            if (sensor.fetchData())
-            {
-                
-                do
-                {
-                    nFieldsLeft = sensor.getData(data);
-                    /* check for valid gas data */
-                    if (data.status & BME68X_GASM_VALID_MSK)
-                    {
-
-						/* Convert sensor raw pressure unit from pascal to hecto pascal */
-						data.pressure *= 0.01f;
-
-                        if (!processData(currTimeNs, data))
-                        {
-                        //printf("Hello World\n");
-                            return false;
-                        }
-                    }
-                } while (nFieldsLeft);
-            }
-
+            if (!fetchFields(currTimeNs))
+                return false;
         }
 
     }
     return true;
 }
 
+/**
+ * @brief Reads the fields of the BME68X and processes the ones with valid gas data
+ */
+bool Bsec2::fetchFields(int64_t currTimeNs)
+{
+    uint8_t nFieldsLeft = 0;
+    bme68xData data;
+    int64_t fieldNs;
+
+    if (sensor.fetchData())
+    {
+        do
+        {
+            nFieldsLeft = sensor.getData(data);
+            fieldNs = currTimeNs;
+            /* check for valid gas data, in sequential mode of a step of the profile not read yet */
+            if ((data.status & BME68X_GASM_VALID_MSK) && (!seqActive || seqTakeField(data.gas_index, currTimeNs, fieldNs)))
+            {
+                /* Convert sensor raw pressure unit from pascal to hecto pascal */
+                data.pressure *= 0.01f;
+
+                if (!processData(fieldNs, data))
+                    return false;
+            }
+        } while (nFieldsLeft);
+    }
+
+    return true;
+}
+
 /**
  * @brief Function to get the state of the algorithm to save to non-volatile memory
  */
@@ -204,8 +320,11 @@ bool Bsec2::getState(uint8_t *state)
 {
     uint32_t n_serialized_state = BSEC_MAX_STATE_BLOB_SIZE;
 
-    status = bsec_get_state_m(bsecInstance, 0, state, BSEC_MAX_STATE_BLOB_SIZE, workBuffer, BSEC_MAX_WORKBUFFER_SIZE,
+    uint8_t *buffer = acquireWorkBuffer();
+
+    status = bsec_get_state_m(bsecInstance, 0, state, BSEC_MAX_STATE_BLOB_SIZE, buffer, BSEC_MAX_WORKBUFFER_SIZE,
             &n_serialized_state);
+    releaseWorkBuffer();
     if (status != BSEC_OK)
         return false;
     return true;
@@ -216,11 +335,15 @@ bool Bsec2::getState(uint8_t *state)
  */
 bool Bsec2::setState(uint8_t *state)
 {
-    status = bsec_set_state_m(bsecInstance, state, BSEC_MAX_STATE_BLOB_SIZE, workBuffer, BSEC_MAX_WORKBUFFER_SIZE);
+    uint8_t *buffer = acquireWorkBuffer();
+
+    status = bsec_set_state_m(bsecInstance, state, BSEC_MAX_STATE_BLOB_SIZE, buffer, BSEC_MAX_WORKBUFFER_SIZE);
+    releaseWorkBuffer();
     if (status != BSEC_OK)
         return false;
 
     memset(&bmeConf, 0, sizeof(bmeConf));
+    seqActive = false;
 
     return true;
 }
@@ -231,8 +354,10 @@ bool Bsec2::setState(uint8_t *state)
 bool Bsec2::getConfig(uint8_t *config)
 {
     uint32_t n_serialized_settings = 0;
-    
-    status = bsec_get_configuration_m(bsecInstance, 0, config, BSEC_MAX_PROPERTY_BLOB_SIZE, workBuffer, BSEC_MAX_WORKBUFFER_SIZE, &n_serialized_settings);
+    uint8_t *buffer = acquireWorkBuffer();
+
+    status = bsec_get_configuration_m(bsecInstance, 0, config, BSEC_MAX_PROPERTY_BLOB_SIZE, buffer, BSEC_MAX_WORKBUFFER_SIZE, &n_serialized_settings);
+    releaseWorkBuffer();
     if (status != BSEC_OK)
         return false;
 
@@ -244,30 +369,82 @@ bool Bsec2::getConfig(uint8_t *config)
  */
 bool Bsec2::setConfig(const uint8_t *config)
 {
-    status = bsec_set_configuration_m(bsecInstance, config, BSEC_MAX_PROPERTY_BLOB_SIZE, workBuffer, BSEC_MAX_WORKBUFFER_SIZE);
+    uint8_t *buffer = acquireWorkBuffer();
+
+    status = bsec_set_configuration_m(bsecInstance, config, BSEC_MAX_PROPERTY_BLOB_SIZE, buffer, BSEC_MAX_WORKBUFFER_SIZE);
+    releaseWorkBuffer();
     if (status != BSEC_OK)
         return false;
 
     memset(&bmeConf, 0, sizeof(bmeConf));
+    seqActive = false;
 
     return true;
 }
 
 /**
- * @brief Function to calculate an int64_t timestamp in milliseconds
+ * @brief Function to get the work buffer for a state or configuration call
  */
-int64_t Bsec2::getTimeMs(void)
+uint8_t *Bsec2::acquireWorkBuffer(void)
 {
-    int64_t timeMs = millis();
+    if (workBuffer)
+        return workBuffer;
 
-    if (lastMillis > timeMs) /* An overflow occurred */
-    { 
-        ovfCounter++;
-    }
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    xSemaphoreTake(sharedWorkBufferLock, portMAX_DELAY);
+#endif
+    return sharedWorkBuffer;
+}
+
+/**
+ * @brief Function to release the buffer returned by acquireWorkBuffer
+ */
+void Bsec2::releaseWorkBuffer(void)
+{
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+    if (!workBuffer)
+        xSemaphoreGive(sharedWorkBufferLock);
+#endif
+}
 
-    lastMillis = timeMs;
+/**
+ * @brief Function to get the time left until BSEC requires the next call to run
+ */
+int64_t Bsec2::getTimeToNextCallMs(void)
+{
+    int64_t remainingNs = getNextCallNs() - getTimeMs() * INT64_C(1000000);
+
+    if (remainingNs <= 0)
+        return 0;
+
+    /* Round up so that a sleep of this length never ends before next_call */
+    return (remainingNs + INT64_C(999999)) / INT64_C(1000000);
+}
 
-    return timeMs + (ovfCounter * INT64_C(0xFFFFFFFF));
+/**
+ * @brief Function to run the parallel mode profiles in sequential mode
+ */
+void Bsec2::setSequentialMode(bool enable)
+{
+    if (enable == seqEnabled)
+        return;
+
+    seqEnabled = enable;
+    /* A profile already running is configured again in the new mode on the next run */
+    if (bmeConf.op_mode == BME68X_PARALLEL_MODE)
+        bmeConf.op_mode = BME68X_SLEEP_MODE;
+}
+
+/**
+ * @brief Function to resume an instance already held in the memory block assigned with allocateMemory
+ */
+void Bsec2::resumeInstance(const bsec_bme_settings_t &settings)
+{
+    bmeConf = settings;
+    /* The sensor is reset by begin, force it to be configured again on the next run */
+    bmeConf.op_mode = BME68X_SLEEP_MODE;
+    seqActive = false;
+    resumed = true;
 }
 
 /**
@@ -275,20 +452,48 @@ int64_t Bsec2::getTimeMs(void)
  */
 void Bsec2::allocateMemory(uint8_t (&memBlock)[BSEC_INSTANCE_SIZE])
 {
+    /* release memory taken by an earlier begin */
+    clearMemory();
     /* allocating memory for the bsec instance */
     bsecInstance = memBlock;
 }
 
 /**
- * @brief Function to de-allocate the dynamically allocated memory
+ * @brief Function to release the memory taken by begin
  */
 void Bsec2::clearMemory(void)
 {
-    delete[] bsecInstance;
+    if (ownsInstance)
+    {
+        delete[] bsecInstance;
+        ownsInstance = false;
+    }
+
+#ifdef BSEC2_STATIC_INSTANCES
+    if (poolSlot >= 0)
+    {
+        if (workBuffer == workBufferPool[poolSlot])
+            workBuffer = nullptr;
+        releasePoolSlot(poolSlot);
+        poolSlot = -1;
+    }
+#endif
+
+    bsecInstance = nullptr;
 }
 
 /* Private functions */
 
+/**
+ * @brief Calls a by-value callback. The copies of its arguments are made in this frame, so that processData
+ *        does not carry them on the stack when a bsecRefCallback is attached
+ */
+static void __attribute__((noinline)) callValueCallback(bsecCallback callback, const bme68xData &data,
+                                                        const bsecOutputs &outputs, const Bsec2 &bsec)
+{
+    callback(data, outputs, bsec);
+}
+
 /**
  * @brief Reads data from the BME68X sensor and process it
  */
@@ -362,8 +567,10 @@ bool Bsec2::processData(int64_t currTimeNs, const bme68xData &data)
         if (status != BSEC_OK)
             return false;
 
-        if(newDataCallback)
-            newDataCallback(data, outputs, *this);
+        if (newDataRefCallback)
+            newDataRefCallback(data, outputs, *this, callbackCtx);
+        else if (newDataCallback)
+            callValueCallback(newDataCallback, data, outputs, *this);
     }
     return true;
 }
@@ -375,8 +582,22 @@ bool Bsec2::beginCommon()
 {
     if (!bsecInstance)
     {
+#ifdef BSEC2_STATIC_INSTANCES
+        /* take the instance memory and a work buffer from the static pool, the heap is never used */
+        poolSlot = claimPoolSlot();
+        if (poolSlot < 0)
+        {
+            status = BSEC_E_INSTANCE_POOL_EXHAUSTED;
+            return false;
+        }
+        bsecInstance = instancePool[poolSlot];
+        if (!workBuffer)
+            workBuffer = workBufferPool[poolSlot];
+#else
         /* allocate memory for the instance if not allocated */
         bsecInstance = new uint8_t[bsec_get_instance_size_m()];
+        ownsInstance = true;
+#endif
     }
 
     if (BSEC_INSTANCE_SIZE < bsec_get_instance_size_m())
@@ -384,16 +605,22 @@ bool Bsec2::beginCommon()
         status = BSEC_E_INSUFFICIENT_INSTANCE_SIZE;
         return false;
     }
-    status = bsec_init_m(bsecInstance);
-    if (status != BSEC_OK)
-        return false;
+
+    if (!resumed)
+    {
+        status = bsec_init_m(bsecInstance);
+        if (status != BSEC_OK)
+            return false;
+    }
 
     status = bsec_get_version_m(bsecInstance, &version);
     if (status != BSEC_OK)
         return false;
 
-    memset(&bmeConf, 0, sizeof(bmeConf));
+    if (!resumed)
+        memset(&bmeConf, 0, sizeof(bmeConf));
     memset(&outputs, 0, sizeof(outputs));
+    resumed = false;
 
     return true;
 }
@@ -449,3 +676,116 @@ void Bsec2::setBme68xConfigParallel(void)
 
     opMode = BME68X_PARALLEL_MODE;
 }
+
+/**
+ * @brief Set the BME68X sensor configuration to sequential mode, with the parallel mode profile
+ */
+void Bsec2::setBme68xConfigSequential(void)
+{
+    uint8_t profileLen = bmeConf.heater_profile_len;
+
+    seqActive = false;
+    if ((profileLen == 0) || (profileLen > BSEC_SEQ_MAX_STEPS))
+        return;
+
+    /* Set the filter, odr, temperature, pressure and humidity settings */
+    sensor.setTPH(bmeConf.temperature_oversampling, bmeConf.pressure_oversampling, bmeConf.humidity_oversampling);
+
+    if (sensor.checkStatus() == BME68X_ERROR)
+        return;
+
+    /* The profile repeats without a pause, as in parallel mode */
+    sensor.setSeqSleep(BME68X_ODR_NONE);
+
+    if (sensor.checkStatus() == BME68X_ERROR)
+        return;
+
+    /* Each step lasts its multiple of BSEC_TOTAL_HEAT_DUR, the TPH measurement included */
+    seqMeasDurUs = sensor.getMeasDur(BME68X_SEQUENTIAL_MODE);
+    for (uint8_t i = 0; i < profileLen; i++)
+    {
+        int32_t heaterDur = (int32_t)bmeConf.heater_duration_profile[i] * BSEC_TOTAL_HEAT_DUR -
+                (int32_t)(seqMeasDurUs / 1000);
+
+        if (heaterDur < 1)
+            heaterDur = 1;
+        if (heaterDur > BSEC_SEQ_MAX_HEATER_DUR)
+            heaterDur = BSEC_SEQ_MAX_HEATER_DUR;
+        seqHeaterDur[i] = (uint16_t)heaterDur;
+    }
+
+    sensor.setHeaterProf(bmeConf.heater_temperature_profile, seqHeaterDur, profileLen);
+
+    if (sensor.checkStatus() == BME68X_ERROR)
+        return;
+
+    sensor.setOpMode(BME68X_SEQUENTIAL_MODE);
+
+    if (sensor.checkStatus() == BME68X_ERROR)
+        return;
+
+    /* The first field ends one step after the start */
+    seqProfileLen = profileLen;
+    seqGasIndex = 0;
+    seqFieldNs = getTimeMs() * INT64_C(1000000) + ((int64_t)seqMeasDurUs + seqHeaterDur[0] * INT64_C(1000)) * 1000;
+    seqActive = true;
+    opMode = BME68X_PARALLEL_MODE;
+}
+
+/**
+ * @brief Time at which run has to be called next
+ */
+int64_t Bsec2::getNextCallNs(void)
+{
+    if (!seqActive)
+        return bmeConf.next_call;
+
+    /* End of the last field the sensor can buffer, counted from the next one expected and at most
+       up to the last step of the profile */
+    int64_t drainNs = seqFieldNs;
+    uint8_t gasIndex = seqGasIndex;
+
+    for (uint8_t i = 1; (i < BSEC_SEQ_FIELDS) && (gasIndex + 1 < seqProfileLen); i++)
+    {
+        gasIndex++;
+        drainNs += ((int64_t)seqMeasDurUs + seqHeaterDur[gasIndex] * INT64_C(1000)) * 1000;
+    }
+    drainNs += BSEC_SEQ_DRAIN_MARGIN_MS * INT64_C(1000000);
+
+    return (drainNs > bmeConf.next_call) ? drainNs : bmeConf.next_call;
+}
+
+/**
+ * @brief Moves the expected sequential field to the next heater step
+ */
+void Bsec2::seqNextStep(void)
+{
+    seqGasIndex++;
+    if (seqGasIndex < seqProfileLen)
+        seqFieldNs += ((int64_t)seqMeasDurUs + seqHeaterDur[seqGasIndex] * INT64_C(1000)) * 1000;
+}
+
+/**
+ * @brief Checks a field drained in sequential mode and gives its timestamp
+ */
+bool Bsec2::seqTakeField(uint8_t gasIndex, int64_t currTimeNs, int64_t &fieldNs)
+{
+    if (gasIndex >= seqProfileLen)
+        return false;
+
+    /* The sensor wrapped to the next loop of the profile, the steps left of this loop are lost */
+    if (gasIndex < seqGasIndex)
+    {
+        seqGasIndex = seqProfileLen;
+        return false;
+    }
+
+    /* Fields overwritten before the host drained them, their steps are skipped */
+    while (seqGasIndex != gasIndex)
+        seqNextStep();
+
+    fieldNs = (seqFieldNs < currTimeNs) ? seqFieldNs : currTimeNs;
+    seqNextStep();
+
+    return true;
+}
@@ -48,6 +48,12 @@
 #include "bme68xLibrary.h"
 #include "inc/bsec_datatypes.h"
 #include "inc/bsec_interface_multi.h"
+#include "bsec2Clock.h"
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
 
 #ifndef ARRAY_LEN
 #define ARRAY_LEN(array)				(sizeof(array)/sizeof(array[0]))
@@ -55,8 +61,23 @@
 
 #define BSEC_CHECK_INPUT(x, shift)		    (x & (1 << (shift-1)))
 #define BSEC_TOTAL_HEAT_DUR                 UINT16_C(140)
+/* Sequential mode: fields the sensor buffers, steps of a profile as in bsec_bme_settings_t, longest
+ * heater duration of a step in ms (gas_wait 0xFF) and time left after the last buffered field before
+ * the host drains them */
+#define BSEC_SEQ_FIELDS                     UINT8_C(3)
+#define BSEC_SEQ_MAX_STEPS                  UINT8_C(10)
+#define BSEC_SEQ_MAX_HEATER_DUR             UINT16_C(4032)
+#define BSEC_SEQ_DRAIN_MARGIN_MS            INT64_C(2)
 #define BSEC_INSTANCE_SIZE                  3272
 #define BSEC_E_INSUFFICIENT_INSTANCE_SIZE   (bsec_library_return_t)-105
+#define BSEC_E_INSTANCE_POOL_EXHAUSTED      (bsec_library_return_t)-106
+
+/* Static allocation mode: define BSEC2_STATIC_INSTANCES to the number of instances that begin may
+ * set up without allocateMemory. Their memory blocks and work buffers are then taken from a pool
+ * sized at compile time instead of the heap */
+#ifdef BSEC2_STATIC_INSTANCES
+#define BSEC2_STATIC_POOL_SIZE              (BSEC2_STATIC_INSTANCES * (BSEC_INSTANCE_SIZE + BSEC_MAX_WORKBUFFER_SIZE))
+#endif
 
 typedef bsec_output_t bsecData;
 typedef bsec_virtual_sensor_t bsecSensor;
@@ -69,6 +90,8 @@ typedef struct
 
 class Bsec2;
 typedef void (*bsecCallback)(const bme68xData data, const bsecOutputs outputs, const Bsec2 bsec);
+/* Same as bsecCallback without copying the data, the outputs and the whole Bsec2 instance on every call */
+typedef void (*bsecRefCallback)(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx);
 
 /* BSEC2 class definition */
 class Bsec2
@@ -127,9 +150,26 @@ public:
      */
     bool run(void);
 
+    /**
+     * @brief Function to attach a callback taking its arguments by value, kept for compatibility
+     * @param callback	: Function called with every new set of outputs
+     */
     void attachCallback(bsecCallback callback)
     {
         newDataCallback = callback;
+        newDataRefCallback = nullptr;
+    }
+
+    /**
+     * @brief Function to attach a callback taking its arguments by reference
+     * @param callback	: Function called with every new set of outputs
+     * @param userCtx	: Pointer handed back to the callback unchanged
+     */
+    void attachCallback(bsecRefCallback callback, void *userCtx = nullptr)
+    {
+        newDataRefCallback = callback;
+        callbackCtx = userCtx;
+        newDataCallback = nullptr;
     }
 
     /**
@@ -197,7 +237,63 @@ public:
     /**
      * @brief Function to calculate an int64_t timestamp in milliseconds
      */
-    int64_t getTimeMs(void);
+    int64_t getTimeMs(void)
+    {
+        return clock ? clock->getTimeMs() : defaultClock.getTimeMs();
+    }
+
+    /**
+     * @brief Function to replace the default time source of the timestamps
+     * @param timeSource	: Clock to use, must outlive this instance
+     */
+    void setClock(Bsec2Clock &timeSource)
+    {
+        clock = &timeSource;
+    }
+
+    /**
+     * @brief Function to get the time left until BSEC requires the next call to run
+     * @return	time in milliseconds, 0 if the next call is already due
+     */
+    int64_t getTimeToNextCallMs(void);
+
+    /**
+     * @brief Function to run the heater profiles BSEC requests in parallel mode in sequential mode
+     *        instead. The sensor then steps through the profile on its own, each step lasting as
+     *        in parallel mode, and run only fetches once BSEC_SEQ_FIELDS fields are buffered, or
+     *        the last step of the profile ended. The sensor is stopped there until BSEC requests
+     *        the profile again. getTimeToNextCallMs follows the fields, so fewer wake ups are
+     *        needed per profile.
+     *        Heater durations are limited to BSEC_SEQ_MAX_HEATER_DUR in sequential mode
+     * @param enable	: true for sequential mode, false for parallel mode as requested by BSEC
+     */
+    void setSequentialMode(bool enable);
+
+    /**
+     * @brief Function to get the sensor settings requested by the last bsec_sensor_control call
+     * @return	reference to the sensor settings, including the next_call schedule
+     */
+    const bsec_bme_settings_t& getBmeSettings(void)
+    {
+        return bmeConf;
+    }
+
+    /**
+     * @brief Function to resume an instance already held in the memory block assigned with
+     *        allocateMemory. The next begin call then skips bsec_init and keeps the algorithm state
+     * @param settings	: Sensor settings saved with getBmeSettings before the instance was suspended
+     */
+    void resumeInstance(const bsec_bme_settings_t &settings);
+
+    /**
+     * @brief Function to give the instance its own work buffer for the state and configuration calls.
+     *        Without one, all instances share a single buffer and those calls are serialized
+     * @param buffer	: Work buffer, must outlive this instance
+     */
+    void setWorkBuffer(uint8_t (&buffer)[BSEC_MAX_WORKBUFFER_SIZE])
+    {
+        workBuffer = buffer;
+    }
 
     /**
      * @brief Function to assign the memory block to the bsec instance
@@ -207,7 +303,8 @@ public:
     void allocateMemory(uint8_t (&memBlock)[BSEC_INSTANCE_SIZE]);
 
     /**
-     * @brief Function to de-allocate the dynamically allocated memory
+     * @brief Function to release the memory taken by begin, from the heap or the static pool.
+     *        A block assigned with allocateMemory belongs to the caller and is left untouched
      */
     void clearMemory(void);
 
@@ -215,20 +312,59 @@ private:
     bsec_bme_settings_t bmeConf;
 
     bsecCallback newDataCallback;
+    bsecRefCallback newDataRefCallback;
+    void *callbackCtx;
 
     bsecOutputs outputs;
     /* operating mode of sensor */
     uint8_t opMode;
 
+    /* Parallel mode profiles run in sequential mode, set with setSequentialMode */
+    bool seqEnabled;
+    /* The sensor runs a profile in sequential mode */
+    bool seqActive;
+    /* Heater step and end time of the next field expected from the sensor in sequential mode,
+     * seqProfileLen once the last step is read */
+    uint8_t seqGasIndex;
+    int64_t seqFieldNs;
+    /* Steps of the profile, TPH duration of a sequential step in us and heater durations of the steps in ms */
+    uint8_t seqProfileLen;
+    uint32_t seqMeasDurUs;
+    uint16_t seqHeaterDur[BSEC_SEQ_MAX_STEPS];
+
     float extTempOffset;
-    /** Global variables to help create a millisecond timestamp that doesn't overflow every 51 days.
-     * If it overflows, it will have a negative value. Something that should never happen.
-     */
-    uint32_t ovfCounter;
-    
-    uint32_t lastMillis;
+
+    /* Time source of the timestamps. Null for the defaultClock of this instance, resolved on use so that a copy
+       of the instance does not point into the original */
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_NATIVE)
+    Bsec2RtcClock defaultClock;
+#else
+    Bsec2MillisClock defaultClock;
+#endif
+    Bsec2Clock *clock;
+
+    /* Set by resumeInstance, the instance memory is valid and must not be initialized again */
+    bool resumed;
     /* Pointer to hold the address of the instance */
     uint8_t *bsecInstance;
+    /* Work buffer set with setWorkBuffer, nullptr to use the shared one */
+    uint8_t *workBuffer;
+    /* The instance memory was allocated by begin from the heap */
+    bool ownsInstance;
+    /* Slot of the static pool holding the instance memory, -1 if none */
+    int8_t poolSlot;
+
+    /**
+     * @brief Function to get the work buffer for a state or configuration call,
+     *        locks the shared buffer when the instance has none of its own
+     * @return pointer to a buffer of BSEC_MAX_WORKBUFFER_SIZE bytes
+     */
+    uint8_t *acquireWorkBuffer(void);
+
+    /**
+     * @brief Function to release the buffer returned by acquireWorkBuffer
+     */
+    void releaseWorkBuffer(void);
 
     /**
      * @brief Reads the data from the BME68x sensor and process it
@@ -237,6 +373,13 @@ private:
      */
     bool processData(int64_t currTimeNs, const bme68xData &data);
 
+    /**
+     * @brief Reads the fields of the BME68x sensor and processes the ones with valid gas data
+     * @param currTimeNs: Current time in ns
+     * @return true on success, false otherwise
+     */
+    bool fetchFields(int64_t currTimeNs);
+
     /**
      * @brief Common code for the begin function
      */
@@ -251,6 +394,32 @@ private:
      * @brief Set the BME68x sensor configuration to parallel mode
      */
     void setBme68xConfigParallel(void);
+
+    /**
+     * @brief Set the BME68x sensor configuration to sequential mode, with the parallel mode profile
+     */
+    void setBme68xConfigSequential(void);
+
+    /**
+     * @brief Time at which run has to be called next, after next_call and in sequential mode
+     *        once the sensor buffered BSEC_SEQ_FIELDS fields
+     * @return time in ns
+     */
+    int64_t getNextCallNs(void);
+
+    /**
+     * @brief Moves the expected sequential field to the next heater step
+     */
+    void seqNextStep(void);
+
+    /**
+     * @brief Checks a field drained in sequential mode and gives its timestamp, the end of its heater step
+     * @param gasIndex		: Heater step of the field
+     * @param currTimeNs	: Current time in ns, no field ends later
+     * @param fieldNs		: Timestamp of the field in ns
+     * @return true for a step of the profile not read yet, false for a field of the next loop
+     */
+    bool seqTakeField(uint8_t gasIndex, int64_t currTimeNs, int64_t &fieldNs);
 };
 
 #endif /* BSEC2_CLASS_H */
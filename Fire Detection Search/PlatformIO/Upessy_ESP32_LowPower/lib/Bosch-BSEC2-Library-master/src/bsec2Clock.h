@@ -0,0 +1,114 @@
+/**
+ * @file	bsec2Clock.h
+ *
+ * Time sources for the Bsec2 timestamps. BSEC expects timestamps that never go
+ * backwards, so duty-cycled nodes that reset on every deep sleep wake need a
+ * clock that keeps counting while the CPU is off.
+ */
+
+#ifndef BSEC2_CLOCK_H_
+#define BSEC2_CLOCK_H_
+
+#include "Arduino.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <sys/time.h>
+#endif
+
+/* Interface of a millisecond time source for Bsec2 */
+class Bsec2Clock
+{
+public:
+    virtual ~Bsec2Clock(void) {}
+
+    /**
+     * @brief Function to get a monotonic timestamp
+     * @return	timestamp in milliseconds
+     */
+    virtual int64_t getTimeMs(void) = 0;
+};
+
+/* millis() extended to 64 bits. Restarts from 0 after every reset, including deep sleep wakes */
+class Bsec2MillisClock : public Bsec2Clock
+{
+public:
+    Bsec2MillisClock(void) : ovfCounter(0), lastMillis(0) {}
+
+    int64_t getTimeMs(void)
+    {
+        int64_t timeMs = millis();
+
+        if (lastMillis > timeMs) /* An overflow occurred */
+        {
+            ovfCounter++;
+        }
+
+        lastMillis = timeMs;
+
+        return timeMs + (ovfCounter * INT64_C(0xFFFFFFFF));
+    }
+
+private:
+    /** Variables to help create a millisecond timestamp that doesn't overflow every 51 days.
+     * If it overflows, it will have a negative value. Something that should never happen.
+     */
+    uint32_t ovfCounter;
+    uint32_t lastMillis;
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+/**
+ * System time of the ESP32, driven by the RTC timer while in deep sleep so it stays
+ * continuous across wakes. The time must not be set by the application (e.g. SNTP),
+ * a jump would be seen by BSEC as well.
+ */
+class Bsec2RtcClock : public Bsec2Clock
+{
+public:
+    int64_t getTimeMs(void)
+    {
+        struct timeval tv;
+
+        gettimeofday(&tv, NULL);
+
+        return (int64_t)tv.tv_sec * INT64_C(1000) + tv.tv_usec / 1000;
+    }
+};
+#elif defined(NODE_NATIVE)
+/* Virtual time of the native build, it keeps counting through emulated deep sleep like the RTC */
+class Bsec2RtcClock : public Bsec2Clock
+{
+public:
+    int64_t getTimeMs(void)
+    {
+        return (int64_t)(nativeNowUs() / 1000);
+    }
+};
+#endif
+
+/* Clock that only moves when told to, for deterministic scheduling on a host */
+class Bsec2ManualClock : public Bsec2Clock
+{
+public:
+    Bsec2ManualClock(int64_t startMs = 0) : nowMs(startMs) {}
+
+    int64_t getTimeMs(void)
+    {
+        return nowMs;
+    }
+
+    void setTimeMs(int64_t timeMs)
+    {
+        nowMs = timeMs;
+    }
+
+    void advanceMs(int64_t deltaMs)
+    {
+        nowMs += deltaMs;
+    }
+
+private:
+    int64_t nowMs;
+};
+
+#endif /* BSEC2_CLOCK_H_ */
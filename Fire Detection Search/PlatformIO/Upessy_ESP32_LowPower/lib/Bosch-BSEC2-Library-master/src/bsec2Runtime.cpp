@@ -0,0 +1,205 @@
+/**
+ * @file	bsec2Runtime.cpp
+ *
+ * Multi-core runner of Bsec2 instances, see bsec2Runtime.h
+ */
+
+#include "bsec2Runtime.h"
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+
+/* Upper bound of a worker wait, keeps the tick conversion from overflowing */
+#define BSEC2_RUNTIME_MAX_WAIT_MS   INT64_C(3600000)
+
+/**
+ * @brief Constructor of Bsec2Runtime class
+ */
+Bsec2Runtime::Bsec2Runtime(void)
+{
+    nSlots = 0;
+    stopper = NULL;
+    running = false;
+    memset(slots, 0, sizeof(slots));
+    memset(workers, 0, sizeof(workers));
+    outputLock = xSemaphoreCreateRecursiveMutexStatic(&outputLockMem);
+}
+
+/**
+ * @brief Function to add an instance
+ */
+bool Bsec2Runtime::add(Bsec2 &bsec, bsecRefCallback callback, void *userCtx, int8_t core)
+{
+    if (running || nSlots >= BSEC2_RUNTIME_MAX_SENSORS || core >= BSEC2_RUNTIME_CORES)
+        return false;
+
+    runtimeSlot &slot = slots[nSlots];
+
+    slot.runtime = this;
+    slot.bsec = &bsec;
+    slot.callback = callback;
+    slot.userCtx = userCtx;
+    slot.core = (core < 0) ? (nSlots % BSEC2_RUNTIME_CORES) : core;
+    slot.errors = 0;
+    bsec.attachCallback(outputCallback, &slot);
+    nSlots++;
+
+    return true;
+}
+
+/**
+ * @brief Function to remove every instance
+ */
+void Bsec2Runtime::clear(void)
+{
+    if (running)
+        return;
+
+    nSlots = 0;
+    memset(slots, 0, sizeof(slots));
+}
+
+/**
+ * @brief Function to start the worker tasks
+ */
+bool Bsec2Runtime::start(UBaseType_t priority)
+{
+    if (running || nSlots == 0)
+        return false;
+
+    for (int8_t core = 0; core < BSEC2_RUNTIME_CORES; core++)
+    {
+        workers[core].active = false;
+
+        for (uint8_t i = 0; i < nSlots; i++)
+            workers[core].active |= (slots[i].core == core);
+
+        if (workers[core].active && workers[core].task == NULL && !createWorker(core, priority))
+            return false;
+    }
+
+    running = true;
+
+    for (int8_t core = 0; core < BSEC2_RUNTIME_CORES; core++)
+    {
+        if (workers[core].active)
+            xTaskNotifyGive(workers[core].task);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Function to stop the worker tasks
+ */
+void Bsec2Runtime::stop(void)
+{
+    uint8_t nWorkers = 0;
+
+    if (!running)
+        return;
+
+    stopper = xTaskGetCurrentTaskHandle();
+    /* Drop notifications left over from other users of this task */
+    (void) ulTaskNotifyTake(pdTRUE, 0);
+    running = false;
+
+    for (int8_t core = 0; core < BSEC2_RUNTIME_CORES; core++)
+    {
+        if (workers[core].active)
+        {
+            /* Cuts the wait for the next call short */
+            xTaskNotifyGive(workers[core].task);
+            nWorkers++;
+        }
+    }
+
+    while (nWorkers--)
+        (void) ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+    for (int8_t core = 0; core < BSEC2_RUNTIME_CORES; core++)
+        workers[core].active = false;
+}
+
+/**
+ * @brief Function to create the worker task of one core
+ */
+bool Bsec2Runtime::createWorker(int8_t core, UBaseType_t priority)
+{
+    runtimeWorker &worker = workers[core];
+
+    worker.runtime = this;
+    worker.core = core;
+#ifdef BSEC2_STATIC_INSTANCES
+    worker.task = xTaskCreateStaticPinnedToCore(workerTask, "bsec2", BSEC2_RUNTIME_STACK_SIZE, &worker, priority,
+            worker.stack, &worker.taskMem, core);
+#else
+    if (xTaskCreatePinnedToCore(workerTask, "bsec2", BSEC2_RUNTIME_STACK_SIZE, &worker, priority,
+            &worker.task, core) != pdPASS)
+        worker.task = NULL;
+#endif
+
+    return worker.task != NULL;
+}
+
+/**
+ * @brief Loop of the worker task of one core
+ */
+void Bsec2Runtime::work(int8_t core)
+{
+    for (;;)
+    {
+        /* Parked until start */
+        while (!running)
+            (void) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (running)
+        {
+            int64_t sleepMs = BSEC2_RUNTIME_MAX_WAIT_MS;
+            TickType_t ticks;
+
+            for (uint8_t i = 0; i < nSlots; i++)
+            {
+                if (slots[i].core != core)
+                    continue;
+
+                if (!slots[i].bsec->run())
+                    slots[i].errors++;
+
+                int64_t nextMs = slots[i].bsec->getTimeToNextCallMs();
+                if (nextMs < sleepMs)
+                    sleepMs = nextMs;
+            }
+
+            /* Always yield, the other tasks of the core must get to run */
+            ticks = pdMS_TO_TICKS(sleepMs);
+            if (ticks == 0)
+                ticks = 1;
+
+            (void) ulTaskNotifyTake(pdTRUE, ticks);
+        }
+
+        xTaskNotifyGive(stopper);
+    }
+}
+
+void Bsec2Runtime::workerTask(void *arg)
+{
+    runtimeWorker *worker = (runtimeWorker*) arg;
+    Bsec2Runtime *runtime = worker->runtime;
+
+    runtime->work(worker->core);
+}
+
+void Bsec2Runtime::outputCallback(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *slotCtx)
+{
+    runtimeSlot *slot = (runtimeSlot*) slotCtx;
+
+    if (slot->callback == nullptr)
+        return;
+
+    slot->runtime->lockOutputs();
+    slot->callback(data, outputs, bsec, slot->userCtx);
+    slot->runtime->unlockOutputs();
+}
+
+#endif /* ARDUINO_ARCH_ESP32 || NODE_BENCH */
@@ -0,0 +1,152 @@
+/**
+ * @file	bsec2Runtime.h
+ *
+ * Runs several Bsec2 instances from FreeRTOS worker tasks, one per ESP32 core.
+ * Each worker calls run() on the instances assigned to its core and sleeps until
+ * the earliest next_call among them, so the BSEC processing of a multi-sensor node
+ * is spread over both cores instead of being serialized in loop().
+ *
+ * The workers are created by the first start and parked by stop, so restarting the
+ * runtime does not allocate. With BSEC2_STATIC_INSTANCES defined their stacks are part
+ * of the runtime object as well.
+ *
+ * Output callbacks are called from the worker tasks, one at a time under the output
+ * lock. The application takes the same lock with lockOutputs before touching the
+ * state shared with the callbacks, e.g. to flush a data logger from loop().
+ */
+
+#ifndef BSEC2_RUNTIME_H_
+#define BSEC2_RUNTIME_H_
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+
+#include "bsec2.h"
+#include "freertos/task.h"
+
+#define BSEC2_RUNTIME_MAX_SENSORS   8
+#define BSEC2_RUNTIME_CORES         2
+#define BSEC2_RUNTIME_ANY_CORE      -1
+
+/* Stack of each worker in bytes, BSEC runs on this stack */
+#ifndef BSEC2_RUNTIME_STACK_SIZE
+#define BSEC2_RUNTIME_STACK_SIZE    8192
+#endif
+
+class Bsec2Runtime
+{
+public:
+    Bsec2Runtime(void);
+
+    /**
+     * @brief Function to add an instance, which must have been set up (begin, setConfig, updateSubscription)
+     * @param bsec		: Instance to run, its callback is replaced by the runtime one
+     * @param callback	: Function called with every new set of outputs, from a worker task
+     * @param userCtx	: Pointer handed back to the callback unchanged
+     * @param core		: Core running the instance, BSEC2_RUNTIME_ANY_CORE to alternate between cores
+     * @return	true for success, false if the runtime is running or full
+     */
+    bool add(Bsec2 &bsec, bsecRefCallback callback, void *userCtx = nullptr, int8_t core = BSEC2_RUNTIME_ANY_CORE);
+
+    /**
+     * @brief Function to remove every instance, the runtime must be stopped
+     */
+    void clear(void);
+
+    /**
+     * @brief Function to start the worker tasks, created on the first call
+     * @param priority	: Priority of the workers, used when they are created
+     * @return	true for success, false otherwise
+     */
+    bool start(UBaseType_t priority = 1);
+
+    /**
+     * @brief Function to stop the worker tasks, returns once they have finished their current cycle and are parked
+     */
+    void stop(void);
+
+    /**
+     * @brief Function to know if the worker tasks are running
+     */
+    bool isRunning(void)
+    {
+        return running;
+    }
+
+    /**
+     * @brief Function to take the lock held while the output callbacks run
+     */
+    void lockOutputs(void)
+    {
+        xSemaphoreTakeRecursive(outputLock, portMAX_DELAY);
+    }
+
+    /**
+     * @brief Function to release the lock taken with lockOutputs
+     */
+    void unlockOutputs(void)
+    {
+        xSemaphoreGiveRecursive(outputLock);
+    }
+
+    /**
+     * @brief Function to get the number of failed run calls of an instance
+     * @param idx	: Index of the instance, in the order of the add calls
+     */
+    uint32_t getErrors(uint8_t idx)
+    {
+        return (idx < nSlots) ? slots[idx].errors : 0;
+    }
+
+private:
+    struct runtimeSlot
+    {
+        Bsec2Runtime *runtime;
+        Bsec2 *bsec;
+        bsecRefCallback callback;
+        void *userCtx;
+        int8_t core;
+        uint32_t errors;
+    };
+
+    runtimeSlot slots[BSEC2_RUNTIME_MAX_SENSORS];
+    uint8_t nSlots;
+
+    SemaphoreHandle_t outputLock;
+    StaticSemaphore_t outputLockMem;
+
+    struct runtimeWorker
+    {
+        Bsec2Runtime *runtime;
+        int8_t core;
+        TaskHandle_t task;
+        /* Started by the current start call, stop waits for it */
+        bool active;
+#ifdef BSEC2_STATIC_INSTANCES
+        StackType_t stack[BSEC2_RUNTIME_STACK_SIZE];
+        StaticTask_t taskMem;
+#endif
+    };
+
+    runtimeWorker workers[BSEC2_RUNTIME_CORES];
+    /* Task waiting in stop for the workers to finish */
+    TaskHandle_t stopper;
+    volatile bool running;
+
+    /**
+     * @brief Function to create the worker task of one core
+     */
+    bool createWorker(int8_t core, UBaseType_t priority);
+
+    /**
+     * @brief Loop of the worker task of one core
+     */
+    void work(int8_t core);
+
+    static void workerTask(void *arg);
+
+    static void outputCallback(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *slotCtx);
+};
+
+#endif /* ARDUINO_ARCH_ESP32 || NODE_BENCH */
+
+#endif /* BSEC2_RUNTIME_H_ */
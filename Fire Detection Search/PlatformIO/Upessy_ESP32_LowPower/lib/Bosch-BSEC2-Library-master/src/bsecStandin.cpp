@@ -0,0 +1,555 @@
+/**
+ * @file	bsecStandin.cpp
+ *
+ * Stand-in for libalgobsec, see bsecStandin.h
+ */
+
+#ifdef BSEC_STANDIN
+
+#include <math.h>
+#include <string.h>
+
+#include "bsecStandin.h"
+#include "inc/bsec_interface_multi.h"
+
+#define STANDIN_MAGIC               UINT32_C(0x42535444)
+#define STANDIN_STATE_MAGIC         UINT32_C(0x42535453)
+#define STANDIN_OP_SLEEP            0
+#define STANDIN_OP_FORCED           1
+#define STANDIN_OP_PARALLEL         2
+
+/* Step period of the parallel mode for a heater duration multiplier of 1, see BSEC_TOTAL_HEAT_DUR */
+#define STANDIN_STEP_MS             140
+/* Period of the sensor control calls while a profile is scanned */
+#define STANDIN_SCAN_CALL_MS        (2 * STANDIN_STEP_MS)
+/* Complete profiles before the gas estimates are reported as accurate */
+#define STANDIN_WARMUP_CYCLES       1
+/* Heater set point of the forced mode */
+#define STANDIN_FORCED_TEMP         320
+#define STANDIN_FORCED_DUR          197
+
+#define NS_PER_MS                   INT64_C(1000000)
+#define NS_PER_S                    INT64_C(1000000000)
+
+/* Default heater profile of the BME688 scan mode, durations in multiples of STANDIN_STEP_MS */
+static const uint16_t profileTemp[BSEC_STANDIN_PROFILE_LEN] = { 320, 100, 100, 100, 200, 200, 200, 320, 320, 320 };
+static const uint16_t profileDur[BSEC_STANDIN_PROFILE_LEN] = { 5, 2, 10, 30, 5, 5, 5, 5, 5, 5 };
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t subscribed;    /* Bit per virtual sensor id */
+    float sampleRate;       /* Rate of the gas outputs, 0 when not subscribed */
+    int64_t cycleStartNs;
+    uint8_t opMode;
+    uint16_t stepsSeen;     /* Bit per heater step of the current profile */
+    float gasResistance[BSEC_STANDIN_PROFILE_LEN];
+    uint32_t cycles;        /* Complete profiles, kept in the state blob */
+} standinInstance;
+
+static void defaultClassifier(const float *gasResistance, uint8_t nSteps, float temperature, float humidity,
+        float *probability, void *ctx);
+
+static bsecStandinClassifier classifier = defaultClassifier;
+static void *classifierCtx = NULL;
+static bsecStandinWorkBufferHook workBufferHook = NULL;
+static void *workBufferHookCtx = NULL;
+
+/**
+ * @brief Function to map the mean log gas resistance to class 1, below 50 kOhm, and class 2
+ */
+static void defaultClassifier(const float *gasResistance, uint8_t nSteps, float temperature, float humidity,
+        float *probability, void *ctx)
+{
+    float logMean = 0;
+
+    (void)temperature;
+    (void)humidity;
+    (void)ctx;
+
+    for (uint8_t i = 0; i < nSteps; i++)
+        logMean += logf(gasResistance[i] > 1.0f ? gasResistance[i] : 1.0f);
+    logMean /= nSteps;
+
+    probability[0] = 1.0f / (1.0f + expf(4.0f * (logMean - logf(50000.0f))));
+    probability[1] = 1.0f - probability[0];
+    probability[2] = 0;
+    probability[3] = 0;
+}
+
+void bsecStandinSetClassifier(bsecStandinClassifier newClassifier, void *ctx)
+{
+    classifier = newClassifier ? newClassifier : defaultClassifier;
+    classifierCtx = ctx;
+}
+
+void bsecStandinSetWorkBufferHook(bsecStandinWorkBufferHook hook, void *ctx)
+{
+    workBufferHook = hook;
+    workBufferHookCtx = ctx;
+}
+
+/* Between writing the work buffer and reading it back */
+static void callWorkBufferHook(void)
+{
+    if (workBufferHook)
+        workBufferHook(workBufferHookCtx);
+}
+
+/* The instance memory is a byte array without alignment guarantee */
+static bool loadInstance(void *inst, standinInstance &instance)
+{
+    if (!inst)
+        return false;
+
+    memcpy(&instance, inst, sizeof(instance));
+
+    return instance.magic == STANDIN_MAGIC;
+}
+
+static void storeInstance(void *inst, const standinInstance &instance)
+{
+    memcpy(inst, &instance, sizeof(instance));
+}
+
+static bool isRate(float rate, float reference)
+{
+    return fabsf(rate - reference) <= reference * 0.001f;
+}
+
+static bool isGasOutput(uint8_t id)
+{
+    return (id >= BSEC_OUTPUT_GAS_ESTIMATE_1 && id <= BSEC_OUTPUT_GAS_ESTIMATE_4) || id == BSEC_OUTPUT_RAW_GAS ||
+           id == BSEC_OUTPUT_RAW_GAS_INDEX || id == BSEC_OUTPUT_GAS_PERCENTAGE;
+}
+
+static uint32_t profileDurationMs(void)
+{
+    uint32_t duration = 0;
+
+    for (uint8_t i = 0; i < BSEC_STANDIN_PROFILE_LEN; i++)
+        duration += profileDur[i] * STANDIN_STEP_MS;
+
+    return duration;
+}
+
+size_t bsec_get_instance_size_m(void)
+{
+    return sizeof(standinInstance);
+}
+
+bsec_library_return_t bsec_get_version_m(void *inst, bsec_version_t *bsec_version_p)
+{
+    (void)inst;
+
+    bsec_version_p->major = 2;
+    bsec_version_p->minor = 5;
+    bsec_version_p->major_bugfix = 0;
+    bsec_version_p->minor_bugfix = 2;
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_init_m(void *inst)
+{
+    standinInstance instance;
+
+    memset(&instance, 0, sizeof(instance));
+    instance.magic = STANDIN_MAGIC;
+    storeInstance(inst, instance);
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_update_subscription_m(void *inst, const bsec_sensor_configuration_t *const requested_virtual_sensors,
+        const uint8_t n_requested_virtual_sensors, bsec_sensor_configuration_t *required_sensor_settings,
+        uint8_t *n_required_sensor_settings)
+{
+    static const uint8_t physical[] = { BSEC_INPUT_PRESSURE, BSEC_INPUT_HUMIDITY, BSEC_INPUT_TEMPERATURE,
+            BSEC_INPUT_GASRESISTOR, BSEC_INPUT_HEATSOURCE, BSEC_INPUT_PROFILE_PART };
+    bsec_library_return_t status = BSEC_OK;
+    standinInstance instance;
+    uint8_t nSettings = 0;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    if (*n_required_sensor_settings < BSEC_MAX_PHYSICAL_SENSOR)
+        return BSEC_E_SU_GATECOUNTEXCEEDSARRAY;
+
+    for (uint8_t i = 0; i < n_requested_virtual_sensors; i++)
+    {
+        uint8_t id = requested_virtual_sensors[i].sensor_id;
+        float rate = requested_virtual_sensors[i].sample_rate;
+
+        if (id == 0 || id > BSEC_OUTPUT_REGRESSION_ESTIMATE_4)
+        {
+            status = BSEC_W_SU_UNKNOWNOUTPUTGATE;
+            continue;
+        }
+
+        if (isRate(rate, BSEC_SAMPLE_RATE_DISABLED))
+        {
+            instance.subscribed &= ~(UINT32_C(1) << id);
+            continue;
+        }
+
+        if (!isRate(rate, BSEC_SAMPLE_RATE_ULP) && !isRate(rate, BSEC_SAMPLE_RATE_LP) &&
+                !isRate(rate, BSEC_SAMPLE_RATE_CONT) && !isRate(rate, BSEC_SAMPLE_RATE_SCAN))
+            return BSEC_E_SU_SAMPLERATELIMITS;
+
+        /* All the outputs share the gas sensor, hence its sample rate */
+        if (instance.sampleRate != 0 && !isRate(rate, instance.sampleRate) && isGasOutput(id))
+            return BSEC_E_SU_MULTGASSAMPLINTVL;
+
+        instance.sampleRate = rate;
+        instance.subscribed |= UINT32_C(1) << id;
+    }
+
+    if (!instance.subscribed)
+        instance.sampleRate = 0;
+
+    for (uint8_t i = 0; i < sizeof(physical); i++)
+    {
+        required_sensor_settings[nSettings].sensor_id = physical[i];
+        required_sensor_settings[nSettings].sample_rate = instance.sampleRate ? instance.sampleRate :
+                BSEC_SAMPLE_RATE_DISABLED;
+        nSettings++;
+    }
+    *n_required_sensor_settings = nSettings;
+
+    instance.cycleStartNs = 0;
+    instance.stepsSeen = 0;
+    storeInstance(inst, instance);
+
+    return status;
+}
+
+bsec_library_return_t bsec_sensor_control_m(void *inst, const int64_t time_stamp, bsec_bme_settings_t *sensor_settings)
+{
+    standinInstance instance;
+    int64_t periodNs;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    memset(sensor_settings, 0, sizeof(*sensor_settings));
+    sensor_settings->process_data = BSEC_PROCESS_PRESSURE | BSEC_PROCESS_TEMPERATURE | BSEC_PROCESS_HUMIDITY |
+            BSEC_PROCESS_GAS | BSEC_PROCESS_PROFILE_PART;
+    sensor_settings->temperature_oversampling = 2;
+    sensor_settings->pressure_oversampling = 1;
+    sensor_settings->humidity_oversampling = 1;
+
+    if (instance.sampleRate == 0)
+    {
+        sensor_settings->op_mode = STANDIN_OP_SLEEP;
+        sensor_settings->next_call = time_stamp + NS_PER_S;
+        instance.opMode = STANDIN_OP_SLEEP;
+        storeInstance(inst, instance);
+        return BSEC_OK;
+    }
+
+    periodNs = (int64_t)(NS_PER_S / instance.sampleRate);
+
+    if (!isRate(instance.sampleRate, BSEC_SAMPLE_RATE_SCAN))
+    {
+        sensor_settings->heater_temperature = STANDIN_FORCED_TEMP;
+        sensor_settings->heater_duration = STANDIN_FORCED_DUR;
+        sensor_settings->run_gas = 1;
+        sensor_settings->trigger_measurement = 1;
+        sensor_settings->op_mode = STANDIN_OP_FORCED;
+        sensor_settings->next_call = time_stamp + periodNs;
+        instance.opMode = STANDIN_OP_FORCED;
+        storeInstance(inst, instance);
+        return BSEC_OK;
+    }
+
+    /* One heater profile per scan period, the sensor sleeps between profiles */
+    if (instance.cycleStartNs == 0 || time_stamp >= instance.cycleStartNs + periodNs)
+    {
+        instance.cycleStartNs = time_stamp;
+        instance.stepsSeen = 0;
+    }
+
+    if (instance.stepsSeen != (1 << BSEC_STANDIN_PROFILE_LEN) - 1 &&
+            time_stamp < instance.cycleStartNs + 2 * (int64_t)profileDurationMs() * NS_PER_MS)
+    {
+        memcpy(sensor_settings->heater_temperature_profile, profileTemp, sizeof(profileTemp));
+        memcpy(sensor_settings->heater_duration_profile, profileDur, sizeof(profileDur));
+        sensor_settings->heater_profile_len = BSEC_STANDIN_PROFILE_LEN;
+        sensor_settings->run_gas = 1;
+        sensor_settings->trigger_measurement = 1;
+        sensor_settings->op_mode = STANDIN_OP_PARALLEL;
+        sensor_settings->next_call = time_stamp + STANDIN_SCAN_CALL_MS * NS_PER_MS;
+    }
+    else
+    {
+        sensor_settings->op_mode = STANDIN_OP_SLEEP;
+        sensor_settings->next_call = instance.cycleStartNs + periodNs;
+    }
+
+    instance.opMode = sensor_settings->op_mode;
+    storeInstance(inst, instance);
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_do_steps_m(void *inst, const bsec_input_t *const inputs, const uint8_t n_inputs,
+        bsec_output_t *outputs, uint8_t *n_outputs)
+{
+    standinInstance instance;
+    bsec_output_t results[BSEC_NUMBER_OUTPUTS];
+    uint8_t nResults = 0;
+    float temperature = 0, humidity = 0, pressure = 0, gas = 0, heatSource = 0;
+    uint8_t step = 0;
+    bool hasGas = false;
+    int64_t timeStamp = 0;
+    float probability[BSEC_STANDIN_NUM_CLASSES];
+    bool estimate = false;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    for (uint8_t i = 0; i < n_inputs; i++)
+    {
+        timeStamp = inputs[i].time_stamp;
+        switch (inputs[i].sensor_id)
+        {
+        case BSEC_INPUT_TEMPERATURE:
+            temperature = inputs[i].signal;
+            break;
+        case BSEC_INPUT_HUMIDITY:
+            humidity = inputs[i].signal;
+            break;
+        case BSEC_INPUT_PRESSURE:
+            pressure = inputs[i].signal;
+            break;
+        case BSEC_INPUT_GASRESISTOR:
+            gas = inputs[i].signal;
+            hasGas = true;
+            break;
+        case BSEC_INPUT_HEATSOURCE:
+            heatSource = inputs[i].signal;
+            break;
+        case BSEC_INPUT_PROFILE_PART:
+            step = (uint8_t)inputs[i].signal;
+            break;
+        default:
+            return BSEC_E_DOSTEPS_INVALIDINPUT;
+        }
+    }
+
+    if (step >= BSEC_STANDIN_PROFILE_LEN)
+        return BSEC_E_DOSTEPS_VALUELIMITS;
+
+    if (hasGas)
+    {
+        instance.gasResistance[step] = gas;
+        instance.stepsSeen |= 1 << step;
+
+        if (instance.opMode != STANDIN_OP_PARALLEL)
+        {
+            classifier(instance.gasResistance, 1, temperature, humidity, probability, classifierCtx);
+            instance.cycles++;
+            estimate = true;
+        }
+        else if (step == BSEC_STANDIN_PROFILE_LEN - 1 && instance.stepsSeen == (1 << BSEC_STANDIN_PROFILE_LEN) - 1)
+        {
+            classifier(instance.gasResistance, BSEC_STANDIN_PROFILE_LEN, temperature, humidity, probability,
+                    classifierCtx);
+            instance.cycles++;
+            estimate = true;
+        }
+    }
+
+    for (uint8_t id = 1; id <= BSEC_OUTPUT_REGRESSION_ESTIMATE_4; id++)
+    {
+        bsec_output_t &result = results[nResults];
+        bool valid = true;
+
+        if (!(instance.subscribed & (UINT32_C(1) << id)))
+            continue;
+
+        result.time_stamp = timeStamp;
+        result.signal_dimensions = 1;
+        result.sensor_id = id;
+        result.accuracy = 0;
+
+        switch (id)
+        {
+        case BSEC_OUTPUT_RAW_TEMPERATURE:
+            result.signal = temperature;
+            break;
+        case BSEC_OUTPUT_RAW_PRESSURE:
+            result.signal = pressure;
+            break;
+        case BSEC_OUTPUT_RAW_HUMIDITY:
+            result.signal = humidity;
+            break;
+        case BSEC_OUTPUT_RAW_GAS:
+            result.signal = gas;
+            valid = hasGas;
+            break;
+        case BSEC_OUTPUT_RAW_GAS_INDEX:
+            result.signal = step;
+            valid = hasGas;
+            break;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE:
+            result.signal = temperature - heatSource;
+            break;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY:
+            result.signal = humidity;
+            break;
+        case BSEC_OUTPUT_STABILIZATION_STATUS:
+        case BSEC_OUTPUT_RUN_IN_STATUS:
+            result.signal = instance.cycles >= STANDIN_WARMUP_CYCLES ? 1.0f : 0.0f;
+            break;
+        case BSEC_OUTPUT_GAS_ESTIMATE_1:
+        case BSEC_OUTPUT_GAS_ESTIMATE_2:
+        case BSEC_OUTPUT_GAS_ESTIMATE_3:
+        case BSEC_OUTPUT_GAS_ESTIMATE_4:
+            result.signal = probability[id - BSEC_OUTPUT_GAS_ESTIMATE_1];
+            result.accuracy = instance.cycles > STANDIN_WARMUP_CYCLES ? 3 : 0;
+            valid = estimate;
+            break;
+        default:
+            /* IAQ and regression outputs are not modelled */
+            valid = false;
+            break;
+        }
+
+        if (valid && nResults < BSEC_NUMBER_OUTPUTS)
+            nResults++;
+    }
+
+    storeInstance(inst, instance);
+
+    if (*n_outputs == 0)
+        return BSEC_I_DOSTEPS_NOOUTPUTSRETURNABLE;
+
+    if (nResults > *n_outputs)
+    {
+        memcpy(outputs, results, *n_outputs * sizeof(bsec_output_t));
+        return BSEC_W_DOSTEPS_EXCESSOUTPUTS;
+    }
+
+    memcpy(outputs, results, nResults * sizeof(bsec_output_t));
+    *n_outputs = nResults;
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_reset_output_m(void *inst, uint8_t sensor_id)
+{
+    standinInstance instance;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    if (sensor_id >= BSEC_OUTPUT_GAS_ESTIMATE_1 && sensor_id <= BSEC_OUTPUT_GAS_ESTIMATE_4)
+    {
+        instance.cycles = 0;
+        instance.stepsSeen = 0;
+    }
+    storeInstance(inst, instance);
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_set_configuration_m(void *inst, const uint8_t *const serialized_settings,
+        const uint32_t n_serialized_settings, uint8_t *work_buffer, const uint32_t n_work_buffer_size)
+{
+    standinInstance instance;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    if (!serialized_settings || n_serialized_settings < 4)
+        return BSEC_E_CONFIG_EMPTY;
+
+    if (!work_buffer || n_work_buffer_size < BSEC_MAX_WORKBUFFER_SIZE)
+        return BSEC_E_CONFIG_INSUFFICIENTWORKBUFFER;
+
+    /* Decoded in the work buffer as the library does, the trained model of the configuration is not interpreted */
+    memcpy(work_buffer, serialized_settings,
+            n_serialized_settings < n_work_buffer_size ? n_serialized_settings : n_work_buffer_size);
+    callWorkBufferHook();
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_get_configuration_m(void *inst, const uint8_t config_id, uint8_t *serialized_settings,
+        const uint32_t n_serialized_settings_max, uint8_t *work_buffer, const uint32_t n_work_buffer,
+        uint32_t *n_serialized_settings)
+{
+    (void)inst;
+    (void)config_id;
+    (void)serialized_settings;
+    (void)n_serialized_settings_max;
+    (void)work_buffer;
+    (void)n_work_buffer;
+
+    *n_serialized_settings = 0;
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_set_state_m(void *inst, const uint8_t *const serialized_state, const uint32_t n_serialized_state,
+        uint8_t *work_buffer, const uint32_t n_work_buffer_size)
+{
+    standinInstance instance;
+    uint32_t magic;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    if (!serialized_state || n_serialized_state < 2 * sizeof(uint32_t))
+        return BSEC_E_CONFIG_EMPTY;
+
+    if (!work_buffer || n_work_buffer_size < 2 * sizeof(uint32_t))
+        return BSEC_E_CONFIG_INSUFFICIENTWORKBUFFER;
+
+    /* Decoded from the work buffer as the library does, instances sharing one must not call at the same time */
+    memcpy(work_buffer, serialized_state, 2 * sizeof(uint32_t));
+    callWorkBufferHook();
+    memcpy(&magic, work_buffer, sizeof(magic));
+    if (magic != STANDIN_STATE_MAGIC)
+        return BSEC_E_CONFIG_VERSIONMISMATCH;
+
+    memcpy(&instance.cycles, &work_buffer[sizeof(magic)], sizeof(instance.cycles));
+    storeInstance(inst, instance);
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_get_state_m(void *inst, const uint8_t state_set_id, uint8_t *serialized_state,
+        const uint32_t n_serialized_state_max, uint8_t *work_buffer, const uint32_t n_work_buffer,
+        uint32_t *n_serialized_state)
+{
+    standinInstance instance;
+    uint32_t magic = STANDIN_STATE_MAGIC;
+
+    (void)state_set_id;
+
+    if (!loadInstance(inst, instance))
+        return BSEC_E_CONFIG_FAIL;
+
+    if (n_serialized_state_max < BSEC_MAX_STATE_BLOB_SIZE)
+        return BSEC_E_CONFIG_INSUFFICIENTBUFFER;
+
+    if (!work_buffer || n_work_buffer < BSEC_MAX_STATE_BLOB_SIZE)
+        return BSEC_E_CONFIG_INSUFFICIENTWORKBUFFER;
+
+    /* Same size as a real state blob, so the state storage is exercised as on the target. It is put
+       together in the work buffer as the library does */
+    memset(work_buffer, 0, BSEC_MAX_STATE_BLOB_SIZE);
+    memcpy(work_buffer, &magic, sizeof(magic));
+    memcpy(&work_buffer[sizeof(magic)], &instance.cycles, sizeof(instance.cycles));
+    callWorkBufferHook();
+    memcpy(serialized_state, work_buffer, BSEC_MAX_STATE_BLOB_SIZE);
+    *n_serialized_state = BSEC_MAX_STATE_BLOB_SIZE;
+
+    return BSEC_OK;
+}
+
+#endif /* BSEC_STANDIN */
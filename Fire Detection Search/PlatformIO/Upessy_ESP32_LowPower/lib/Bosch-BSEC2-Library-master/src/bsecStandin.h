@@ -0,0 +1,59 @@
+/**
+ * @file	bsecStandin.h
+ *
+ * Stand-in for libalgobsec, built instead of the proprietary library when
+ * BSEC_STANDIN is defined, e.g. for the native environment of a host build.
+ *
+ * It implements the multi-instance interface of bsec_interface_multi.h with
+ * the same call pattern as the real library: a heater profile scanned in
+ * parallel mode at BSEC_SAMPLE_RATE_SCAN, forced mode measurements at the
+ * other sample rates, raw outputs passed through and a 221 byte state blob.
+ * The gas estimates come from a classifier set with bsecStandinSetClassifier,
+ * which sees the gas resistances of one complete heater profile. The default
+ * classifier only maps a low resistance to class 1 and is no model of any
+ * trained configuration, which is ignored by the stand-in.
+ */
+
+#ifndef BSEC_STANDIN_H_
+#define BSEC_STANDIN_H_
+
+#include <stdint.h>
+
+#define BSEC_STANDIN_NUM_CLASSES        4
+#define BSEC_STANDIN_PROFILE_LEN        10
+
+/**
+ * @brief Function computing the class probabilities of a heater profile
+ * @param gasResistance	: Gas resistance of each heater step in Ohm
+ * @param nSteps		: Number of heater steps, 1 in forced mode
+ * @param temperature	: Temperature of the last step in degrees Celsius
+ * @param humidity		: Relative humidity of the last step in percent
+ * @param probability	: Probability of each of the BSEC_STANDIN_NUM_CLASSES classes, between 0 and 1
+ * @param ctx			: Context given to bsecStandinSetClassifier
+ */
+typedef void (*bsecStandinClassifier)(const float *gasResistance, uint8_t nSteps, float temperature, float humidity,
+        float *probability, void *ctx);
+
+/**
+ * @brief Function to replace the classifier of all the instances
+ * @param classifier	: Classifier, NULL restores the default one
+ * @param ctx			: Pointer handed to the classifier unchanged
+ */
+void bsecStandinSetClassifier(bsecStandinClassifier classifier, void *ctx);
+
+/**
+ * @brief Function called by the state and configuration calls while their data is in the work buffer,
+ * between writing it there and reading it back
+ * @param ctx			: Context given to bsecStandinSetWorkBufferHook
+ */
+typedef void (*bsecStandinWorkBufferHook)(void *ctx);
+
+/**
+ * @brief Function to set the work buffer hook of all the instances, e.g. to let other threads run while
+ * a work buffer is in use
+ * @param hook			: Hook, NULL for none
+ * @param ctx			: Pointer handed to the hook unchanged
+ */
+void bsecStandinSetWorkBufferHook(bsecStandinWorkBufferHook hook, void *ctx);
+
+#endif /* BSEC_STANDIN_H_ */
@@ -38,6 +38,11 @@
 
 #include "commMux.h"
 
+#ifdef ARDUINO_ARCH_ESP32
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
+
 #define CLOCK_FREQUENCY 	UINT32_C(400000)
 #define COMM_SPEED      	UINT32_C(8000000)
 
@@ -47,6 +52,20 @@ const uint8_t I2C_EXPANDER_OUTPUT_DESELECT = 0xFF;
 const uint8_t I2C_EXPANDER_CONFIG_REG_ADDR = 0x03;
 const uint8_t I2C_EXPANDER_CONFIG_REG_MASK = 0x00;
 
+#ifdef ARDUINO_ARCH_ESP32
+/* Guards the I2C expander and the SPI bus, sensors may be read from tasks on both cores */
+static SemaphoreHandle_t bus_lock = NULL;
+static StaticSemaphore_t bus_lock_mem;
+static portMUX_TYPE bus_lock_init = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+/* Output level of the expander, the sensor selected or I2C_EXPANDER_OUTPUT_DESELECT */
+static uint8_t cs_mask = I2C_EXPANDER_OUTPUT_DESELECT;
+/* A register access ended since the chip select was asserted, the next one needs a new falling edge */
+static bool cs_used = false;
+/* Nesting of comm_mux_begin_transaction, the chip select is released when it drops to 0 */
+static uint8_t transaction_depth = 0;
+
 /**
  * @brief Function to configure the communication across sensors
  */
@@ -72,6 +91,37 @@ void comm_mux_begin(TwoWire &wireobj, SPIClass &spiobj)
 	wireobj.endTransmission();
 
 	spiobj.begin();
+
+	cs_mask = I2C_EXPANDER_OUTPUT_DESELECT;
+	cs_used = false;
+	transaction_depth = 0;
+}
+
+/**
+ * @brief Function to take the bus shared by the sensors
+ */
+void comm_mux_lock(void)
+{
+#ifdef ARDUINO_ARCH_ESP32
+	portENTER_CRITICAL(&bus_lock_init);
+	if (bus_lock == NULL)
+	{
+		bus_lock = xSemaphoreCreateRecursiveMutexStatic(&bus_lock_mem);
+	}
+	portEXIT_CRITICAL(&bus_lock_init);
+
+	xSemaphoreTakeRecursive(bus_lock, portMAX_DELAY);
+#endif
+}
+
+/**
+ * @brief Function to release the bus taken with comm_mux_lock
+ */
+void comm_mux_unlock(void)
+{
+#ifdef ARDUINO_ARCH_ESP32
+	xSemaphoreGiveRecursive(bus_lock);
+#endif
 }
 
 /** 
@@ -89,6 +139,77 @@ static void set_chip_select(TwoWire *wireobj, uint8_t mask)
 	wireobj->endTransmission();
 }
 
+/**
+ * @brief Function to give the selected sensor a new falling edge of its chip select. The expander
+ *        latches every data byte written to its output register, so the deselect and the select
+ *        go out in one I2C transaction
+ */
+static void restart_chip_select(TwoWire *wireobj, uint8_t mask)
+{
+	wireobj->beginTransmission(I2C_EXPANDER_ADDR);
+	wireobj->write(I2C_EXPANDER_OUTPUT_REG_ADDR);
+	wireobj->write(I2C_EXPANDER_OUTPUT_DESELECT);
+	wireobj->write(mask);
+	wireobj->endTransmission();
+}
+
+/**
+ * @brief Function to assert the chip select of a sensor for one register access. The BME68x takes
+ *        the register address after a falling edge only, so a select that was already used is restarted
+ */
+static void select_sensor(const comm_mux *comm)
+{
+	if (cs_mask == I2C_EXPANDER_OUTPUT_DESELECT)
+	{
+		set_chip_select(comm->wireobj, comm->select);
+	}
+	else if ((cs_mask != comm->select) || cs_used)
+	{
+		restart_chip_select(comm->wireobj, comm->select);
+	}
+
+	cs_mask = comm->select;
+	cs_used = false;
+}
+
+/**
+ * @brief Function to end one register access, the chip select is kept within a transaction
+ */
+static void release_sensor(const comm_mux *comm)
+{
+	cs_used = true;
+
+	if (transaction_depth == 0)
+	{
+		set_chip_select(comm->wireobj, I2C_EXPANDER_OUTPUT_DESELECT);
+		cs_mask = I2C_EXPANDER_OUTPUT_DESELECT;
+	}
+}
+
+/**
+ * @brief Function to open a transaction with one sensor, the chip select is asserted by its first access
+ */
+void comm_mux_begin_transaction(comm_mux &comm)
+{
+	(void) comm;
+	comm_mux_lock();
+	transaction_depth++;
+}
+
+/**
+ * @brief Function to close the transaction opened with comm_mux_begin_transaction
+ */
+void comm_mux_end_transaction(comm_mux &comm)
+{
+	/* Released only if an access of the transaction selected a sensor */
+	if ((transaction_depth > 0) && (--transaction_depth == 0) && (cs_mask != I2C_EXPANDER_OUTPUT_DESELECT))
+	{
+		set_chip_select(comm.wireobj, I2C_EXPANDER_OUTPUT_DESELECT);
+		cs_mask = I2C_EXPANDER_OUTPUT_DESELECT;
+	}
+	comm_mux_unlock();
+}
+
 /**
  * @brief Function to write the sensor data to the register
  */
@@ -99,7 +220,8 @@ int8_t comm_mux_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t length
 
 	if (comm)
 	{
-		set_chip_select(comm->wireobj, comm->select);
+		comm_mux_lock();
+		select_sensor(comm);
 
 		comm->spiobj->beginTransaction(SPISettings(COMM_SPEED, MSBFIRST, SPI_MODE0));
 		comm->spiobj->transfer(reg_addr);
@@ -110,7 +232,8 @@ int8_t comm_mux_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t length
 		}
 		comm->spiobj->endTransaction();
 
-		set_chip_select(comm->wireobj, I2C_EXPANDER_OUTPUT_DESELECT);
+		release_sensor(comm);
+		comm_mux_unlock();
 
 		return 0;
 	}
@@ -128,7 +251,8 @@ int8_t comm_mux_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t length, void
 
 	if (comm)
 	{
-		set_chip_select(comm->wireobj, comm->select);
+		comm_mux_lock();
+		select_sensor(comm);
 
 		comm->spiobj->beginTransaction(SPISettings(COMM_SPEED, MSBFIRST, SPI_MODE0));
 		comm->spiobj->transfer(reg_addr);
@@ -139,7 +263,8 @@ int8_t comm_mux_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t length, void
 		}
 		comm->spiobj->endTransaction();
 
-		set_chip_select(comm->wireobj, I2C_EXPANDER_OUTPUT_DESELECT);
+		release_sensor(comm);
+		comm_mux_unlock();
 
 		return 0;
 	}
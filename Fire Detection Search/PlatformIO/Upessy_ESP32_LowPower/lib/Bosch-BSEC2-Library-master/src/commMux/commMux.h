@@ -42,6 +42,8 @@
 #include "Wire.h"
 #include "SPI.h"
 
+#include "bme68x/bme68x_defs.h"
+
 /**
  * Datatype working as an interface descriptor
  */
@@ -68,6 +70,34 @@ comm_mux comm_mux_set_config(TwoWire &wireobj, SPIClass &spiobj, uint8_t idx, co
  */
 void comm_mux_begin(TwoWire &wireobj, SPIClass &spiobj);
 
+/**
+ * @brief Function to take the bus shared by the sensors. Reads and writes take it on their own,
+ *        other users of the TwoWire or SPIClass objects must take it when sensors run in other tasks
+ */
+void comm_mux_lock(void);
+
+/**
+ * @brief Function to release the bus taken with comm_mux_lock
+ */
+void comm_mux_unlock(void);
+
+/**
+ * @brief Function to open a transaction with one sensor. The bus is taken, the first read or write
+ *        asserts the chip select of the sensor and it stays asserted until comm_mux_end_transaction:
+ *        the reads and writes in between only restart it, with one I2C transaction to the expander
+ *        instead of two. A transaction without an access does not write the expander. Transactions
+ *        may nest, the bus must not be used for other SPI devices while one is open
+ * @param comm : Structure for selected sensor
+ */
+void comm_mux_begin_transaction(comm_mux &comm);
+
+/**
+ * @brief Function to close the transaction opened with comm_mux_begin_transaction, the chip select
+ *        is released when the outermost transaction closes
+ * @param comm : Structure for selected sensor
+ */
+void comm_mux_end_transaction(comm_mux &comm);
+
 /**
  * @brief Function to write the sensor data to the register
  * @param reg_addr : Address of the register
@@ -95,4 +125,50 @@ int8_t comm_mux_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t length, void
  */
 void comm_mux_delay(uint32_t period_us, void *intf_ptr);
 
+/**
+ * Transport policy of Bme68xT for a sensor behind the I2C expander, see bme68xTransport.h
+ */
+class commMuxTransport
+{
+public:
+   static const bme68x_intf intf = BME68X_SPI_INTF;
+
+   commMuxTransport(TwoWire &wireobj, SPIClass &spiobj, uint8_t idx)
+   {
+      comm_mux_set_config(wireobj, spiobj, idx, comm);
+   }
+
+   void begin(void)
+   {
+   }
+
+   int8_t read(uint8_t reg_addr, uint8_t *reg_data, uint32_t length)
+   {
+      return comm_mux_read(reg_addr, reg_data, length, &comm);
+   }
+
+   int8_t write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t length)
+   {
+      return comm_mux_write(reg_addr, reg_data, length, &comm);
+   }
+
+   void beginTransaction(void)
+   {
+      comm_mux_begin_transaction(comm);
+   }
+
+   void endTransaction(void)
+   {
+      comm_mux_end_transaction(comm);
+   }
+
+   void delayUs(uint32_t period_us)
+   {
+      delayMicroseconds(period_us);
+   }
+
+private:
+   comm_mux comm;
+};
+
 #endif /* COMM_MUX_H */
@@ -0,0 +1,448 @@
+/**
+ * @file	sdLogWriter.cpp
+ *
+ * Append-only SD card log file written by a FreeRTOS task, see sdLogWriter.h
+ */
+
+#include "sdLogWriter.h"
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+
+#ifdef ARDUINO_ARCH_ESP32
+#include "esp_timer.h"
+#define SD_LOG_TIME_US()    ((uint32_t) esp_timer_get_time())
+#else
+#include <chrono>
+/* The card of the host shims takes real time, micros runs on the virtual clock */
+#define SD_LOG_TIME_US()    ((uint32_t) std::chrono::duration_cast<std::chrono::microseconds>( \
+        std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+
+/* Both buffers, a patch, the close and the next open */
+#define SD_LOG_QUEUE_LEN    (SD_LOG_BUFFERS + 3)
+
+static SemaphoreHandle_t cardLock = xSemaphoreCreateRecursiveMutex();
+static void (*busLock)(void) = NULL;
+static void (*busUnlock)(void) = NULL;
+
+/* Card write latency histogram, under the card lock */
+static uint32_t latencyBuckets[SD_LOG_LATENCY_BUCKETS];
+static uint32_t latencyCount = 0;
+static uint32_t latencyMaxUs = 0;
+
+/**
+ * @brief Constructor of sdLogWriter class
+ */
+sdLogWriter::sdLogWriter(void)
+{
+    current = 0;
+    bufferPos = 0;
+    fill = 0;
+    written = 0;
+    open = false;
+    closing = false;
+    fileName[0] = '\0';
+    preallocSize = 0;
+    syncBuffers = SD_LOG_SYNC_BUFFERS;
+    unsynced = 0;
+    errors = 0;
+    errorsAtBegin = 0;
+    stalls = 0;
+    task = NULL;
+    jobs = NULL;
+    freeBuffers = NULL;
+    closed = NULL;
+}
+
+/**
+ * @brief Function to start a new log file
+ */
+bool sdLogWriter::begin(const char *name, uint32_t preallocSize, uint32_t syncBuffers)
+{
+    writerJob job = {};
+
+    if (open)
+        (void) end();
+
+    /* The task still uses the settings and the error count of the file ended before */
+    (void) waitClosed();
+
+    if (strlen(name) >= SD_LOG_MAX_NAME || (task == NULL && !createTask()))
+        return false;
+
+    /* The task reads the name once the open job runs, no file is open until then */
+    strcpy(fileName, name);
+    this->preallocSize = preallocSize;
+    this->syncBuffers = syncBuffers;
+    errorsAtBegin = errors;
+    bufferPos = 0;
+    fill = 0;
+    written = 0;
+
+    (void) xSemaphoreTake(freeBuffers, portMAX_DELAY);
+    job.type = JOB_OPEN;
+    queueJob(job);
+    open = true;
+
+    return true;
+}
+
+/**
+ * @brief Function to append a byte
+ */
+size_t sdLogWriter::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+/**
+ * @brief Function to append data
+ */
+size_t sdLogWriter::write(const uint8_t *buffer, size_t size)
+{
+    if (!open)
+        return 0;
+
+    for (size_t left = size; left;)
+    {
+        size_t chunk = SD_LOG_BUFFER_SIZE - fill;
+
+        if (chunk > left)
+            chunk = left;
+        memcpy(&buffers[current][fill], buffer, chunk);
+        fill += chunk;
+        buffer += chunk;
+        left -= chunk;
+
+        if (fill == SD_LOG_BUFFER_SIZE)
+            queueBuffer();
+    }
+    written += size;
+
+    return size;
+}
+
+/**
+ * @brief Function to overwrite data written before
+ */
+bool sdLogWriter::patch(uint32_t pos, const uint8_t *data, size_t len)
+{
+    if (!open || pos + len > written)
+        return false;
+
+    /* The part in the buffer in use is changed in place, the rest follows the buffers queued before */
+    if (pos + len > bufferPos)
+    {
+        uint32_t from = (pos > bufferPos) ? pos : bufferPos;
+
+        memcpy(&buffers[current][from - bufferPos], data + (from - pos), pos + len - from);
+        len = from - pos;
+    }
+
+    if (len)
+    {
+        writerJob job = {};
+
+        if (len > SD_LOG_PATCH_SIZE)
+            return false;
+        job.type = JOB_PATCH;
+        job.pos = pos;
+        job.len = (uint16_t) len;
+        memcpy(job.data, data, len);
+        queueJob(job);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Function to write the buffered data and close the file
+ */
+bool sdLogWriter::end(void)
+{
+    writerJob job = {};
+
+    if (!open)
+        return false;
+
+    if (fill)
+    {
+        job.type = JOB_WRITE;
+        job.buffer = current;
+        job.len = (uint16_t) fill;
+        queueJob(job);
+    }
+    else
+    {
+        (void) xSemaphoreGive(freeBuffers);
+    }
+    current = (current + 1) % SD_LOG_BUFFERS;
+    bufferPos += fill;
+    fill = 0;
+
+    /* The task cuts and closes the file on its own, the next begin waits for it if it has not yet */
+    job.type = JOB_CLOSE;
+    queueJob(job);
+    closing = true;
+    open = false;
+
+    return errors == errorsAtBegin;
+}
+
+/**
+ * @brief Function to wait until the file ended before is closed
+ */
+bool sdLogWriter::waitClosed(void)
+{
+    if (closing)
+    {
+        (void) xSemaphoreTake(closed, portMAX_DELAY);
+        closing = false;
+    }
+
+    return errors == errorsAtBegin;
+}
+
+/**
+ * @brief Function to take the card
+ */
+void sdLogWriter::lockCard(void)
+{
+    (void) xSemaphoreTakeRecursive(cardLock, portMAX_DELAY);
+    if (busLock)
+        busLock();
+}
+
+/**
+ * @brief Function to release the card
+ */
+void sdLogWriter::unlockCard(void)
+{
+    if (busUnlock)
+        busUnlock();
+    (void) xSemaphoreGiveRecursive(cardLock);
+}
+
+/**
+ * @brief Function to get a percentile of the card write latency
+ */
+uint32_t sdLogWriter::getWriteLatencyUs(uint8_t percent)
+{
+    uint32_t latencyUs = 0;
+
+    lockCard();
+    if (percent >= 100)
+    {
+        latencyUs = latencyMaxUs;
+    }
+    else if (latencyCount)
+    {
+        /* Rank of the write, rounded up, among the writes sorted by latency */
+        uint32_t rank = (uint32_t) (((uint64_t) latencyCount * percent + 99) / 100);
+        uint32_t seen = 0;
+        uint8_t i = 0;
+
+        if (rank == 0)
+            rank = 1;
+        for (; i < SD_LOG_LATENCY_BUCKETS - 1; i++)
+        {
+            seen += latencyBuckets[i];
+            if (seen >= rank)
+                break;
+        }
+
+        /* Upper bound of the bucket, the first steps are one microsecond wide */
+        if (i < SD_LOG_LATENCY_STEPS)
+            latencyUs = i;
+        else
+        {
+            uint8_t shift = i / SD_LOG_LATENCY_STEPS - 1;
+
+            latencyUs = ((uint32_t) (SD_LOG_LATENCY_STEPS + i % SD_LOG_LATENCY_STEPS + 1) << shift) - 1;
+        }
+        if (latencyUs > latencyMaxUs)
+            latencyUs = latencyMaxUs;
+    }
+    unlockCard();
+
+    return latencyUs;
+}
+
+/**
+ * @brief Function to get the number of card writes in the latency histogram
+ */
+uint32_t sdLogWriter::getWriteCount(void)
+{
+    return latencyCount;
+}
+
+/**
+ * @brief Function to clear the latency histogram
+ */
+void sdLogWriter::resetWriteLatency(void)
+{
+    lockCard();
+    memset(latencyBuckets, 0, sizeof(latencyBuckets));
+    latencyCount = 0;
+    latencyMaxUs = 0;
+    unlockCard();
+}
+
+/**
+ * @brief Function to add a card write to the latency histogram
+ */
+void sdLogWriter::addWriteLatency(uint32_t us)
+{
+    uint32_t i = us;
+
+    /* Buckets of SD_LOG_LATENCY_STEPS per power of two, by the 2 bits after the leading one */
+    if (us >= SD_LOG_LATENCY_STEPS)
+    {
+        uint8_t shift = 31 - __builtin_clz(us) - 2;
+
+        i = (shift + 1) * SD_LOG_LATENCY_STEPS + ((us >> shift) & (SD_LOG_LATENCY_STEPS - 1));
+    }
+    if (i >= SD_LOG_LATENCY_BUCKETS)
+        i = SD_LOG_LATENCY_BUCKETS - 1;
+
+    latencyBuckets[i]++;
+    latencyCount++;
+    if (us > latencyMaxUs)
+        latencyMaxUs = us;
+}
+
+/**
+ * @brief Function to set the lock of the SPI bus of the card
+ */
+void sdLogWriter::setBusLock(void (*lock)(void), void (*unlock)(void))
+{
+    busLock = lock;
+    busUnlock = unlock;
+}
+
+/**
+ * @brief Function to create the task, its queue and semaphores
+ */
+bool sdLogWriter::createTask(void)
+{
+    if (jobs == NULL)
+        jobs = xQueueCreate(SD_LOG_QUEUE_LEN, sizeof(writerJob));
+    if (freeBuffers == NULL)
+        freeBuffers = xSemaphoreCreateCounting(SD_LOG_BUFFERS, SD_LOG_BUFFERS);
+    if (closed == NULL)
+        closed = xSemaphoreCreateBinary();
+    if (jobs == NULL || freeBuffers == NULL || closed == NULL)
+        return false;
+
+    if (xTaskCreatePinnedToCore(writerTask, "sdlog", SD_LOG_STACK_SIZE, this, SD_LOG_PRIORITY, &task,
+            tskNO_AFFINITY) != pdPASS)
+        task = NULL;
+
+    return task != NULL;
+}
+
+/**
+ * @brief Function to hand the buffer in use to the task and take the next one
+ */
+void sdLogWriter::queueBuffer(void)
+{
+    writerJob job = {};
+
+    job.type = JOB_WRITE;
+    job.buffer = current;
+    job.len = (uint16_t) fill;
+    queueJob(job);
+
+    /* The task frees the buffers in the order they were queued */
+    current = (current + 1) % SD_LOG_BUFFERS;
+    bufferPos += fill;
+    fill = 0;
+
+    if (xSemaphoreTake(freeBuffers, 0) != pdTRUE)
+    {
+        stalls++;
+        (void) xSemaphoreTake(freeBuffers, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief Function to queue a job
+ */
+void sdLogWriter::queueJob(const writerJob &job)
+{
+    (void) xQueueSend(jobs, &job, portMAX_DELAY);
+}
+
+/**
+ * @brief Function to run one job in the task
+ */
+void sdLogWriter::runJob(const writerJob &job)
+{
+    switch (job.type)
+    {
+    case JOB_OPEN:
+        unsynced = 0;
+        if (!file.open(fileName, O_RDWR | O_CREAT | O_TRUNC))
+            errors++;
+        /* Without the preallocation the file grows cluster by cluster, slower but still correct */
+        else if (preallocSize)
+            (void) file.preAllocate(preallocSize);
+        break;
+
+    case JOB_WRITE:
+        if (!file.isOpen() || file.write(buffers[job.buffer], job.len) != job.len)
+            errors++;
+        else if (++unsynced >= syncBuffers)
+        {
+            (void) file.sync();
+            unsynced = 0;
+        }
+        (void) xSemaphoreGive(freeBuffers);
+        break;
+
+    case JOB_PATCH:
+    {
+        uint32_t pos = file.curPosition();
+
+        if (!file.isOpen() || !file.seekSet(job.pos) || file.write(job.data, job.len) != job.len ||
+                !file.seekSet(pos))
+            errors++;
+    }
+    break;
+
+    case JOB_CLOSE:
+        if (file.isOpen() && (!file.truncate() || !file.close()))
+            errors++;
+        (void) xSemaphoreGive(closed);
+        break;
+    }
+}
+
+/**
+ * @brief Loop of the writer task
+ */
+void sdLogWriter::work(void)
+{
+    writerJob job;
+
+    for (;;)
+    {
+        if (xQueueReceive(jobs, &job, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        uint32_t startUs = SD_LOG_TIME_US();
+
+        lockCard();
+        runJob(job);
+        if (job.type == JOB_WRITE)
+            addWriteLatency(SD_LOG_TIME_US() - startUs);
+        unlockCard();
+    }
+}
+
+void sdLogWriter::writerTask(void *arg)
+{
+    ((sdLogWriter*) arg)->work();
+}
+
+#endif /* ARDUINO_ARCH_ESP32 || NODE_BENCH */
@@ -0,0 +1,254 @@
+/**
+ * @file	sdLogWriter.h
+ *
+ * Append-only SD card log file written by a FreeRTOS task. The file is created and
+ * preallocated contiguously by the task, then the data goes through two buffers of whole
+ * 512 byte blocks: the caller fills one while the task writes the other, so full buffers land
+ * on sector boundaries and SdFat sends them in one multiple block command without its sector
+ * cache. The file stays open until end, which writes the last partial buffer and cuts the
+ * preallocation at the size written. The task closes the file after end returns, the next
+ * begin waits for it if it is not done yet.
+ *
+ * SdFat is not thread safe. The task holds the card lock around every file operation, other
+ * users of the card must take it with lockCard while a writer is open. When the card shares
+ * its SPI bus with other devices, setBusLock makes the card lock take the bus lock as well.
+ *
+ * Writes do not block unless both buffers are waiting for the card, these waits are counted
+ * as stalls. Errors of the task are counted as well, the caller polls them. The time of each
+ * card write of the tasks, card lock wait included, goes into a histogram shared by all the
+ * writers, getWriteLatencyUs gives its percentiles.
+ */
+
+#ifndef SD_LOG_WRITER_H_
+#define SD_LOG_WRITER_H_
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(NODE_BENCH)
+
+#include "Arduino.h"
+#include <SdFat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define SD_LOG_BLOCK_SIZE       512
+#define SD_LOG_BUFFERS          2
+
+/* Blocks per buffer, each full buffer is one card write */
+#ifndef SD_LOG_BUFFER_BLOCKS
+#define SD_LOG_BUFFER_BLOCKS    4
+#endif
+#define SD_LOG_BUFFER_SIZE      (SD_LOG_BLOCK_SIZE * SD_LOG_BUFFER_BLOCKS)
+
+/* Buffers written between two syncs by default. With a preallocation they only matter if it
+   failed, without one the size on the card, and so the data a reset leaves, is the synced one */
+#ifndef SD_LOG_SYNC_BUFFERS
+#define SD_LOG_SYNC_BUFFERS     32
+#endif
+
+/* Stack of the writer task in bytes, SdFat runs on this stack */
+#ifndef SD_LOG_STACK_SIZE
+#define SD_LOG_STACK_SIZE       4096
+#endif
+
+#ifndef SD_LOG_PRIORITY
+#define SD_LOG_PRIORITY         1
+#endif
+
+/* Card write latency histogram, 4 buckets per power of two of microseconds up to 2^24 us */
+#define SD_LOG_LATENCY_STEPS    4
+#define SD_LOG_LATENCY_BUCKETS  (23 * SD_LOG_LATENCY_STEPS)
+
+#define SD_LOG_MAX_NAME         128
+/* Bytes of one patch past the buffer in use, e.g. a file header */
+#define SD_LOG_PATCH_SIZE       16
+
+class sdLogWriter : public Print
+{
+public:
+    sdLogWriter(void);
+
+    /**
+     * @brief Function to start a new log file, the open one is ended first
+     * @param name			: Path of the file, truncated if it exists
+     * @param preallocSize	: Bytes allocated contiguously up front, 0 for none
+     * @param syncBuffers	: Buffers written between two syncs of the directory entry
+     * @return	true for success, false if the name is too long or the task could not be created
+     */
+    bool begin(const char *name, uint32_t preallocSize, uint32_t syncBuffers = SD_LOG_SYNC_BUFFERS);
+
+    /**
+     * @brief Function to append data, blocks only while both buffers wait for the card
+     * @return	Number of bytes taken, 0 if no file is open
+     */
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    /**
+     * @brief Function to overwrite data written before, e.g. a header completed after the data that follows it
+     * @param pos	: Position in the file
+     * @param data	: New bytes, at most SD_LOG_PATCH_SIZE of them are past the buffer in use
+     * @param len	: Number of bytes
+     * @return	true for success, false if the range is past the end or too long
+     */
+    bool patch(uint32_t pos, const uint8_t *data, size_t len);
+
+    /**
+     * @brief Function to queue the buffered data, the cut of the file at its size and its close, returns without
+     *        waiting for the task. The errors of these operations are counted once the task ran them
+     * @return	true if no error occurred since begin, false otherwise
+     */
+    bool end(void);
+
+    /**
+     * @brief Function to wait until the file ended before is written and closed, e.g. before the card is set up
+     *        again or the file is read back
+     * @return	true if no error occurred from begin to the close, false otherwise
+     */
+    bool waitClosed(void);
+
+    /**
+     * @brief Function to know if a file is open
+     */
+    bool isOpen(void)
+    {
+        return open;
+    }
+
+    /**
+     * @brief Function to get the size of the file, with the buffered data
+     */
+    uint32_t size(void)
+    {
+        return written;
+    }
+
+    /**
+     * @brief Function to get the number of writes that waited for a free buffer
+     */
+    uint32_t getStalls(void)
+    {
+        return stalls;
+    }
+
+    /**
+     * @brief Function to get the number of failed file operations of the task
+     */
+    uint32_t getErrors(void)
+    {
+        return errors;
+    }
+
+    /**
+     * @brief Function to get a percentile of the card write latency of all the writers
+     * @param percent	: Percentage of the writes, 100 for the longest write
+     * @return	Upper bound in microseconds of the latency of percent percent of the writes,
+     *          within a quarter of a power of two, 0 without writes
+     */
+    static uint32_t getWriteLatencyUs(uint8_t percent);
+
+    /**
+     * @brief Function to get the number of card writes in the latency histogram
+     */
+    static uint32_t getWriteCount(void);
+
+    /**
+     * @brief Function to clear the latency histogram
+     */
+    static void resetWriteLatency(void);
+
+    /**
+     * @brief Function to take the card, recursive
+     */
+    static void lockCard(void);
+
+    /**
+     * @brief Function to release the card taken with lockCard
+     */
+    static void unlockCard(void);
+
+    /**
+     * @brief Function to set the lock of the SPI bus of the card, taken by lockCard after the card lock
+     */
+    static void setBusLock(void (*lock)(void), void (*unlock)(void));
+
+private:
+    enum jobType : uint8_t
+    {
+        JOB_OPEN,
+        JOB_WRITE,
+        JOB_PATCH,
+        JOB_CLOSE
+    };
+
+    struct writerJob
+    {
+        jobType type;
+        uint8_t buffer;
+        uint16_t len;
+        uint32_t pos;
+        uint8_t data[SD_LOG_PATCH_SIZE];
+    };
+
+    alignas(4) uint8_t buffers[SD_LOG_BUFFERS][SD_LOG_BUFFER_SIZE];
+    /* Buffer filled by the caller, its position in the file and its fill level */
+    uint8_t current;
+    uint32_t bufferPos;
+    uint32_t fill;
+    uint32_t written;
+    bool open;
+    /* A close queued by end that the caller has not waited for */
+    bool closing;
+
+    char fileName[SD_LOG_MAX_NAME];
+    uint32_t preallocSize;
+    uint32_t syncBuffers;
+    File file;
+    uint32_t unsynced;
+
+    volatile uint32_t errors;
+    uint32_t errorsAtBegin;
+    uint32_t stalls;
+
+    TaskHandle_t task;
+    QueueHandle_t jobs;
+    SemaphoreHandle_t freeBuffers;
+    SemaphoreHandle_t closed;
+
+    /**
+     * @brief Function to create the task, its queue and semaphores
+     */
+    bool createTask(void);
+
+    /**
+     * @brief Function to hand the buffer in use to the task and take the next one
+     */
+    void queueBuffer(void);
+
+    /**
+     * @brief Function to queue a job, waits for room in the queue
+     */
+    void queueJob(const writerJob &job);
+
+    /**
+     * @brief Function to run one job in the task
+     */
+    void runJob(const writerJob &job);
+
+    /**
+     * @brief Function to add a card write to the latency histogram, under the card lock
+     */
+    static void addWriteLatency(uint32_t us);
+
+    /**
+     * @brief Loop of the writer task
+     */
+    void work(void);
+
+    static void writerTask(void *arg);
+};
+
+#endif /* ARDUINO_ARCH_ESP32 || NODE_BENCH */
+
+#endif /* SD_LOG_WRITER_H_ */
@@ -0,0 +1,257 @@
+#include "Arduino.h"
+
+#define NATIVE_MAX_EVENTS 8
+
+typedef struct
+{
+	bool pending;
+	uint64_t atUs;
+	nativeEventHandler handler;
+	void *ctx;
+} nativeEvent;
+
+HardwareSerial Serial;
+
+static uint64_t nowUs = 0;
+static uint64_t bootStartUs = 0;
+static uint64_t yieldUs = 0;
+static uint64_t lightSleepUs = 0;
+static esp_reset_reason_t resetReason = ESP_RST_POWERON;
+static nativeEvent events[NATIVE_MAX_EVENTS];
+static uint8_t pins[NATIVE_NUM_PINS];
+
+static uint64_t timerWakeupUs = 0;
+static bool timerWakeup = false;
+static bool gpioWakeup = false;
+
+uint64_t nativeNowUs()
+{
+	return nowUs;
+}
+
+uint64_t nativeBootUs()
+{
+	return nowUs - bootStartUs;
+}
+
+uint64_t nativeYieldUs()
+{
+	return yieldUs;
+}
+
+uint64_t nativeLightSleepUs()
+{
+	return lightSleepUs;
+}
+
+bool nativeNextEvent(uint64_t &atUs)
+{
+	bool found = false;
+
+	for (uint8_t i = 0; i < NATIVE_MAX_EVENTS; i++)
+	{
+		if (events[i].pending && (!found || events[i].atUs < atUs))
+		{
+			atUs = events[i].atUs;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+void nativeAdvanceUs(uint64_t us)
+{
+	uint64_t targetUs = nowUs + us;
+	uint64_t eventUs = 0;
+
+	/* Events may schedule new ones, pick them one at a time in time order */
+	while (nativeNextEvent(eventUs) && eventUs <= targetUs)
+	{
+		for (uint8_t i = 0; i < NATIVE_MAX_EVENTS; i++)
+		{
+			if (events[i].pending && events[i].atUs == eventUs)
+			{
+				if (eventUs > nowUs)
+					nowUs = eventUs;
+				events[i].pending = false;
+				events[i].handler(events[i].ctx);
+				break;
+			}
+		}
+	}
+
+	nowUs = targetUs;
+}
+
+bool nativeScheduleEvent(uint64_t atUs, nativeEventHandler handler, void *ctx)
+{
+	nativeEvent *slot = nullptr;
+
+	for (uint8_t i = 0; i < NATIVE_MAX_EVENTS; i++)
+	{
+		if (events[i].pending && events[i].handler == handler && events[i].ctx == ctx)
+		{
+			slot = &events[i];
+			break;
+		}
+		if (!events[i].pending && slot == nullptr)
+			slot = &events[i];
+	}
+
+	if (slot == nullptr)
+		return false;
+
+	slot->pending = true;
+	slot->atUs = atUs;
+	slot->handler = handler;
+	slot->ctx = ctx;
+
+	return true;
+}
+
+void nativeCancelEvent(nativeEventHandler handler, void *ctx)
+{
+	for (uint8_t i = 0; i < NATIVE_MAX_EVENTS; i++)
+		if (events[i].pending && events[i].handler == handler && events[i].ctx == ctx)
+			events[i].pending = false;
+}
+
+void nativeBoot(bool deepSleepWake)
+{
+	bootStartUs = nowUs;
+	resetReason = deepSleepWake ? ESP_RST_DEEPSLEEP : ESP_RST_POWERON;
+	timerWakeup = false;
+	gpioWakeup = false;
+}
+
+/* 32 bit counters since the current boot that wrap like on the target */
+unsigned long millis()
+{
+	return (uint32_t)(nativeBootUs() / 1000);
+}
+
+unsigned long micros()
+{
+	return (uint32_t)nativeBootUs();
+}
+
+void delay(uint32_t ms)
+{
+	yieldUs += (uint64_t)ms * 1000;
+	nativeAdvanceUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+	nativeAdvanceUs(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin < NATIVE_NUM_PINS)
+		pins[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+	return pin < NATIVE_NUM_PINS ? pins[pin] : LOW;
+}
+
+void nativeSetPin(uint8_t pin, uint8_t value)
+{
+	digitalWrite(pin, value);
+}
+
+esp_reset_reason_t esp_reset_reason()
+{
+	return resetReason;
+}
+
+int64_t esp_timer_get_time()
+{
+	return (int64_t)nativeBootUs();
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs)
+{
+	timerWakeupUs = timeUs;
+	timerWakeup = true;
+	return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup()
+{
+	gpioWakeup = true;
+	return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source)
+{
+	if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL)
+		timerWakeup = false;
+	if (source == ESP_SLEEP_WAKEUP_GPIO || source == ESP_SLEEP_WAKEUP_ALL)
+		gpioWakeup = false;
+	return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t type)
+{
+	(void)gpio;
+	(void)type;
+	return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio)
+{
+	(void)gpio;
+	return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type)
+{
+	(void)gpio;
+	(void)type;
+	return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start()
+{
+	uint64_t eventUs = 0;
+	uint64_t wakeUs = nowUs;
+	bool wake = false;
+
+	if (timerWakeup)
+	{
+		wakeUs = nowUs + timerWakeupUs;
+		wake = true;
+	}
+
+	/* Peripheral events are assumed to raise a wakeup GPIO */
+	if (gpioWakeup && nativeNextEvent(eventUs) && (!wake || eventUs < wakeUs))
+	{
+		wakeUs = eventUs > nowUs ? eventUs : nowUs;
+		wake = true;
+	}
+
+	/* Without a wakeup source the target would sleep forever */
+	if (!wake)
+		return ESP_FAIL;
+
+	lightSleepUs += wakeUs - nowUs;
+	nativeAdvanceUs(wakeUs - nowUs);
+	return ESP_OK;
+}
+
+void esp_deep_sleep_start()
+{
+	nativeDeepSleep sleep = {timerWakeup ? timerWakeupUs : 0};
+
+	throw sleep;
+}
@@ -0,0 +1,163 @@
+/*
+  Arduino core subset for the native build
+
+  Covers what the node firmware and the Bosch libraries use: time on the
+  virtual clock of native_time.h, digital pins kept in a table that fake
+  peripherals can drive, a String backed by std::string, a Print base for
+  byte sinks and a Serial that prints to stdout.
+
+  millis() and micros() restart from 0 on every emulated boot, as on the
+  target. Bsec2 takes its timestamps from nativeNowUs() instead, which stands
+  in for the RTC backed clock it uses on ESP32.
+*/
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "native_time.h"
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define NATIVE_NUM_PINS 64
+
+/* No RTC memory on a host, RTC_DATA_ATTR data survives emulated deep sleep like any global */
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+#define PROGMEM
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+/**
+ * @brief : Drives an input pin from a fake peripheral
+ * @param[in] pin   : Pin number
+ * @param[in] value : LOW or HIGH
+ */
+void nativeSetPin(uint8_t pin, uint8_t value);
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String
+{
+public:
+	String(const char *str = "") : text(str ? str : "") {}
+	String(const std::string &str) : text(str) {}
+	String(const __FlashStringHelper *str) : text(reinterpret_cast<const char *>(str)) {}
+	String(char c) : text(1, c) {}
+	String(int value) : text(std::to_string(value)) {}
+	String(unsigned int value) : text(std::to_string(value)) {}
+	String(long value) : text(std::to_string(value)) {}
+	String(unsigned long value) : text(std::to_string(value)) {}
+	String(long long value) : text(std::to_string(value)) {}
+	String(unsigned long long value) : text(std::to_string(value)) {}
+	String(float value, unsigned int decimals = 2) : text(format(value, decimals)) {}
+	String(double value, unsigned int decimals = 2) : text(format(value, decimals)) {}
+
+	const char *c_str() const { return text.c_str(); }
+	unsigned int length() const { return text.length(); }
+	String &operator+=(const String &rhs)
+	{
+		text += rhs.text;
+		return *this;
+	}
+	bool operator==(const String &rhs) const { return text == rhs.text; }
+	bool operator!=(const String &rhs) const { return text != rhs.text; }
+	friend String operator+(const String &lhs, const String &rhs) { return String(lhs.text + rhs.text); }
+
+private:
+	std::string text;
+
+	static std::string format(double value, unsigned int decimals)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+		return buffer;
+	}
+};
+
+/* Byte sink of the Arduino core, println ends lines with "\r\n" as on the target */
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size)
+	{
+		size_t n = 0;
+		while (size--)
+			n += write(*buffer++);
+		return n;
+	}
+
+	size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+	size_t print(const char *s) { return print(String(s)); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(int n) { return print(String(n)); }
+	size_t print(unsigned int n) { return print(String(n)); }
+	size_t print(long n) { return print(String(n)); }
+	size_t print(unsigned long n) { return print(String(n)); }
+	size_t print(double n, int decimals = 2) { return print(String(n, decimals)); }
+
+	template <typename T>
+	size_t println(const T &value)
+	{
+		size_t n = print(value);
+		return n + print("\r\n");
+	}
+	size_t println() { return print("\r\n"); }
+};
+
+class HardwareSerial
+{
+public:
+	void begin(unsigned long baud) { (void)baud; }
+	void flush() { fflush(stdout); }
+
+	size_t print(const String &s) { return fputs(s.c_str(), stdout) >= 0 ? s.length() : 0; }
+	size_t print(const char *s) { return print(String(s)); }
+	size_t print(const __FlashStringHelper *s) { return print(String(s)); }
+	size_t print(char c) { return print(String(c)); }
+	size_t print(int n) { return print(String(n)); }
+	size_t print(unsigned int n) { return print(String(n)); }
+	size_t print(long n) { return print(String(n)); }
+	size_t print(unsigned long n) { return print(String(n)); }
+	size_t print(double n, int decimals = 2) { return print(String(n, decimals)); }
+
+	template <typename T>
+	size_t println(const T &value)
+	{
+		size_t n = print(value);
+		return n + print("\n");
+	}
+	size_t println() { return print("\n"); }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* NATIVE_ARDUINO_H */
@@ -0,0 +1,45 @@
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() : commits(0), size(0)
+{
+	/* Erased flash */
+	memset(data, 0xFF, sizeof(data));
+}
+
+bool EEPROMClass::begin(size_t size)
+{
+	if (size > NATIVE_EEPROM_MAX_SIZE)
+		return false;
+
+	this->size = size;
+	return true;
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+	return (address >= 0 && (size_t)address < size) ? data[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+	if (address >= 0 && (size_t)address < size)
+		data[address] = value;
+}
+
+bool EEPROMClass::commit()
+{
+	commits++;
+	return size > 0;
+}
+
+void EEPROMClass::end()
+{
+	size = 0;
+}
+
+size_t EEPROMClass::length()
+{
+	return size;
+}
@@ -0,0 +1,34 @@
+/*
+  EEPROM emulation for the native build, kept in RAM for the whole run
+*/
+
+#ifndef NATIVE_EEPROM_H
+#define NATIVE_EEPROM_H
+
+#include "Arduino.h"
+
+#define NATIVE_EEPROM_MAX_SIZE 4096
+
+class EEPROMClass
+{
+public:
+	EEPROMClass();
+
+	bool begin(size_t size);
+	uint8_t read(int address);
+	void write(int address, uint8_t value);
+	bool commit();
+	void end();
+	size_t length();
+
+	/* Number of commits, each one costs a flash sector erase on the target */
+	uint32_t commits;
+
+private:
+	uint8_t data[NATIVE_EEPROM_MAX_SIZE];
+	size_t size;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif /* NATIVE_EEPROM_H */
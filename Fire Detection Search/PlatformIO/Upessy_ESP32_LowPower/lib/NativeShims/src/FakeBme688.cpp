@@ -0,0 +1,523 @@
+#include "FakeBme688.h"
+
+#define REG_COEFF3 0x00
+#define REG_FIELD0 0x1D
+#define REG_IDAC_HEAT0 0x50
+#define REG_RES_HEAT0 0x5A
+#define REG_GAS_WAIT0 0x64
+#define REG_CTRL_GAS_1 0x71
+#define REG_CTRL_HUM 0x72
+#define REG_CTRL_MEAS 0x74
+#define REG_UNIQUE_ID 0x83
+#define REG_COEFF1 0x8A
+#define REG_CHIP_ID 0xD0
+#define REG_SOFT_RESET 0xE0
+#define REG_COEFF2 0xE1
+#define REG_VARIANT_ID 0xF0
+
+#define LEN_COEFF1 23
+#define LEN_COEFF2 14
+#define LEN_FIELD 17
+#define NUM_FIELDS 3
+
+#define CHIP_ID 0x61
+#define VARIANT_GAS_HIGH 0x01
+#define SOFT_RESET_CMD 0xB6
+
+#define MODE_MSK 0x03
+#define MODE_SLEEP 0x00
+#define MODE_FORCED 0x01
+#define MODE_PARALLEL 0x02
+#define MODE_SEQUENTIAL 0x03
+
+#define NEW_DATA_MSK 0x80
+#define GASM_VALID_MSK 0x20
+#define HEAT_STAB_MSK 0x10
+#define NBCONV_MSK 0x0F
+#define RUN_GAS_MSK 0x30
+#define RUN_GAS_MSK 0x30
+
+/* Coefficients of a production BME688, in the order of the bme68x.c coefficient array */
+static const int32_t calibT1 = 26041, calibT2 = 26130, calibT3 = 3;
+static const int32_t calibP1 = 36401, calibP2 = -10520, calibP3 = 88, calibP4 = 6421, calibP5 = -124, calibP6 = 30,
+					 calibP7 = 41, calibP8 = -3424, calibP9 = -2070, calibP10 = 30;
+static const int32_t calibH1 = 762, calibH2 = 1012, calibH3 = 0, calibH4 = 45, calibH5 = 20, calibH6 = 120,
+					 calibH7 = -100;
+static const int32_t calibGh1 = -35, calibGh2 = -12325, calibGh3 = 18;
+static const int32_t calibResHeatVal = 44, calibResHeatRange = 1, calibRangeSwErr = 0;
+
+/* Clean air at sea level */
+static const fakeBme688Sample cleanAir = {
+	25.0f, 101325.0f, 40.0f, {150000.0f, 150000.0f, 150000.0f, 150000.0f, 150000.0f, 150000.0f, 150000.0f, 150000.0f, 150000.0f, 150000.0f}};
+
+FakeBme688::FakeBme688()
+	: measurements(0), regWrites(0), regReads(0), pointer(0), measIndex(0), gasIndex(0), fieldSlot(0),
+	  forcedTiming(false), defaultSample(cleanAir), generator(nullptr), generatorCtx(nullptr)
+{
+	memset(forced, 0, sizeof(forced));
+	memset(forcedValue, 0, sizeof(forcedValue));
+
+	parT1 = calibT1;
+	parT2 = calibT2;
+	parT3 = calibT3;
+	parP1 = calibP1;
+	parP2 = calibP2;
+	parP3 = calibP3;
+	parP4 = calibP4;
+	parP5 = calibP5;
+	parP6 = calibP6;
+	parP7 = calibP7;
+	parP8 = calibP8;
+	parP9 = calibP9;
+	parP10 = calibP10;
+	parH1 = calibH1;
+	parH2 = calibH2;
+	parH3 = calibH3;
+	parH4 = calibH4;
+	parH5 = calibH5;
+	parH6 = calibH6;
+	parH7 = calibH7;
+
+	reset();
+}
+
+void FakeBme688::reset()
+{
+	uint8_t coeff[LEN_COEFF1 + LEN_COEFF2 + 5] = {0};
+
+	setMode(MODE_SLEEP);
+	memset(regs, 0, sizeof(regs));
+
+	coeff[0] = calibT2 & 0xFF;
+	coeff[1] = (calibT2 >> 8) & 0xFF;
+	coeff[2] = calibT3 & 0xFF;
+	coeff[4] = calibP1 & 0xFF;
+	coeff[5] = (calibP1 >> 8) & 0xFF;
+	coeff[6] = calibP2 & 0xFF;
+	coeff[7] = (calibP2 >> 8) & 0xFF;
+	coeff[8] = calibP3 & 0xFF;
+	coeff[10] = calibP4 & 0xFF;
+	coeff[11] = (calibP4 >> 8) & 0xFF;
+	coeff[12] = calibP5 & 0xFF;
+	coeff[13] = (calibP5 >> 8) & 0xFF;
+	coeff[14] = calibP7 & 0xFF;
+	coeff[15] = calibP6 & 0xFF;
+	coeff[18] = calibP8 & 0xFF;
+	coeff[19] = (calibP8 >> 8) & 0xFF;
+	coeff[20] = calibP9 & 0xFF;
+	coeff[21] = (calibP9 >> 8) & 0xFF;
+	coeff[22] = calibP10 & 0xFF;
+	coeff[23] = (calibH2 >> 4) & 0xFF;
+	coeff[24] = ((calibH2 & 0x0F) << 4) | (calibH1 & 0x0F);
+	coeff[25] = (calibH1 >> 4) & 0xFF;
+	coeff[26] = calibH3 & 0xFF;
+	coeff[27] = calibH4 & 0xFF;
+	coeff[28] = calibH5 & 0xFF;
+	coeff[29] = calibH6 & 0xFF;
+	coeff[30] = calibH7 & 0xFF;
+	coeff[31] = calibT1 & 0xFF;
+	coeff[32] = (calibT1 >> 8) & 0xFF;
+	coeff[33] = calibGh2 & 0xFF;
+	coeff[34] = (calibGh2 >> 8) & 0xFF;
+	coeff[35] = calibGh1 & 0xFF;
+	coeff[36] = calibGh3 & 0xFF;
+	coeff[37] = calibResHeatVal & 0xFF;
+	coeff[39] = (calibResHeatRange << 4) & 0x30;
+	coeff[41] = (calibRangeSwErr << 4) & 0xF0;
+
+	memcpy(&regs[REG_COEFF1], coeff, LEN_COEFF1);
+	memcpy(&regs[REG_COEFF2], &coeff[LEN_COEFF1], LEN_COEFF2);
+	memcpy(&regs[REG_COEFF3], &coeff[LEN_COEFF1 + LEN_COEFF2], 5);
+
+	regs[REG_CHIP_ID] = CHIP_ID;
+	regs[REG_VARIANT_ID] = VARIANT_GAS_HIGH;
+	regs[REG_UNIQUE_ID] = 0x4E;
+	regs[REG_UNIQUE_ID + 1] = 0x41;
+	regs[REG_UNIQUE_ID + 2] = 0x54;
+	regs[REG_UNIQUE_ID + 3] = 0x49;
+
+	measIndex = 0;
+	gasIndex = 0;
+	fieldSlot = 0;
+}
+
+size_t FakeBme688::loadScript(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[256];
+	size_t loaded = 0;
+
+	if (file == nullptr)
+		return 0;
+
+	while (fgets(line, sizeof(line), file))
+	{
+		timedSample entry;
+		char *cursor = line;
+		char *end;
+		uint8_t nGas = 0;
+
+		while (*cursor == ' ' || *cursor == '\t')
+			cursor++;
+		if (*cursor == '#' || *cursor == '\n' || *cursor == '\0')
+			continue;
+
+		entry.startMs = strtoull(cursor, &end, 10);
+		entry.sample.temperature = strtof(end, &end);
+		entry.sample.pressure = strtof(end, &end);
+		entry.sample.humidity = strtof(end, &end);
+		while (nGas < FAKE_BME688_MAX_STEPS)
+		{
+			cursor = end;
+			float gas = strtof(cursor, &end);
+			if (end == cursor)
+				break;
+			entry.sample.gasResistance[nGas++] = gas;
+		}
+
+		if (nGas == 0)
+			continue;
+		for (uint8_t i = nGas; i < FAKE_BME688_MAX_STEPS; i++)
+			entry.sample.gasResistance[i] = entry.sample.gasResistance[nGas - 1];
+
+		addSample(entry.startMs, entry.sample);
+		loaded++;
+	}
+
+	fclose(file);
+	return loaded;
+}
+
+void FakeBme688::addSample(uint64_t startMs, const fakeBme688Sample &sample)
+{
+	timedSample entry = {startMs, sample};
+	size_t i = timeline.size();
+
+	/* Keep the timeline sorted */
+	timeline.push_back(entry);
+	while (i > 0 && timeline[i - 1].startMs > startMs)
+	{
+		timeline[i] = timeline[i - 1];
+		i--;
+	}
+	timeline[i] = entry;
+}
+
+void FakeBme688::setDefaultSample(const fakeBme688Sample &sample)
+{
+	defaultSample = sample;
+}
+
+void FakeBme688::setGenerator(fakeBme688Generator generator, void *ctx)
+{
+	this->generator = generator;
+	generatorCtx = ctx;
+}
+
+void FakeBme688::forceRegister(uint8_t reg, uint8_t value)
+{
+	forced[reg] = true;
+	forcedValue[reg] = value;
+}
+
+void FakeBme688::setForcedTiming(bool enable)
+{
+	forcedTiming = enable;
+}
+
+void FakeBme688::receive(const uint8_t *data, size_t length)
+{
+	pointer = data[0];
+
+	/* Register writes are address and data pairs */
+	for (size_t i = 0; i + 1 < length; i += 2)
+	{
+		regWrites++;
+		writeReg(data[i], data[i + 1]);
+	}
+}
+
+void FakeBme688::transmit(uint8_t *data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		uint8_t reg = pointer++;
+
+		regReads++;
+		data[i] = forced[reg] ? forcedValue[reg] : regs[reg];
+
+		/* The new data flag of a field is cleared once read */
+		if (reg >= REG_FIELD0 && reg < REG_FIELD0 + NUM_FIELDS * LEN_FIELD && (reg - REG_FIELD0) % LEN_FIELD == 0)
+			regs[reg] &= ~NEW_DATA_MSK;
+	}
+}
+
+void FakeBme688::writeReg(uint8_t reg, uint8_t value)
+{
+	switch (reg)
+	{
+	case REG_SOFT_RESET:
+		if (value == SOFT_RESET_CMD)
+			reset();
+		break;
+	case REG_CTRL_MEAS:
+		regs[reg] = value;
+		setMode(value & MODE_MSK);
+		break;
+	case REG_CHIP_ID:
+	case REG_VARIANT_ID:
+		break;
+	default:
+		/* Calibration and field data are read only */
+		if ((reg >= REG_COEFF1 && reg < REG_COEFF1 + LEN_COEFF1) || (reg >= REG_COEFF2 && reg < REG_COEFF2 + LEN_COEFF2) ||
+			(reg >= REG_FIELD0 && reg < REG_FIELD0 + NUM_FIELDS * LEN_FIELD))
+			break;
+		regs[reg] = value;
+		break;
+	}
+}
+
+void FakeBme688::setMode(uint8_t mode)
+{
+	/* Leaving a mode cancels its pending step or measurement */
+	nativeCancelEvent(onStep, this);
+	nativeCancelEvent(onForced, this);
+
+	switch (mode)
+	{
+	case MODE_FORCED:
+		if (forcedTiming)
+		{
+			nativeScheduleEvent(nativeNowUs() + measDurationUs(regs[REG_CTRL_GAS_1] & NBCONV_MSK), onForced, this);
+			break;
+		}
+		measure(0, regs[REG_CTRL_GAS_1] & NBCONV_MSK);
+		regs[REG_CTRL_MEAS] &= ~MODE_MSK;
+		break;
+	case MODE_PARALLEL:
+	case MODE_SEQUENTIAL:
+		gasIndex = 0;
+		scheduleStep();
+		break;
+	default:
+		break;
+	}
+}
+
+uint32_t FakeBme688::stepDurationUs(uint8_t gasIdx)
+{
+	uint8_t gasWait = regs[REG_GAS_WAIT0 + gasIdx];
+
+	if ((regs[REG_CTRL_MEAS] & MODE_MSK) == MODE_PARALLEL)
+		return (gasWait ? gasWait : 1) * FAKE_BME688_PARALLEL_BASE_MS * 1000;
+
+	/* A sequential step is a forced mode measurement on its heater step */
+	return measDurationUs(gasIdx);
+}
+
+uint32_t FakeBme688::measDurationUs(uint8_t gasIdx)
+{
+	static const uint8_t osToMeasCycles[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+	uint32_t cycles = osToMeasCycles[regs[REG_CTRL_MEAS] >> 5] + osToMeasCycles[(regs[REG_CTRL_MEAS] >> 2) & 0x07] +
+					  osToMeasCycles[regs[REG_CTRL_HUM] & 0x07];
+
+	/* TPH conversions, switching, gas measurement and wake up, as bme68x_get_meas_dur counts them */
+	uint32_t durationUs = cycles * 1963 + 477 * 4 + 477 * 5 + 1000;
+
+	/* Heater wait of the step, 6 bit duration with a multiplication factor of 1, 4, 16 or 64 */
+	if (regs[REG_CTRL_GAS_1] & RUN_GAS_MSK)
+	{
+		uint8_t gasWait = regs[REG_GAS_WAIT0 + gasIdx];
+		durationUs += (gasWait & 0x3F) * (1UL << (2 * (gasWait >> 6))) * 1000;
+	}
+
+	return durationUs;
+}
+
+void FakeBme688::onForced(void *ctx)
+{
+	FakeBme688 *fake = (FakeBme688 *)ctx;
+
+	fake->measure(0, fake->regs[REG_CTRL_GAS_1] & NBCONV_MSK);
+	fake->regs[REG_CTRL_MEAS] &= ~MODE_MSK;
+}
+
+void FakeBme688::scheduleStep()
+{
+	nativeScheduleEvent(nativeNowUs() + stepDurationUs(gasIndex), onStep, this);
+}
+
+void FakeBme688::onStep(void *ctx)
+{
+	FakeBme688 *fake = (FakeBme688 *)ctx;
+	uint8_t nbConv = fake->regs[REG_CTRL_GAS_1] & NBCONV_MSK;
+	uint8_t mode = fake->regs[REG_CTRL_MEAS] & MODE_MSK;
+
+	if (mode != MODE_PARALLEL && mode != MODE_SEQUENTIAL)
+		return;
+
+	fake->measure(fake->fieldSlot, fake->gasIndex);
+	fake->fieldSlot = (fake->fieldSlot + 1) % NUM_FIELDS;
+	fake->gasIndex = nbConv ? (fake->gasIndex + 1) % nbConv : 0;
+	fake->scheduleStep();
+}
+
+fakeBme688Sample FakeBme688::currentSample(uint8_t gasIdx)
+{
+	uint64_t timeMs = nativeNowUs() / 1000;
+	fakeBme688Sample sample = defaultSample;
+
+	if (generator && generator(timeMs, gasIdx, sample, generatorCtx))
+		return sample;
+
+	for (size_t i = 0; i < timeline.size() && timeline[i].startMs <= timeMs; i++)
+		sample = timeline[i].sample;
+
+	return sample;
+}
+
+void FakeBme688::measure(uint8_t slot, uint8_t gasIdx)
+{
+	uint8_t *field = &regs[REG_FIELD0 + slot * LEN_FIELD];
+	fakeBme688Sample sample = currentSample(gasIdx % FAKE_BME688_MAX_STEPS);
+	float tFine;
+	uint32_t tempAdc = encodeTemperature(sample.temperature, tFine);
+	uint32_t presAdc = encodePressure(sample.pressure, tFine);
+	uint16_t humAdc = encodeHumidity(sample.humidity, tFine);
+	uint16_t gasAdc = 0;
+	uint8_t gasRange = 0;
+	bool runGas = (regs[REG_CTRL_GAS_1] & RUN_GAS_MSK) != 0;
+
+	encodeGas(sample.gasResistance[gasIdx % FAKE_BME688_MAX_STEPS], gasAdc, gasRange);
+
+	memset(field, 0, LEN_FIELD);
+	field[0] = NEW_DATA_MSK | (gasIdx & 0x0F);
+	field[1] = measIndex++;
+	field[2] = (presAdc >> 12) & 0xFF;
+	field[3] = (presAdc >> 4) & 0xFF;
+	field[4] = (presAdc & 0x0F) << 4;
+	field[5] = (tempAdc >> 12) & 0xFF;
+	field[6] = (tempAdc >> 4) & 0xFF;
+	field[7] = (tempAdc & 0x0F) << 4;
+	field[8] = humAdc >> 8;
+	field[9] = humAdc & 0xFF;
+	field[15] = gasAdc >> 2;
+	field[16] = ((gasAdc & 0x03) << 6) | gasRange;
+	if (runGas)
+		field[16] |= GASM_VALID_MSK | HEAT_STAB_MSK;
+
+	measurements++;
+}
+
+/* Float compensation of bme68x.c, used to search the ADC codes of a physical value */
+float FakeBme688::compensateTemperature(uint32_t adc, float &tFine)
+{
+	float var1 = ((((float)adc / 16384.0f) - (parT1 / 1024.0f)) * parT2);
+	float var2 = ((((float)adc / 131072.0f) - (parT1 / 8192.0f)) * (((float)adc / 131072.0f) - (parT1 / 8192.0f))) *
+				 (parT3 * 16.0f);
+
+	tFine = var1 + var2;
+	return tFine / 5120.0f;
+}
+
+float FakeBme688::compensatePressure(uint32_t adc, float tFine)
+{
+	float var1 = (tFine / 2.0f) - 64000.0f;
+	float var2 = var1 * var1 * (parP6 / 131072.0f);
+	float var3;
+	float pressure;
+
+	var2 = var2 + (var1 * parP5 * 2.0f);
+	var2 = (var2 / 4.0f) + (parP4 * 65536.0f);
+	var1 = (((parP3 * var1 * var1) / 16384.0f) + (parP2 * var1)) / 524288.0f;
+	var1 = (1.0f + (var1 / 32768.0f)) * parP1;
+	pressure = 1048576.0f - (float)adc;
+	pressure = ((pressure - (var2 / 4096.0f)) * 6250.0f) / var1;
+	var1 = (parP9 * pressure * pressure) / 2147483648.0f;
+	var2 = pressure * (parP8 / 32768.0f);
+	var3 = (pressure / 256.0f) * (pressure / 256.0f) * (pressure / 256.0f) * (parP10 / 131072.0f);
+
+	return pressure + (var1 + var2 + var3 + (parP7 * 128.0f)) / 16.0f;
+}
+
+float FakeBme688::compensateHumidity(uint32_t adc, float tFine)
+{
+	float tempComp = tFine / 5120.0f;
+	float var1 = (float)adc - ((parH1 * 16.0f) + ((parH3 / 2.0f) * tempComp));
+	float var2 = var1 * ((parH2 / 262144.0f) * (1.0f + ((parH4 / 16384.0f) * tempComp) +
+												 ((parH5 / 1048576.0f) * tempComp * tempComp)));
+	float var3 = parH6 / 16384.0f;
+	float var4 = parH7 / 2097152.0f;
+
+	return var2 + ((var3 + (var4 * tempComp)) * var2 * var2);
+}
+
+uint32_t FakeBme688::encodeTemperature(float temperature, float &tFine)
+{
+	uint32_t low = 0, high = (1UL << 20) - 1;
+
+	/* Temperature grows with the ADC code */
+	while (low < high)
+	{
+		uint32_t mid = (low + high) / 2;
+		if (compensateTemperature(mid, tFine) < temperature)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	compensateTemperature(low, tFine);
+	return low;
+}
+
+uint32_t FakeBme688::encodePressure(float pressure, float tFine)
+{
+	uint32_t low = 0, high = (1UL << 20) - 1;
+
+	/* Pressure falls as the ADC code grows */
+	while (low < high)
+	{
+		uint32_t mid = (low + high) / 2;
+		if (compensatePressure(mid, tFine) > pressure)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+uint16_t FakeBme688::encodeHumidity(float humidity, float tFine)
+{
+	uint32_t low = 0, high = 0xFFFF;
+
+	while (low < high)
+	{
+		uint32_t mid = (low + high) / 2;
+		if (compensateHumidity(mid, tFine) < humidity)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return (uint16_t)low;
+}
+
+void FakeBme688::encodeGas(float resistance, uint16_t &adc, uint8_t &range)
+{
+	/* Inverse of calc_gas_resistance_high(), picking the range that keeps the 10 bit code in bounds */
+	for (range = 0; range < 16; range++)
+	{
+		float var2 = 1000000.0f * (float)(262144UL >> range) / (resistance > 1.0f ? resistance : 1.0f);
+		float code = (var2 - 4096.0f) / 3.0f + 512.0f;
+
+		if (code <= 1023.0f)
+		{
+			adc = code < 0.0f ? 0 : (uint16_t)lroundf(code);
+			return;
+		}
+	}
+
+	range = 15;
+	adc = 1023;
+}
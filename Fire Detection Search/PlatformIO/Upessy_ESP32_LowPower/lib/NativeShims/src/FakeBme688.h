@@ -0,0 +1,145 @@
+/*
+  Register level model of a BME688 on the native I2C bus
+
+  The fake holds the 256 byte register map of the real part: chip and
+  variant IDs, a fixed set of calibration coefficients and the field data
+  registers. Physical values taken from a script are encoded to raw ADC
+  codes with the inverse of the Bosch compensation formulas, so bme68x.c
+  decodes them as it would decode a real sensor.
+
+  Forced mode fills field 0 as soon as the measurement is triggered and
+  goes back to sleep, or with setForcedTiming() once the TPH and heater
+  durations have passed on the virtual clock. Parallel and sequential modes produce one field per
+  heater step on the virtual clock, rotating over the 3 field slots, with
+  the gas index running over the nb_conv steps set in CTRL_GAS_1. A
+  sequential step takes the TPH duration and its heater duration, the ODR
+  sleep between profiles is not modelled.
+
+  Samples come, by order of precedence, from a generator callback, from a
+  timeline loaded with loadScript() or from the default sample.
+*/
+
+#ifndef FAKE_BME688_H
+#define FAKE_BME688_H
+
+#include <vector>
+
+#include "Wire.h"
+
+#define FAKE_BME688_MAX_STEPS 10
+
+/* Step period of the parallel mode for a gas_wait multiplier of 1, BSEC_TOTAL_HEAT_DUR in bsec2.h */
+#define FAKE_BME688_PARALLEL_BASE_MS 140
+
+typedef struct
+{
+	float temperature;							  /* degC */
+	float pressure;								  /* Pa */
+	float humidity;								  /* %RH */
+	float gasResistance[FAKE_BME688_MAX_STEPS]; /* Ohm, per heater step */
+} fakeBme688Sample;
+
+/**
+ * @brief : Provides the sample of a measurement
+ * @param[in] timeMs    : Virtual time of the measurement since the start of the run
+ * @param[in] gasIndex  : Heater step of the measurement
+ * @param[out] sample   : Sample to return
+ * @param[in] ctx       : Context given to setGenerator()
+ * @return false to fall back to the script
+ */
+typedef bool (*fakeBme688Generator)(uint64_t timeMs, uint8_t gasIndex, fakeBme688Sample &sample, void *ctx);
+
+class FakeBme688 : public NativeI2cDevice
+{
+public:
+	FakeBme688();
+
+	/**
+	 * @brief : Loads a timeline of samples. Each line holds the start time in ms, the temperature,
+	 *          the pressure, the humidity and 1 to 10 gas resistances, one per heater step.
+	 *          A single resistance applies to every step, lines starting with '#' are skipped.
+	 * @param[in] path : Text file to load
+	 * @return Number of samples loaded, 0 if the file cannot be read
+	 */
+	size_t loadScript(const char *path);
+
+	/**
+	 * @brief : Appends a sample to the timeline
+	 * @param[in] startMs : Virtual time from which the sample applies
+	 * @param[in] sample  : Sample values
+	 */
+	void addSample(uint64_t startMs, const fakeBme688Sample &sample);
+
+	void setDefaultSample(const fakeBme688Sample &sample);
+	void setGenerator(fakeBme688Generator generator, void *ctx);
+
+	/**
+	 * @brief : Makes the fake return a fixed value for a register, to inject faults
+	 * @param[in] reg   : Register address
+	 * @param[in] value : Value read back
+	 */
+	void forceRegister(uint8_t reg, uint8_t value);
+
+	/**
+	 * @brief : Makes a forced mode measurement take its TPH and heater durations
+	 * @param[in] enable : Delay the data of forced mode, off by default
+	 */
+	void setForcedTiming(bool enable);
+
+	void receive(const uint8_t *data, size_t length);
+	void transmit(uint8_t *data, size_t length);
+
+	/* Number of measurements and register accesses, for the benchmarks */
+	uint32_t measurements;
+	uint32_t regWrites;
+	uint32_t regReads;
+
+private:
+	typedef struct
+	{
+		uint64_t startMs;
+		fakeBme688Sample sample;
+	} timedSample;
+
+	uint8_t regs[256];
+	uint8_t pointer;
+	bool forced[256];
+	uint8_t forcedValue[256];
+
+	uint8_t measIndex;
+	uint8_t gasIndex;
+	uint8_t fieldSlot;
+	bool forcedTiming;
+
+	std::vector<timedSample> timeline;
+	fakeBme688Sample defaultSample;
+	fakeBme688Generator generator;
+	void *generatorCtx;
+
+	/* Calibration, as decoded by bme68x.c */
+	float parT1, parT2, parT3;
+	float parP1, parP2, parP3, parP4, parP5, parP6, parP7, parP8, parP9, parP10;
+	float parH1, parH2, parH3, parH4, parH5, parH6, parH7;
+
+	void reset();
+	void writeReg(uint8_t reg, uint8_t value);
+	void setMode(uint8_t mode);
+	void measure(uint8_t slot, uint8_t gasIdx);
+	void scheduleStep();
+	uint32_t stepDurationUs(uint8_t gasIdx);
+	uint32_t measDurationUs(uint8_t gasIdx);
+	fakeBme688Sample currentSample(uint8_t gasIdx);
+
+	float compensateTemperature(uint32_t adc, float &tFine);
+	float compensatePressure(uint32_t adc, float tFine);
+	float compensateHumidity(uint32_t adc, float tFine);
+	uint32_t encodeTemperature(float temperature, float &tFine);
+	uint32_t encodePressure(float pressure, float tFine);
+	uint16_t encodeHumidity(float humidity, float tFine);
+	void encodeGas(float resistance, uint16_t &adc, uint8_t &range);
+
+	static void onStep(void *ctx);
+	static void onForced(void *ctx);
+};
+
+#endif /* FAKE_BME688_H */
@@ -0,0 +1,290 @@
+#include "freertos/FreeRTOS.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct nativeTask
+{
+	TaskFunction_t code;
+	void *arg;
+	/* Notification value */
+	std::mutex lock;
+	std::condition_variable changed;
+	uint32_t notifications;
+};
+
+struct nativeQueue
+{
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque<std::vector<uint8_t>> items;
+	UBaseType_t length;
+	UBaseType_t itemSize;
+};
+
+struct nativeSemaphore
+{
+	std::mutex lock;
+	std::condition_variable changed;
+	UBaseType_t count;
+	UBaseType_t maxCount;
+	/* Recursive mutexes only */
+	std::thread::id owner;
+};
+
+static thread_local nativeTask *currentTask = nullptr;
+static nativeTask mainTask;
+
+static std::atomic<uint32_t> semaphoreTakes(0), semaphoreWaits(0);
+static std::atomic<uint32_t> recursiveTakes(0), recursiveWaits(0);
+
+/**
+ * @brief : Waits on a condition for the given number of ticks, portMAX_DELAY waits forever
+ */
+template <typename Predicate>
+static bool waitFor(std::condition_variable &changed, std::unique_lock<std::mutex> &guard, TickType_t ticks,
+					Predicate ready)
+{
+	if (ticks == portMAX_DELAY)
+	{
+		changed.wait(guard, ready);
+		return true;
+	}
+
+	return changed.wait_for(guard, std::chrono::milliseconds(ticks), ready);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth, void *arg,
+								   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+	(void)name;
+	(void)stackDepth;
+	(void)priority;
+	(void)core;
+
+	nativeTask *task = new nativeTask;
+
+	task->code = code;
+	task->arg = arg;
+	task->notifications = 0;
+	std::thread([task]() {
+		currentTask = task;
+		task->code(task->arg);
+	}).detach();
+
+	if (handle)
+		*handle = task;
+
+	return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth, void *arg,
+										   UBaseType_t priority, StackType_t *stack, StaticTask_t *taskMem,
+										   BaseType_t core)
+{
+	TaskHandle_t handle = nullptr;
+
+	(void)stack;
+	(void)taskMem;
+	xTaskCreatePinnedToCore(code, name, stackDepth, arg, priority, &handle, core);
+
+	return handle;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+	return currentTask ? currentTask : &mainTask;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+	std::lock_guard<std::mutex> guard(task->lock);
+
+	task->notifications++;
+	task->changed.notify_all();
+
+	return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+	nativeTask *task = (nativeTask *)xTaskGetCurrentTaskHandle();
+	std::unique_lock<std::mutex> guard(task->lock);
+	uint32_t value;
+
+	if (!waitFor(task->changed, guard, ticks, [task]() { return task->notifications > 0; }))
+		return 0;
+
+	value = task->notifications;
+	task->notifications = clearOnExit ? 0 : value - 1;
+
+	return value;
+}
+
+void nativeEnterCritical(portMUX_TYPE *mux)
+{
+	while (mux->locked.test_and_set(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+void nativeExitCritical(portMUX_TYPE *mux)
+{
+	mux->locked.clear(std::memory_order_release);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+	nativeQueue *queue = new nativeQueue;
+
+	queue->length = length;
+	queue->itemSize = itemSize;
+
+	return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+	std::unique_lock<std::mutex> guard(queue->lock);
+
+	if (!waitFor(queue->changed, guard, ticks, [queue]() { return queue->items.size() < queue->length; }))
+		return pdFAIL;
+
+	const uint8_t *bytes = (const uint8_t *)item;
+	queue->items.emplace_back(bytes, bytes + queue->itemSize);
+	queue->changed.notify_all();
+
+	return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+	std::unique_lock<std::mutex> guard(queue->lock);
+
+	if (!waitFor(queue->changed, guard, ticks, [queue]() { return !queue->items.empty(); }))
+		return pdFALSE;
+
+	memcpy(item, queue->items.front().data(), queue->itemSize);
+	queue->items.pop_front();
+	queue->changed.notify_all();
+
+	return pdTRUE;
+}
+
+static SemaphoreHandle_t createSemaphore(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+	nativeSemaphore *semaphore = new nativeSemaphore;
+
+	semaphore->count = initialCount;
+	semaphore->maxCount = maxCount;
+
+	return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+	return createSemaphore(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+	return createSemaphore(maxCount, initialCount);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+	return createSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+	/* The count is the depth of the owner */
+	return createSemaphore(UINT32_MAX, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *semaphoreMem)
+{
+	(void)semaphoreMem;
+
+	return xSemaphoreCreateMutex();
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *semaphoreMem)
+{
+	(void)semaphoreMem;
+
+	return xSemaphoreCreateRecursiveMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+	std::unique_lock<std::mutex> guard(semaphore->lock);
+
+	semaphoreTakes++;
+	if (semaphore->count == 0)
+		semaphoreWaits++;
+	if (!waitFor(semaphore->changed, guard, ticks, [semaphore]() { return semaphore->count > 0; }))
+		return pdFALSE;
+	semaphore->count--;
+
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+	std::lock_guard<std::mutex> guard(semaphore->lock);
+
+	if (semaphore->count >= semaphore->maxCount)
+		return pdFALSE;
+	semaphore->count++;
+	semaphore->changed.notify_all();
+
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks)
+{
+	std::unique_lock<std::mutex> guard(mutex->lock);
+	std::thread::id self = std::this_thread::get_id();
+
+	recursiveTakes++;
+	if (mutex->count != 0 && mutex->owner != self)
+		recursiveWaits++;
+	if (!waitFor(mutex->changed, guard, ticks, [mutex, self]() { return mutex->count == 0 || mutex->owner == self; }))
+		return pdFALSE;
+	mutex->owner = self;
+	mutex->count++;
+
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex)
+{
+	std::lock_guard<std::mutex> guard(mutex->lock);
+
+	if (mutex->count == 0 || mutex->owner != std::this_thread::get_id())
+		return pdFALSE;
+	if (--mutex->count == 0)
+	{
+		mutex->owner = std::thread::id();
+		mutex->changed.notify_all();
+	}
+
+	return pdTRUE;
+}
+
+nativeSemaphoreStats nativeGetSemaphoreStats()
+{
+	nativeSemaphoreStats stats = {semaphoreTakes, semaphoreWaits, recursiveTakes, recursiveWaits};
+
+	return stats;
+}
@@ -0,0 +1,68 @@
+/*
+  Background bus with the timing of a real I2C bus
+
+  Runs the transfers of a Bme68xAsync queue on a transport of
+  bme68xTransport.h, typically Bme68xI2cTransport on the native Wire. The
+  data moves when the transfer starts, but the completion is an event on the
+  virtual clock, one transfer time later: the caller may go on with other
+  work, and a read that has to wait moves the clock to the end of the
+  transfer, as a blocking bus access would on the target.
+
+  The transfer time counts 9 clock cycles per byte, with the address byte
+  and the register address, plus the repeated address of a read.
+*/
+
+#ifndef NATIVE_LATENCY_BUS_H
+#define NATIVE_LATENCY_BUS_H
+
+#include "bme68xAsync.h"
+#include "native_time.h"
+
+template <typename Transport>
+class NativeLatencyBus : public Bme68xAsyncBus
+{
+public:
+	NativeLatencyBus(const Transport &transport, uint32_t clockHz = 100000)
+		: busyUs(0), bus(transport), clockHz(clockHz), owner(nullptr), rslt(0)
+	{
+	}
+
+	void start(bme68xAsyncXfer &xfer, Bme68xAsync &owner)
+	{
+		uint32_t bytes = xfer.length + (xfer.read ? 3 : 2);
+		uint64_t durationUs = ((uint64_t)bytes * 9 * 1000000 + clockHz - 1) / clockHz;
+
+		this->owner = &owner;
+		rslt = xfer.read ? bus.read(xfer.regAddr, xfer.rxData, xfer.length)
+						 : bus.write(xfer.regAddr, xfer.txData, xfer.length);
+		busyUs += durationUs;
+		nativeScheduleEvent(nativeNowUs() + durationUs, done, this);
+	}
+
+	void wait(void)
+	{
+		uint64_t atUs;
+
+		/* Nothing else runs on the host, move the clock to the next event */
+		if (nativeNextEvent(atUs))
+			nativeAdvanceUs(atUs > nativeNowUs() ? atUs - nativeNowUs() : 0);
+	}
+
+	/* Time the bus spent transferring, in microseconds */
+	uint64_t busyUs;
+
+private:
+	Transport bus;
+	uint32_t clockHz;
+	Bme68xAsync *owner;
+	int8_t rslt;
+
+	static void done(void *ctx)
+	{
+		NativeLatencyBus *self = (NativeLatencyBus *)ctx;
+
+		self->owner->complete(self->rslt);
+	}
+};
+
+#endif /* NATIVE_LATENCY_BUS_H */
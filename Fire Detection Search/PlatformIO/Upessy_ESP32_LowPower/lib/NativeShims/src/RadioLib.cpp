@@ -0,0 +1,203 @@
+#include "RadioLib.h"
+
+static nativeRadioTxHook txHook = nullptr;
+static void *txHookCtx = nullptr;
+
+void nativeRadioSetTxHook(nativeRadioTxHook hook, void *ctx)
+{
+	txHook = hook;
+	txHookCtx = ctx;
+}
+
+SX1262::SX1262(Module *mod)
+	: packetsSent(0), airtimeUs(0), mod(mod), frequency(434.0), bandwidth(125.0), spreadingFactor(9), codingRate(7),
+	  syncWord(RADIOLIB_SX126X_SYNC_WORD_PRIVATE), outputPower(10), preambleLength(8), packetSentAction(nullptr),
+	  transmitting(false), txLength(0)
+{
+}
+
+int16_t SX1262::begin(float freq, float bw, uint8_t sf, uint8_t cr, uint8_t syncWord, int8_t power,
+					  uint16_t preambleLength, float tcxoVoltage, bool useRegulatorLDO)
+{
+	int16_t state;
+
+	(void)tcxoVoltage;
+	(void)useRegulatorLDO;
+	transmitting = false;
+	digitalWrite(mod->irq, LOW);
+
+	state = setFrequency(freq);
+	if (state == RADIOLIB_ERR_NONE)
+		state = setBandwidth(bw);
+	if (state == RADIOLIB_ERR_NONE)
+		state = setSpreadingFactor(sf);
+	if (state == RADIOLIB_ERR_NONE)
+		state = setCodingRate(cr);
+	if (state == RADIOLIB_ERR_NONE)
+		state = setSyncWord(syncWord);
+	if (state == RADIOLIB_ERR_NONE)
+		state = setOutputPower(power);
+	if (state == RADIOLIB_ERR_NONE)
+		state = setPreambleLength(preambleLength);
+
+	return state;
+}
+
+int16_t SX1262::setFrequency(float freq)
+{
+	if (freq < 150.0 || freq > 960.0)
+		return RADIOLIB_ERR_INVALID_FREQUENCY;
+
+	frequency = freq;
+	return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::setBandwidth(float bw)
+{
+	static const float bandwidths[] = {7.8, 10.4, 15.6, 20.8, 31.25, 41.7, 62.5, 125.0, 250.0, 500.0};
+
+	for (size_t i = 0; i < sizeof(bandwidths) / sizeof(bandwidths[0]); i++)
+	{
+		if (fabsf(bw - bandwidths[i]) <= 0.001f)
+		{
+			bandwidth = bandwidths[i];
+			return RADIOLIB_ERR_NONE;
+		}
+	}
+
+	return RADIOLIB_ERR_INVALID_BANDWIDTH;
+}
+
+int16_t SX1262::setSpreadingFactor(uint8_t sf)
+{
+	if (sf < 5 || sf > 12)
+		return RADIOLIB_ERR_INVALID_SPREADING_FACTOR;
+
+	spreadingFactor = sf;
+	return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::setCodingRate(uint8_t cr)
+{
+	if (cr < 5 || cr > 8)
+		return RADIOLIB_ERR_INVALID_CODING_RATE;
+
+	codingRate = cr;
+	return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::setSyncWord(uint8_t syncWord)
+{
+	this->syncWord = syncWord;
+	return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::setOutputPower(int8_t power)
+{
+	if (power < -9 || power > 22)
+		return RADIOLIB_ERR_INVALID_OUTPUT_POWER;
+
+	outputPower = power;
+	return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::setPreambleLength(uint16_t preambleLength)
+{
+	this->preambleLength = preambleLength;
+	return RADIOLIB_ERR_NONE;
+}
+
+void SX1262::setPacketSentAction(void (*func)(void))
+{
+	packetSentAction = func;
+}
+
+void SX1262::clearPacketSentAction()
+{
+	packetSentAction = nullptr;
+}
+
+uint32_t SX1262::getTimeOnAir(size_t len)
+{
+	/* Symbol duration in us, low data rate optimization above 16 ms like the driver */
+	float symbolUs = (float)(1UL << spreadingFactor) * 1000.0f / bandwidth;
+	uint8_t ldro = symbolUs >= 16000.0f ? 1 : 0;
+	int32_t payloadBits = 8 * (int32_t)len + 16 - 4 * spreadingFactor + 20;
+	float preambleSymbols;
+	int32_t payloadSymbols;
+
+	if (spreadingFactor >= 7)
+	{
+		payloadBits += 8;
+		preambleSymbols = preambleLength + 4.25f;
+	}
+	else
+	{
+		preambleSymbols = preambleLength + 6.25f;
+	}
+
+	if (payloadBits < 0)
+		payloadBits = 0;
+	payloadSymbols = 8 + ((payloadBits + 4 * (spreadingFactor - 2 * ldro) - 1) / (4 * (spreadingFactor - 2 * ldro))) *
+							 (codingRate);
+
+	return (uint32_t)((preambleSymbols + payloadSymbols) * symbolUs);
+}
+
+int16_t SX1262::startTransmit(const uint8_t *data, size_t len, uint8_t addr)
+{
+	uint32_t timeOnAirUs;
+
+	(void)addr;
+	if (len > RADIOLIB_SX126X_MAX_PACKET_LENGTH)
+		return RADIOLIB_ERR_PACKET_TOO_LONG;
+
+	memcpy(txBuffer, data, len);
+	txLength = len;
+	transmitting = true;
+	digitalWrite(mod->irq, LOW);
+
+	timeOnAirUs = getTimeOnAir(len);
+	airtimeUs += timeOnAirUs;
+	if (!nativeScheduleEvent(nativeNowUs() + timeOnAirUs, onTxDone, this))
+		return RADIOLIB_ERR_UNKNOWN;
+
+	return RADIOLIB_ERR_NONE;
+}
+
+void SX1262::onTxDone(void *ctx)
+{
+	SX1262 *radio = (SX1262 *)ctx;
+
+	if (!radio->transmitting)
+		return;
+
+	radio->transmitting = false;
+	radio->packetsSent++;
+	if (txHook)
+		txHook(radio->txBuffer, radio->txLength, txHookCtx);
+
+	/* TX_DONE IRQ on DIO1, stays high until the IRQ is cleared */
+	nativeSetPin(radio->mod->irq, HIGH);
+	if (radio->packetSentAction)
+		radio->packetSentAction();
+}
+
+int16_t SX1262::finishTransmit()
+{
+	transmitting = false;
+	digitalWrite(mod->irq, LOW);
+	return standby();
+}
+
+int16_t SX1262::sleep(bool retainConfig)
+{
+	(void)retainConfig;
+	transmitting = false;
+	return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::standby()
+{
+	return RADIOLIB_ERR_NONE;
+}
@@ -0,0 +1,110 @@
+/*
+  RadioLib subset for the native build: an SX1262 that validates its settings
+  like the real driver and puts packets on the virtual air
+
+  startTransmit() computes the LoRa time on air, raises DIO1 once it has
+  elapsed on the virtual clock and calls the packet sent action, the way the
+  SX1262 IRQ does. Sent packets are handed to the hook set with
+  nativeRadioSetTxHook(), which plays the part of the receiving gateway.
+*/
+
+#ifndef NATIVE_RADIOLIB_H
+#define NATIVE_RADIOLIB_H
+
+#include "Arduino.h"
+
+#define RADIOLIB_ERR_NONE 0
+#define RADIOLIB_ERR_UNKNOWN -1
+#define RADIOLIB_ERR_PACKET_TOO_LONG -4
+#define RADIOLIB_ERR_TX_TIMEOUT -5
+#define RADIOLIB_ERR_INVALID_BANDWIDTH -8
+#define RADIOLIB_ERR_INVALID_SPREADING_FACTOR -9
+#define RADIOLIB_ERR_INVALID_CODING_RATE -10
+#define RADIOLIB_ERR_INVALID_FREQUENCY -12
+#define RADIOLIB_ERR_INVALID_OUTPUT_POWER -13
+#define RADIOLIB_ERR_INVALID_PREAMBLE_LENGTH -18
+
+#define RADIOLIB_SX126X_SYNC_WORD_PRIVATE 0x12
+#define RADIOLIB_SX126X_MAX_PACKET_LENGTH 255
+
+#define ICACHE_RAM_ATTR
+
+/**
+ * @brief : Called for every packet that left the radio
+ * @param[in] data   : Packet payload
+ * @param[in] length : Payload length
+ * @param[in] ctx    : Context given to nativeRadioSetTxHook()
+ */
+typedef void (*nativeRadioTxHook)(const uint8_t *data, size_t length, void *ctx);
+
+/**
+ * @brief : Sets the receiver of the transmitted packets, nullptr drops them
+ */
+void nativeRadioSetTxHook(nativeRadioTxHook hook, void *ctx);
+
+class Module
+{
+public:
+	Module(uint32_t cs, uint32_t irq, uint32_t rst, uint32_t gpio) : cs(cs), irq(irq), rst(rst), gpio(gpio) {}
+
+	uint32_t cs;
+	uint32_t irq;
+	uint32_t rst;
+	uint32_t gpio;
+};
+
+class SX1262
+{
+public:
+	SX1262(Module *mod);
+
+	int16_t begin(float freq = 434.0, float bw = 125.0, uint8_t sf = 9, uint8_t cr = 7,
+				  uint8_t syncWord = RADIOLIB_SX126X_SYNC_WORD_PRIVATE, int8_t power = 10, uint16_t preambleLength = 8,
+				  float tcxoVoltage = 1.6, bool useRegulatorLDO = false);
+
+	int16_t setFrequency(float freq);
+	int16_t setBandwidth(float bw);
+	int16_t setSpreadingFactor(uint8_t sf);
+	int16_t setCodingRate(uint8_t cr);
+	int16_t setSyncWord(uint8_t syncWord);
+	int16_t setOutputPower(int8_t power);
+	int16_t setPreambleLength(uint16_t preambleLength);
+
+	void setPacketSentAction(void (*func)(void));
+	void clearPacketSentAction();
+
+	/**
+	 * @brief : Computes the LoRa time on air with explicit header and CRC, as the SX126x datasheet does
+	 * @param[in] len : Payload length
+	 * @return Time on air in microseconds
+	 */
+	uint32_t getTimeOnAir(size_t len);
+
+	int16_t startTransmit(const uint8_t *data, size_t len, uint8_t addr = 0);
+	int16_t finishTransmit();
+	int16_t sleep(bool retainConfig = true);
+	int16_t standby();
+
+	/* Counters for the benchmarks */
+	uint32_t packetsSent;
+	uint64_t airtimeUs;
+
+private:
+	Module *mod;
+	float frequency;
+	float bandwidth;
+	uint8_t spreadingFactor;
+	uint8_t codingRate;
+	uint8_t syncWord;
+	int8_t outputPower;
+	uint16_t preambleLength;
+
+	void (*packetSentAction)(void);
+	bool transmitting;
+	uint8_t txBuffer[RADIOLIB_SX126X_MAX_PACKET_LENGTH];
+	size_t txLength;
+
+	static void onTxDone(void *ctx);
+};
+
+#endif /* NATIVE_RADIOLIB_H */
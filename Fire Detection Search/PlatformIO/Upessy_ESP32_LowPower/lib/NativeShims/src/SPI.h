@@ -0,0 +1,51 @@
+/*
+  SPIClass for the native build, no device answers: reads return 0xFF
+*/
+
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+	SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+	{
+		(void)clock;
+		(void)bitOrder;
+		(void)dataMode;
+	}
+};
+
+class SPIClass
+{
+public:
+	SPIClass() : transactions(0) {}
+
+	void begin() {}
+	void end() {}
+	void beginTransaction(SPISettings settings)
+	{
+		(void)settings;
+		transactions++;
+	}
+	void endTransaction() {}
+	uint8_t transfer(uint8_t data)
+	{
+		(void)data;
+		return 0xFF;
+	}
+	void transfer(void *data, size_t length) { memset(data, 0xFF, length); }
+
+	/* Number of transactions seen by the bus, for the benchmarks */
+	uint32_t transactions;
+};
+
+extern SPIClass SPI;
+
+#endif /* NATIVE_SPI_H */
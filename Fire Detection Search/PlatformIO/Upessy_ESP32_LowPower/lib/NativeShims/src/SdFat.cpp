@@ -0,0 +1,326 @@
+#include "SdFat.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+static std::mutex cardLock;
+static nativeSdTiming timing = {100, 683, 500};
+static nativeSdStats stats;
+
+void nativeSdSetTiming(const nativeSdTiming &newTiming)
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	timing = newTiming;
+}
+
+nativeSdStats nativeSdGetStats()
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	return stats;
+}
+
+void nativeSdResetStats()
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	stats = nativeSdStats();
+}
+
+static void readSectors(uint32_t count, uint64_t &us)
+{
+	stats.readCommands++;
+	stats.sectorsRead += count;
+	us += timing.commandUs + (uint64_t)count * timing.sectorUs;
+}
+
+static void writeSectors(uint32_t count, uint64_t &us)
+{
+	stats.writeCommands++;
+	stats.sectorsWritten += count;
+	us += timing.commandUs + (uint64_t)count * timing.sectorUs + timing.programUs;
+}
+
+/**
+ * @brief : Updates the FAT for a number of clusters, each FAT sector is read and written to both FATs
+ */
+static void updateFat(uint32_t clusters, uint64_t &us)
+{
+	for (uint32_t i = 0; i < clusters; i += NATIVE_SD_FAT_ENTRIES)
+	{
+		readSectors(1, us);
+		for (uint8_t fat = 0; fat < NATIVE_SD_FAT_COPIES; fat++)
+			writeSectors(1, us);
+	}
+}
+
+/**
+ * @brief : Follows a number of links of a cluster chain, the FAT sectors are read once each
+ */
+static void walkFat(uint32_t links, uint64_t &us)
+{
+	for (uint32_t i = 0; i < links; i += NATIVE_SD_FAT_ENTRIES)
+		readSectors(1, us);
+}
+
+/**
+ * @brief : Holds the card for the time of an operation, the bus serves one operation at a time
+ */
+static void spend(uint64_t us)
+{
+	stats.busyUs += us;
+	if (us)
+		std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static uint32_t clustersFor(uint32_t length)
+{
+	return (uint32_t)(((uint64_t)length + NATIVE_SD_CLUSTER_SIZE - 1) / NATIVE_SD_CLUSTER_SIZE);
+}
+
+File::File()
+	: fd(-1), pos(0), fileSize(0), clusters(0), contiguous(false), cachedSector(UINT32_MAX), cacheDirty(false),
+	  entryDirty(false)
+{
+}
+
+File::~File()
+{
+	if (fd >= 0)
+		::close(fd);
+}
+
+bool File::open(const char *path, int oflag)
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	uint64_t us = 0;
+
+	if (fd >= 0)
+		return false;
+	fd = ::open(path, oflag & (O_ACCMODE | O_CREAT | O_TRUNC | O_EXCL), 0644);
+	if (fd < 0)
+		return false;
+
+	stats.opens++;
+	readSectors(1, us);
+	off_t length = lseek(fd, 0, SEEK_END);
+	fileSize = (length > 0) ? (uint32_t)length : 0;
+	clusters = clustersFor(fileSize);
+	pos = 0;
+	contiguous = false;
+	cachedSector = UINT32_MAX;
+	cacheDirty = false;
+	entryDirty = false;
+
+	if ((oflag & O_TRUNC) && clusters)
+	{
+		updateFat(clusters, us);
+		clusters = 0;
+		entryDirty = true;
+	}
+	if (oflag & O_AT_END)
+	{
+		walkTo(fileSize, us);
+		pos = fileSize;
+	}
+	spend(us);
+
+	return true;
+}
+
+bool File::close()
+{
+	if (fd < 0)
+		return false;
+
+	bool ret = sync();
+	::close(fd);
+	fd = -1;
+
+	return ret;
+}
+
+bool File::sync()
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	uint64_t us = 0;
+
+	if (fd < 0)
+		return false;
+
+	stats.syncs++;
+	flushCache(us);
+	if (entryDirty)
+	{
+		readSectors(1, us);
+		writeSectors(1, us);
+		entryDirty = false;
+	}
+	spend(us);
+
+	return true;
+}
+
+size_t File::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	uint64_t us = 0;
+
+	if (fd < 0 || pwrite(fd, buffer, size, pos) != (ssize_t)size)
+		return 0;
+
+	allocate(pos + (uint32_t)size, us);
+	for (size_t done = 0; done < size;)
+	{
+		uint32_t at = pos + (uint32_t)done;
+		uint32_t sector = at / NATIVE_SD_SECTOR_SIZE;
+		uint32_t offset = at % NATIVE_SD_SECTOR_SIZE;
+		size_t left = size - done;
+
+		if (offset == 0 && left >= NATIVE_SD_SECTOR_SIZE)
+		{
+			uint32_t count = (uint32_t)(left / NATIVE_SD_SECTOR_SIZE);
+
+			if (cachedSector >= sector && cachedSector < sector + count)
+			{
+				cachedSector = UINT32_MAX;
+				cacheDirty = false;
+			}
+			writeSectors(count, us);
+			done += (size_t)count * NATIVE_SD_SECTOR_SIZE;
+		}
+		else
+		{
+			size_t chunk = NATIVE_SD_SECTOR_SIZE - offset;
+
+			if (chunk > left)
+				chunk = left;
+			cacheSector(sector, (uint64_t)sector * NATIVE_SD_SECTOR_SIZE < fileSize, us);
+			cacheDirty = true;
+			done += chunk;
+		}
+	}
+
+	pos += (uint32_t)size;
+	if (pos > fileSize)
+	{
+		fileSize = pos;
+		entryDirty = true;
+	}
+	spend(us);
+
+	return size;
+}
+
+bool File::seekSet(uint32_t newPos)
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	uint64_t us = 0;
+
+	if (fd < 0 || newPos > fileSize)
+		return false;
+
+	/* SdFat walks on from the current cluster when seeking forward */
+	if (newPos < pos)
+		walkTo(newPos, us);
+	else if (!contiguous)
+		walkFat(newPos / NATIVE_SD_CLUSTER_SIZE - pos / NATIVE_SD_CLUSTER_SIZE, us);
+	pos = newPos;
+	spend(us);
+
+	return true;
+}
+
+bool File::preAllocate(uint32_t length)
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	uint64_t us = 0;
+
+	if (fd < 0 || length == 0 || fileSize || clusters || ftruncate(fd, length) != 0)
+		return false;
+
+	clusters = clustersFor(length);
+	updateFat(clusters, us);
+	fileSize = length;
+	contiguous = true;
+	/* The directory entry is written at once, as SdFat does */
+	readSectors(1, us);
+	writeSectors(1, us);
+	spend(us);
+
+	return true;
+}
+
+bool File::truncate(uint32_t length)
+{
+	std::lock_guard<std::mutex> guard(cardLock);
+	uint64_t us = 0;
+
+	if (fd < 0 || length > fileSize || ftruncate(fd, length) != 0)
+		return false;
+
+	uint32_t keep = clustersFor(length);
+	if (keep < clusters)
+		updateFat(clusters - keep, us);
+	clusters = keep;
+	fileSize = length;
+	if (pos > length)
+		pos = length;
+	if (cachedSector != UINT32_MAX && (uint64_t)cachedSector * NATIVE_SD_SECTOR_SIZE >= length)
+	{
+		cachedSector = UINT32_MAX;
+		cacheDirty = false;
+	}
+	entryDirty = true;
+	spend(us);
+
+	return true;
+}
+
+void File::flushCache(uint64_t &us)
+{
+	if (cacheDirty)
+	{
+		writeSectors(1, us);
+		cacheDirty = false;
+	}
+}
+
+void File::walkTo(uint32_t to, uint64_t &us)
+{
+	if (!contiguous)
+		walkFat(to / NATIVE_SD_CLUSTER_SIZE, us);
+}
+
+void File::allocate(uint32_t end, uint64_t &us)
+{
+	uint32_t need = clustersFor(end);
+
+	if (need <= clusters)
+		return;
+
+	/* Clusters past a preallocation are found one by one */
+	contiguous = false;
+	for (; clusters < need; clusters++)
+	{
+		readSectors(1, us);
+		for (uint8_t fat = 0; fat < NATIVE_SD_FAT_COPIES; fat++)
+			writeSectors(1, us);
+	}
+}
+
+void File::cacheSector(uint32_t sector, bool load, uint64_t &us)
+{
+	if (cachedSector == sector)
+		return;
+
+	flushCache(us);
+	if (load)
+		readSectors(1, us);
+	cachedSector = sector;
+}
@@ -0,0 +1,130 @@
+/*
+  SdFat subset for the native build, files of the host with an SD card cost model
+
+  A File is a host file, so what a program writes can be checked afterwards.
+  The card is a FAT32 volume behind an SPI bus: every operation counts the
+  block commands and sectors SdFat would send for it, and sleeps in real
+  time for them, so host threads writing to the card see its latency.
+
+  - sectors move one at a time through a one sector cache, as in SdFat.
+    Writing part of a sector reads it first unless it lies past the end of
+    the file, the cache is written back when another sector is needed or on
+    sync and close. Whole sectors are written straight to the card, in one
+    multiple block command
+  - growing a file allocates clusters, one FAT sector read and one write
+    per FAT for each
+  - seeking in a file that is not contiguous walks its cluster chain from
+    the first cluster, one FAT sector read per 128 clusters
+  - open reads the directory sector of the entry, sync and close write it
+    back with the new size
+
+  Volume layout, directories and free space are not modelled.
+*/
+
+#ifndef NATIVE_SDFAT_H
+#define NATIVE_SDFAT_H
+
+#include <fcntl.h>
+
+#include "Arduino.h"
+
+#define O_READ O_RDONLY
+#define O_WRITE O_WRONLY
+/* Not a host flag, open seeks to the end of the file */
+#define O_AT_END 0x40000000
+
+#define NATIVE_SD_SECTOR_SIZE 512
+#define NATIVE_SD_CLUSTER_SIZE 32768
+/* FAT32 entries per FAT sector */
+#define NATIVE_SD_FAT_ENTRIES 128
+#define NATIVE_SD_FAT_COPIES 2
+
+/* Card and bus timing, zero costs make the card free */
+typedef struct
+{
+	/* Command and response of each block command */
+	uint32_t commandUs;
+	/* Transfer of one sector on the bus */
+	uint32_t sectorUs;
+	/* Card busy after a write command */
+	uint32_t programUs;
+} nativeSdTiming;
+
+typedef struct
+{
+	uint32_t opens;
+	uint32_t syncs;
+	uint32_t readCommands;
+	uint32_t writeCommands;
+	uint32_t sectorsRead;
+	uint32_t sectorsWritten;
+	uint64_t busyUs;
+} nativeSdStats;
+
+/**
+ * @brief : Sets the card timing, by default a 6 MHz bus as with SPI_EIGHTH_SPEED
+ */
+void nativeSdSetTiming(const nativeSdTiming &timing);
+
+/**
+ * @brief : Gets the operations of all files since the last reset
+ */
+nativeSdStats nativeSdGetStats();
+void nativeSdResetStats();
+
+class File : public Print
+{
+public:
+	File();
+	~File();
+
+	bool open(const char *path, int oflag = O_READ);
+	bool close();
+	bool isOpen() const { return fd >= 0; }
+	bool sync();
+
+	using Print::write;
+	size_t write(uint8_t c);
+	size_t write(const uint8_t *buffer, size_t size);
+
+	bool seek(uint32_t pos) { return seekSet(pos); }
+	bool seekSet(uint32_t pos);
+	uint32_t position() const { return pos; }
+	uint32_t curPosition() const { return pos; }
+	uint32_t size() const { return fileSize; }
+
+	/**
+	 * @brief : Allocates contiguous clusters to an empty file, which then has this size
+	 */
+	bool preAllocate(uint32_t length);
+	bool isContiguous() const { return contiguous; }
+
+	/**
+	 * @brief : Cuts the file at the current position, or at length
+	 */
+	bool truncate() { return truncate(pos); }
+	bool truncate(uint32_t length);
+
+private:
+	int fd;
+	uint32_t pos;
+	uint32_t fileSize;
+	uint32_t clusters;
+	bool contiguous;
+	/* Sector in the cache, UINT32_MAX for none */
+	uint32_t cachedSector;
+	bool cacheDirty;
+	bool entryDirty;
+
+	void flushCache(uint64_t &us);
+	void walkTo(uint32_t to, uint64_t &us);
+	void allocate(uint32_t end, uint64_t &us);
+	void cacheSector(uint32_t sector, bool load, uint64_t &us);
+
+	File(const File &);
+	File &operator=(const File &);
+};
+
+typedef File FsFile;
+
+#endif /* NATIVE_SDFAT_H */
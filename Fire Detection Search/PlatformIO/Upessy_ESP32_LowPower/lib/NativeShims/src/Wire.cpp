@@ -0,0 +1,125 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+	: transactions(0), bytes(0), busyUs(0), nDevices(0), txAddress(0), txLength(0), rxLength(0), rxIndex(0),
+	  timingHz(0)
+{
+}
+
+bool TwoWire::begin()
+{
+	return true;
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+	(void)frequency;
+}
+
+bool TwoWire::attach(uint8_t address, NativeI2cDevice &device)
+{
+	if (nDevices >= NATIVE_I2C_MAX_DEVICES)
+		return false;
+
+	addresses[nDevices] = address;
+	devices[nDevices] = &device;
+	nDevices++;
+
+	return true;
+}
+
+void TwoWire::setTransferTiming(uint32_t clockHz)
+{
+	timingHz = clockHz;
+}
+
+void TwoWire::chargeTransfer(size_t length)
+{
+	uint64_t durationUs;
+
+	if (timingHz == 0)
+		return;
+
+	durationUs = ((uint64_t)(length + 1) * 9 * 1000000 + timingHz - 1) / timingHz;
+	busyUs += durationUs;
+	nativeAdvanceUs(durationUs);
+}
+
+NativeI2cDevice *TwoWire::find(uint8_t address)
+{
+	for (uint8_t i = 0; i < nDevices; i++)
+		if (addresses[i] == address)
+			return devices[i];
+
+	return nullptr;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+	txAddress = address;
+	txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+	if (txLength >= NATIVE_I2C_BUFFER_LENGTH)
+		return 0;
+
+	txBuffer[txLength++] = data;
+	return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+	NativeI2cDevice *device = find(txAddress);
+
+	(void)sendStop;
+	transactions++;
+	bytes += txLength;
+	chargeTransfer(txLength);
+
+	/* Address not acknowledged */
+	if (device == nullptr)
+		return 2;
+
+	if (txLength > 0)
+		device->receive(txBuffer, txLength);
+
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity)
+{
+	NativeI2cDevice *device = find((uint8_t)address);
+
+	transactions++;
+	rxLength = 0;
+	rxIndex = 0;
+	if (device == nullptr || quantity <= 0)
+	{
+		chargeTransfer(0);
+		return 0;
+	}
+
+	if (quantity > NATIVE_I2C_BUFFER_LENGTH)
+		quantity = NATIVE_I2C_BUFFER_LENGTH;
+	chargeTransfer(quantity);
+
+	device->transmit(rxBuffer, quantity);
+	rxLength = quantity;
+	bytes += quantity;
+
+	return (uint8_t)quantity;
+}
+
+int TwoWire::available()
+{
+	return (int)(rxLength - rxIndex);
+}
+
+int TwoWire::read()
+{
+	return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+}
@@ -0,0 +1,85 @@
+/*
+  TwoWire for the native build
+
+  Transactions are routed to fake devices attached to the bus by address.
+  The devices see the raw bytes of each transaction and keep their own
+  register pointer, so burst and interleaved register writes behave as on
+  the real part.
+*/
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include "Arduino.h"
+
+#define NATIVE_I2C_BUFFER_LENGTH 128
+#define NATIVE_I2C_MAX_DEVICES 8
+
+/* I2C slave as seen by the bus */
+class NativeI2cDevice
+{
+public:
+	virtual ~NativeI2cDevice() {}
+	/* Bytes written by the master in one transaction */
+	virtual void receive(const uint8_t *data, size_t length) = 0;
+	/* Bytes requested by the master */
+	virtual void transmit(uint8_t *data, size_t length) = 0;
+};
+
+class TwoWire
+{
+public:
+	TwoWire();
+
+	bool begin();
+	void setClock(uint32_t frequency);
+
+	/**
+	 * @brief : Attaches a fake device to the bus
+	 * @param[in] address : 7 bit I2C address
+	 * @param[in] device  : Device answering at this address
+	 * @return true if there was room on the bus
+	 */
+	bool attach(uint8_t address, NativeI2cDevice &device);
+
+	/**
+	 * @brief : Makes every transaction take its transfer time on the virtual clock, 9 clock cycles
+	 *          per byte with the address byte. Transactions take no time by default
+	 * @param[in] clockHz : Bus clock, 0 to stop charging the transfer time
+	 */
+	void setTransferTiming(uint32_t clockHz);
+
+	void beginTransmission(uint8_t address);
+	size_t write(uint8_t data);
+	uint8_t endTransmission(bool sendStop = true);
+	uint8_t requestFrom(int address, int quantity);
+	int available();
+	int read();
+
+	/* Number of transactions and bytes seen by the bus, and the time they took, for the benchmarks */
+	uint32_t transactions;
+	uint32_t bytes;
+	uint64_t busyUs;
+
+private:
+	uint8_t addresses[NATIVE_I2C_MAX_DEVICES];
+	NativeI2cDevice *devices[NATIVE_I2C_MAX_DEVICES];
+	uint8_t nDevices;
+
+	uint8_t txAddress;
+	uint8_t txBuffer[NATIVE_I2C_BUFFER_LENGTH];
+	size_t txLength;
+
+	uint8_t rxBuffer[NATIVE_I2C_BUFFER_LENGTH];
+	size_t rxLength;
+	size_t rxIndex;
+
+	uint32_t timingHz;
+
+	NativeI2cDevice *find(uint8_t address);
+	void chargeTransfer(size_t length);
+};
+
+extern TwoWire Wire;
+
+#endif /* NATIVE_WIRE_H */
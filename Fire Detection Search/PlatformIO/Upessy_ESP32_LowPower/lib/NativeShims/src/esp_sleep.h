@@ -0,0 +1,52 @@
+/*
+  ESP32 sleep and GPIO wakeup API on virtual time, see native_time.h
+*/
+
+#ifndef NATIVE_ESP_SLEEP_H
+#define NATIVE_ESP_SLEEP_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef int gpio_num_t;
+
+typedef enum
+{
+	GPIO_INTR_DISABLE,
+	GPIO_INTR_POSEDGE,
+	GPIO_INTR_NEGEDGE,
+	GPIO_INTR_ANYEDGE,
+	GPIO_INTR_LOW_LEVEL,
+	GPIO_INTR_HIGH_LEVEL
+} gpio_int_type_t;
+
+typedef enum
+{
+	ESP_SLEEP_WAKEUP_ALL,
+	ESP_SLEEP_WAKEUP_UNDEFINED,
+	ESP_SLEEP_WAKEUP_TIMER,
+	ESP_SLEEP_WAKEUP_GPIO
+} esp_sleep_source_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs);
+esp_err_t esp_sleep_enable_gpio_wakeup();
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t type);
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio);
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type);
+
+/**
+ * @brief : Advances the virtual clock to the timer wakeup or, with the GPIO wakeup enabled,
+ *          to the first peripheral event if it comes earlier
+ */
+esp_err_t esp_light_sleep_start();
+
+/**
+ * @brief : Ends the boot, see nativeDeepSleep
+ */
+[[noreturn]] void esp_deep_sleep_start();
+
+#endif /* NATIVE_ESP_SLEEP_H */
@@ -0,0 +1,98 @@
+/*
+  FreeRTOS subset for the native build: tasks, queues and semaphores
+
+  Tasks are host threads and block for real, ticks are milliseconds of the
+  host clock, not of the virtual clock of native_time.h. Only the calls the
+  libraries use are there. Priorities and cores are accepted and ignored,
+  and a task cannot be deleted, it runs until the program exits. Static
+  creation takes its memory from the heap like the dynamic calls, and a
+  critical section is a spinlock that only excludes the other threads.
+*/
+
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef struct nativeTask *TaskHandle_t;
+typedef struct nativeQueue *QueueHandle_t;
+typedef struct nativeSemaphore *SemaphoreHandle_t;
+
+typedef struct
+{
+	uint8_t unused;
+} StaticSemaphore_t;
+
+typedef struct
+{
+	uint8_t unused;
+} StaticTask_t;
+
+typedef struct
+{
+	std::atomic_flag locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {ATOMIC_FLAG_INIT}
+#define portENTER_CRITICAL(mux) nativeEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) nativeExitCritical(mux)
+
+/* Semaphore calls since the start of the run, for the benchmarks. A wait is a take that found the semaphore taken */
+typedef struct
+{
+	uint32_t takes;
+	uint32_t waits;
+	uint32_t recursiveTakes;
+	uint32_t recursiveWaits;
+} nativeSemaphoreStats;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth, void *arg,
+								   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth, void *arg,
+										   UBaseType_t priority, StackType_t *stack, StaticTask_t *taskMem,
+										   BaseType_t core);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+
+void nativeEnterCritical(portMUX_TYPE *mux);
+void nativeExitCritical(portMUX_TYPE *mux);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *semaphoreMem);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *semaphoreMem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex);
+
+nativeSemaphoreStats nativeGetSemaphoreStats();
+
+#endif /* NATIVE_FREERTOS_H */
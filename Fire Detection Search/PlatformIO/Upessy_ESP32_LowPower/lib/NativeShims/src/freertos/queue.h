@@ -0,0 +1,10 @@
+/*
+  FreeRTOS queue API for the native build, see FreeRTOS.h
+*/
+
+#ifndef NATIVE_FREERTOS_QUEUE_H
+#define NATIVE_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+#endif /* NATIVE_FREERTOS_QUEUE_H */
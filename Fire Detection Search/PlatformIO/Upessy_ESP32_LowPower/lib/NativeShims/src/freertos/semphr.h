@@ -0,0 +1,10 @@
+/*
+  FreeRTOS semphr API for the native build, see FreeRTOS.h
+*/
+
+#ifndef NATIVE_FREERTOS_SEMPHR_H
+#define NATIVE_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+#endif /* NATIVE_FREERTOS_SEMPHR_H */
@@ -0,0 +1,10 @@
+/*
+  FreeRTOS task API for the native build, see FreeRTOS.h
+*/
+
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+#endif /* NATIVE_FREERTOS_TASK_H */
@@ -0,0 +1,86 @@
+/*
+  Virtual time of the native build
+
+  Nothing waits for real: delays, light sleep and deep sleep move a virtual
+  microsecond clock forward, so a day of node operation runs in seconds and
+  every run is reproducible. Fake peripherals schedule their events (end of
+  a LoRa transmission, a measurement step) on this clock and are called back
+  once it passes the event time.
+
+  Deep sleep ends the current boot: esp_deep_sleep_start() throws
+  nativeDeepSleep, which the native main catches to boot the firmware again
+  after moving the clock forward. Globals are not cleared between boots, the
+  firmware sets its per boot state again in setup().
+*/
+
+#ifndef NATIVE_TIME_H
+#define NATIVE_TIME_H
+
+#include <stdint.h>
+
+typedef void (*nativeEventHandler)(void *ctx);
+
+/* Thrown by esp_deep_sleep_start() */
+typedef struct
+{
+	uint64_t durationUs;
+} nativeDeepSleep;
+
+/**
+ * @brief : Gets the virtual time since the start of the run
+ * @return Time in microseconds, keeps counting through emulated deep sleep
+ */
+uint64_t nativeNowUs();
+
+/**
+ * @brief : Gets the virtual time since the current boot, as esp_timer does
+ * @return Time in microseconds
+ */
+uint64_t nativeBootUs();
+
+/**
+ * @brief : Moves the virtual clock forward and runs the events falling due on the way
+ * @param[in] us : Time to advance in microseconds
+ */
+void nativeAdvanceUs(uint64_t us);
+
+/**
+ * @brief : Registers an event, there is room for one pending event per handler and context
+ * @param[in] atUs    : Virtual time of the event
+ * @param[in] handler : Function called when the clock reaches atUs
+ * @param[in] ctx     : Pointer handed to the handler
+ * @return true if the event is scheduled
+ */
+bool nativeScheduleEvent(uint64_t atUs, nativeEventHandler handler, void *ctx);
+
+/**
+ * @brief : Drops the pending event of a handler and context, if any
+ */
+void nativeCancelEvent(nativeEventHandler handler, void *ctx);
+
+/**
+ * @brief : Gets the time of the earliest pending event
+ * @param[out] atUs : Virtual time of the event
+ * @return true if an event is pending
+ */
+bool nativeNextEvent(uint64_t &atUs);
+
+/**
+ * @brief : Gets the virtual time spent in delay(), where the target blocks the task and the CPU may idle
+ * @return Time in microseconds since the start of the run
+ */
+uint64_t nativeYieldUs();
+
+/**
+ * @brief : Gets the virtual time spent in light sleep
+ * @return Time in microseconds since the start of the run
+ */
+uint64_t nativeLightSleepUs();
+
+/**
+ * @brief : Starts a new emulated boot, called by the native main
+ * @param[in] deepSleepWake : The boot is a wake from deep sleep
+ */
+void nativeBoot(bool deepSleepWake);
+
+#endif /* NATIVE_TIME_H */
@@ -0,0 +1,143 @@
+/*
+  Overlap of the BME68x bus transfers with processing, on the host
+
+  Runs forced mode cycles against the fake BME688 through a Bme68xAsync
+  queue on a bus with the timing of a 100 kHz I2C bus (NativeLatencyBus).
+  Each cycle triggers a measurement, waits for it, fetches the fields and
+  spends --work-us of CPU time on the previous sample, as BSEC would.
+
+  - blocking  : fetchData reads the fields, the CPU waits for the bus
+  - overlapped: fetchDataAsync queues the read, the processing runs while
+                the bus is busy, fetchData then decodes the fields from RAM
+
+  Times are virtual, so the run is reproducible and needs no hardware.
+
+  Usage: program [--cycles N] [--work-us N] [--clock-hz N]
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+#include <NativeLatencyBus.h>
+#include <Wire.h>
+
+#include "bme68xAsync.h"
+
+#define BENCH_BME688_ADDR 0x77
+
+typedef struct
+{
+	uint64_t cycleUs;
+	uint64_t blockedUs;
+	uint64_t busUs;
+	uint32_t samples;
+} benchResult;
+
+static FakeBme688 bme688;
+
+static void onFields(int8_t rslt, void *ctx)
+{
+	(void)rslt;
+	(*(uint32_t *)ctx)++;
+}
+
+/**
+ * @brief : Runs the measurement cycles on a fresh queue and bus
+ */
+static benchResult runCycles(bool overlapped, uint32_t cycles, uint32_t workUs, uint32_t clockHz)
+{
+	NativeLatencyBus<Bme68xI2cTransport> bus(Bme68xI2cTransport(BENCH_BME688_ADDR, Wire), clockHz);
+	Bme68xAsync async(bus);
+	Bme68x sensor;
+	bme68xData data;
+	benchResult result = {0, 0, 0, 0};
+	uint32_t callbacks = 0;
+
+	sensor.begin(BME68X_I2C_INTF, Bme68xAsync::read, Bme68xAsync::write, Bme68xAsync::delayUs, &async);
+	sensor.setTPH();
+	sensor.setHeaterProf(300, 100);
+	async.waitIdle();
+
+	uint64_t startUs = nativeNowUs();
+	uint64_t busStartUs = bus.busyUs;
+	for (uint32_t i = 0; i < cycles; i++)
+	{
+		sensor.setOpMode(BME68X_FORCED_MODE);
+		delayMicroseconds(sensor.getMeasDur() + 100 * 1000);
+
+		if (overlapped)
+			async.fetchDataAsync(BME68X_FORCED_MODE, onFields, &callbacks);
+
+		/* Processing of the previous sample */
+		if (overlapped)
+			delayMicroseconds(workUs);
+
+		uint64_t fetchUs = nativeNowUs();
+		if (sensor.fetchData())
+		{
+			sensor.getData(data);
+			if (data.status & BME68X_NEW_DATA_MSK)
+				result.samples++;
+		}
+		result.blockedUs += nativeNowUs() - fetchUs;
+
+		if (!overlapped)
+			delayMicroseconds(workUs);
+	}
+
+	result.cycleUs = (nativeNowUs() - startUs) / cycles;
+	result.blockedUs /= cycles;
+	result.busUs = (bus.busyUs - busStartUs) / cycles;
+	if (overlapped && callbacks != cycles)
+		printf("BENCH %u prefetch callbacks for %u cycles\n", callbacks, cycles);
+
+	return result;
+}
+
+static void report(const char *name, const benchResult &result, uint32_t cycles)
+{
+	printf("BENCH %-10s cycle=%llu us blocked_on_bus=%llu us bus_busy=%llu us samples=%u/%u\n", name,
+		   (unsigned long long)result.cycleUs, (unsigned long long)result.blockedUs,
+		   (unsigned long long)result.busUs, result.samples, cycles);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t cycles = 100;
+	uint32_t workUs = 2000;
+	uint32_t clockHz = 100000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--cycles") && i + 1 < argc)
+			cycles = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--work-us") && i + 1 < argc)
+			workUs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--clock-hz") && i + 1 < argc)
+			clockHz = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--cycles N] [--work-us N] [--clock-hz N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (cycles == 0)
+		cycles = 1;
+	if (clockHz == 0)
+		clockHz = 100000;
+
+	Wire.attach(BENCH_BME688_ADDR, bme688);
+	Wire.begin();
+
+	benchResult blocking = runCycles(false, cycles, workUs, clockHz);
+	benchResult overlapped = runCycles(true, cycles, workUs, clockHz);
+
+	report("blocking", blocking, cycles);
+	report("overlapped", overlapped, cycles);
+	printf("BENCH saved=%lld us per cycle\n", (long long)blocking.cycleUs - (long long)overlapped.cycleUs);
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
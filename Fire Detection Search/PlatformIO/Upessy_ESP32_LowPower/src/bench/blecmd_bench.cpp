@@ -0,0 +1,666 @@
+/*
+  Parsing and queuing of the demo BLE commands on the host, see ble_command.h
+
+  - fuzz  : valid commands, their mutations (digits, signs, white space,
+            zeros, cuts, long label fields) and random bytes go through
+            bleCommand::parse and through the std::stringstream parsers the
+            controller had before, kept here as the reference. The status and
+            the message fields must match, the reply must be a JSON object
+            within BLE_CMD_REPLY_SIZE
+  - alloc : heap allocations and time per command of both parsers
+  - burst : bursts of --burst commands, --write-gap-ms apart, every
+            --burst-period-ms, go through the parser into the queue, the loop
+            takes all queued messages every --loop-ms. The former queue depth
+            of 3 against BLE_MSG_QUEUE_LEN, on a virtual clock
+  - spsc  : a producer thread and a consumer thread move numbered messages
+            through bleMsgQueue, the producer tries again while it is full.
+            All messages must arrive whole and in order
+
+  Usage: program [--inputs N] [--seed N] [--burst N] [--write-gap-ms N] [--burst-period-ms N]
+                 [--loop-ms N] [--seconds N]
+  Exits with 1 if a check fails.
+*/
+
+#ifdef NODE_BENCH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ble_command.h"
+
+typedef bleCommand::ble_msg bleMsg;
+typedef bleCommand::cmd_status cmdStatus;
+
+/* Heap allocations of the running thread, counted by operator new */
+static std::atomic<uint64_t> allocations(0);
+static thread_local bool countAllocations = false;
+
+void *operator new(size_t size)
+{
+	void *ptr = malloc(size ? size : 1);
+
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+	if (countAllocations)
+		allocations++;
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+/* Reference: the std::stringstream parsers of the controller before ble_command.h */
+namespace reference
+{
+typedef cmdStatus (*parseFn)(std::stringstream &ss, bleMsg &msg);
+
+static cmdStatus noArgs(std::stringstream &, bleMsg &)
+{
+	return bleCommand::CMD_VALID;
+}
+
+static cmdStatus setRtcTime(std::stringstream &ss, bleMsg &msg)
+{
+	uint32_t rtc;
+
+	if (ss >> rtc)
+	{
+		msg.rtc_time = rtc;
+		return bleCommand::CMD_VALID;
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static cmdStatus setLabel(std::stringstream &ss, bleMsg &msg)
+{
+	uint32_t label;
+
+	if (ss >> label)
+	{
+		msg.label = label;
+		return bleCommand::CMD_VALID;
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static cmdStatus setLabelInfo(std::stringstream &ss, bleMsg &msg)
+{
+	uint32_t label;
+	std::string name, desc;
+
+	if (ss >> label)
+	{
+		msg.label_info.label = label;
+
+		if (std::getline(ss, name, ','))
+		{
+			/* The former code erased the first character of an empty name too, undefined */
+			if (!name.empty())
+				name.erase(name.begin());
+
+			if (name.length() > LABEL_NAME_SIZE)
+				return bleCommand::MAX_LABEL_NAME_REACHED;
+			memset(msg.label_info.label_name, 0, (LABEL_NAME_SIZE + 1));
+			strncpy(msg.label_info.label_name, name.c_str(), (LABEL_NAME_SIZE - 1));
+
+			if (std::getline(ss, desc, '.'))
+			{
+				if (desc.length() > LABEL_DESC_SIZE)
+					return bleCommand::MAX_LABEL_DESCRIPTION_REACHED;
+				memset(msg.label_info.label_desc, 0, (LABEL_DESC_SIZE + 1));
+				strncpy(msg.label_info.label_desc, desc.c_str(), (LABEL_DESC_SIZE - 1));
+				return bleCommand::CMD_VALID;
+			}
+		}
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static cmdStatus startStreaming(std::stringstream &ss, bleMsg &msg)
+{
+	int32_t sensorNum, sampleRate, outputId;
+
+	if (ss >> sensorNum)
+	{
+		msg.bsec.selected_sensor = static_cast<uint8_t>(sensorNum);
+
+		if (ss >> sampleRate)
+		{
+			msg.bsec.sample_rate = static_cast<uint8_t>(sampleRate);
+			msg.bsec.len = 0;
+
+			while ((msg.bsec.len < BSEC_NUMBER_OUTPUTS) && (ss >> outputId))
+				msg.bsec.output_id[msg.bsec.len++] = static_cast<uint8_t>(outputId);
+
+			if (ss >> outputId)
+				return bleCommand::BSEC_OUTPUT_EXCESS_ERROR;
+			return bleCommand::CMD_VALID;
+		}
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static cmdStatus readConfig(std::stringstream &ss, bleMsg &msg)
+{
+	int32_t fileType;
+
+	if (ss >> fileType)
+	{
+		msg.file_type = static_cast<bleCommand::config_file>(fileType);
+		return bleCommand::CMD_VALID;
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static cmdStatus setMode(std::stringstream &ss, bleMsg &msg)
+{
+	int32_t mode;
+
+	if (ss >> mode)
+	{
+		msg.mode = static_cast<uint8_t>(mode);
+		return bleCommand::CMD_VALID;
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static cmdStatus setGroundTruth(std::stringstream &ss, bleMsg &msg)
+{
+	int32_t groundTruth;
+
+	if (ss >> groundTruth)
+	{
+		msg.ground_truth = static_cast<uint32_t>(groundTruth);
+		return bleCommand::CMD_VALID;
+	}
+	return bleCommand::CMD_INVALID;
+}
+
+static const struct
+{
+	const char *name;
+	parseFn parse;
+	bleCommand::ble_msg_id id;
+} commands[] = {
+	{"setlabel", setLabel, bleCommand::SET_LABEL},
+	{"setlabelinfo", setLabelInfo, bleCommand::SET_LABEL_INFO},
+	{"getlabelinfo", noArgs, bleCommand::GET_LABEL_INFO},
+	{"setrtctime", setRtcTime, bleCommand::SET_RTC_TIME},
+	{"getrtctime", noArgs, bleCommand::GET_RTC_TIME},
+	{"start", startStreaming, bleCommand::START_STREAMING},
+	{"stop", noArgs, bleCommand::STOP_STREAMING},
+	{"readconfig", readConfig, bleCommand::READ_CONFIG},
+	{"setappmode", setMode, bleCommand::SET_APPMODE},
+	{"getappmode", noArgs, bleCommand::GET_APPMODE},
+	{"setgroundtruth", setGroundTruth, bleCommand::SET_GROUNDTRUTH},
+	{"getfwversion", noArgs, bleCommand::GET_FW_VERSION},
+	{"setstreammode", setMode, bleCommand::SET_STREAM_MODE},
+};
+
+/**
+ * @brief : The former onWrite up to the queue, the command name is the key of the reply
+ */
+static bool parse(const std::string &text, bleMsg &msg, cmdStatus &status, std::string &name)
+{
+	std::stringstream ss(text);
+
+	if (!(ss >> name))
+		return false;
+
+	status = bleCommand::CMD_INVALID;
+	for (auto &cmd : commands)
+	{
+		if (name == cmd.name)
+		{
+			status = cmd.parse(ss, msg);
+			if (status == bleCommand::CMD_VALID)
+			{
+				msg.name = cmd.name;
+				msg.id = cmd.id;
+			}
+			break;
+		}
+	}
+	return true;
+}
+} // namespace reference
+
+/**
+ * @brief : Compares the fields of two messages of the same command
+ */
+static bool sameMsg(const bleMsg &a, const bleMsg &b)
+{
+	if (a.id != b.id || strcmp(a.name, b.name))
+		return false;
+
+	switch (a.id)
+	{
+	case bleCommand::SET_LABEL:
+		return a.label == b.label;
+	case bleCommand::SET_RTC_TIME:
+		return a.rtc_time == b.rtc_time;
+	case bleCommand::SET_GROUNDTRUTH:
+		return a.ground_truth == b.ground_truth;
+	case bleCommand::READ_CONFIG:
+		/* The type is cast from any integer, compared as stored */
+		return !memcmp(&a.file_type, &b.file_type, sizeof(a.file_type));
+	case bleCommand::SET_APPMODE:
+		return a.mode == b.mode;
+	case bleCommand::SET_STREAM_MODE:
+		return a.stream_mode == b.stream_mode;
+	case bleCommand::START_STREAMING:
+		return a.bsec.selected_sensor == b.bsec.selected_sensor && a.bsec.sample_rate == b.bsec.sample_rate &&
+			   a.bsec.len == b.bsec.len && !memcmp(a.bsec.output_id, b.bsec.output_id, a.bsec.len);
+	case bleCommand::SET_LABEL_INFO:
+		return a.label_info.label == b.label_info.label &&
+			   !memcmp(a.label_info.label_name, b.label_info.label_name, sizeof(a.label_info.label_name)) &&
+			   !memcmp(a.label_info.label_desc, b.label_info.label_desc, sizeof(a.label_info.label_desc));
+	default:
+		return true;
+	}
+}
+
+/**
+ * @brief : Checks a reply is a JSON object with one escaped key and an integer
+ */
+static bool validReply(const char *reply, uint8_t len, cmdStatus status)
+{
+	char tail[16];
+	int tailLen = snprintf(tail, sizeof(tail), "\":%d}", (int)status);
+	uint8_t i = 2;
+
+	if (len >= BLE_CMD_REPLY_SIZE || len < 2 + tailLen || strncmp(reply, "{\"", 2) ||
+		memcmp(reply + len - tailLen, tail, tailLen))
+		return false;
+
+	while (i < len - tailLen)
+	{
+		if ((uint8_t)reply[i] < 0x20 || reply[i] == '"')
+			return false;
+		if (reply[i] == '\\')
+		{
+			if (i + 1 >= len - tailLen || !strchr("\"\\bfnrtu", reply[i + 1]))
+				return false;
+			i += (reply[i + 1] == 'u') ? 6 : 2;
+		}
+		else
+			i++;
+	}
+	return i == len - tailLen;
+}
+
+/**
+ * @brief : Valid commands the app sends
+ */
+static const char *const validCommands[] = {
+	"setlabel 1001",
+	"setlabelinfo 1002 Coffee,Fresh ground coffee beans.",
+	"getlabelinfo",
+	"setrtctime 1700000000",
+	"getrtctime",
+	"start 0 1 1 2 3 4 5 6 7 8",
+	"start 3 2",
+	"stop",
+	"readconfig 0",
+	"readconfig 1",
+	"setappmode 1",
+	"getappmode",
+	"setgroundtruth 1003",
+	"getfwversion",
+	"setstreammode 1",
+};
+
+/**
+ * @brief : Builds the fuzz inputs, the valid commands, their mutations and random bytes
+ */
+static std::vector<std::string> buildInputs(uint32_t count, std::mt19937 &rng)
+{
+	static const char *const numbers[] = {"0", "-1", "+7", "-0", "2147483647", "2147483648", "-2147483648",
+										  "-2147483649", "4294967295", "4294967296", "99999999999999999999",
+										  "12abc", "-", "+", "007", "1.5", "0x10"};
+	static const char insertChars[] = {' ', '\t', '\n', '\r', '\v', '\f', ',', '.', '\0', '-', '+', '9', 'a', '"',
+									   '\\', '\x01', '\x7f', '\xff'};
+	std::vector<std::string> inputs;
+	const uint32_t nValid = sizeof(validCommands) / sizeof(validCommands[0]);
+
+	for (uint32_t i = 0; i < nValid; i++)
+		inputs.push_back(validCommands[i]);
+
+	while (inputs.size() < count)
+	{
+		std::string text = validCommands[rng() % nValid];
+
+		switch (rng() % 8)
+		{
+		case 0:
+		{
+			/* A number argument at a limit */
+			size_t pos = text.find(' ');
+			text = text.substr(0, pos == std::string::npos ? text.size() : pos) + " " + numbers[rng() % 17];
+			if (rng() % 2)
+				text += std::string(" ") + numbers[rng() % 17];
+			break;
+		}
+		case 1:
+			text.insert(rng() % (text.size() + 1), 1, insertChars[rng() % sizeof(insertChars)]);
+			break;
+		case 2:
+			text.resize(rng() % (text.size() + 1));
+			break;
+		case 3:
+			text[rng() % text.size()] = (char)(rng() % 256);
+			break;
+		case 4:
+		{
+			/* Label fields around their limits */
+			text = "setlabelinfo " + std::to_string(rng() % 3000) + (rng() % 2 ? " " : "") +
+				   std::string(LABEL_NAME_SIZE - 2 + rng() % 5, 'n') + (rng() % 4 ? "," : "") +
+				   std::string(LABEL_DESC_SIZE - 2 + rng() % 5, 'd') + (rng() % 4 ? "." : "");
+			break;
+		}
+		case 5:
+		{
+			/* More outputs than BSEC_NUMBER_OUTPUTS */
+			text = "start 0 1";
+			for (uint32_t n = BSEC_NUMBER_OUTPUTS - 2 + rng() % 4; n; n--)
+				text += " " + std::to_string(rng() % 30);
+			break;
+		}
+		case 6:
+			text = std::string(1 + rng() % 4, ' ') + text + std::string(rng() % 4, '\n');
+			break;
+		default:
+		{
+			/* Random bytes, a BLE write of up to the payload size */
+			text.assign(rng() % 64, '\0');
+			for (auto &c : text)
+				c = (char)(rng() % 256);
+			break;
+		}
+		}
+		inputs.push_back(text);
+	}
+	return inputs;
+}
+
+typedef struct
+{
+	uint64_t sent;
+	uint64_t processed;
+	uint64_t dropped;
+} burstResult;
+
+/**
+ * @brief : Bursts of commands through the parser into a queue of the given depth, drained by the loop
+ */
+template <uint8_t DEPTH>
+static burstResult runBursts(const std::vector<std::string> &commands, uint32_t burst, uint32_t writeGapMs,
+							 uint32_t burstPeriodMs, uint32_t loopMs, uint32_t seconds)
+{
+	static bleMsgQueue<DEPTH> queue;
+	burstResult result = {};
+	uint32_t next = 0;
+
+	for (uint32_t now = 0; now < seconds * 1000; now++)
+	{
+		uint32_t inPeriod = now % burstPeriodMs;
+		uint32_t writes;
+
+		/* The writes of a burst, one per write gap or all at once */
+		if (writeGapMs == 0)
+			writes = (inPeriod == 0) ? burst : 0;
+		else
+			writes = (inPeriod % writeGapMs == 0 && inPeriod / writeGapMs < burst) ? 1 : 0;
+
+		for (; writes; writes--)
+		{
+			const std::string &text = commands[next++ % commands.size()];
+			bleMsg msg;
+			cmdStatus status;
+			const char *name;
+			size_t nameLen;
+
+			if (bleCommand::parse(text.data(), text.size(), msg, status, name, nameLen) &&
+				status == bleCommand::CMD_VALID)
+			{
+				result.sent++;
+				if (!queue.push(msg))
+					result.dropped++;
+			}
+		}
+
+		if (now % loopMs == loopMs - 1)
+		{
+			bleMsg msg;
+
+			while (queue.pop(msg))
+				result.processed++;
+		}
+	}
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t inputs = 200000;
+	uint32_t seed = 1;
+	uint32_t burst = 8;
+	uint32_t writeGapMs = 0;
+	uint32_t burstPeriodMs = 1000;
+	uint32_t loopMs = 100;
+	uint32_t seconds = 600;
+	bool ok = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--inputs") && i + 1 < argc)
+			inputs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--burst") && i + 1 < argc)
+			burst = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--write-gap-ms") && i + 1 < argc)
+			writeGapMs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--burst-period-ms") && i + 1 < argc)
+			burstPeriodMs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--loop-ms") && i + 1 < argc)
+			loopMs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+			seconds = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr,
+					"Usage: %s [--inputs N] [--seed N] [--burst N] [--write-gap-ms N] [--burst-period-ms N]\n"
+					"          [--loop-ms N] [--seconds N]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+	if (burstPeriodMs == 0)
+		burstPeriodMs = 1;
+	if (loopMs == 0)
+		loopMs = 1;
+
+	std::mt19937 rng(seed);
+	std::vector<std::string> corpus = buildInputs(inputs, rng);
+
+	/* fuzz: both parsers on every input */
+	uint64_t mismatches = 0, badReplies = 0, valid = 0, rejected = 0, silent = 0;
+
+	for (const std::string &text : corpus)
+	{
+		bleMsg msg = {}, refMsg = {};
+		cmdStatus status = bleCommand::CMD_INVALID, refStatus = bleCommand::CMD_INVALID;
+		const char *name = nullptr;
+		size_t nameLen = 0;
+		std::string refName;
+		bool parsed = bleCommand::parse(text.data(), text.size(), msg, status, name, nameLen);
+		bool refParsed = reference::parse(text, refMsg, refStatus, refName);
+
+		if (parsed != refParsed || (parsed && (status != refStatus || std::string(name, nameLen) != refName ||
+											   (status == bleCommand::CMD_VALID && !sameMsg(msg, refMsg)))))
+		{
+			if (mismatches++ < 5)
+			{
+				printf("BENCH mismatch: \"");
+				for (unsigned char c : text)
+					printf((c >= 0x20 && c < 0x7f && c != '"') ? "%c" : "\\x%02x", c);
+				printf("\" status %d against %d\n", parsed ? (int)status : -1, refParsed ? (int)refStatus : -1);
+			}
+			continue;
+		}
+
+		if (!parsed)
+			silent++;
+		else if (status == bleCommand::CMD_VALID)
+			valid++;
+		else
+		{
+			char reply[BLE_CMD_REPLY_SIZE];
+			uint8_t len = bleCommand::format_reply(name, nameLen, status, reply);
+
+			rejected++;
+			if (!validReply(reply, len, status))
+				badReplies++;
+		}
+	}
+	printf("BENCH fuzz inputs=%zu valid=%llu rejected=%llu no_command=%llu mismatches=%llu bad_replies=%llu\n",
+		   corpus.size(), (unsigned long long)valid, (unsigned long long)rejected, (unsigned long long)silent,
+		   (unsigned long long)mismatches, (unsigned long long)badReplies);
+	ok = ok && !mismatches && !badReplies;
+
+	/* alloc: allocations and time per command of the valid commands, many times over */
+	const uint32_t rounds = 20000;
+	const uint32_t nValid = sizeof(validCommands) / sizeof(validCommands[0]);
+	std::vector<std::string> texts(validCommands, validCommands + nValid);
+	uint64_t sink = 0;
+
+	for (int ref = 0; ref < 2; ref++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		allocations = 0;
+		countAllocations = true;
+		for (uint32_t r = 0; r < rounds; r++)
+		{
+			for (const std::string &text : texts)
+			{
+				bleMsg msg;
+				cmdStatus status;
+
+				if (ref)
+				{
+					std::string name;
+
+					sink += reference::parse(text, msg, status, name) + status;
+				}
+				else
+				{
+					const char *name;
+					size_t nameLen;
+
+					sink += bleCommand::parse(text.data(), text.size(), msg, status, name, nameLen) + status;
+				}
+			}
+		}
+		countAllocations = false;
+
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		uint64_t count = (uint64_t)rounds * nValid;
+
+		printf("BENCH alloc %-12s allocations/command=%.2f ns/command=%.0f\n", ref ? "stringstream" : "bleCmdReader",
+			   (double)allocations / count, ns / count);
+		if (!ref && allocations)
+			ok = false;
+	}
+
+	/* burst: the former depth against BLE_MSG_QUEUE_LEN */
+	burstResult shallow = runBursts<3>(texts, burst, writeGapMs, burstPeriodMs, loopMs, seconds);
+	burstResult deep = runBursts<BLE_MSG_QUEUE_LEN>(texts, burst, writeGapMs, burstPeriodMs, loopMs, seconds);
+
+	printf("BENCH burst: %u commands %u ms apart every %u ms, loop drains every %u ms, %u s\n", burst, writeGapMs,
+		   burstPeriodMs, loopMs, seconds);
+	for (int d = 0; d < 2; d++)
+	{
+		const burstResult &r = d ? deep : shallow;
+
+		printf("BENCH burst depth=%-2u processed/s=%.2f dropped/s=%.2f dropped=%.1f%%\n",
+			   d ? BLE_MSG_QUEUE_LEN : 3, (double)r.processed / seconds, (double)r.dropped / seconds,
+			   r.sent ? 100.0 * r.dropped / r.sent : 0.0);
+		ok = ok && (r.processed + r.dropped == r.sent);
+	}
+
+	/* spsc: numbered messages from a producer thread to a consumer thread */
+	static bleMsgQueue<BLE_MSG_QUEUE_LEN> queue;
+	const uint32_t total = 1000000;
+	std::atomic<bool> done(false);
+	uint64_t pushed = 0, popped = 0;
+	bool ordered = true;
+
+	std::thread consumer([&]() {
+		bleMsg msg;
+		uint32_t last = 0;
+
+		for (;;)
+		{
+			bool finished = done.load();
+
+			while (queue.pop(msg))
+			{
+				/* A message copied while it was written would mix two numbers */
+				if (msg.label_info.label <= last || msg.label_info.label_desc[0] != (char)msg.label_info.label ||
+					msg.label_info.label_desc[LABEL_DESC_SIZE - 1] != (char)msg.label_info.label)
+					ordered = false;
+				last = msg.label_info.label;
+				popped++;
+			}
+			if (finished)
+				break;
+			std::this_thread::yield();
+		}
+	});
+
+	for (uint32_t n = 1; n <= total; n++)
+	{
+		bleMsg msg = {};
+
+		msg.label_info.label = n;
+		memset(msg.label_info.label_desc, (char)n, LABEL_DESC_SIZE);
+		/* A full queue is tried again, every message must arrive */
+		while (!queue.push(msg))
+			std::this_thread::yield();
+		pushed++;
+	}
+	done = true;
+	consumer.join();
+
+	printf("BENCH spsc pushed=%llu full=%u popped=%llu ordered=%s\n", (unsigned long long)pushed,
+		   queue.get_dropped(), (unsigned long long)popped, ordered ? "yes" : "no");
+	ok = ok && ordered && (popped == total);
+
+	if (!ok)
+	{
+		printf("BENCH check failed\n");
+		return 1;
+	}
+	return (int)(sink & 0);
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,279 @@
+/*
+  Streaming throughput of the demo BLE notifications, JSON against binary, on the host
+
+  Feeds bme68x samples, and every --bsec-every samples a set of BSEC
+  outputs, as the demo produces them in the BSEC mode, to two streams:
+
+  - json   : one notification per sample or output set, the JSON text of
+             ble_notify_bme68x_data and ble_notify_bsec_output cut into
+             notifications of the payload size. Floats are printed as
+             ArduinoJson prints doubles, up to 9 decimals without trailing
+             zeros. The link carries --notifs-per-event notifications per
+             connection interval, the rest are lost
+  - binary : bleStreamQueue of ble_stream_format.h on a virtual clock, one
+             frame per connection interval. Each frame is decoded, its
+             sequence number checked and its records counted
+
+  The payload size is the ATT MTU less 3 bytes. Both streams run for the
+  same samples, the delivered share tells which one keeps up.
+
+  Usage: program [--rate N] [--seconds N] [--mtu N] [--interval-ms N] [--notifs-per-event N]
+                 [--bsec-every N] [--bsec-outputs N]
+    --rate : bme68x samples per second, 100 by default
+  The frames left at the end are drained before the report. Exits with 1 if a frame does not
+  decode or the sequence gaps do not match the frames dropped.
+*/
+
+#ifdef NODE_BENCH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "ble_stream_format.h"
+
+/**
+ * @brief : Appends a number as ArduinoJson prints a double, at most 9 decimals and no trailing zeros
+ */
+static void jsonNumber(std::string &out, double value)
+{
+	char buff[48];
+	int len = snprintf(buff, sizeof(buff), "%.9f", value);
+
+	while ((len > 0) && (buff[len - 1] == '0'))
+		len--;
+	if ((len > 0) && (buff[len - 1] == '.'))
+		len--;
+	out.append(buff, len);
+}
+
+/**
+ * @brief : Text of ble_notify_bme68x_data
+ */
+static std::string bme68xJson(uint8_t sensorNum, uint8_t gasIndex, float temperature, float pressure, float humidity,
+							  float gasResistance)
+{
+	std::string out = "{\"bme68x\":{\"sensor_number\":" + std::to_string(sensorNum) + ",\"temperature\":";
+
+	jsonNumber(out, temperature);
+	out += ",\"pressure\":";
+	jsonNumber(out, pressure);
+	out += ",\"humidity\":";
+	jsonNumber(out, humidity);
+	out += ",\"gas_resistance\":";
+	jsonNumber(out, gasResistance);
+	out += ",\"gas_index\":" + std::to_string(gasIndex) + "}}";
+	return out;
+}
+
+/**
+ * @brief : Text of ble_notify_bsec_output for outputs 1 to count
+ */
+static std::string bsecJson(uint8_t sensorNum, uint8_t count, float signal)
+{
+	std::string out = "{\"bsec\":[";
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		out += (i ? ",{\"sensor_num\":" : "{\"sensor_num\":") + std::to_string(sensorNum) +
+			   ",\"id\":" + std::to_string(i + 1) + ",\"signal\":";
+		jsonNumber(out, signal + i);
+		out += ",\"accuracy\":3}";
+	}
+	out += "]}";
+	return out;
+}
+
+typedef struct
+{
+	uint64_t messages;
+	uint64_t bytes;
+	uint64_t notifications;
+	uint64_t delivered;
+} jsonResult;
+
+typedef struct
+{
+	uint64_t records;
+	uint64_t frames;
+	uint64_t bytes;
+	uint64_t delivered;
+	uint32_t gaps;
+	bool ok;
+} binaryResult;
+
+/**
+ * @brief : Decodes a frame, counts its records and checks its sequence number
+ */
+static bool checkFrame(const uint8_t *frame, uint16_t len, uint16_t &nextSeq, binaryResult &result)
+{
+	uint16_t seq = frame[1] | (frame[2] << 8);
+	uint16_t pos = BLE_STREAM_HEADER_SIZE;
+
+	if ((len < BLE_STREAM_HEADER_SIZE) || (frame[0] != BLE_STREAM_VERSION))
+		return false;
+
+	result.gaps += (uint16_t)(seq - nextSeq);
+	nextSeq = seq + 1;
+
+	for (uint8_t i = 0; i < frame[3]; i++)
+	{
+		uint8_t size = (frame[pos] == BLE_STREAM_BME68X) ? BLE_STREAM_BME68X_SIZE
+					   : (frame[pos] == BLE_STREAM_BSEC) ? BLE_STREAM_BSEC_SIZE
+														 : 0;
+		if ((size == 0) || (pos + size > len))
+			return false;
+		pos += size;
+	}
+	result.delivered += frame[3];
+
+	return pos == len;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t rate = 100;
+	uint32_t seconds = 60;
+	uint32_t mtu = 247;
+	uint32_t intervalMs = 30;
+	uint32_t notifsPerEvent = 4;
+	uint32_t bsecEvery = 10;
+	uint32_t bsecOutputs = 4;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+			rate = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+			seconds = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--mtu") && i + 1 < argc)
+			mtu = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--interval-ms") && i + 1 < argc)
+			intervalMs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--notifs-per-event") && i + 1 < argc)
+			notifsPerEvent = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--bsec-every") && i + 1 < argc)
+			bsecEvery = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--bsec-outputs") && i + 1 < argc)
+			bsecOutputs = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr,
+					"Usage: %s [--rate N] [--seconds N] [--mtu N] [--interval-ms N] [--notifs-per-event N]\n"
+					"          [--bsec-every N] [--bsec-outputs N]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+	if (mtu < 23)
+		mtu = 23;
+	if (intervalMs == 0)
+		intervalMs = 1;
+	if (bsecOutputs > 20)
+		bsecOutputs = 20;
+
+	static bleStreamQueue queue;
+	static uint8_t frame[BLE_STREAM_FRAME_MAX];
+	uint16_t payload = mtu - 3;
+	jsonResult json = {};
+	binaryResult binary = {};
+	uint16_t nextSeq = 0;
+	uint32_t eventNotifs = 0;
+	uint64_t samples = 0;
+
+	binary.ok = true;
+	queue.set_payload_size(payload);
+
+	for (uint32_t now = 0; now < seconds * 1000; now++)
+	{
+		/* Samples due by the end of this millisecond */
+		uint64_t due = (uint64_t)(now + 1) * rate / 1000;
+
+		if (now % intervalMs == 0)
+			eventNotifs = 0;
+
+		for (; samples < due; samples++)
+		{
+			uint8_t sensorNum = (uint8_t)(samples % 4);
+			uint8_t gasIndex = (uint8_t)(samples / 4 % 10);
+			float temperature = 21.5f + (float)(samples % 100) * 0.013f;
+			float pressure = 1013.25f - (float)(samples % 50) * 0.07f;
+			float humidity = 40.0f + (float)(samples % 30) * 0.37f;
+			float gasResistance = 10000.0f * (float)(1 + samples % 10) + 0.3f;
+			std::string text[2];
+			uint8_t texts = 1;
+
+			text[0] = bme68xJson(sensorNum, gasIndex, temperature, pressure, humidity, gasResistance);
+			queue.add_bme68x(sensorNum, gasIndex, temperature, pressure, humidity, gasResistance);
+			binary.records++;
+			json.messages++;
+
+			if (bsecEvery && (samples % bsecEvery == bsecEvery - 1))
+			{
+				text[texts++] = bsecJson(sensorNum, (uint8_t)bsecOutputs, 0.25f + (float)(samples % 7) * 0.1f);
+				for (uint8_t i = 0; i < bsecOutputs; i++)
+					queue.add_bsec(sensorNum, i + 1, 3, 0.25f + (float)(samples % 7) * 0.1f + i);
+				binary.records += bsecOutputs;
+				json.messages++;
+			}
+
+			/* A message is delivered if all of its notifications fit in the connection event */
+			for (uint8_t t = 0; t < texts; t++)
+			{
+				uint32_t notifs = (text[t].size() + payload - 1) / payload;
+				uint32_t records = (t == 0) ? 1 : bsecOutputs;
+
+				json.bytes += text[t].size();
+				json.notifications += notifs;
+				if (eventNotifs + notifs <= notifsPerEvent)
+					json.delivered += records;
+				eventNotifs += notifs;
+			}
+		}
+
+		uint16_t len = queue.take_frame(now, intervalMs, frame);
+		if (len)
+		{
+			binary.frames++;
+			binary.bytes += len;
+			binary.ok = binary.ok && checkFrame(frame, len, nextSeq, binary);
+		}
+	}
+
+	/* The frames still queued go in the next intervals, the drops are all seen as gaps then */
+	for (uint32_t now = seconds * 1000 + intervalMs;; now += intervalMs)
+	{
+		uint16_t len = queue.take_frame(now, intervalMs, frame);
+		if (len == 0)
+			break;
+		binary.frames++;
+		binary.bytes += len;
+		binary.ok = binary.ok && checkFrame(frame, len, nextSeq, binary);
+	}
+
+	double secs = (double)seconds;
+	uint64_t jsonRecords = samples + (bsecEvery ? samples / bsecEvery * bsecOutputs : 0);
+
+	printf("BENCH link: payload=%u bytes interval=%u ms notifications/event=%u, %.0f samples/s\n", payload,
+		   intervalMs, notifsPerEvent, samples / secs);
+	printf("BENCH json   bytes/record=%.1f notifications/s=%.1f of %.1f delivered=%.1f%% records/s=%.1f\n",
+		   (double)json.bytes / jsonRecords, json.notifications / secs, notifsPerEvent * 1000.0 / intervalMs,
+		   100.0 * json.delivered / jsonRecords, json.delivered / secs);
+	printf("BENCH binary bytes/record=%.1f notifications/s=%.1f delivered=%.1f%% records/s=%.1f "
+		   "frames_dropped=%u seq_gaps=%u records_dropped=%u\n",
+		   binary.frames ? (double)binary.bytes / binary.delivered : 0.0, binary.frames / secs,
+		   100.0 * binary.delivered / binary.records, binary.delivered / secs, queue.get_dropped_frames(),
+		   binary.gaps, queue.get_dropped_records());
+
+	if (!binary.ok || (binary.gaps != queue.get_dropped_frames()))
+	{
+		printf("BENCH binary stream check failed\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
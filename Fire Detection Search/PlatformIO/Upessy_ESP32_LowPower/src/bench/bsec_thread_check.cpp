@@ -0,0 +1,392 @@
+/*
+  Concurrent Bsec2 instances on threads, on the host
+
+  Each instance reads its own fake BME688 through bus callbacks, the fakes
+  differing by their temperature, and runs with the BSEC stand-in at the
+  continuous rate, in forced mode. The semaphores come from the FreeRTOS
+  subset of the native shims, which counts the takes and the waits:
+
+  - shared  : one thread per instance, each on its own manual clock, the
+              threads start together. Every --state-every runs, every run by
+              default, the thread reads the state, sets it back, sets the
+              configuration and reads the state again. These calls go through
+              the shared work buffer, four takes of its lock per round trip.
+              The stand-in yields the thread while its data is in the work
+              buffer, so that the other threads run into the held lock on
+              any number of cores: the phase must see waits on the lock, and
+              every round trip must still give back the state of its own
+              instance
+  - own     : the same with a work buffer per instance, no lock is taken
+  - runtime : Bsec2Runtime runs the instances from its workers for
+              --runtime-ms on the host clock, while the main thread holds the
+              output lock 2 ms out of every 3 as a logger flush would. The
+              workers must wait on it, no callback may run while another one
+              or the main thread holds the lock, and none after stop
+
+  The stand-in counts the gas samples in its state and builds the state in
+  the work buffer, so a state round trip mixed up with another instance
+  shows as a count that is not the number of outputs of the instance. Every
+  output must carry the temperature of the fake of its instance.
+
+  Usage: program [--sensors N] [--runs N] [--state-every N] [--runtime-ms N]
+    --sensors : Instances, up to 8, 4 by default
+  Exits with 1 on a wrong output, state, lock count, a phase without waits or a run error.
+*/
+
+#ifdef NODE_BENCH
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+
+#include "bsec2.h"
+#include "bsec2Runtime.h"
+#include "bsecStandin.h"
+
+#define CHECK_MAX_SENSORS BSEC2_RUNTIME_MAX_SENSORS
+#define CHECK_STATE_COUNT_OFFSET 4
+/* Takes of the shared work buffer lock per round trip: getState, setState, setConfig, getState */
+#define CHECK_TAKES_PER_ROUND_TRIP 4
+#define CHECK_FLUSH_HOLD_MS 2
+
+typedef struct
+{
+	FakeBme688 device;
+	Bsec2 bsec;
+	Bsec2ManualClock clock;
+	uint8_t workBuffer[BSEC_MAX_WORKBUFFER_SIZE];
+	float temperature;
+	uint32_t outputs;
+	uint32_t badOutputs;
+	uint32_t badStates;
+	uint32_t stateChecks;
+	uint32_t runErrors;
+} sensorCtx;
+
+/* Time of the host, continuing from where the manual clocks stopped */
+class HostClock : public Bsec2Clock
+{
+public:
+	HostClock(int64_t startMs) : startMs(startMs), origin(std::chrono::steady_clock::now())
+	{
+	}
+
+	int64_t getTimeMs(void)
+	{
+		return startMs +
+			   std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+private:
+	int64_t startMs;
+	std::chrono::steady_clock::time_point origin;
+};
+
+static sensorCtx sensors[CHECK_MAX_SENSORS];
+
+/* Callbacks running, and overlaps seen by them or by the main thread holding the output lock */
+static std::atomic<int> inCallback(0);
+static std::atomic<uint32_t> overlaps(0);
+/* Threads at the start line of a phase */
+static std::atomic<uint32_t> arrived(0);
+/* Configuration set in the round trips, the stand-in does not interpret it */
+static const uint8_t config[BSEC_MAX_PROPERTY_BLOB_SIZE] = {1, 2, 3, 4};
+
+static int8_t fakeRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	FakeBme688 *device = (FakeBme688 *)intfPtr;
+
+	device->receive(&regAddr, 1);
+	device->transmit(regData, length);
+
+	return BME68X_INTF_RET_SUCCESS;
+}
+
+static int8_t fakeWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	FakeBme688 *device = (FakeBme688 *)intfPtr;
+	uint8_t buffer[NATIVE_I2C_BUFFER_LENGTH];
+
+	if (length + 1 > sizeof(buffer))
+		return -1;
+
+	buffer[0] = regAddr;
+	memcpy(&buffer[1], regData, length);
+	device->receive(buffer, length + 1);
+
+	return BME68X_INTF_RET_SUCCESS;
+}
+
+/* The fakes answer at once, there is nothing to wait for */
+static void fakeDelayUs(uint32_t periodUs, void *intfPtr)
+{
+	(void)periodUs;
+	(void)intfPtr;
+}
+
+static void newData(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx)
+{
+	sensorCtx *ctx = (sensorCtx *)userCtx;
+	bool found = false;
+
+	(void)data;
+	(void)bsec;
+
+	if (inCallback.fetch_add(1) != 0)
+		overlaps++;
+
+	for (uint8_t i = 0; i < outputs.nOutputs; i++)
+	{
+		if (outputs.output[i].sensor_id != BSEC_OUTPUT_RAW_TEMPERATURE)
+			continue;
+		found = true;
+		if (fabsf(outputs.output[i].signal - ctx->temperature) > 0.05f)
+			ctx->badOutputs++;
+	}
+	if (!found)
+		ctx->badOutputs++;
+	ctx->outputs++;
+
+	inCallback--;
+}
+
+/* Lets the other threads run while a work buffer is in use */
+static void yieldInWorkBuffer(void *ctx)
+{
+	(void)ctx;
+
+	std::this_thread::yield();
+}
+
+/**
+ * @brief : Reads the state, sets it back, sets the configuration and reads the state again. The stand-in
+ *          keeps the gas sample count in the state
+ */
+static void checkState(sensorCtx &ctx)
+{
+	uint8_t state[BSEC_MAX_STATE_BLOB_SIZE], again[BSEC_MAX_STATE_BLOB_SIZE];
+	uint32_t cycles;
+
+	ctx.stateChecks++;
+	if (!ctx.bsec.getState(state) || !ctx.bsec.setState(state) || !ctx.bsec.setConfig(config) ||
+		!ctx.bsec.getState(again))
+	{
+		ctx.badStates++;
+		return;
+	}
+
+	memcpy(&cycles, &state[CHECK_STATE_COUNT_OFFSET], sizeof(cycles));
+	if (cycles != ctx.outputs || memcmp(state, again, sizeof(state)) != 0)
+		ctx.badStates++;
+}
+
+/**
+ * @brief : Runs an instance on its manual clock, one call per next_call
+ */
+static void runSensor(sensorCtx *ctx, uint32_t runs, uint32_t stateEvery, uint32_t nThreads)
+{
+	/* All together, so that the round trips of the threads overlap from the first run */
+	arrived++;
+	while (arrived < nThreads)
+		std::this_thread::yield();
+
+	for (uint32_t i = 0; i < runs; i++)
+	{
+		ctx->clock.advanceMs(ctx->bsec.getTimeToNextCallMs());
+		if (!ctx->bsec.run())
+			ctx->runErrors++;
+
+		if (stateEvery && (i % stateEvery == stateEvery - 1))
+			checkState(*ctx);
+
+		/* Interleave the threads even on a single core */
+		std::this_thread::yield();
+	}
+}
+
+/**
+ * @brief : Runs every instance on a thread of its own
+ * @return Semaphore takes of the phase
+ */
+static nativeSemaphoreStats runThreads(uint8_t nSensors, uint32_t runs, uint32_t stateEvery)
+{
+	nativeSemaphoreStats before = nativeGetSemaphoreStats(), after;
+	std::thread threads[CHECK_MAX_SENSORS];
+
+	arrived = 0;
+	bsecStandinSetWorkBufferHook(yieldInWorkBuffer, nullptr);
+	for (uint8_t i = 0; i < nSensors; i++)
+		threads[i] = std::thread(runSensor, &sensors[i], runs, stateEvery, (uint32_t)nSensors);
+	for (uint8_t i = 0; i < nSensors; i++)
+		threads[i].join();
+	bsecStandinSetWorkBufferHook(nullptr, nullptr);
+
+	after = nativeGetSemaphoreStats();
+	after.takes -= before.takes;
+	after.waits -= before.waits;
+	after.recursiveTakes -= before.recursiveTakes;
+	after.recursiveWaits -= before.recursiveWaits;
+
+	return after;
+}
+
+static uint32_t sum(uint8_t nSensors, uint32_t sensorCtx::*field)
+{
+	uint32_t total = 0;
+
+	for (uint8_t i = 0; i < nSensors; i++)
+		total += sensors[i].*field;
+
+	return total;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t nSensors = 4;
+	uint32_t runs = 2000;
+	uint32_t stateEvery = 1;
+	uint32_t runtimeMs = 3000;
+	bool ok = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--sensors") && i + 1 < argc)
+			nSensors = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+			runs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--state-every") && i + 1 < argc)
+			stateEvery = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--runtime-ms") && i + 1 < argc)
+			runtimeMs = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--sensors N] [--runs N] [--state-every N] [--runtime-ms N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (nSensors == 0 || nSensors > CHECK_MAX_SENSORS)
+		nSensors = CHECK_MAX_SENSORS;
+
+	bsecSensor sensorList[] = {BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_GAS, BSEC_OUTPUT_GAS_ESTIMATE_1,
+							   BSEC_OUTPUT_GAS_ESTIMATE_2};
+
+	for (uint8_t i = 0; i < nSensors; i++)
+	{
+		sensorCtx &ctx = sensors[i];
+		fakeBme688Sample sample = {20.0f + 2.5f * i, 101325.0f, 40.0f, {}};
+
+		for (uint8_t s = 0; s < FAKE_BME688_MAX_STEPS; s++)
+			sample.gasResistance[s] = 20000.0f * (i + 1);
+		ctx.device.setDefaultSample(sample);
+		ctx.temperature = sample.temperature;
+		ctx.bsec.setClock(ctx.clock);
+		if (!ctx.bsec.begin(BME68X_I2C_INTF, fakeRead, fakeWrite, fakeDelayUs, &ctx.device) ||
+			!ctx.bsec.updateSubscription(sensorList, ARRAY_LEN(sensorList), BSEC_SAMPLE_RATE_CONT))
+		{
+			printf("CHECK sensor %u setup failed, status %d\n", i, ctx.bsec.status);
+			return 1;
+		}
+		ctx.bsec.attachCallback(newData, &ctx);
+	}
+
+	/* Shared work buffer */
+	nativeSemaphoreStats shared = runThreads(nSensors, runs, stateEvery);
+	uint32_t sharedChecks = sum(nSensors, &sensorCtx::stateChecks);
+
+	uint32_t sharedBadStates = sum(nSensors, &sensorCtx::badStates);
+
+	printf("CHECK shared  %u threads x %u runs: outputs=%u state_round_trips=%u (expected > 0) bad_states=%u "
+		   "(expected 0) lock_takes=%u (expected %u) lock_waits=%u (expected > 0)\n",
+		   nSensors, runs, sum(nSensors, &sensorCtx::outputs), sharedChecks, sharedBadStates, shared.takes,
+		   CHECK_TAKES_PER_ROUND_TRIP * sharedChecks, shared.waits);
+	ok = ok && sharedChecks > 0 && sharedBadStates == 0 && shared.takes == CHECK_TAKES_PER_ROUND_TRIP * sharedChecks &&
+		 shared.waits > 0;
+
+	/* Own work buffers */
+	for (uint8_t i = 0; i < nSensors; i++)
+		sensors[i].bsec.setWorkBuffer(sensors[i].workBuffer);
+	nativeSemaphoreStats own = runThreads(nSensors, runs, stateEvery);
+
+	printf("CHECK own     %u threads x %u runs: state_round_trips=%u lock_takes=%u (expected 0)\n", nSensors, runs,
+		   sum(nSensors, &sensorCtx::stateChecks) - sharedChecks, own.takes);
+	ok = ok && own.takes == 0;
+
+	/* Runtime workers on the host clock */
+	int64_t lastMs = 0;
+	uint32_t before[CHECK_MAX_SENSORS];
+	uint32_t flushes = 0;
+	Bsec2Runtime runtime;
+
+	for (uint8_t i = 0; i < nSensors; i++)
+	{
+		if (sensors[i].clock.getTimeMs() > lastMs)
+			lastMs = sensors[i].clock.getTimeMs();
+		before[i] = sensors[i].outputs;
+	}
+	HostClock hostClock(lastMs);
+	for (uint8_t i = 0; i < nSensors; i++)
+	{
+		sensors[i].bsec.setClock(hostClock);
+		runtime.add(sensors[i].bsec, newData, &sensors[i]);
+	}
+
+	nativeSemaphoreStats start = nativeGetSemaphoreStats();
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(runtimeMs);
+
+	runtime.start();
+	while (std::chrono::steady_clock::now() < end)
+	{
+		runtime.lockOutputs();
+		if (inCallback != 0)
+			overlaps++;
+		flushes++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(CHECK_FLUSH_HOLD_MS));
+		runtime.unlockOutputs();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	runtime.stop();
+
+	nativeSemaphoreStats stop = nativeGetSemaphoreStats();
+	uint32_t runtimeOutputs = 0, runtimeErrors = 0, minOutputs = UINT32_MAX, stopped;
+
+	for (uint8_t i = 0; i < nSensors; i++)
+	{
+		uint32_t outputs = sensors[i].outputs - before[i];
+
+		runtimeOutputs += outputs;
+		runtimeErrors += runtime.getErrors(i);
+		if (outputs < minOutputs)
+			minOutputs = outputs;
+	}
+	stopped = sum(nSensors, &sensorCtx::outputs);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	uint32_t runtimeWaits = stop.recursiveWaits - start.recursiveWaits;
+
+	printf("CHECK runtime %u instances for %u ms: outputs=%u min_per_instance=%u (expected >= %u) errors=%u "
+		   "output_lock_takes=%u (expected %u) waits=%u (expected > 0) overlaps=%u after_stop=%u\n",
+		   nSensors, runtimeMs, runtimeOutputs, minOutputs, runtimeMs / 1000, runtimeErrors,
+		   stop.recursiveTakes - start.recursiveTakes, runtimeOutputs + flushes,
+		   runtimeWaits, (uint32_t)overlaps,
+		   sum(nSensors, &sensorCtx::outputs) - stopped);
+	ok = ok && minOutputs >= runtimeMs / 1000 && runtimeErrors == 0 &&
+		 stop.recursiveTakes - start.recursiveTakes == runtimeOutputs + flushes && runtimeWaits > 0 &&
+		 sum(nSensors, &sensorCtx::outputs) == stopped;
+
+	uint32_t badOutputs = sum(nSensors, &sensorCtx::badOutputs);
+	uint32_t badStates = sum(nSensors, &sensorCtx::badStates);
+	uint32_t runErrors = sum(nSensors, &sensorCtx::runErrors);
+
+	printf("CHECK bad_outputs=%u bad_states=%u run_errors=%u overlaps=%u\n", badOutputs, badStates, runErrors,
+		   (uint32_t)overlaps);
+	ok = ok && badOutputs == 0 && badStates == 0 && runErrors == 0 && overlaps == 0;
+
+	printf("CHECK %s\n", ok ? "passed" : "FAILED");
+
+	return ok ? 0 : 1;
+}
+
+#endif /* NODE_BENCH */
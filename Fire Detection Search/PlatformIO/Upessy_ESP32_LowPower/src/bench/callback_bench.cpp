@@ -0,0 +1,291 @@
+/*
+  Stack and cycles of the Bsec2 output callback, by value against by reference
+
+  Bsec2 hands its outputs either to a bsecCallback, which takes the sample,
+  the outputs and the Bsec2 instance by value, or to a bsecRefCallback,
+  which takes them by reference along with a user context. Both callbacks
+  do the same work, they read a few fields of what they are given:
+
+  - run  : Bsec2::run on a fake BME688 with the BSEC stand-in, in forced
+           mode at the continuous rate on a manual clock, the two forms
+           attached in turns. Reports the median cycles of the runs that
+           delivered outputs, and the stack from the caller of run to the
+           frame of the callback
+  - call : the call of the callback alone, through a function pointer with
+           the arguments of Bsec2::run. Reports the median cycles per call of
+           batches of --batch calls, and the stack from the caller to the
+           frame of the callback
+
+  Cycles come from the TSC on x86 hosts, and from micros() and F_CPU
+  elsewhere. The stack is the distance between frame addresses, the copies
+  of the by-value arguments are made in the frame of the caller.
+
+  Usage: program [--runs N] [--batches N] [--batch N]
+  Exits with 1 if a case misses its outputs or a run fails.
+*/
+
+#ifdef NODE_BENCH
+
+#include <stdlib.h>
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+
+#include "bsec2.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLE_SOURCE "tsc"
+static inline uint32_t benchCycles(void)
+{
+	return (uint32_t)__rdtsc();
+}
+#else
+#define BENCH_CYCLE_SOURCE "micros"
+static inline uint32_t benchCycles(void)
+{
+	return micros() * (F_CPU / 1000000);
+}
+#endif
+
+typedef struct
+{
+	/* Frame address of the caller of run, or of the callback */
+	uintptr_t top;
+	/* Largest distance from top to the frame of the callback */
+	uintptr_t maxDepth;
+	uint32_t calls;
+} benchStack;
+
+static benchStack stack;
+static volatile float sink;
+
+static FakeBme688 device;
+static Bsec2 benchBsec;
+static Bsec2ManualClock benchClock;
+
+static int8_t fakeRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	FakeBme688 *fake = (FakeBme688 *)intfPtr;
+
+	fake->receive(&regAddr, 1);
+	fake->transmit(regData, length);
+
+	return BME68X_INTF_RET_SUCCESS;
+}
+
+static int8_t fakeWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	FakeBme688 *fake = (FakeBme688 *)intfPtr;
+	uint8_t buffer[NATIVE_I2C_BUFFER_LENGTH];
+
+	if (length + 1 > sizeof(buffer))
+		return -1;
+
+	buffer[0] = regAddr;
+	memcpy(&buffer[1], regData, length);
+	fake->receive(buffer, length + 1);
+
+	return BME68X_INTF_RET_SUCCESS;
+}
+
+/* The fake answers at once, there is nothing to wait for */
+static void fakeDelayUs(uint32_t periodUs, void *intfPtr)
+{
+	(void)periodUs;
+	(void)intfPtr;
+}
+
+static inline void recordFrame(void)
+{
+	uintptr_t depth = stack.top - (uintptr_t)__builtin_frame_address(0);
+
+	if (depth > stack.maxDepth)
+		stack.maxDepth = depth;
+	stack.calls++;
+}
+
+static void __attribute__((noinline)) newDataValue(const bme68xData data, const bsecOutputs outputs, const Bsec2 bsec)
+{
+	recordFrame();
+	sink = data.temperature + outputs.output[0].signal + outputs.nOutputs + bsec.status;
+}
+
+static void __attribute__((noinline))
+newDataRef(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx)
+{
+	(void)userCtx;
+
+	recordFrame();
+	sink = data.temperature + outputs.output[0].signal + outputs.nOutputs + bsec.status;
+}
+
+/**
+ * @brief : One Bsec2::run at the next call time
+ * @return Cycles of the run, 0 when it failed
+ */
+static uint32_t __attribute__((noinline)) runOnce(void)
+{
+	uint32_t start;
+	bool ok;
+
+	benchClock.advanceMs(benchBsec.getTimeToNextCallMs());
+	stack.top = (uintptr_t)__builtin_frame_address(0);
+	start = benchCycles();
+	ok = benchBsec.run();
+
+	return ok ? benchCycles() - start : 0;
+}
+
+/* Kept out of reach of the optimizer, the calls go through the pointers as in Bsec2::run */
+static bsecCallback volatile valueCallback = newDataValue;
+static bsecRefCallback volatile refCallback = newDataRef;
+
+/* One caller per form, so that the frame of the reference caller holds no copies */
+static uint32_t __attribute__((noinline)) callValue(const bme68xData &data, const bsecOutputs &outputs, uint32_t batch)
+{
+	uint32_t start;
+
+	stack.top = (uintptr_t)__builtin_frame_address(0);
+	start = benchCycles();
+	for (uint32_t i = 0; i < batch; i++)
+		valueCallback(data, outputs, benchBsec);
+
+	return benchCycles() - start;
+}
+
+static uint32_t __attribute__((noinline)) callRef(const bme68xData &data, const bsecOutputs &outputs, uint32_t batch)
+{
+	uint32_t start;
+
+	stack.top = (uintptr_t)__builtin_frame_address(0);
+	start = benchCycles();
+	for (uint32_t i = 0; i < batch; i++)
+		refCallback(data, outputs, benchBsec, nullptr);
+
+	return benchCycles() - start;
+}
+
+static int compareCycles(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static uint32_t median(uint32_t *values, uint32_t count)
+{
+	if (count == 0)
+		return 0;
+	qsort(values, count, sizeof(*values), compareCycles);
+
+	return values[count / 2];
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t runs = 2000;
+	uint32_t batches = 101;
+	uint32_t batch = 10000;
+	bool ok = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+			runs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--batches") && i + 1 < argc)
+			batches = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--batch") && i + 1 < argc)
+			batch = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--runs N] [--batches N] [--batch N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (runs == 0)
+		runs = 1;
+	if (batches == 0)
+		batches = 1;
+	if (batch == 0)
+		batch = 1;
+
+	bsecSensor sensorList[] = {BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_GAS, BSEC_OUTPUT_GAS_ESTIMATE_1,
+							   BSEC_OUTPUT_GAS_ESTIMATE_2};
+
+	benchBsec.setClock(benchClock);
+	if (!benchBsec.begin(BME68X_I2C_INTF, fakeRead, fakeWrite, fakeDelayUs, &device) ||
+		!benchBsec.updateSubscription(sensorList, ARRAY_LEN(sensorList), BSEC_SAMPLE_RATE_CONT))
+	{
+		printf("BENCH setup failed, status %d\n", benchBsec.status);
+		return 1;
+	}
+
+	printf("BENCH sizeof bme68xData=%zu bsecOutputs=%zu Bsec2=%zu, cycles from %s\n", sizeof(bme68xData),
+		   sizeof(bsecOutputs), sizeof(Bsec2), BENCH_CYCLE_SOURCE);
+
+	/* Whole runs, the two forms take turns so that both see the same drift of the host */
+	uint32_t *runCycles[2] = {new uint32_t[runs], new uint32_t[runs]};
+	uint32_t delivered[2] = {0, 0}, failed = 0;
+	uintptr_t runDepth[2] = {0, 0};
+
+	for (uint32_t i = 0; i < 2 * runs; i++)
+	{
+		uint8_t ref = i & 1;
+		uint32_t cycles;
+
+		if (ref)
+			benchBsec.attachCallback(newDataRef);
+		else
+			benchBsec.attachCallback(newDataValue);
+
+		stack = {};
+		cycles = runOnce();
+		if (cycles == 0)
+			failed++;
+		else if (stack.calls)
+			runCycles[ref][delivered[ref]++] = cycles;
+		if (stack.maxDepth > runDepth[ref])
+			runDepth[ref] = stack.maxDepth;
+	}
+
+	/* The call alone, on a sample with one output */
+	uint32_t *callCycles = new uint32_t[batches];
+	bme68xData data = {};
+	bsecOutputs outputs = {};
+
+	data.temperature = 25.0f;
+	outputs.nOutputs = 1;
+	outputs.output[0].signal = 25.0f;
+
+	for (uint8_t ref = 0; ref < 2; ref++)
+	{
+		const char *name = ref ? "reference" : "value";
+
+		printf("BENCH run  %-9s runs=%u with_outputs=%u median=%u cycles stack=%u bytes\n", name, runs, delivered[ref],
+			   median(runCycles[ref], delivered[ref]), (unsigned)runDepth[ref]);
+		ok = ok && delivered[ref] > 0;
+
+		stack = {};
+		for (uint32_t i = 0; i < batches; i++)
+			callCycles[i] = ref ? callRef(data, outputs, batch) : callValue(data, outputs, batch);
+		printf("BENCH call %-9s calls=%u median=%.1f cycles per call stack=%u bytes\n", name, batches * batch,
+			   (double)median(callCycles, batches) / batch, (unsigned)stack.maxDepth);
+		ok = ok && stack.calls == batches * batch;
+	}
+	ok = ok && failed == 0;
+
+	delete[] runCycles[0];
+	delete[] runCycles[1];
+	delete[] callCycles;
+
+	if (!ok)
+	{
+		printf("BENCH check failed\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,299 @@
+/*
+  Deterministic check of the Bsec2 scheduling on a manual clock, on the host
+
+  Bsec2 reads its time from a Bsec2ManualClock and runs the BSEC stand-in
+  on a fake BME688 in forced mode, so every timestamp is known in advance:
+
+  - schedule : --runs calls, each one after getTimeToNextCallMs. Every call
+               must deliver outputs stamped with the time of the clock,
+               one sample period after the ones before, and leave a full
+               period until the next call. The runs from a quarter to half
+               of --runs are at the low power rate, the others continuous
+  - early    : calls before next_call, at random fractions of the time left,
+               deliver nothing and leave the rest of the time. A call late
+               by a random time delivers outputs stamped with the late time,
+               the next period counts from it
+  - copies   : a copy of an instance on the default clock reads its own
+               default clock after the original is gone, a copy of an
+               instance on the manual clock follows the manual clock
+
+  Usage: program [--runs N] [--seed N]
+  Exits with 1 on the first failure.
+*/
+
+#ifdef NODE_BENCH
+
+#include <new>
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+
+#include "bsec2.h"
+
+#define CHECK_START_MS 1000
+#define CHECK_CONT_PERIOD_MS 1000
+/* 1 / BSEC_SAMPLE_RATE_LP is a little over 3 s, getTimeToNextCallMs rounds it up */
+#define CHECK_LP_PERIOD_MS 3001
+
+typedef struct
+{
+	uint32_t deliveries;
+	int64_t lastStampNs;
+} outputLog;
+
+static FakeBme688 device;
+static Bsec2ManualClock manualClock(CHECK_START_MS);
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                               \
+	do                                                                                                                 \
+	{                                                                                                                  \
+		if (!(cond))                                                                                                   \
+		{                                                                                                              \
+			printf("CHECK failed: " __VA_ARGS__);                                                                      \
+			printf("\n");                                                                                              \
+			failures++;                                                                                                \
+		}                                                                                                              \
+	} while (0)
+
+static int8_t fakeRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	FakeBme688 *fake = (FakeBme688 *)intfPtr;
+
+	fake->receive(&regAddr, 1);
+	fake->transmit(regData, length);
+
+	return BME68X_INTF_RET_SUCCESS;
+}
+
+static int8_t fakeWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	FakeBme688 *fake = (FakeBme688 *)intfPtr;
+	uint8_t buffer[NATIVE_I2C_BUFFER_LENGTH];
+
+	if (length + 1 > sizeof(buffer))
+		return -1;
+
+	buffer[0] = regAddr;
+	memcpy(&buffer[1], regData, length);
+	fake->receive(buffer, length + 1);
+
+	return BME68X_INTF_RET_SUCCESS;
+}
+
+/* The fake answers at once, there is nothing to wait for */
+static void fakeDelayUs(uint32_t periodUs, void *intfPtr)
+{
+	(void)periodUs;
+	(void)intfPtr;
+}
+
+static void newData(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx)
+{
+	outputLog *log = (outputLog *)userCtx;
+
+	(void)data;
+	(void)bsec;
+
+	log->deliveries++;
+	log->lastStampNs = outputs.nOutputs ? outputs.output[0].time_stamp : -1;
+}
+
+static bool setRate(Bsec2 &bsec, float sampleRate)
+{
+	bsecSensor sensorList[] = {BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_GAS, BSEC_OUTPUT_GAS_ESTIMATE_1,
+							   BSEC_OUTPUT_GAS_ESTIMATE_2};
+
+	return bsec.updateSubscription(sensorList, ARRAY_LEN(sensorList), sampleRate);
+}
+
+/**
+ * @brief : Runs once at the clock time and checks that it delivers outputs of that time
+ */
+static bool runDue(Bsec2 &bsec, outputLog &log, int64_t periodMs, const char *phase, uint32_t run)
+{
+	uint32_t before = log.deliveries;
+	int64_t nowMs = manualClock.getTimeMs();
+
+	if (!bsec.run())
+	{
+		CHECK(false, "%s: run %u failed, status %d", phase, run, bsec.status);
+		return false;
+	}
+	if (log.deliveries != before + 1 || log.lastStampNs != nowMs * INT64_C(1000000))
+	{
+		CHECK(false, "%s: run %u at %lld ms delivered %u outputs stamped %lld ns", phase, run, (long long)nowMs,
+			  log.deliveries - before, (long long)log.lastStampNs);
+		return false;
+	}
+	if (bsec.getTimeToNextCallMs() != periodMs)
+	{
+		CHECK(false, "%s: run %u leaves %lld ms to the next call, expected %lld", phase, run,
+			  (long long)bsec.getTimeToNextCallMs(), (long long)periodMs);
+		return false;
+	}
+
+	return true;
+}
+
+static void checkSchedule(Bsec2 &bsec, outputLog &log, uint32_t runs)
+{
+	int64_t periodMs = CHECK_CONT_PERIOD_MS;
+	int64_t lastMs = -1;
+	uint32_t lowPowerRuns = 0;
+
+	for (uint32_t i = 0; i < runs; i++)
+	{
+		/* To low power and back, the new rate applies from the next call */
+		if (i == runs / 4 || i == runs / 2)
+		{
+			bool lowPower = (i == runs / 4);
+
+			/* BSEC refuses a second gas sample rate, the outputs are disabled first */
+			if (!setRate(bsec, BSEC_SAMPLE_RATE_DISABLED) ||
+				!setRate(bsec, lowPower ? BSEC_SAMPLE_RATE_LP : BSEC_SAMPLE_RATE_CONT))
+			{
+				CHECK(false, "schedule: rate change at run %u, status %d", i, bsec.status);
+				return;
+			}
+			periodMs = lowPower ? CHECK_LP_PERIOD_MS : CHECK_CONT_PERIOD_MS;
+		}
+
+		manualClock.advanceMs(bsec.getTimeToNextCallMs());
+		if (lastMs >= 0 && i != runs / 4 && i != runs / 2 &&
+			manualClock.getTimeMs() - lastMs != periodMs)
+		{
+			CHECK(false, "schedule: run %u %lld ms after the one before, expected %lld", i,
+				  (long long)(manualClock.getTimeMs() - lastMs), (long long)periodMs);
+			return;
+		}
+		lastMs = manualClock.getTimeMs();
+		lowPowerRuns += (periodMs == CHECK_LP_PERIOD_MS);
+
+		if (!runDue(bsec, log, periodMs, "schedule", i))
+			return;
+	}
+
+	printf("CHECK schedule: %u runs, %u at low power, outputs=%u, clock at %lld ms\n", runs, lowPowerRuns,
+		   log.deliveries, (long long)manualClock.getTimeMs());
+}
+
+static void checkEarly(Bsec2 &bsec, outputLog &log, uint32_t runs)
+{
+	uint32_t earlyCalls = 0;
+
+	for (uint32_t i = 0; i < runs; i++)
+	{
+		int64_t leftMs = bsec.getTimeToNextCallMs();
+		uint32_t before = log.deliveries;
+
+		/* Before next_call, nothing happens */
+		while (leftMs > 1)
+		{
+			int64_t stepMs = 1 + rand() % (leftMs - 1);
+
+			manualClock.advanceMs(stepMs);
+			earlyCalls++;
+			if (!bsec.run() || log.deliveries != before || bsec.getTimeToNextCallMs() != leftMs - stepMs)
+			{
+				CHECK(false, "early: call %lld ms before next_call delivered %u outputs, %lld ms left, expected %lld",
+					  (long long)(leftMs - stepMs), log.deliveries - before, (long long)bsec.getTimeToNextCallMs(),
+					  (long long)(leftMs - stepMs));
+				return;
+			}
+			leftMs -= stepMs;
+		}
+
+		/* Late, the outputs carry the time of the call */
+		manualClock.advanceMs(leftMs + rand() % CHECK_CONT_PERIOD_MS);
+		if (bsec.getTimeToNextCallMs() != 0)
+		{
+			CHECK(false, "early: %lld ms left after next_call", (long long)bsec.getTimeToNextCallMs());
+			return;
+		}
+		if (!runDue(bsec, log, CHECK_CONT_PERIOD_MS, "early", i))
+			return;
+	}
+
+	printf("CHECK early: %u calls before next_call delivered nothing, %u late calls on their own time\n", earlyCalls,
+		   runs);
+}
+
+static void checkCopies(void)
+{
+	/* The original lives in storage that is cleared once it is gone */
+	alignas(Bsec2) static uint8_t storage[sizeof(Bsec2)];
+	Bsec2 *original = new (storage) Bsec2();
+	Bsec2 defaultCopy(*original);
+	int64_t reference;
+
+	original->~Bsec2();
+	memset(storage, 0, sizeof(storage));
+	reference = Bsec2().getTimeMs();
+	CHECK(defaultCopy.getTimeMs() - reference <= 1 && reference - defaultCopy.getTimeMs() <= 1,
+		  "copies: copy on the default clock reads %lld ms, a new instance %lld ms",
+		  (long long)defaultCopy.getTimeMs(), (long long)reference);
+
+	Bsec2 manual;
+
+	manual.setClock(manualClock);
+	Bsec2 manualCopy(manual);
+
+	manualClock.advanceMs(1234);
+	CHECK(manualCopy.getTimeMs() == manualClock.getTimeMs(), "copies: copy on the manual clock reads %lld ms of %lld",
+		  (long long)manualCopy.getTimeMs(), (long long)manualClock.getTimeMs());
+
+	printf("CHECK copies: default clock of the copy, manual clock shared\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t runs = 4000;
+	uint32_t seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+			runs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--runs N] [--seed N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (runs < 4)
+		runs = 4;
+	srand(seed);
+
+	Bsec2 bsec;
+	outputLog log = {0, -1};
+
+	bsec.setClock(manualClock);
+	if (!bsec.begin(BME68X_I2C_INTF, fakeRead, fakeWrite, fakeDelayUs, &device) ||
+		!setRate(bsec, BSEC_SAMPLE_RATE_CONT))
+	{
+		printf("CHECK setup failed, status %d\n", bsec.status);
+		return 1;
+	}
+	bsec.attachCallback(newData, &log);
+
+	/* Nothing ran yet, the first call is due at once */
+	CHECK(bsec.getTimeToNextCallMs() == 0, "setup: %lld ms to the first call", (long long)bsec.getTimeToNextCallMs());
+
+	checkSchedule(bsec, log, runs);
+	checkEarly(bsec, log, runs / 4);
+	checkCopies();
+
+	if (failures)
+	{
+		printf("CHECK %u failures\n", failures);
+		return 1;
+	}
+	printf("CHECK passed\n");
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,339 @@
+/*
+  I2C expander traffic of the comm_mux chip select, on the host
+
+  Eight BME688 share the SPI bus, their chip selects are the outputs of an
+  I2C expander (the x8 board). A scheduler visits the sensors in turn, each
+  visit runs the register accesses of one of three workloads:
+
+  - idle     : none, as a run() pass before the next call of the sensor is due
+  - parallel : a parallel mode fetch, as sensorManager::collect_data does
+  - forced   : the configuration, trigger and fetch of a forced mode sample,
+               as Bsec2::run does in the low power modes
+
+  and the chip select is handled in one of two ways:
+
+  - per access   : comm_mux_read/write select and deselect around every
+                   register access, two expander writes each
+  - transaction  : the visit runs in comm_mux_begin/end_transaction, the
+                   chip select only restarts between accesses and moves
+                   when the scheduler moves to the next sensor. The
+                   expander is written at the first access of a visit only
+
+  The SPI shim has no device, so the driver talks to a fake BME688 on a
+  second native bus through an SPI register map (pages and read/write
+  bits), and each access is mirrored through comm_mux for the accounting. A fake
+  expander checks that every SPI frame got its own falling edge of the
+  chip select of the right sensor.
+
+  Usage: program [--visits N] [--i2c-hz N]
+  Exits with 1 if a frame ran without a falling edge of its chip select.
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+#include <SPI.h>
+#include <Wire.h>
+
+#include "bme68xLibrary.h"
+#include "bme68xTransport.h"
+#include "commMux/commMux.h"
+
+#define BENCH_BME688_ADDR 0x77
+#define BENCH_EXPANDER_ADDR 0x20
+#define BENCH_EXPANDER_OUTPUT_REG 0x01
+#define BENCH_NUM_SENSORS 8
+#define BENCH_DESELECT 0xFF
+#define BENCH_SPI_PAGE_REG 0x73
+
+/**
+ * @brief : Output register of the expander, follows the chip select windows
+ */
+class FakeExpander : public NativeI2cDevice
+{
+public:
+	FakeExpander() : level(BENCH_DESELECT), lastSelected(BENCH_DESELECT), frameAtFall(0), framesSelected(0), errors(0)
+	{
+	}
+
+	void receive(const uint8_t *data, size_t length)
+	{
+		/* Every data byte written to the output register is latched */
+		if ((length < 2) || (data[0] != BENCH_EXPANDER_OUTPUT_REG))
+			return;
+
+		for (size_t i = 1; i < length; i++)
+			latch(data[i]);
+	}
+
+	void transmit(uint8_t *data, size_t length)
+	{
+		memset(data, level, length);
+	}
+
+	/* Closes the window left open at the end of a run */
+	void flush(void)
+	{
+		latch(BENCH_DESELECT);
+	}
+
+	uint8_t level;
+	uint8_t lastSelected;
+	uint32_t frameAtFall;
+	uint32_t framesSelected;
+	uint32_t errors;
+
+private:
+	void latch(uint8_t value)
+	{
+		if (level != BENCH_DESELECT)
+		{
+			/* A falling edge starts one register access of the BME68x, not more */
+			uint32_t frames = SPI.transactions - frameAtFall;
+			if (frames > 1)
+				errors++;
+			framesSelected += frames;
+		}
+
+		level = value;
+		if (level != BENCH_DESELECT)
+		{
+			lastSelected = level;
+			frameAtFall = SPI.transactions;
+		}
+	}
+};
+
+typedef enum
+{
+	WORKLOAD_IDLE,
+	WORKLOAD_PARALLEL,
+	WORKLOAD_FORCED,
+	WORKLOAD_COUNT
+} benchWorkload;
+
+static const char *const workloadNames[WORKLOAD_COUNT] = {"idle", "parallel", "forced"};
+
+typedef struct
+{
+	Bme68xI2cTransport bus;
+	comm_mux *comm;
+	uint8_t page;
+	uint32_t frames;
+	uint32_t wrongSelect;
+} benchCtx;
+
+typedef struct
+{
+	uint32_t i2cTransactions;
+	uint32_t i2cBytes;
+	uint32_t frames;
+	double i2cUs;
+} benchResult;
+
+static FakeBme688 bme688;
+static TwoWire sensorBus;
+static FakeExpander expander;
+static comm_mux comm[BENCH_NUM_SENSORS];
+
+/**
+ * @brief : Address of the fake for an SPI register address in the current page
+ */
+static uint8_t mapReg(const benchCtx *ctx, uint8_t spiReg)
+{
+	spiReg &= BME68X_SPI_WR_MSK;
+
+	return (ctx->page & BME68X_MEM_PAGE_MSK) ? spiReg : (uint8_t)(spiReg | BME68X_SPI_RD_MSK);
+}
+
+/**
+ * @brief : Mirrors a register access through comm_mux and checks the chip select it got
+ */
+static void mirror(benchCtx *ctx, bool read, uint8_t regAddr, uint32_t length)
+{
+	uint8_t scratch[64] = {0};
+
+	if (read)
+		(void)comm_mux_read(regAddr, scratch, length < sizeof(scratch) ? length : sizeof(scratch), ctx->comm);
+	else
+		(void)comm_mux_write(regAddr, scratch, 0, ctx->comm);
+
+	if (expander.lastSelected != ctx->comm->select)
+		ctx->wrongSelect++;
+	ctx->frames++;
+}
+
+static int8_t benchRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	benchCtx *ctx = (benchCtx *)intfPtr;
+
+	mirror(ctx, true, regAddr, length);
+	if ((regAddr & BME68X_SPI_WR_MSK) == BENCH_SPI_PAGE_REG)
+	{
+		memset(regData, 0, length);
+		regData[0] = ctx->page;
+		return BME68X_OK;
+	}
+
+	return ctx->bus.read(mapReg(ctx, regAddr), regData, length);
+}
+
+static int8_t benchWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	benchCtx *ctx = (benchCtx *)intfPtr;
+	uint8_t data[BME68X_LEN_INTERLEAVE_BUFF];
+
+	mirror(ctx, false, regAddr, length);
+	if ((regAddr & BME68X_SPI_WR_MSK) == BENCH_SPI_PAGE_REG)
+	{
+		ctx->page = regData[0];
+		return BME68X_OK;
+	}
+
+	/* Burst writes interleave the register addresses with the data */
+	if (length > sizeof(data))
+		return BME68X_E_COM_FAIL;
+	for (uint32_t i = 0; i < length; i++)
+		data[i] = (i & 1) ? mapReg(ctx, regData[i]) : regData[i];
+
+	return ctx->bus.write(mapReg(ctx, regAddr), data, length);
+}
+
+static void benchDelayUs(uint32_t periodUs, void *intfPtr)
+{
+	(void)intfPtr;
+	delayMicroseconds(periodUs);
+}
+
+/**
+ * @brief : Register accesses of one visit
+ */
+static void visit(Bme68x &sensor, benchWorkload workload)
+{
+	switch (workload)
+	{
+	case WORKLOAD_FORCED:
+		sensor.setTPH();
+		sensor.setHeaterProf(320, 100);
+		sensor.setOpMode(BME68X_FORCED_MODE);
+		delay(100 + sensor.getMeasDur() / 1000);
+		(void)sensor.fetchData();
+		break;
+	case WORKLOAD_PARALLEL:
+		delay(140 / BENCH_NUM_SENSORS);
+		(void)sensor.fetchData();
+		break;
+	default:
+		delay(1);
+		break;
+	}
+}
+
+/**
+ * @brief : Visits the sensors in turn on a fresh driver, with or without transactions
+ */
+static benchResult runVisits(benchWorkload workload, bool transactions, uint32_t visits, uint32_t i2cHz)
+{
+	benchCtx ctx = {Bme68xI2cTransport(BENCH_BME688_ADDR, sensorBus), &comm[0], 0, 0, 0};
+	uint16_t temps[] = {320, 100, 100, 100, 200, 200, 200, 320, 320, 320};
+	uint16_t muls[] = {5, 2, 10, 30, 5, 5, 5, 5, 5, 5};
+	benchResult result = {0, 0, 0, 0};
+	Bme68x sensor;
+
+	sensor.begin(BME68X_SPI_INTF, benchRead, benchWrite, benchDelayUs, &ctx);
+	sensor.setTPH();
+	sensor.setHeaterProf(temps, muls, 140 - sensor.getMeasDur(BME68X_PARALLEL_MODE) / 1000, 10);
+	if (workload == WORKLOAD_PARALLEL)
+		sensor.setOpMode(BME68X_PARALLEL_MODE);
+
+	uint32_t startTransactions = Wire.transactions;
+	uint32_t startBytes = Wire.bytes;
+	uint32_t startFrames = ctx.frames;
+	for (uint32_t i = 0; i < visits; i++)
+	{
+		ctx.comm = &comm[i % BENCH_NUM_SENSORS];
+
+		if (transactions)
+			comm_mux_begin_transaction(*ctx.comm);
+		visit(sensor, workload);
+		if (transactions)
+			comm_mux_end_transaction(*ctx.comm);
+	}
+	expander.flush();
+
+	result.frames = ctx.frames - startFrames;
+	result.i2cTransactions = Wire.transactions - startTransactions;
+	result.i2cBytes = Wire.bytes - startBytes;
+	/* 9 clock cycles per byte, with the address byte of each transaction */
+	result.i2cUs = (double)(result.i2cBytes + result.i2cTransactions) * 9 * 1000000 / i2cHz;
+
+	if (ctx.wrongSelect)
+	{
+		printf("BENCH %u frames ran on another chip select\n", ctx.wrongSelect);
+		expander.errors += ctx.wrongSelect;
+	}
+
+	return result;
+}
+
+static void report(const char *name, const benchResult &result, uint32_t visits)
+{
+	printf("BENCH %-22s spi_frames=%.1f expander_transactions=%.1f expander_bytes=%.1f i2c_time=%.1f us per visit\n",
+		   name, (double)result.frames / visits, (double)result.i2cTransactions / visits,
+		   (double)result.i2cBytes / visits, result.i2cUs / visits);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t visits = 800;
+	uint32_t i2cHz = 400000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--visits") && i + 1 < argc)
+			visits = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--i2c-hz") && i + 1 < argc)
+			i2cHz = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--visits N] [--i2c-hz N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (visits == 0)
+		visits = 1;
+	if (i2cHz == 0)
+		i2cHz = 400000;
+
+	sensorBus.attach(BENCH_BME688_ADDR, bme688);
+	sensorBus.begin();
+	Wire.attach(BENCH_EXPANDER_ADDR, expander);
+	comm_mux_begin(Wire, SPI);
+	for (uint8_t i = 0; i < BENCH_NUM_SENSORS; i++)
+		comm[i] = comm_mux_set_config(Wire, SPI, i, comm[i]);
+
+	for (uint8_t workload = 0; workload < WORKLOAD_COUNT; workload++)
+	{
+		benchResult perAccess = runVisits((benchWorkload)workload, false, visits, i2cHz);
+		benchResult transaction = runVisits((benchWorkload)workload, true, visits, i2cHz);
+		char name[32];
+
+		snprintf(name, sizeof(name), "%s, per access", workloadNames[workload]);
+		report(name, perAccess, visits);
+		snprintf(name, sizeof(name), "%s, transaction", workloadNames[workload]);
+		report(name, transaction, visits);
+		printf("BENCH %s: expander I2C time saved=%.1f us per visit\n", workloadNames[workload],
+			   (perAccess.i2cUs - transaction.i2cUs) / visits);
+	}
+
+	if (expander.errors)
+	{
+		printf("BENCH %u chip select errors\n", expander.errors);
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,332 @@
+/*
+  Cost and accuracy of the BME68x compensation kernels, on the host and on the target
+
+  Runs the fixed-point and the float kernels of bme68x_comp.h, through
+  Bme68xCompensation, on the same raw readouts and reports for each
+  quantity the cycles per sample and the largest error against a
+  double-precision evaluation of the datasheet formulas. The calibration is
+  the one of FakeBme688. The readouts are drawn at random and kept when the
+  reference lies in the operating range of the sensor.
+
+  Cycles come from the CPU cycle counter on ESP32, from the TSC on x86
+  hosts, and from micros() and F_CPU elsewhere.
+
+  On the host: pio run -e native_bench_comp && .pio/build/native_bench_comp/program
+  On ESP32:    pio run -e upesy_wroom_bench_comp -t upload -t monitor
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+#include <math.h>
+
+#include "bme68xCompensation.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define BENCH_PRINTF(...) Serial.printf(__VA_ARGS__)
+#define BENCH_CYCLE_SOURCE "cpu"
+static inline uint32_t benchCycles(void)
+{
+	return ESP.getCycleCount();
+}
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_PRINTF(...) printf(__VA_ARGS__)
+#define BENCH_CYCLE_SOURCE "tsc"
+static inline uint32_t benchCycles(void)
+{
+	return (uint32_t)__rdtsc();
+}
+#else
+#define BENCH_PRINTF(...) printf(__VA_ARGS__)
+#define BENCH_CYCLE_SOURCE "micros"
+static inline uint32_t benchCycles(void)
+{
+	return micros() * (F_CPU / 1000000);
+}
+#endif
+
+#define BENCH_SAMPLES 256
+#define BENCH_ROUNDS 20
+
+static bme68x_calib_data calib;
+static bme68xRawSample raws[BENCH_SAMPLES];
+static volatile float sink;
+
+/**
+ * @brief : Calibration of FakeBme688
+ */
+static void loadCalib(void)
+{
+	memset(&calib, 0, sizeof(calib));
+	calib.par_t1 = 26041;
+	calib.par_t2 = 26130;
+	calib.par_t3 = 3;
+	calib.par_p1 = 36401;
+	calib.par_p2 = -10520;
+	calib.par_p3 = 88;
+	calib.par_p4 = 6421;
+	calib.par_p5 = -124;
+	calib.par_p6 = 30;
+	calib.par_p7 = 41;
+	calib.par_p8 = -3424;
+	calib.par_p9 = -2070;
+	calib.par_p10 = 30;
+	calib.par_h1 = 762;
+	calib.par_h2 = 1012;
+	calib.par_h3 = 0;
+	calib.par_h4 = 45;
+	calib.par_h5 = 20;
+	calib.par_h6 = 120;
+	calib.par_h7 = -100;
+	calib.par_gh1 = -35;
+	calib.par_gh2 = -12325;
+	calib.par_gh3 = 18;
+	calib.res_heat_val = 44;
+	calib.res_heat_range = 1;
+	calib.range_sw_err = 0;
+}
+
+/* Datasheet formulas in double precision */
+typedef struct
+{
+	double temperature;
+	double pressure;
+	double humidity;
+	double gasHigh;
+	double gasLow;
+} benchReference;
+
+static void reference(const bme68xRawSample &raw, benchReference &ref)
+{
+	double adcT = raw.tempAdc, adcP = raw.presAdc, adcH = raw.humAdc, adcG = raw.gasAdc;
+
+	double var1 = ((adcT / 16384.0) - (calib.par_t1 / 1024.0)) * calib.par_t2;
+	double var2 = ((adcT / 131072.0) - (calib.par_t1 / 8192.0)) * ((adcT / 131072.0) - (calib.par_t1 / 8192.0)) *
+				  (calib.par_t3 * 16.0);
+	double tFine = var1 + var2;
+	ref.temperature = tFine / 5120.0;
+
+	var1 = (tFine / 2.0) - 64000.0;
+	var2 = var1 * var1 * (calib.par_p6 / 131072.0);
+	var2 = var2 + (var1 * calib.par_p5 * 2.0);
+	var2 = (var2 / 4.0) + (calib.par_p4 * 65536.0);
+	var1 = (((calib.par_p3 * var1 * var1) / 16384.0) + (calib.par_p2 * var1)) / 524288.0;
+	var1 = (1.0 + (var1 / 32768.0)) * calib.par_p1;
+	double pres = 1048576.0 - adcP;
+	pres = ((pres - (var2 / 4096.0)) * 6250.0) / var1;
+	var1 = (calib.par_p9 * pres * pres) / 2147483648.0;
+	var2 = pres * (calib.par_p8 / 32768.0);
+	double var3 = (pres / 256.0) * (pres / 256.0) * (pres / 256.0) * (calib.par_p10 / 131072.0);
+	ref.pressure = pres + (var1 + var2 + var3 + (calib.par_p7 * 128.0)) / 16.0;
+
+	double temp = ref.temperature;
+	var1 = adcH - ((calib.par_h1 * 16.0) + ((calib.par_h3 / 2.0) * temp));
+	var2 = var1 * ((calib.par_h2 / 262144.0) *
+				   (1.0 + ((calib.par_h4 / 16384.0) * temp) + ((calib.par_h5 / 1048576.0) * temp * temp)));
+	var3 = calib.par_h6 / 16384.0;
+	double var4 = calib.par_h7 / 2097152.0;
+	ref.humidity = var2 + ((var3 + (var4 * temp)) * var2 * var2);
+
+	ref.gasHigh = 1000000.0 * (double)(262144UL >> raw.gasRange) / (4096.0 + 3.0 * (adcG - 512.0));
+
+	static const double k1[16] = {0, 0, 0, 0, 0, -1.0, 0, -0.8, 0, 0, -0.2, -0.5, 0, -1.0, 0, 0};
+	static const double k2[16] = {0, 0, 0, 0, 0.1, 0.7, 0, -0.8, -0.1, 0, 0, 0, 0, 0, 0, 0};
+	var1 = 1340.0 + 5.0 * calib.range_sw_err;
+	var2 = var1 * (1.0 + k1[raw.gasRange] / 100.0);
+	var3 = 1.0 + k2[raw.gasRange] / 100.0;
+	ref.gasLow = 1.0 / (var3 * 0.000000125 * (double)(1UL << raw.gasRange) * (((adcG - 512.0) / var2) + 1.0));
+}
+
+/**
+ * @brief : Draws raw readouts whose reference lies in the operating range, -40 to 85 degC,
+ *          300 to 1100 hPa and 1 to 99 %rH
+ */
+static void drawSamples(void)
+{
+	uint32_t state = 1;
+	uint32_t n = 0;
+	benchReference ref;
+
+	while (n < BENCH_SAMPLES)
+	{
+		bme68xRawSample raw;
+
+		/* xorshift32, the same readouts on every platform */
+		uint32_t r[4];
+		for (uint8_t i = 0; i < 4; i++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			r[i] = state;
+		}
+		raw.tempAdc = r[0] & 0xFFFFF;
+		raw.presAdc = r[1] & 0xFFFFF;
+		raw.humAdc = (uint16_t)r[2];
+		raw.gasAdc = (uint16_t)(r[3] & 0x3FF);
+		raw.gasRange = (uint8_t)((r[3] >> 10) & 0x0F);
+
+		reference(raw, ref);
+		if ((ref.temperature < -40.0) || (ref.temperature > 85.0) || (ref.pressure < 30000.0) ||
+			(ref.pressure > 110000.0) || (ref.humidity < 1.0) || (ref.humidity > 99.0))
+			continue;
+
+		raws[n++] = raw;
+	}
+}
+
+typedef struct
+{
+	float temperature;
+	float pressure;
+	float humidity;
+	float gasHigh;
+	float gasLow;
+	float all;
+} benchCost;
+
+typedef struct
+{
+	double temperature;
+	double pressure;
+	double humidity;
+	double gasHigh;
+	double gasLow;
+} benchError;
+
+/**
+ * @brief : Cycles per sample of each kernel, the best of BENCH_ROUNDS rounds over the readouts
+ */
+template <typename Kernel>
+static benchCost timeKernel(void)
+{
+	typedef Bme68xCompensation<Kernel> Comp;
+	static typename Kernel::TFine tFines[BENCH_SAMPLES];
+	uint32_t best[6] = {UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX};
+	float acc = 0;
+
+	for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		uint32_t t[7];
+
+		t[0] = benchCycles();
+		for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+			acc += Kernel::temperature(raws[i].tempAdc, calib, tFines[i]);
+		t[1] = benchCycles();
+		for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+			acc += Kernel::pressure(raws[i].presAdc, tFines[i], calib);
+		t[2] = benchCycles();
+		for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+			acc += Kernel::humidity(raws[i].humAdc, tFines[i], calib);
+		t[3] = benchCycles();
+		for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+			acc += Kernel::gasResistanceHigh(raws[i].gasAdc, raws[i].gasRange);
+		t[4] = benchCycles();
+		for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+			acc += Kernel::gasResistanceLow(raws[i].gasAdc, raws[i].gasRange, calib);
+		t[5] = benchCycles();
+		for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+		{
+			typename Comp::Sample out;
+			Comp::compensate(raws[i], calib, BME68X_VARIANT_GAS_HIGH, out);
+			acc += out.temperature + out.humidity;
+		}
+		t[6] = benchCycles();
+
+		for (uint8_t k = 0; k < 6; k++)
+			if (t[k + 1] - t[k] < best[k])
+				best[k] = t[k + 1] - t[k];
+	}
+	sink = acc;
+
+	benchCost cost = {(float)best[0] / BENCH_SAMPLES, (float)best[1] / BENCH_SAMPLES, (float)best[2] / BENCH_SAMPLES,
+					  (float)best[3] / BENCH_SAMPLES, (float)best[4] / BENCH_SAMPLES, (float)best[5] / BENCH_SAMPLES};
+
+	return cost;
+}
+
+/**
+ * @brief : Largest error against the reference, gas resistances as a relative error in percent
+ */
+template <typename Kernel>
+static benchError measureError(void)
+{
+	benchError err = {0, 0, 0, 0, 0};
+	benchReference ref;
+
+	for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+	{
+		typename Kernel::TFine tFine;
+
+		reference(raws[i], ref);
+		double temp = Kernel::celsius(Kernel::temperature(raws[i].tempAdc, calib, tFine));
+		double pres = Kernel::pressure(raws[i].presAdc, tFine, calib);
+		double hum = Kernel::percentRh(Kernel::humidity(raws[i].humAdc, tFine, calib));
+		double gasHigh = Kernel::gasResistanceHigh(raws[i].gasAdc, raws[i].gasRange);
+		double gasLow = Kernel::gasResistanceLow(raws[i].gasAdc, raws[i].gasRange, calib);
+
+		err.temperature = fmax(err.temperature, fabs(temp - ref.temperature));
+		err.pressure = fmax(err.pressure, fabs(pres - ref.pressure));
+		err.humidity = fmax(err.humidity, fabs(hum - ref.humidity));
+		err.gasHigh = fmax(err.gasHigh, 100.0 * fabs(gasHigh - ref.gasHigh) / ref.gasHigh);
+		err.gasLow = fmax(err.gasLow, 100.0 * fabs(gasLow - ref.gasLow) / ref.gasLow);
+	}
+
+	return err;
+}
+
+template <typename Kernel>
+static void report(const char *name)
+{
+	benchCost cost = timeKernel<Kernel>();
+	benchError err = measureError<Kernel>();
+
+	BENCH_PRINTF("BENCH %-5s temperature  %8.1f cycles/sample  max_err=%.4f degC\n", name, cost.temperature,
+				 err.temperature);
+	BENCH_PRINTF("BENCH %-5s pressure     %8.1f cycles/sample  max_err=%.3f Pa\n", name, cost.pressure, err.pressure);
+	BENCH_PRINTF("BENCH %-5s humidity     %8.1f cycles/sample  max_err=%.4f %%rH\n", name, cost.humidity,
+				 err.humidity);
+	BENCH_PRINTF("BENCH %-5s gas (high)   %8.1f cycles/sample  max_err=%.5f %%\n", name, cost.gasHigh, err.gasHigh);
+	BENCH_PRINTF("BENCH %-5s gas (low)    %8.1f cycles/sample  max_err=%.5f %%\n", name, cost.gasLow, err.gasLow);
+	BENCH_PRINTF("BENCH %-5s full field   %8.1f cycles/sample\n", name, cost.all);
+}
+
+static void runBench(void)
+{
+	loadCalib();
+	drawSamples();
+
+	BENCH_PRINTF("BENCH %u readouts, best of %u rounds, %s cycles\n", BENCH_SAMPLES, BENCH_ROUNDS,
+				 BENCH_CYCLE_SOURCE);
+	report<Bme68xFixedPoint>("fixed");
+	report<Bme68xFloat>("float");
+#ifdef BME68X_COMP_FLOAT
+	BENCH_PRINTF("BENCH the driver of this build uses the float kernels\n");
+#else
+	BENCH_PRINTF("BENCH the driver of this build uses the fixed-point kernels\n");
+#endif
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void setup()
+{
+	Serial.begin(115200);
+	delay(1000);
+	runBench();
+}
+
+void loop()
+{
+	delay(1000);
+}
+#else
+int main(void)
+{
+	runBench();
+
+	return 0;
+}
+#endif
+
+#endif /* NODE_BENCH */
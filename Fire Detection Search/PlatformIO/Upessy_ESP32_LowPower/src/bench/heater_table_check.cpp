@@ -0,0 +1,292 @@
+/*
+  Check of the BME68x heater resistance table and gas wait encoding, on the host
+
+  The driver serves the res_heat register values from a table of the
+  calibration data, each entry computed on the first use of its heater
+  temperature, and encodes gas_wait without a loop. This program loads
+  calibration sets into Bme68xMockTransport, programs every heater
+  temperature at every ambient temperature through setHeaterProf, and
+  compares the registers the driver wrote with the formulas the driver used
+  before, copied below. The integer or float formula is checked, as the
+  driver is built to use one or the other, see BME68X_COMP_FLOAT.
+
+  It also reports the cost of the table: the time of begin(), the entries
+  filled by begin() and by the 10 step scan profile, and the time a build of
+  the whole table would add to every begin(), e.g. every deep sleep wake up.
+
+  Usage: program [--calib-sets N] [--seed N]
+  Exits with 1 on the first mismatch.
+*/
+
+#ifdef NODE_BENCH
+
+#include <chrono>
+
+#include <Arduino.h>
+
+#include "bme68xT.h"
+
+class CheckSensor : public Bme68xT<Bme68xMockTransport>
+{
+public:
+	const bme68x_dev &dev(void)
+	{
+		return bme6;
+	}
+};
+
+#ifndef BME68X_COMP_FLOAT
+/* calc_res_heat of bme68x.c in integer */
+static uint8_t refResHeat(uint16_t temp, const bme68x_dev *dev)
+{
+	int32_t var1, var2, var3, var4, var5, heatr_res_x100;
+
+	if (temp > 400)
+		temp = 400;
+
+	var1 = (((int32_t)dev->amb_temp * dev->calib.par_gh3) / 1000) * 256;
+	var2 = (dev->calib.par_gh1 + 784) * (((((dev->calib.par_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
+	var3 = var1 + (var2 / 2);
+	var4 = (var3 / (dev->calib.res_heat_range + 4));
+	var5 = (131 * dev->calib.res_heat_val) + 65536;
+	heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
+
+	return (uint8_t)((heatr_res_x100 + 50) / 100);
+}
+#else
+/* calc_res_heat of bme68x.c in float */
+static uint8_t refResHeat(uint16_t temp, const bme68x_dev *dev)
+{
+	float var1, var2, var3, var4, var5;
+
+	if (temp > 400)
+		temp = 400;
+
+	var1 = (((float)dev->calib.par_gh1 / (16.0f)) + 49.0f);
+	var2 = ((((float)dev->calib.par_gh2 / (32768.0f)) * (0.0005f)) + 0.00235f);
+	var3 = ((float)dev->calib.par_gh3 / (1024.0f));
+	var4 = (var1 * (1.0f + (var2 * (float)temp)));
+	var5 = (var4 + (var3 * (float)dev->amb_temp));
+
+	return (uint8_t)(3.4f * ((var5 * (4 / (4 + (float)dev->calib.res_heat_range)) *
+							  (1 / (1 + ((float)dev->calib.res_heat_val * 0.002f)))) -
+							 25));
+}
+#endif
+
+/* calc_gas_wait of bme68x.c, with its loop */
+static uint8_t refGasWait(uint16_t dur)
+{
+	uint8_t factor = 0;
+
+	if (dur >= 0xfc0)
+		return 0xff;
+
+	while (dur > 0x3F)
+	{
+		dur = dur / 4;
+		factor += 1;
+	}
+
+	return (uint8_t)(dur + (factor * 64));
+}
+
+static uint32_t rngState = 1;
+
+/**
+ * @brief : xorshift32, the same sequence on every host for a given seed
+ */
+static uint8_t nextByte(void)
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+
+	return (uint8_t)rngState;
+}
+
+/**
+ * @brief : Fills the calibration registers of the mock, the first sets are the extreme values
+ */
+static void loadCalib(Bme68xMockTransport &mock, uint32_t set)
+{
+	static const uint8_t fixed[] = {0x00, 0xFF, 0x80, 0x7F};
+
+	for (uint8_t i = 0; i < BME68X_LEN_COEFF1; i++)
+		mock.regs[BME68X_REG_COEFF1 + i] = (set < sizeof(fixed)) ? fixed[set] : nextByte();
+	for (uint8_t i = 0; i < BME68X_LEN_COEFF2; i++)
+		mock.regs[BME68X_REG_COEFF2 + i] = (set < sizeof(fixed)) ? fixed[set] : nextByte();
+	for (uint8_t i = 0; i < BME68X_LEN_COEFF3; i++)
+		mock.regs[BME68X_REG_COEFF3 + i] = (set < sizeof(fixed)) ? fixed[set] : nextByte();
+}
+
+/**
+ * @brief : Checks every heater temperature at every ambient temperature for one calibration set
+ * @return Number of checked set-points, 0 on a mismatch
+ */
+static uint32_t checkResHeat(uint32_t set)
+{
+	CheckSensor sensor;
+	Bme68xMockTransport &mock = sensor.getTransport();
+	uint32_t checked = 0;
+
+	loadCalib(mock, set);
+	sensor.begin();
+
+	for (int amb = INT8_MIN; amb <= INT8_MAX; amb++)
+	{
+		sensor.setAmbientTemp((int8_t)amb);
+
+		/* Past the 400 degC cap as well */
+		for (uint32_t temp = 0; temp <= 450; temp++)
+		{
+			sensor.setHeaterProf((uint16_t)temp, 100);
+			uint8_t expected = refResHeat((uint16_t)temp, &sensor.dev());
+			if ((sensor.status != BME68X_OK) || (mock.regs[BME68X_REG_RES_HEAT0] != expected))
+			{
+				printf("CHECK res_heat mismatch set=%u gh1=%d gh2=%d gh3=%d range=%u val=%d amb=%d temp=%u "
+					   "table=0x%02X formula=0x%02X status=%d\n",
+					   set, sensor.dev().calib.par_gh1, sensor.dev().calib.par_gh2, sensor.dev().calib.par_gh3,
+					   sensor.dev().calib.res_heat_range, sensor.dev().calib.res_heat_val, amb, temp,
+					   mock.regs[BME68X_REG_RES_HEAT0], expected, sensor.status);
+				return 0;
+			}
+			checked++;
+		}
+	}
+
+	return checked;
+}
+
+/**
+ * @brief : Checks the gas wait encoding of every duration
+ * @return Number of checked durations, 0 on a mismatch
+ */
+static uint32_t checkGasWait(void)
+{
+	CheckSensor sensor;
+	Bme68xMockTransport &mock = sensor.getTransport();
+	uint32_t checked = 0;
+
+	sensor.begin();
+	for (uint32_t dur = 0; dur <= UINT16_MAX; dur++)
+	{
+		sensor.setHeaterProf(300, (uint16_t)dur);
+		if (mock.regs[BME68X_REG_GAS_WAIT0] != refGasWait((uint16_t)dur))
+		{
+			printf("CHECK gas_wait mismatch dur=%u driver=0x%02X formula=0x%02X\n", dur,
+				   mock.regs[BME68X_REG_GAS_WAIT0], refGasWait((uint16_t)dur));
+			return 0;
+		}
+		checked++;
+	}
+
+	return checked;
+}
+
+/**
+ * @brief : Number of res_heat table entries computed so far
+ */
+static uint32_t countFilled(const bme68x_dev &dev)
+{
+	uint32_t filled = 0;
+
+	for (uint16_t temp = 0; temp <= BME68X_MAX_HEATR_TEMP; temp++)
+		filled += (dev.res_heat_filled[temp / 8] >> (temp % 8)) & 1;
+
+	return filled;
+}
+
+/**
+ * @brief : Time of the formula and of the table for one heater step, and cost of the table
+ */
+static void timeResHeat(void)
+{
+	CheckSensor sensor;
+	const uint32_t rounds = 1000;
+	const uint32_t begins = 10000;
+	uint16_t scanTemps[] = {320, 100, 100, 100, 200, 200, 200, 320, 320, 320};
+	uint16_t scanMuls[] = {5, 2, 10, 30, 5, 5, 5, 5, 5, 5};
+	uint32_t checksum = 0;
+
+	loadCalib(sensor.getTransport(), sizeof(uint32_t));
+	auto beginStart = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < begins; i++)
+		sensor.begin();
+	auto beginEnd = std::chrono::steady_clock::now();
+	const bme68x_dev &dev = sensor.dev();
+
+	uint32_t filledAtBegin = countFilled(dev);
+	sensor.setHeaterProf(scanTemps, scanMuls, 140, sizeof(scanTemps) / sizeof(scanTemps[0]));
+	uint32_t filledByScan = countFilled(dev);
+	/* The lookups below read filled entries only */
+	for (uint16_t temp = 0; temp <= BME68X_MAX_HEATR_TEMP; temp++)
+		sensor.setHeaterProf(temp, 100);
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t r = 0; r < rounds; r++)
+		for (uint16_t temp = 0; temp <= BME68X_MAX_HEATR_TEMP; temp++)
+			checksum += refResHeat(temp, &dev);
+	auto mid = std::chrono::steady_clock::now();
+	for (uint32_t r = 0; r < rounds; r++)
+		for (uint16_t temp = 0; temp <= BME68X_MAX_HEATR_TEMP; temp++)
+			checksum += dev.res_heat_table[temp];
+	auto end = std::chrono::steady_clock::now();
+
+	double steps = (double)rounds * BME68X_LEN_RES_HEAT_TABLE;
+	double formulaNs = std::chrono::duration<double, std::nano>(mid - start).count() / steps;
+	printf("CHECK res_heat per step: formula=%.2f ns table=%.2f ns (checksum %u)\n", formulaNs,
+		   std::chrono::duration<double, std::nano>(end - mid).count() / steps, checksum);
+	printf("CHECK res_heat table: begin=%.2f us on the mock, entries filled by begin=%u by the scan profile=%u, "
+		   "a full build would add %.2f us to each begin (%u formula steps), %u bytes per device\n",
+		   std::chrono::duration<double, std::micro>(beginEnd - beginStart).count() / begins, filledAtBegin,
+		   filledByScan, formulaNs * BME68X_LEN_RES_HEAT_TABLE / 1000.0, (unsigned)BME68X_LEN_RES_HEAT_TABLE,
+		   (unsigned)(sizeof(dev.res_heat_table) + sizeof(dev.res_heat_filled)));
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t calibSets = 64;
+	uint32_t seed = 1;
+	uint64_t checked = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--calib-sets") && i + 1 < argc)
+			calibSets = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--calib-sets N] [--seed N]\n", argv[0]);
+			return 1;
+		}
+	}
+	rngState = seed ? seed : 1;
+
+	for (uint32_t set = 0; set < calibSets; set++)
+	{
+		uint32_t n = checkResHeat(set);
+		if (n == 0)
+			return 1;
+		checked += n;
+	}
+
+	uint32_t durations = checkGasWait();
+	if (durations == 0)
+		return 1;
+
+#ifdef BME68X_COMP_FLOAT
+	const char *variant = "float";
+#else
+	const char *variant = "integer";
+#endif
+	printf("CHECK %s res_heat: %llu set-points over %u calibration sets match\n", variant,
+		   (unsigned long long)checked, calibSets);
+	printf("CHECK gas_wait: %u durations match\n", durations);
+	timeResHeat();
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,287 @@
+/*
+  Wear and power loss check of the BSEC state journal, on the host
+
+  Runs StateJournal on SimulatedFlash with the geometry of the "bsecstate"
+  partition, 4 sectors of 4 kB by default, and a payload of the size of the
+  BSEC state blob:
+
+  - wear     : --saves saves of random blobs, one in --repeat-every identical
+               to the previous one. The journal is mounted again every
+               --remount-every saves, as after a reset, and must load the
+               newest blob. Reports the erase count of every sector, their
+               maximum and mean, and the erases per save
+  - torn     : --torn saves cut by a power loss after a random number of
+               bytes, the last byte partly programmed. A journal mounted
+               afterwards must load the blob saved before, then take a new
+               save and load it. One cut in three falls on the first slot of
+               a sector, just after its erase
+
+  Usage: program [--saves N] [--torn N] [--sectors N] [--sector-size N] [--blob-size N]
+                 [--remount-every N] [--repeat-every N] [--seed N]
+  Exits with 1 on the first wrong load, failed save or NOR write violation.
+*/
+
+#ifdef NODE_BENCH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "state_journal.h"
+
+/* BSEC_MAX_STATE_BLOB_SIZE of BSEC 2 */
+#define CHECK_BLOB_SIZE 221
+
+/* Flash that loses power in the middle of a write */
+class TornFlash : public JournalFlash
+{
+public:
+	TornFlash(SimulatedFlash &flash) : tearAfter(-1), afterErase(false), torn(false), flash(flash), erased(false)
+	{
+	}
+
+	uint32_t sectorSize()
+	{
+		return flash.sectorSize();
+	}
+
+	uint32_t sectorCount()
+	{
+		return flash.sectorCount();
+	}
+
+	bool read(uint32_t offset, void *data, size_t length)
+	{
+		return flash.read(offset, data, length);
+	}
+
+	/* Writes the first tearAfter bytes and a partly programmed next one, then fails */
+	bool write(uint32_t offset, const void *data, size_t length)
+	{
+		bool cut = tearAfter >= 0 && (size_t)tearAfter < length && (!afterErase || erased);
+		uint8_t partial;
+
+		erased = false;
+		if (!cut)
+			return flash.write(offset, data, length);
+
+		if (tearAfter > 0 && !flash.write(offset, data, tearAfter))
+			return false;
+
+		/* Only some of the bits to clear made it */
+		partial = ((const uint8_t *)data)[tearAfter] | (uint8_t)rand();
+		flash.write(offset + tearAfter, &partial, 1);
+		tearAfter = -1;
+		torn = true;
+		return false;
+	}
+
+	bool eraseSector(uint32_t sector)
+	{
+		erased = true;
+		return flash.eraseSector(sector);
+	}
+
+	/* Bytes written before the power loss, -1 for none */
+	int32_t tearAfter;
+	/* Only cut the first write after an erase */
+	bool afterErase;
+	/* A write was cut */
+	bool torn;
+
+private:
+	SimulatedFlash &flash;
+	bool erased;
+};
+
+static void fillBlob(uint8_t *blob, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+		blob[i] = (uint8_t)rand();
+}
+
+/**
+ * @brief : Mounts a new journal on the flash, as after a reset, and compares its newest blob
+ */
+static bool loadMatches(JournalFlash &flash, size_t blobSize, const uint8_t *expected)
+{
+	StateJournal journal(flash, blobSize);
+	uint8_t loaded[JOURNAL_MAX_PAYLOAD];
+	size_t length = 0;
+
+	return journal.load(loaded, sizeof(loaded), length) && length == blobSize &&
+		   memcmp(loaded, expected, blobSize) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t saves = 100000;
+	uint32_t tornSaves = 2000;
+	uint32_t sectors = 4;
+	uint32_t sectorSize = 4096;
+	uint32_t blobSize = CHECK_BLOB_SIZE;
+	uint32_t remountEvery = 97;
+	uint32_t repeatEvery = 8;
+	uint32_t seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--saves") && i + 1 < argc)
+			saves = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--torn") && i + 1 < argc)
+			tornSaves = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--sectors") && i + 1 < argc)
+			sectors = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--sector-size") && i + 1 < argc)
+			sectorSize = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--blob-size") && i + 1 < argc)
+			blobSize = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--remount-every") && i + 1 < argc)
+			remountEvery = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--repeat-every") && i + 1 < argc)
+			repeatEvery = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr,
+					"Usage: %s [--saves N] [--torn N] [--sectors N] [--sector-size N] [--blob-size N]\n"
+					"          [--remount-every N] [--repeat-every N] [--seed N]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+	if (sectors < 2)
+		sectors = 2;
+	if (blobSize == 0 || blobSize > JOURNAL_MAX_PAYLOAD)
+		blobSize = CHECK_BLOB_SIZE;
+	if (sectorSize < sizeof(journalRecordHeader) + blobSize)
+		sectorSize = sizeof(journalRecordHeader) + blobSize;
+	if (remountEvery == 0)
+		remountEvery = 1;
+	srand(seed);
+
+	uint8_t blob[JOURNAL_MAX_PAYLOAD];
+	uint32_t skipped = 0;
+
+	/* Wear */
+	SimulatedFlash wearFlash(sectorSize, sectors);
+	StateJournal *journal = new StateJournal(wearFlash, blobSize);
+
+	fillBlob(blob, blobSize);
+	for (uint32_t i = 0; i < saves; i++)
+	{
+		if (repeatEvery == 0 || i % repeatEvery != repeatEvery - 1)
+			fillBlob(blob, blobSize);
+
+		if (!journal->save(blob, blobSize))
+		{
+			printf("CHECK wear: save %u failed\n", i);
+			return 1;
+		}
+
+		if (i % remountEvery == remountEvery - 1)
+		{
+			skipped += journal->skippedWrites;
+			delete journal;
+			if (!loadMatches(wearFlash, blobSize, blob))
+			{
+				printf("CHECK wear: save %u not loaded after a remount\n", i);
+				return 1;
+			}
+			journal = new StateJournal(wearFlash, blobSize);
+		}
+	}
+	skipped += journal->skippedWrites;
+	delete journal;
+
+	uint64_t totalErases = 0;
+
+	printf("CHECK wear: %u saves of %u bytes, %u skipped as unchanged, %u sectors of %u bytes\n", saves, blobSize,
+		   skipped, sectors, sectorSize);
+	printf("CHECK wear: erases per sector");
+	for (uint32_t s = 0; s < sectors; s++)
+	{
+		printf(" %u", wearFlash.eraseCount(s));
+		totalErases += wearFlash.eraseCount(s);
+	}
+	printf("\nCHECK wear: max=%u mean=%.1f erases per written save=%.4f violations=%u\n", wearFlash.maxEraseCount(),
+		   (double)totalErases / sectors, saves > skipped ? (double)totalErases / (saves - skipped) : 0.0,
+		   wearFlash.violations);
+	if (wearFlash.violations)
+		return 1;
+
+	/* Torn writes */
+	SimulatedFlash tornFlash(sectorSize, sectors);
+	TornFlash flash(tornFlash);
+	uint32_t recordSize = sizeof(journalRecordHeader) + blobSize;
+	uint32_t sectorStarts = 0;
+	uint8_t previous[JOURNAL_MAX_PAYLOAD];
+
+	fillBlob(previous, blobSize);
+	{
+		StateJournal first(flash, blobSize);
+
+		if (!first.save(previous, blobSize))
+		{
+			printf("CHECK torn: first save failed\n");
+			return 1;
+		}
+	}
+
+	for (uint32_t i = 0; i < tornSaves; i++)
+	{
+		StateJournal cut(flash, blobSize);
+		int32_t tearAfter = rand() % recordSize;
+
+		flash.tearAfter = tearAfter;
+		flash.afterErase = (i % 3 == 0);
+		flash.torn = false;
+		sectorStarts += flash.afterErase;
+
+		/* Save until the power loss, the saves before it go through */
+		for (;;)
+		{
+			fillBlob(blob, blobSize);
+			if (cut.save(blob, blobSize))
+				memcpy(previous, blob, blobSize);
+			else if (flash.torn)
+				break;
+			else
+			{
+				printf("CHECK torn: save failed\n");
+				return 1;
+			}
+		}
+
+		if (!loadMatches(flash, blobSize, previous))
+		{
+			printf("CHECK torn: save %u cut after %d bytes, the blob saved before is lost\n", i, tearAfter);
+			return 1;
+		}
+
+		/* The journal goes on after the torn slot */
+		{
+			StateJournal next(flash, blobSize);
+
+			fillBlob(previous, blobSize);
+			if (!next.save(previous, blobSize) || !loadMatches(flash, blobSize, previous))
+			{
+				printf("CHECK torn: save after the cut of save %u not loaded\n", i);
+				return 1;
+			}
+		}
+	}
+
+	if (tornFlash.violations)
+	{
+		printf("CHECK torn: %u writes over programmed bits\n", tornFlash.violations);
+		return 1;
+	}
+	printf("CHECK torn: %u cut saves, %u at the start of a sector, all recovered the blob saved before\n", tornSaves,
+		   sectorStarts);
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
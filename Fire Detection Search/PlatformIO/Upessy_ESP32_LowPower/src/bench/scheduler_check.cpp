@@ -0,0 +1,281 @@
+/*
+  Check of the sensor manager scheduler against a linear scan, on the host
+
+  The sensorScheduler of the bme68x_demo_sample keeps the sensors in one
+  min-heap per operation mode. The reference scans all the sensors on every
+  call, as the sensor manager did before the heaps. Both see the same random
+  steps, at 8 sensors as on the board and at 40:
+
+  - read     : the sensor scheduled is read, it gets a new wake up time of a
+               heater profile, now and then another mode
+  - change   : a random sensor gets a random mode, configured flag and wake
+               up time, on a 10 ms grid so that wake up times tie
+  - advance  : the time moves on by up to 200 ms
+  - restart  : rarely, the scheduler is cleared and every sensor queued again
+
+  Every step compares what both schedule: whether a sensor is due, the wake
+  up time they return, and the sensor. Among sensors of a queue waking up at
+  the same time, the heap may pick another one than the scan, it must be in
+  the same queue with the same wake up time.
+
+  Usage: program [--steps N] [--seed N]
+  Exits with 1 on the first failure.
+*/
+
+#ifdef NODE_BENCH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sensor_scheduler.h"
+
+/* The operation modes of the BME68x driver */
+#define CHECK_SLEEP_MODE 0
+#define CHECK_FORCED_MODE 1
+#define CHECK_PARALLEL_MODE 2
+#define CHECK_SEQUENTIAL_MODE 3
+
+#define CHECK_MAX_SENSORS 40
+
+typedef struct
+{
+	uint8_t mode;
+	bool isConfigured;
+	uint64_t wakeUpTime;
+} checkSensor;
+
+typedef struct
+{
+	uint32_t dueParallel;
+	uint32_t dueSleep;
+	uint32_t lookahead;
+	uint32_t idle;
+	uint32_t ties;
+} checkCounts;
+
+static checkSensor sensors[CHECK_MAX_SENSORS];
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                               \
+	do                                                                                                                 \
+	{                                                                                                                  \
+		if (!(cond))                                                                                                   \
+		{                                                                                                              \
+			printf("CHECK failed: " __VA_ARGS__);                                                                      \
+			printf("\n");                                                                                              \
+			failures++;                                                                                                \
+		}                                                                                                              \
+	} while (0)
+
+/* The queue of a sensor, as get_queue of the sensor manager */
+static uint8_t queueOf(const checkSensor &sensor)
+{
+	if (!sensor.isConfigured)
+		return SCHEDULER_NOT_QUEUED;
+
+	switch (sensor.mode)
+	{
+	case CHECK_PARALLEL_MODE:
+		return SCHEDULER_QUEUE_PARALLEL;
+	case CHECK_SLEEP_MODE:
+		return SCHEDULER_QUEUE_SLEEP;
+	default:
+		return SCHEDULER_NOT_QUEUED;
+	}
+}
+
+/**
+ * @brief : The linear scan, the earliest configured sensor of a mode
+ */
+static bool scanMode(uint8_t count, uint8_t mode, uint8_t &num, uint64_t &wakeUpTime)
+{
+	num = SCHEDULER_NOT_QUEUED;
+	wakeUpTime = UINT64_MAX;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (sensors[i].isConfigured && sensors[i].mode == mode && sensors[i].wakeUpTime < wakeUpTime)
+		{
+			wakeUpTime = sensors[i].wakeUpTime;
+			num = i;
+		}
+	}
+
+	return num != SCHEDULER_NOT_QUEUED;
+}
+
+/**
+ * @brief : The reference, the policy of sensorScheduler::schedule on the linear scan
+ */
+static bool scanSchedule(uint8_t count, uint64_t timeStamp, uint8_t &num, uint64_t &wakeUpTime)
+{
+	uint8_t parallelNum, sleepNum;
+	uint64_t parallelTime, sleepTime;
+
+	wakeUpTime = UINT64_MAX;
+
+	if (scanMode(count, CHECK_PARALLEL_MODE, parallelNum, parallelTime))
+	{
+		wakeUpTime = parallelTime;
+		if (parallelTime <= timeStamp)
+		{
+			num = parallelNum;
+			return true;
+		}
+		if (parallelTime < timeStamp + SCHEDULER_LOOKAHEAD_MS)
+			return false;
+	}
+
+	if (scanMode(count, CHECK_SLEEP_MODE, sleepNum, sleepTime))
+	{
+		if (sleepTime <= timeStamp)
+		{
+			num = sleepNum;
+			return true;
+		}
+		if (sleepTime < wakeUpTime)
+			wakeUpTime = sleepTime;
+	}
+
+	return false;
+}
+
+static uint32_t randomBelow(uint32_t bound)
+{
+	return (uint32_t)rand() % bound;
+}
+
+/* A wake up time on the 10 ms grid, from a little in the past to 5 s ahead */
+static uint64_t randomWakeUpTime(uint64_t timeStamp)
+{
+	return (timeStamp - timeStamp % 10) + 10 * (uint64_t)randomBelow(510) - 100;
+}
+
+/* The periods of the heater profiles of the demo, 140 ms time base, 1 s and 3 s rates */
+static uint64_t randomPeriod(void)
+{
+	static const uint64_t periods[] = {0, 140, 280, 1000, 3000};
+
+	return periods[randomBelow(sizeof(periods) / sizeof(periods[0]))];
+}
+
+template <uint8_t numSensors>
+static void checkSize(uint32_t steps)
+{
+	static sensorScheduler<numSensors> scheduler;
+	checkCounts counts = {};
+	uint64_t timeStamp = 1000;
+
+	scheduler.clear();
+	memset(sensors, 0, sizeof(sensors));
+
+	for (uint32_t step = 0; step < steps; step++)
+	{
+		uint32_t action = randomBelow(100);
+
+		if (action < 40)
+		{
+			uint8_t heapNum = SCHEDULER_NOT_QUEUED, scanNum = SCHEDULER_NOT_QUEUED;
+			uint64_t heapTime, scanTime;
+			bool heapDue = scheduler.schedule(timeStamp, heapNum, heapTime);
+			bool scanDue = scanSchedule(numSensors, timeStamp, scanNum, scanTime);
+
+			if (heapDue != scanDue || heapTime != scanTime)
+			{
+				CHECK(false, "%u sensors, step %u at %llu ms: heap due=%d wake up %llu ms, scan due=%d wake up %llu ms",
+					  numSensors, step, (unsigned long long)timeStamp, heapDue, (unsigned long long)heapTime, scanDue,
+					  (unsigned long long)scanTime);
+				return;
+			}
+
+			if (!heapDue)
+			{
+				if (heapTime < timeStamp + SCHEDULER_LOOKAHEAD_MS)
+					counts.lookahead++;
+				else
+					counts.idle++;
+				continue;
+			}
+
+			if (heapNum >= numSensors || queueOf(sensors[heapNum]) != queueOf(sensors[scanNum]) ||
+				sensors[heapNum].wakeUpTime != sensors[scanNum].wakeUpTime)
+			{
+				CHECK(false, "%u sensors, step %u at %llu ms: heap scheduled sensor %u, scan sensor %u", numSensors,
+					  step, (unsigned long long)timeStamp, heapNum, scanNum);
+				return;
+			}
+			counts.ties += (heapNum != scanNum);
+			if (queueOf(sensors[heapNum]) == SCHEDULER_QUEUE_PARALLEL)
+				counts.dueParallel++;
+			else
+				counts.dueSleep++;
+
+			/* Read, then the next step of the heater profile, or another mode */
+			checkSensor &sensor = sensors[heapNum];
+
+			sensor.wakeUpTime = timeStamp + randomPeriod();
+			if (randomBelow(50) == 0)
+				sensor.mode = (uint8_t)randomBelow(4);
+			scheduler.queue(heapNum, queueOf(sensor), sensor.wakeUpTime);
+		}
+		else if (action < 60)
+		{
+			uint8_t num = (uint8_t)randomBelow(numSensors);
+			checkSensor &sensor = sensors[num];
+
+			sensor.mode = (uint8_t)randomBelow(4);
+			sensor.isConfigured = randomBelow(8) != 0;
+			sensor.wakeUpTime = randomWakeUpTime(timeStamp);
+			scheduler.queue(num, queueOf(sensor), sensor.wakeUpTime);
+		}
+		else if (action < 99 || randomBelow(1000) != 0)
+		{
+			timeStamp += randomBelow(201);
+		}
+		else
+		{
+			scheduler.clear();
+			for (uint8_t num = 0; num < numSensors; num++)
+				scheduler.queue(num, queueOf(sensors[num]), sensors[num].wakeUpTime);
+		}
+	}
+
+	printf("CHECK %u sensors: %u steps, due parallel=%u sleep=%u ties=%u, not due with a parallel read within "
+		   "the lookahead=%u, later=%u\n",
+		   numSensors, steps, counts.dueParallel, counts.dueSleep, counts.ties, counts.lookahead, counts.idle);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t steps = 2000000;
+	uint32_t seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--steps") && i + 1 < argc)
+			steps = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--steps N] [--seed N]\n", argv[0]);
+			return 1;
+		}
+	}
+	srand(seed);
+
+	checkSize<8>(steps);
+	checkSize<CHECK_MAX_SENSORS>(steps);
+
+	if (failures)
+	{
+		printf("CHECK %u failures\n", failures);
+		return 1;
+	}
+	printf("CHECK passed\n");
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
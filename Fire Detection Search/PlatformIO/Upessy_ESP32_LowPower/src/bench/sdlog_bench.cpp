@@ -0,0 +1,615 @@
+/*
+  Sustained records per second of the SD raw data log and the BSEC output
+  log, on the host
+
+  Writes raw data records (raw_data_format.h, 44 bytes each) behind the
+  header and JSON text of a log file, to the SdFat shim whose card model
+  sleeps for every block command, in two ways:
+
+  - reopen : the dataloggers before the SD log task, each flush opens the
+             file with O_AT_END, appends the records buffered since the
+             last flush and closes the file
+  - task   : sdLogWriter, the file is preallocated and stays open, the
+             records go through two buffers written by a FreeRTOS task and
+             the file is cut at its size by the task after end
+
+  Then writes BSEC outputs as the dataBlock rows of an .aipredictions file
+  (ai_prediction_format.h, about 150 bytes each):
+
+  - aiopen : write_bsec_output before the SD log task, each output opens
+             the file, seeks back over the closing brackets, prints the row
+             field by field, prints the closing brackets and closes the file
+  - aitask : the row is formatted in one buffer and written to a
+             sdLogWriter that syncs every buffer, end adds the closing
+             brackets
+
+  The producer writes records as fast as the log takes them. The sustained
+  rate is taken after the first tenth of the records, past the setup. The
+  reopen pattern flushes every --flush-every records, the demo flushes on
+  every loop, one or a few records each at the BSEC sample rates.
+  --start-mb makes the text of the reopen file that long, as later in a
+  file: the open walks the cluster chain to the end of the file.
+
+  The latency of each write of the producer is given in percentiles, and
+  for the task runs the latency of the card writes of the task as well,
+  from the histogram of sdLogWriter. The raw data files are read back and
+  compared with the records written, the two .aipredictions files must be
+  the same. The end of a file and the begin of the next one, as at the
+  size limit of the datalogger, are timed as well: end returns at once,
+  the begin waits for the close.
+
+  Usage: program [--records N] [--outputs N] [--flush-every N] [--start-mb N] [--prealloc-mb N]
+                 [--dir PATH] [--command-us N] [--sector-us N] [--program-us N]
+  Exits with 1 if a file does not hold the data written.
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ai_prediction_format.h"
+#include "raw_data_format.h"
+#include "sdLog/sdLogWriter.h"
+
+#define BENCH_TEXT_SIZE 4096
+#define BENCH_RECORD_LEN (RAW_DATA_RECORD_SIZE + 1)
+
+typedef struct
+{
+	double setupMs;
+	double sustained;
+	std::vector<double> writeMs;
+	/* Time the caller spent in end, and until the file was closed */
+	double endMs;
+	double closeMs;
+	uint32_t stalls;
+	/* Card writes of the task, 50th, 90th, 99th percentile and max in microseconds */
+	uint32_t cardUs[4];
+	nativeSdStats stats;
+} benchResult;
+
+typedef std::chrono::steady_clock benchClock;
+
+static double elapsedMs(benchClock::time_point from, benchClock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+/**
+ * @brief : Record of sample i, as a 8 sensor board logs them
+ */
+static uint8_t encodeRecord(uint32_t i, uint8_t *buff)
+{
+	raw_data_record record = {};
+
+	record.present = RAW_DATA_HAS_NUM | RAW_DATA_HAS_SENSOR_ID | RAW_DATA_HAS_DATA | RAW_DATA_HAS_SCAN_CYCLE;
+	record.sensor_num = (uint8_t)(i % 8);
+	record.sensor_id = 0x5A000000u + record.sensor_num;
+	record.time_since_power_on = i * 140 / 8;
+	record.rtc = 1700000000u + i / 8 * 140 / 1000;
+	record.temperature = 21.5f + (float)(i % 100) * 0.01f;
+	record.pressure = 1013.25f - (float)(i % 50) * 0.1f;
+	record.humidity = 40.0f + (float)(i % 30) * 0.5f;
+	record.gas_resistance = 10000.0f * (float)(1 + i % 10);
+	record.gas_index = (uint8_t)(i / 8 % 10);
+	record.scan_cycle_index = i / 80;
+	record.label = 0;
+	record.code = 0;
+
+	return raw_data_encode_record(record, buff);
+}
+
+/**
+ * @brief : Header and text in front of the records, the text is a run of tabs.
+ *          The header is written with no text, the caller patches in the one it returns
+ */
+static void writeHead(Print &out, uint32_t textLen, uint8_t *header)
+{
+	raw_data_header head = {RAW_DATA_KIND_BME68X, 0};
+	std::vector<uint8_t> text(4096, '\t');
+
+	raw_data_encode_header(head, header);
+	out.write(header, RAW_DATA_HEADER_SIZE);
+	head.text_len = textLen;
+	raw_data_encode_header(head, header);
+	for (uint32_t left = textLen; left;)
+	{
+		uint32_t chunk = (left < text.size()) ? left : (uint32_t)text.size();
+		out.write(text.data(), chunk);
+		left -= chunk;
+	}
+}
+
+/**
+ * @brief : Appends the records through the old reopen on every flush pattern
+ */
+static benchResult runReopen(const char *path, uint32_t records, uint32_t flushEvery, uint32_t textLen,
+							 const nativeSdTiming &timing)
+{
+	benchResult result = {};
+	nativeSdTiming freeCard = {0, 0, 0};
+	uint8_t header[RAW_DATA_HEADER_SIZE];
+	std::string pending;
+	File logFile;
+
+	/* The file is set up on a free card, a long text stands for the records of earlier flushes */
+	nativeSdSetTiming(freeCard);
+	if (!logFile.open(path, O_RDWR | O_CREAT | O_TRUNC))
+	{
+		printf("BENCH cannot create %s\n", path);
+		return result;
+	}
+	writeHead(logFile, textLen, header);
+	logFile.seek(0);
+	logFile.write(header, sizeof(header));
+	logFile.close();
+	nativeSdSetTiming(timing);
+	nativeSdResetStats();
+
+	uint32_t warm = records / 10;
+	benchClock::time_point warmAt = benchClock::now();
+	for (uint32_t i = 0; i < records; i++)
+	{
+		uint8_t buff[BENCH_RECORD_LEN];
+		benchClock::time_point start = benchClock::now();
+
+		if (i == warm)
+			warmAt = start;
+		pending.append((const char *)buff, encodeRecord(i, buff));
+
+		if ((i + 1) % flushEvery == 0 || i + 1 == records)
+		{
+			if (logFile.open(path, O_RDWR | O_AT_END))
+			{
+				logFile.write((const uint8_t *)pending.data(), pending.size());
+				logFile.close();
+			}
+			pending.clear();
+		}
+
+		result.writeMs.push_back(elapsedMs(start, benchClock::now()));
+	}
+	result.sustained = (records - warm) / (elapsedMs(warmAt, benchClock::now()) / 1000.0);
+	result.stats = nativeSdGetStats();
+
+	return result;
+}
+
+/**
+ * @brief : Card write latency of the task and card operations of the run
+ */
+static void getCardLatency(benchResult &result)
+{
+	const uint8_t percents[4] = {50, 90, 99, 100};
+
+	for (uint8_t i = 0; i < 4; i++)
+		result.cardUs[i] = sdLogWriter::getWriteLatencyUs(percents[i]);
+	result.stats = nativeSdGetStats();
+}
+
+/**
+ * @brief : Writes the records through sdLogWriter
+ */
+static benchResult runTask(const char *path, uint32_t records, uint32_t preallocSize, const nativeSdTiming &timing)
+{
+	static sdLogWriter writer;
+	benchResult result = {};
+	uint8_t header[RAW_DATA_HEADER_SIZE];
+
+	nativeSdSetTiming(timing);
+	nativeSdResetStats();
+	sdLogWriter::resetWriteLatency();
+
+	/* As the dataloggers create their files, the header is completed once the text is written */
+	benchClock::time_point setupAt = benchClock::now();
+	if (!writer.begin(path, preallocSize))
+	{
+		printf("BENCH sdLogWriter begin failed\n");
+		return result;
+	}
+	writeHead(writer, BENCH_TEXT_SIZE, header);
+	(void)writer.patch(0, header, sizeof(header));
+	result.setupMs = elapsedMs(setupAt, benchClock::now());
+
+	uint32_t warm = records / 10;
+	benchClock::time_point warmAt = benchClock::now();
+	for (uint32_t i = 0; i < records; i++)
+	{
+		uint8_t buff[BENCH_RECORD_LEN];
+		benchClock::time_point start = benchClock::now();
+
+		if (i == warm)
+			warmAt = start;
+		writer.write(buff, encodeRecord(i, buff));
+
+		result.writeMs.push_back(elapsedMs(start, benchClock::now()));
+	}
+	result.sustained = (records - warm) / (elapsedMs(warmAt, benchClock::now()) / 1000.0);
+
+	benchClock::time_point closeAt = benchClock::now();
+	bool ended = writer.end();
+	result.endMs = elapsedMs(closeAt, benchClock::now());
+	if (!writer.waitClosed() || !ended)
+		printf("BENCH sdLogWriter had %u errors\n", writer.getErrors());
+	result.closeMs = elapsedMs(closeAt, benchClock::now());
+	result.stalls = writer.getStalls();
+	getCardLatency(result);
+
+	return result;
+}
+
+/**
+ * @brief : BSEC output i of a 4 sensor board with 4 class estimates and IAQ
+ */
+static ai_prediction_row makeRow(uint32_t i)
+{
+	ai_prediction_row row = {};
+
+	row.sensor_num = (uint8_t)(i % 4);
+	row.sensor_id = 0x5A000000u + row.sensor_num;
+	row.start_time_since_power_on = i / 4 * 14000;
+	row.end_time_since_power_on = row.start_time_since_power_on + 13860;
+	for (uint8_t t = 0; t < AI_PREDICTION_TARGETS; t++)
+		row.prediction[t] = (float)((i + t) % 100) / (t + 1.0f);
+	row.has_predictions = true;
+	row.prediction_accuracy = (uint8_t)(i % 256);
+	row.iaq = (i % 7) ? 25.0f + (float)(i % 400) * 0.5f : NAN;
+	row.iaq_accuracy = (i % 7) ? (uint8_t)(i % 4) : AI_PREDICTION_NO_ACCURACY;
+	row.code = (i % 50) ? 0 : -2;
+	row.ground_truth = (uint16_t)(1001 + i / 100 % 3);
+
+	return row;
+}
+
+static void printNumber(Print &out, float value)
+{
+	isnan(value) ? out.print("null") : out.print(value);
+}
+
+/**
+ * @brief : Appends the BSEC outputs as write_bsec_output did before the SD log task
+ */
+static benchResult runAiOpen(const char *path, uint32_t outputs, const nativeSdTiming &timing)
+{
+	benchResult result = {};
+	nativeSdTiming freeCard = {0, 0, 0};
+	std::vector<uint8_t> text(BENCH_TEXT_SIZE, '\t');
+	uint32_t dataPos;
+	File logFile;
+
+	nativeSdSetTiming(freeCard);
+	if (!logFile.open(path, O_RDWR | O_CREAT | O_TRUNC))
+	{
+		printf("BENCH cannot create %s\n", path);
+		return result;
+	}
+	logFile.write(text.data(), text.size());
+	dataPos = logFile.position();
+	logFile.print(AI_PREDICTION_NO_ROWS_END);
+	logFile.close();
+	nativeSdSetTiming(timing);
+	nativeSdResetStats();
+
+	uint32_t warm = outputs / 10;
+	benchClock::time_point warmAt = benchClock::now();
+	for (uint32_t i = 0; i < outputs; i++)
+	{
+		ai_prediction_row row = makeRow(i);
+		benchClock::time_point start = benchClock::now();
+
+		if (i == warm)
+			warmAt = start;
+		if (logFile.open(path, O_RDWR | O_AT_END))
+		{
+			logFile.seek(dataPos);
+			if (i)
+				logFile.println(",");
+			logFile.print("\t\t\t[\n\t\t\t\t");
+			logFile.print(row.sensor_num);
+			logFile.print(",\n\t\t\t\t");
+			logFile.print((unsigned long)row.sensor_id);
+			logFile.print(",\n\t\t\t\t");
+			logFile.print((unsigned long)row.start_time_since_power_on);
+			logFile.print(",\n\t\t\t\t");
+			logFile.print((unsigned long)row.end_time_since_power_on);
+			logFile.print(",\n\t\t\t\t");
+			for (uint8_t t = 0; t < AI_PREDICTION_TARGETS; t++)
+			{
+				printNumber(logFile, row.prediction[t]);
+				logFile.print(",\n\t\t\t\t");
+			}
+			logFile.print(row.prediction_accuracy);
+			logFile.print(",\n\t\t\t\t");
+			printNumber(logFile, row.iaq);
+			logFile.print(",\n\t\t\t\t");
+			(row.iaq_accuracy != AI_PREDICTION_NO_ACCURACY) ? logFile.print(row.iaq_accuracy) : logFile.print("null");
+			logFile.print(",\n\t\t\t\t");
+			logFile.print((long)row.code);
+			logFile.print(",\n\t\t\t\t");
+			logFile.println(row.ground_truth);
+			logFile.print("\t\t\t]");
+			dataPos = logFile.position();
+			logFile.print(AI_PREDICTION_ROWS_END);
+			logFile.close();
+		}
+		result.writeMs.push_back(elapsedMs(start, benchClock::now()));
+	}
+	result.sustained = (outputs - warm) / (elapsedMs(warmAt, benchClock::now()) / 1000.0);
+	result.stats = nativeSdGetStats();
+
+	return result;
+}
+
+/**
+ * @brief : Writes the BSEC outputs as write_bsec_output does, one formatted row per write
+ */
+static benchResult runAiTask(const char *path, uint32_t outputs, const nativeSdTiming &timing)
+{
+	static sdLogWriter writer;
+	static char rowBuff[AI_PREDICTION_ROW_MAX];
+	benchResult result = {};
+	std::vector<uint8_t> text(BENCH_TEXT_SIZE, '\t');
+
+	nativeSdSetTiming(timing);
+	nativeSdResetStats();
+	sdLogWriter::resetWriteLatency();
+
+	benchClock::time_point setupAt = benchClock::now();
+	if (!writer.begin(path, 0, 1))
+	{
+		printf("BENCH sdLogWriter begin failed\n");
+		return result;
+	}
+	writer.write(text.data(), text.size());
+	result.setupMs = elapsedMs(setupAt, benchClock::now());
+
+	uint32_t warm = outputs / 10;
+	benchClock::time_point warmAt = benchClock::now();
+	for (uint32_t i = 0; i < outputs; i++)
+	{
+		ai_prediction_row row = makeRow(i);
+		benchClock::time_point start = benchClock::now();
+
+		if (i == warm)
+			warmAt = start;
+		writer.write((const uint8_t *)rowBuff, ai_prediction_format_row(row, i == 0, rowBuff));
+		result.writeMs.push_back(elapsedMs(start, benchClock::now()));
+	}
+	result.sustained = (outputs - warm) / (elapsedMs(warmAt, benchClock::now()) / 1000.0);
+
+	benchClock::time_point closeAt = benchClock::now();
+	writer.print(outputs ? AI_PREDICTION_ROWS_END : AI_PREDICTION_NO_ROWS_END);
+	bool ended = writer.end();
+	result.endMs = elapsedMs(closeAt, benchClock::now());
+	if (!writer.waitClosed() || !ended)
+		printf("BENCH sdLogWriter had %u errors\n", writer.getErrors());
+	result.closeMs = elapsedMs(closeAt, benchClock::now());
+	result.stalls = writer.getStalls();
+	getCardLatency(result);
+
+	return result;
+}
+
+/**
+ * @brief : Checks that a file holds the header, the text and the records, and nothing after them
+ */
+static bool checkFile(const char *path, uint32_t records)
+{
+	FILE *in = fopen(path, "rb");
+	uint8_t buff[BENCH_RECORD_LEN];
+	uint8_t expected[BENCH_RECORD_LEN];
+	raw_data_header header;
+	bool ok = false;
+
+	if (in == nullptr)
+		return false;
+
+	if ((fread(buff, 1, RAW_DATA_HEADER_SIZE, in) == RAW_DATA_HEADER_SIZE) && raw_data_decode_header(buff, header) &&
+		(fseek(in, header.text_len, SEEK_CUR) == 0))
+	{
+		ok = true;
+		for (uint32_t i = 0; ok && i < records; i++)
+		{
+			uint8_t len = encodeRecord(i, expected);
+			ok = (fread(buff, 1, len, in) == len) && !memcmp(buff, expected, len);
+		}
+		ok = ok && (fgetc(in) == EOF);
+	}
+	fclose(in);
+
+	return ok;
+}
+
+/**
+ * @brief : Ends a file and begins the next one at once, as the datalogger does at its size limit. The begin
+ *          waits for the close of the file ended before
+ */
+static bool runRollover(const char *path1, const char *path2, uint32_t records, uint32_t preallocSize,
+						const nativeSdTiming &timing, double &endMs, double &beginMs)
+{
+	static sdLogWriter writer;
+	const char *paths[2] = {path1, path2};
+	uint8_t header[RAW_DATA_HEADER_SIZE];
+	bool ok = true;
+
+	nativeSdSetTiming(timing);
+	for (uint8_t f = 0; f < 2; f++)
+	{
+		benchClock::time_point beginAt = benchClock::now();
+
+		if (!writer.begin(paths[f], preallocSize))
+			return false;
+		if (f == 1)
+			beginMs = elapsedMs(beginAt, benchClock::now());
+		writeHead(writer, BENCH_TEXT_SIZE, header);
+		(void)writer.patch(0, header, sizeof(header));
+		for (uint32_t i = 0; i < records; i++)
+		{
+			uint8_t buff[BENCH_RECORD_LEN];
+
+			writer.write(buff, encodeRecord(i, buff));
+		}
+
+		benchClock::time_point endAt = benchClock::now();
+		ok = writer.end() && ok;
+		if (f == 0)
+			endMs = elapsedMs(endAt, benchClock::now());
+	}
+	ok = writer.waitClosed() && ok;
+
+	return ok && checkFile(path1, records) && checkFile(path2, records);
+}
+
+/**
+ * @brief : Percentile of the write latencies of the producer, nearest rank
+ */
+static double percentile(std::vector<double> sorted, uint8_t percent)
+{
+	if (sorted.empty())
+		return 0.0;
+	std::sort(sorted.begin(), sorted.end());
+	size_t rank = (sorted.size() * percent + 99) / 100;
+	return sorted[rank ? rank - 1 : 0];
+}
+
+/**
+ * @brief : Checks that two files hold the same bytes
+ */
+static bool sameFiles(const char *path1, const char *path2)
+{
+	FILE *in1 = fopen(path1, "rb");
+	FILE *in2 = fopen(path2, "rb");
+	bool same = (in1 != nullptr) && (in2 != nullptr);
+
+	while (same)
+	{
+		int c = fgetc(in1);
+
+		same = (c == fgetc(in2));
+		if (c == EOF)
+			break;
+	}
+	if (in1)
+		fclose(in1);
+	if (in2)
+		fclose(in2);
+
+	return same;
+}
+
+static void report(const char *name, const benchResult &result, uint32_t records)
+{
+	printf("BENCH %-6s sustained=%.0f records/s setup=%.1f ms end=%.1f ms close=%.1f ms stalls=%u\n", name,
+		   result.sustained, result.setupMs, result.endMs, result.closeMs, result.stalls);
+	printf("BENCH %-6s write latency: p50=%.3f ms p90=%.3f ms p99=%.3f ms max=%.3f ms\n", name,
+		   percentile(result.writeMs, 50), percentile(result.writeMs, 90), percentile(result.writeMs, 99),
+		   percentile(result.writeMs, 100));
+	if (result.cardUs[3])
+		printf("BENCH %-6s card write latency: p50<=%u us p90<=%u us p99<=%u us max=%u us\n", name, result.cardUs[0],
+			   result.cardUs[1], result.cardUs[2], result.cardUs[3]);
+	printf("BENCH %-6s per record: opens=%.3f commands=%.3f sectors_read=%.3f sectors_written=%.3f card=%.3f ms\n",
+		   name, (double)result.stats.opens / records,
+		   (double)(result.stats.readCommands + result.stats.writeCommands) / records,
+		   (double)result.stats.sectorsRead / records, (double)result.stats.sectorsWritten / records,
+		   (double)result.stats.busyUs / records / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t records = 1000;
+	uint32_t outputs = 1000;
+	uint32_t flushEvery = 1;
+	uint32_t startMb = 0;
+	uint32_t preallocMb = 297;
+	const char *dir = "/tmp";
+	nativeSdTiming timing = {100, 683, 500};
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--records") && i + 1 < argc)
+			records = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--outputs") && i + 1 < argc)
+			outputs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--flush-every") && i + 1 < argc)
+			flushEvery = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--start-mb") && i + 1 < argc)
+			startMb = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--prealloc-mb") && i + 1 < argc)
+			preallocMb = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--dir") && i + 1 < argc)
+			dir = argv[++i];
+		else if (!strcmp(argv[i], "--command-us") && i + 1 < argc)
+			timing.commandUs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--sector-us") && i + 1 < argc)
+			timing.sectorUs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--program-us") && i + 1 < argc)
+			timing.programUs = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr,
+					"Usage: %s [--records N] [--outputs N] [--flush-every N] [--start-mb N] [--prealloc-mb N]\n"
+					"          [--dir PATH] [--command-us N] [--sector-us N] [--program-us N]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+	if (records < 10)
+		records = 10;
+	if (outputs < 10)
+		outputs = 10;
+	if (flushEvery == 0)
+		flushEvery = 1;
+
+	std::string reopenPath = std::string(dir) + "/sdlog_bench_reopen.bmerawbin";
+	std::string taskPath = std::string(dir) + "/sdlog_bench_task.bmerawbin";
+	std::string aiOpenPath = std::string(dir) + "/sdlog_bench_open.aipredictions";
+	std::string aiTaskPath = std::string(dir) + "/sdlog_bench_task.aipredictions";
+	uint32_t textLen = startMb ? startMb * 1024 * 1024 : BENCH_TEXT_SIZE;
+
+	benchResult reopen = runReopen(reopenPath.c_str(), records, flushEvery, textLen, timing);
+	benchResult task = runTask(taskPath.c_str(), records, preallocMb * 1024 * 1024, timing);
+
+	benchResult aiOpen = runAiOpen(aiOpenPath.c_str(), outputs, timing);
+	benchResult aiTask = runAiTask(aiTaskPath.c_str(), outputs, timing);
+
+	report("reopen", reopen, records);
+	report("task", task, records);
+	printf("BENCH task/reopen sustained rate: %.1fx\n", reopen.sustained > 0 ? task.sustained / reopen.sustained : 0.0);
+	report("aiopen", aiOpen, outputs);
+	report("aitask", aiTask, outputs);
+	printf("BENCH aitask/aiopen sustained rate: %.1fx\n", aiOpen.sustained > 0 ? aiTask.sustained / aiOpen.sustained : 0.0);
+
+	std::string rolloverPath1 = std::string(dir) + "/sdlog_bench_rollover1.bmerawbin";
+	std::string rolloverPath2 = std::string(dir) + "/sdlog_bench_rollover2.bmerawbin";
+	double rolloverEndMs = 0, rolloverBeginMs = 0;
+	bool rolloverOk = runRollover(rolloverPath1.c_str(), rolloverPath2.c_str(), records, preallocMb * 1024 * 1024,
+								  timing, rolloverEndMs, rolloverBeginMs);
+
+	printf("BENCH rollover end=%.1f ms next begin=%.1f ms, waiting for the close\n", rolloverEndMs, rolloverBeginMs);
+	remove(rolloverPath1.c_str());
+	remove(rolloverPath2.c_str());
+
+	bool reopenOk = checkFile(reopenPath.c_str(), records);
+	bool taskOk = checkFile(taskPath.c_str(), records);
+	bool aiOk = sameFiles(aiOpenPath.c_str(), aiTaskPath.c_str());
+	remove(reopenPath.c_str());
+	remove(taskPath.c_str());
+	remove(aiOpenPath.c_str());
+	remove(aiTaskPath.c_str());
+
+	if (!reopenOk || !taskOk || !aiOk || !rolloverOk)
+	{
+		printf("BENCH data read back differs:%s%s%s%s\n", reopenOk ? "" : " reopen", taskOk ? "" : " task",
+			   aiOk ? "" : " aipredictions", rolloverOk ? "" : " rollover");
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,241 @@
+/*
+  MCU wake ups per heater profile in forced, parallel and sequential mode, on the host
+
+  Runs the 10 step scan profile of the BSEC stand-in against the fake
+  BME688 for the same virtual time in three ways:
+
+  - forced     : the host steps through the profile, one forced mode
+                 measurement per step, each wake up fetches the last step
+                 and triggers the next one
+  - parallel   : Bsec2 at BSEC_SAMPLE_RATE_SCAN, the host wakes up at every
+                 next_call requested by BSEC
+  - sequential : the same with setSequentialMode, the sensor steps through
+                 the profile on its own and the host wakes up once 3 fields
+                 are buffered or the last step ended. Bsec2 stops the sensor
+                 there, fields of the next loop of the profile are not
+                 processed
+
+  The host sleeps until the time getTimeToNextCallMs returns. The awake
+  time of a wake up is --wake-us, the cost of leaving light sleep, plus the
+  time of its I2C traffic at --i2c-hz. BSEC processing is left out, it runs
+  once per field in every mode.
+
+  Usage: program [--seconds N] [--wake-us N] [--i2c-hz N]
+  Exits with 1 if the sequential field timestamps do not increase.
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+#include <Wire.h>
+
+#include "bsec2.h"
+#include "bsecStandin.h"
+
+#define BENCH_BME688_ADDR 0x77
+
+/* Scan profile of the BSEC stand-in, durations in multiples of BSEC_TOTAL_HEAT_DUR */
+static const uint16_t profileTemp[BSEC_STANDIN_PROFILE_LEN] = {320, 100, 100, 100, 200, 200, 200, 320, 320, 320};
+static const uint16_t profileMul[BSEC_STANDIN_PROFILE_LEN] = {5, 2, 10, 30, 5, 5, 5, 5, 5, 5};
+
+typedef struct
+{
+	uint32_t wakes;
+	uint32_t fields;
+	uint32_t profiles;
+	uint64_t awakeUs;
+	uint32_t timeInversions;
+	int64_t lastTimeNs;
+} benchResult;
+
+static FakeBme688 bme688;
+static uint32_t wakeUs = 500;
+static uint32_t i2cHz = 100000;
+
+/**
+ * @brief : Awake time of one wake up, from the I2C traffic it caused
+ */
+static uint64_t awakeUs(uint32_t transactions, uint32_t bytes)
+{
+	/* 9 clock cycles per byte, with the address byte of each transaction */
+	return wakeUs + ((uint64_t)(bytes + transactions) * 9 * 1000000 + i2cHz - 1) / i2cHz;
+}
+
+/**
+ * @brief : Sleeps until the given time on the virtual clock
+ */
+static void sleepUntilUs(uint64_t atUs)
+{
+	if (atUs > nativeNowUs())
+		delayMicroseconds(atUs - nativeNowUs());
+}
+
+/**
+ * @brief : The host steps through the profile in forced mode
+ */
+static benchResult runForced(uint32_t seconds)
+{
+	Bme68x sensor;
+	bme68xData data;
+	benchResult result = {0, 0, 0, 0, 0, 0};
+	uint64_t endUs = nativeNowUs() + (uint64_t)seconds * 1000000;
+	uint64_t periodUs = (uint64_t)(1000000 / BSEC_SAMPLE_RATE_SCAN);
+
+	sensor.begin(BENCH_BME688_ADDR, Wire);
+	sensor.setTPH(BME68X_OS_2X, BME68X_OS_1X, BME68X_OS_1X);
+	uint32_t measDurUs = sensor.getMeasDur(BME68X_FORCED_MODE);
+
+	while (nativeNowUs() < endUs)
+	{
+		uint64_t cycleStartUs = nativeNowUs();
+
+		for (uint8_t step = 0; step <= BSEC_STANDIN_PROFILE_LEN; step++)
+		{
+			uint32_t transactions = Wire.transactions;
+			uint32_t bytes = Wire.bytes;
+
+			result.wakes++;
+			if (step > 0 && sensor.fetchData())
+			{
+				sensor.getData(data);
+				if (data.status & BME68X_GASM_VALID_MSK)
+					result.fields++;
+			}
+
+			if (step < BSEC_STANDIN_PROFILE_LEN)
+			{
+				int32_t heaterMs = (int32_t)profileMul[step] * BSEC_TOTAL_HEAT_DUR - (int32_t)(measDurUs / 1000);
+
+				if (heaterMs > BSEC_SEQ_MAX_HEATER_DUR)
+					heaterMs = BSEC_SEQ_MAX_HEATER_DUR;
+				sensor.setHeaterProf(profileTemp[step], (uint16_t)heaterMs);
+				sensor.setOpMode(BME68X_FORCED_MODE);
+			}
+			result.awakeUs += awakeUs(Wire.transactions - transactions, Wire.bytes - bytes);
+
+			if (step < BSEC_STANDIN_PROFILE_LEN)
+				sleepUntilUs(nativeNowUs() + sensor.getMeasDur(BME68X_FORCED_MODE) +
+							 (uint64_t)sensor.getHeaterConfiguration().heatr_dur * 1000);
+		}
+
+		result.profiles++;
+		sleepUntilUs(cycleStartUs + periodUs);
+	}
+
+	return result;
+}
+
+static void onOutputs(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx)
+{
+	benchResult *result = (benchResult *)userCtx;
+	(void)data;
+	(void)bsec;
+
+	result->fields++;
+	for (uint8_t i = 0; i < outputs.nOutputs; i++)
+	{
+		if (outputs.output[i].sensor_id == BSEC_OUTPUT_GAS_ESTIMATE_1)
+			result->profiles++;
+	}
+
+	if (outputs.nOutputs)
+	{
+		if (outputs.output[0].time_stamp <= result->lastTimeNs)
+			result->timeInversions++;
+		result->lastTimeNs = outputs.output[0].time_stamp;
+	}
+}
+
+/**
+ * @brief : Bsec2 in scan mode, with the profile in parallel or in sequential mode
+ */
+static benchResult runBsec(bool sequential, uint32_t seconds)
+{
+	/* One object per mode, begin does not reset the mode the sensor was configured in */
+	static Bsec2 bsecs[2];
+	Bsec2 &bsec = bsecs[sequential];
+	bsecSensor sensorList[] = {BSEC_OUTPUT_RAW_GAS, BSEC_OUTPUT_RAW_GAS_INDEX, BSEC_OUTPUT_GAS_ESTIMATE_1};
+	benchResult result = {0, 0, 0, 0, 0, 0};
+	uint64_t endUs = nativeNowUs() + (uint64_t)seconds * 1000000;
+
+	bsec.clearMemory();
+	if (!bsec.begin(BENCH_BME688_ADDR, Wire) ||
+		!bsec.updateSubscription(sensorList, ARRAY_LEN(sensorList), BSEC_SAMPLE_RATE_SCAN))
+	{
+		printf("BENCH Bsec2 setup failed, status %d\n", bsec.status);
+		return result;
+	}
+	bsec.setSequentialMode(sequential);
+	bsec.attachCallback(onOutputs, &result);
+
+	while (nativeNowUs() < endUs)
+	{
+		uint32_t transactions = Wire.transactions;
+		uint32_t bytes = Wire.bytes;
+
+		result.wakes++;
+		if (!bsec.run())
+			printf("BENCH run failed, status %d\n", bsec.status);
+		result.awakeUs += awakeUs(Wire.transactions - transactions, Wire.bytes - bytes);
+
+		int64_t sleepMs = bsec.getTimeToNextCallMs();
+		delay(sleepMs > 0 ? (uint32_t)sleepMs : 1);
+	}
+	bsec.sensor.setOpMode(BME68X_SLEEP_MODE);
+
+	return result;
+}
+
+static void report(const char *name, const benchResult &result)
+{
+	uint32_t profiles = result.profiles ? result.profiles : 1;
+
+	printf("BENCH %-10s profiles=%u fields=%u wakes=%u wakes_per_profile=%.1f awake_per_profile=%.2f ms\n", name,
+		   result.profiles, result.fields, result.wakes, (double)result.wakes / profiles,
+		   (double)result.awakeUs / profiles / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t seconds = 3600;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+			seconds = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--wake-us") && i + 1 < argc)
+			wakeUs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--i2c-hz") && i + 1 < argc)
+			i2cHz = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--seconds N] [--wake-us N] [--i2c-hz N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (i2cHz == 0)
+		i2cHz = 100000;
+
+	bme688.setForcedTiming(true);
+	Wire.attach(BENCH_BME688_ADDR, bme688);
+	Wire.begin();
+
+	benchResult forced = runForced(seconds);
+	benchResult parallel = runBsec(false, seconds);
+	benchResult sequential = runBsec(true, seconds);
+
+	report("forced", forced);
+	report("parallel", parallel);
+	report("sequential", sequential);
+
+	if (sequential.timeInversions)
+	{
+		printf("BENCH %u sequential field timestamps did not increase\n", sequential.timeInversions);
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,511 @@
+/*
+  Check of the BME68x register copy against the registers of the mock, on the host
+
+  bme68x.c keeps a copy of the configuration registers 0x50 to 0x75 in
+  bme68x_dev, and compensate_field_data takes idac, res_heat and gas_wait of
+  a field from the copy instead of reading them. This program runs the
+  driver on the register map of Bme68xMockTransport and compares the values
+  of every fetched field with the registers of its gas index:
+
+  - forced   : a fetch through Bme68xT and one through the C API after each
+               of a series of random heater profiles
+  - parallel : 3 fields after each random parallel mode profile
+  - sequential : 3 fields after each random sequential mode profile
+  - reset    : a fetch after a soft reset, which puts the registers back to
+               their reset values, then after a new profile
+
+  It also checks the bus traffic the copy saves on the I2C mock and what it
+  must not serve over SPI, where the mock maps the addresses on the memory
+  page selected in the page register:
+
+  - a repeated setTPH or setHeaterProf of each mode writes nothing
+  - changed bytes go out in one transaction, without the unchanged ones
+  - ctrl_meas is read from the bus while the copy holds forced mode, the
+    sensor goes back to sleep on its own, and from the copy once asleep
+  - the SPI page register 0x73 is read from the bus on every access, alone,
+    in a burst and through getTPH
+
+  Usage: program [--profiles N] [--seed N]
+  Exits with 1 if a check fails.
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+
+#include "bme68xT.h"
+
+#define CHECK_MAX_PROFILE 10
+
+/**
+ * Bme68xMockTransport, with the soft reset putting the configuration
+ * registers back to their reset values as the sensor does. Over SPI, the
+ * addresses map to 0x00 to 0x7f on BME68X_MEM_PAGE0 and to 0x80 to 0xff on
+ * BME68X_MEM_PAGE1, the page register is BME68X_REG_MEM_PAGE on both.
+ */
+template <bme68x_intf checkIntf>
+class CheckTransport : public Bme68xMockTransport
+{
+public:
+	static const bme68x_intf intf = checkIntf;
+
+	int8_t read(uint8_t regAddr, uint8_t *regData, uint32_t length)
+	{
+		for (uint32_t i = 0; i < length; i++)
+			regData[i] = regs[mapAddr((uint8_t)(regAddr + i))];
+		reads++;
+
+		return BME68X_OK;
+	}
+
+	int8_t write(uint8_t regAddr, const uint8_t *regData, uint32_t length)
+	{
+		writeReg(mapAddr(regAddr), regData[0]);
+		for (uint32_t i = 1; i + 1 < length; i += 2)
+			writeReg(mapAddr(regData[i]), regData[i + 1]);
+		writes++;
+
+		return BME68X_OK;
+	}
+
+	/*! Number of soft resets */
+	uint32_t resets = 0;
+
+private:
+	uint8_t mapAddr(uint8_t regAddr)
+	{
+		if (checkIntf != BME68X_SPI_INTF)
+			return regAddr;
+
+		regAddr &= BME68X_SPI_WR_MSK;
+		if (regAddr == (BME68X_REG_MEM_PAGE & BME68X_SPI_WR_MSK))
+			return BME68X_REG_MEM_PAGE;
+
+		return ((regs[BME68X_REG_MEM_PAGE] & BME68X_MEM_PAGE_MSK) == BME68X_MEM_PAGE0) ? regAddr : (regAddr | 0x80);
+	}
+
+	void writeReg(uint8_t regAddr, uint8_t regData)
+	{
+		/* The soft reset command is not a register value */
+		if (regAddr == BME68X_REG_SOFT_RESET)
+		{
+			if (regData == BME68X_SOFT_RESET_CMD)
+			{
+				memset(&regs[BME68X_REG_IDAC_HEAT0], 0, BME68X_LEN_SHADOW);
+				regs[BME68X_REG_MEM_PAGE] &= ~BME68X_MEM_PAGE_MSK;
+				resets++;
+			}
+			return;
+		}
+
+		regs[regAddr] = regData;
+	}
+};
+
+typedef CheckTransport<BME68X_I2C_INTF> CheckI2cTransport;
+typedef CheckTransport<BME68X_SPI_INTF> CheckSpiTransport;
+typedef Bme68xT<CheckI2cTransport> CheckSensor;
+typedef Bme68xT<CheckSpiTransport> CheckSpiSensor;
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                               \
+	do                                                                                                                 \
+	{                                                                                                                  \
+		if (!(cond))                                                                                                   \
+		{                                                                                                              \
+			printf("CHECK failed: " __VA_ARGS__);                                                                      \
+			printf("\n");                                                                                              \
+			failures++;                                                                                                \
+		}                                                                                                              \
+	} while (0)
+
+static uint32_t rngState = 1;
+
+/**
+ * @brief : xorshift32, the same sequence on every host for a given seed
+ */
+static uint32_t nextRandom(void)
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+
+	return rngState;
+}
+
+static uint16_t randomBetween(uint16_t low, uint16_t high)
+{
+	return (uint16_t)(low + nextRandom() % (high - low + 1));
+}
+
+/**
+ * @brief : Puts a new field of the given heater step in the mock, as the sensor does at the end of a measurement
+ */
+static void putField(Bme68xMockTransport &mock, uint8_t field, uint8_t gasIndex, uint8_t measIndex)
+{
+	uint8_t *regs = &mock.regs[BME68X_REG_FIELD0 + field * BME68X_LEN_FIELD_OFFSET];
+
+	memset(regs, 0, BME68X_LEN_FIELD);
+	regs[0] = BME68X_NEW_DATA_MSK | gasIndex;
+	regs[1] = measIndex;
+	regs[2] = 0x50;
+	regs[5] = 0x80;
+	regs[8] = 0x60;
+	regs[15] = 0x40;
+	regs[16] = BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK | 0x04;
+}
+
+/**
+ * @brief : Compares the heater set-points the driver gave a field with the registers of its gas index
+ * @return True if they match
+ */
+static bool checkField(const char *step, uint32_t profile, const bme68xData &data, const Bme68xMockTransport &mock)
+{
+	uint8_t i = data.gas_index;
+	uint8_t idac = mock.regs[BME68X_REG_IDAC_HEAT0 + i];
+	uint8_t resHeat = mock.regs[BME68X_REG_RES_HEAT0 + i];
+	uint8_t gasWait = mock.regs[BME68X_REG_GAS_WAIT0 + i];
+
+	if ((data.idac == idac) && (data.res_heat == resHeat) && (data.gas_wait == gasWait))
+		return true;
+
+	CHECK(false, "%s, profile %u, gas index %u: copy idac=0x%02X res_heat=0x%02X gas_wait=0x%02X, registers "
+				 "0x%02X 0x%02X 0x%02X",
+		  step, profile, i, data.idac, data.res_heat, data.gas_wait, idac, resHeat, gasWait);
+	return false;
+}
+
+/**
+ * @brief : Writes random idac values through the driver, which keeps the copy up to date
+ */
+static void writeIdac(CheckSensor &sensor, uint8_t profileLen)
+{
+	for (uint8_t i = 0; i < profileLen; i++)
+		sensor.writeReg(BME68X_REG_IDAC_HEAT0 + i, (uint8_t)nextRandom());
+}
+
+/**
+ * @brief : Fetches a forced mode field of a random heater profile, through Bme68xT and through the C API
+ * @return Number of checked fields
+ */
+static uint32_t checkForced(CheckSensor &sensor, uint32_t profile)
+{
+	CheckI2cTransport &mock = sensor.getTransport();
+	Bme68x &api = sensor;
+	bme68xData data;
+	uint32_t checked = 0;
+
+	sensor.setHeaterProf(randomBetween(200, 400), randomBetween(1, 4000));
+	writeIdac(sensor, 1);
+
+	for (uint8_t path = 0; path < 2; path++)
+	{
+		sensor.setOpMode(BME68X_FORCED_MODE);
+		/* The sensor is back to sleep with a new field */
+		mock.regs[BME68X_REG_CTRL_MEAS] &= ~BME68X_MODE_MSK;
+		putField(mock, 0, 0, (uint8_t)profile);
+
+		uint8_t n = path ? api.fetchData() : sensor.fetchData();
+		CHECK(n == 1, "forced %s, profile %u: %u fields, status %d", path ? "C API" : "Bme68xT", profile, n,
+			  sensor.status);
+		if (n == 1)
+		{
+			sensor.getData(data);
+			checked += checkField(path ? "forced C API" : "forced Bme68xT", profile, data, mock);
+		}
+	}
+
+	return checked;
+}
+
+/**
+ * @brief : Fetches the 3 fields of a random parallel or sequential mode heater profile
+ * @return Number of checked fields
+ */
+static uint32_t checkFields(CheckSensor &sensor, uint8_t opMode, uint32_t profile)
+{
+	CheckI2cTransport &mock = sensor.getTransport();
+	const char *step = (opMode == BME68X_PARALLEL_MODE) ? "parallel" : "sequential";
+	uint16_t temps[CHECK_MAX_PROFILE], durs[CHECK_MAX_PROFILE];
+	uint8_t profileLen = (uint8_t)randomBetween(1, CHECK_MAX_PROFILE);
+	bme68xData data;
+	uint32_t checked = 0;
+
+	for (uint8_t i = 0; i < profileLen; i++)
+	{
+		temps[i] = randomBetween(100, 400);
+		durs[i] = (opMode == BME68X_PARALLEL_MODE) ? randomBetween(1, 30) : randomBetween(1, 4000);
+	}
+
+	if (opMode == BME68X_PARALLEL_MODE)
+		sensor.setHeaterProf(temps, durs, randomBetween(1, 500), profileLen);
+	else
+		sensor.setHeaterProf(temps, durs, profileLen);
+	writeIdac(sensor, profileLen);
+	sensor.setOpMode(opMode);
+
+	for (uint8_t field = 0; field < 3; field++)
+		putField(mock, field, (uint8_t)(nextRandom() % profileLen), (uint8_t)(3 * profile + field));
+
+	uint8_t n = sensor.fetchData();
+	CHECK(n == 3, "%s, profile %u: %u fields, status %d", step, profile, n, sensor.status);
+	for (uint8_t i = 0; i < n; i++)
+	{
+		sensor.getData(data);
+		checked += checkField(step, profile, data, mock);
+	}
+	sensor.setOpMode(BME68X_SLEEP_MODE);
+
+	return checked;
+}
+
+/**
+ * @brief : Fetches a forced mode field after a soft reset, then after a new heater profile
+ * @return Number of checked fields
+ */
+static uint32_t checkReset(CheckSensor &sensor, uint32_t profile)
+{
+	CheckI2cTransport &mock = sensor.getTransport();
+	uint32_t resets = mock.resets;
+	bme68xData data;
+	uint32_t checked = 0;
+
+	sensor.setHeaterProf(randomBetween(200, 400), randomBetween(1, 4000));
+	writeIdac(sensor, 1);
+	sensor.setOpMode(BME68X_FORCED_MODE);
+	sensor.softReset();
+	CHECK(mock.resets == resets + 1, "reset, profile %u: no soft reset on the bus", profile);
+
+	/* The copy still holds the profile, the registers their reset values */
+	putField(mock, 0, 0, (uint8_t)profile);
+	uint8_t n = sensor.fetchData();
+	CHECK(n == 1, "reset, profile %u: %u fields, status %d", profile, n, sensor.status);
+	if (n == 1)
+	{
+		sensor.getData(data);
+		checked += checkField("after the reset", profile, data, mock);
+	}
+
+	checked += checkForced(sensor, profile);
+
+	return checked;
+}
+
+/**
+ * @brief : Checks the writes of a call that repeats the configuration, and of one that changes it
+ * @param[in] changed : Number of registers the call changes, 0 for a repeat
+ */
+static void checkWrites(CheckSensor &sensor, const char *call, uint32_t writesBefore, uint8_t changed)
+{
+	CheckI2cTransport &mock = sensor.getTransport();
+	bme68xBusStats stats = sensor.getCallStats();
+	uint32_t writes = mock.writes - writesBefore;
+
+	if (changed == 0)
+	{
+		CHECK((writes == 0) && (stats.transactions == 0) && (sensor.status == BME68X_OK),
+			  "repeated %s: %u writes, %u transactions, status %d", call, writes, stats.transactions, sensor.status);
+		return;
+	}
+
+	/* One transaction of the changed address and data pairs */
+	CHECK((writes == 1) && (stats.transactions == 1) && (stats.bytes == 2u * changed) &&
+			  (sensor.status == BME68X_OK),
+		  "%s changing %u registers: %u writes, %u transactions, %u bytes, status %d", call, changed, writes,
+		  stats.transactions, stats.bytes, sensor.status);
+}
+
+/**
+ * @brief : Bus traffic of repeated and changed configuration calls, and of the mode reads after forced mode
+ */
+static void checkBusTraffic(void)
+{
+	CheckSensor sensor;
+	CheckI2cTransport &mock = sensor.getTransport();
+	uint16_t temps[CHECK_MAX_PROFILE] = {320, 100, 100, 100, 200, 200, 200, 320, 320, 320};
+	uint16_t durs[CHECK_MAX_PROFILE] = {5, 2, 10, 30, 5, 5, 5, 5, 5, 5};
+	uint32_t writes;
+	uint32_t reads;
+	uint8_t opMode;
+
+	sensor.begin();
+
+	sensor.setTPH(BME68X_OS_2X, BME68X_OS_16X, BME68X_OS_1X);
+	writes = mock.writes;
+	sensor.setTPH(BME68X_OS_2X, BME68X_OS_16X, BME68X_OS_1X);
+	checkWrites(sensor, "setTPH", writes, 0);
+	CHECK(sensor.getCallStats().skippedWrites == BME68X_LEN_CONFIG, "repeated setTPH: %u of %u writes skipped",
+		  sensor.getCallStats().skippedWrites, (unsigned)BME68X_LEN_CONFIG);
+
+	/* ctrl_hum and ctrl_meas */
+	writes = mock.writes;
+	sensor.setTPH(BME68X_OS_1X, BME68X_OS_16X, BME68X_OS_2X);
+	checkWrites(sensor, "setTPH", writes, 2);
+	CHECK(((mock.regs[BME68X_REG_CTRL_HUM] & BME68X_OSH_MSK) == BME68X_OS_2X) &&
+			  (((mock.regs[BME68X_REG_CTRL_MEAS] & BME68X_OST_MSK) >> BME68X_OST_POS) == BME68X_OS_1X),
+		  "setTPH: ctrl_hum=0x%02X ctrl_meas=0x%02X on the bus", mock.regs[BME68X_REG_CTRL_HUM],
+		  mock.regs[BME68X_REG_CTRL_MEAS]);
+
+	sensor.setHeaterProf(200, 100);
+	writes = mock.writes;
+	sensor.setHeaterProf(200, 100);
+	checkWrites(sensor, "forced setHeaterProf", writes, 0);
+
+	/* res_heat of step 0 */
+	writes = mock.writes;
+	sensor.setHeaterProf(400, 100);
+	checkWrites(sensor, "forced setHeaterProf", writes, 1);
+
+	sensor.setHeaterProf(temps, durs, CHECK_MAX_PROFILE);
+	writes = mock.writes;
+	sensor.setHeaterProf(temps, durs, CHECK_MAX_PROFILE);
+	checkWrites(sensor, "sequential setHeaterProf", writes, 0);
+
+	/* res_heat of steps 0 and 9, around the unchanged steps */
+	temps[0] = 400;
+	temps[9] = 150;
+	writes = mock.writes;
+	sensor.setHeaterProf(temps, durs, CHECK_MAX_PROFILE);
+	checkWrites(sensor, "sequential setHeaterProf", writes, 2);
+
+	sensor.setHeaterProf(temps, durs, 140, CHECK_MAX_PROFILE);
+	writes = mock.writes;
+	sensor.setHeaterProf(temps, durs, 140, CHECK_MAX_PROFILE);
+	checkWrites(sensor, "parallel setHeaterProf", writes, 0);
+
+	/* The sensor leaves forced mode on its own, the mode is read from the bus */
+	sensor.setOpMode(BME68X_FORCED_MODE);
+	reads = mock.reads;
+	opMode = sensor.getOpMode();
+	CHECK((opMode == BME68X_FORCED_MODE) && (mock.reads == reads + 1),
+		  "forced mode: getOpMode=%u with %u bus reads, expected forced mode and 1", opMode, mock.reads - reads);
+
+	mock.regs[BME68X_REG_CTRL_MEAS] &= ~BME68X_MODE_MSK;
+	reads = mock.reads;
+	opMode = sensor.getOpMode();
+	CHECK((opMode == BME68X_SLEEP_MODE) && (mock.reads == reads + 1),
+		  "end of forced mode: getOpMode=%u with %u bus reads, expected sleep mode and 1", opMode,
+		  mock.reads - reads);
+
+	/* Asleep, the copy holds the mode */
+	reads = mock.reads;
+	opMode = sensor.getOpMode();
+	CHECK((opMode == BME68X_SLEEP_MODE) && (mock.reads == reads),
+		  "sleep mode: getOpMode=%u with %u bus reads, expected sleep mode and 0", opMode, mock.reads - reads);
+
+	printf("CHECK bus traffic: repeated setTPH and setHeaterProf write nothing, changes go out in one transaction, "
+		   "ctrl_meas read from the bus after forced mode, %u transactions in total\n",
+		   sensor.getTransactionCount());
+}
+
+/**
+ * @brief : Reads of the SPI page register, which the register copy must never serve
+ */
+static void checkSpiPage(uint32_t rounds)
+{
+	CheckSpiSensor sensor;
+	CheckSpiTransport &mock = sensor.getTransport();
+	const uint8_t pageAddr = BME68X_REG_MEM_PAGE & BME68X_SPI_WR_MSK;
+	uint8_t regs[BME68X_LEN_CONFIG];
+	uint8_t osHum, osTemp, osPres;
+	uint32_t reads;
+	uint32_t checked = 0;
+
+	sensor.begin();
+	CHECK(sensor.status == BME68X_OK, "SPI begin: status %d", sensor.status);
+
+	/* Fills the copy, with the page register */
+	sensor.setTPH(BME68X_OS_2X, BME68X_OS_16X, BME68X_OS_1X);
+	sensor.readReg(BME68X_REG_IDAC_HEAT0, regs, 1);
+
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		/* To the other page, and back with the next read */
+		sensor.readReg(BME68X_REG_CHIP_ID);
+		sensor.readReg(BME68X_REG_CTRL_GAS_1, regs, BME68X_LEN_CONFIG);
+
+		/* Other bits of the register than the page, which the copy cannot see change */
+		uint8_t page = (uint8_t)((mock.regs[BME68X_REG_MEM_PAGE] & BME68X_MEM_PAGE_MSK) |
+								 (nextRandom() & ~BME68X_MEM_PAGE_MSK));
+		mock.regs[BME68X_REG_MEM_PAGE] = page;
+
+		reads = mock.reads;
+		uint8_t value = sensor.readReg(pageAddr);
+		CHECK((value == page) && (mock.reads == reads + 1),
+			  "SPI round %u: page register 0x%02X read as 0x%02X with %u bus reads", round, page, value,
+			  mock.reads - reads);
+
+		page ^= (uint8_t)~BME68X_MEM_PAGE_MSK;
+		mock.regs[BME68X_REG_MEM_PAGE] = page;
+		reads = mock.reads;
+		sensor.readReg(BME68X_REG_CTRL_GAS_1, regs, BME68X_LEN_CONFIG);
+		value = regs[pageAddr - BME68X_REG_CTRL_GAS_1];
+		CHECK((value == page) && (mock.reads == reads + 1),
+			  "SPI round %u: page register 0x%02X read as 0x%02X in a burst with %u bus reads", round, page, value,
+			  mock.reads - reads);
+
+		/* getTPH reads 0x71 to 0x75 */
+		reads = mock.reads;
+		sensor.getTPH(osHum, osTemp, osPres);
+		CHECK((mock.reads == reads + 1) && (osHum == BME68X_OS_1X) && (osTemp == BME68X_OS_2X),
+			  "SPI round %u: getTPH with %u bus reads, os_hum=%u os_temp=%u", round, mock.reads - reads, osHum,
+			  osTemp);
+		checked++;
+	}
+
+	printf("CHECK SPI page register: %u rounds, read from the bus alone, in a burst and through getTPH\n", checked);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t profiles = 10000;
+	uint32_t seed = 1;
+	uint32_t forced = 0, parallel = 0, sequential = 0, reset = 0;
+	uint32_t profile;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--profiles") && i + 1 < argc)
+			profiles = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--profiles N] [--seed N]\n", argv[0]);
+			return 1;
+		}
+	}
+	rngState = seed ? seed : 1;
+
+	CheckSensor sensor;
+	sensor.begin();
+	CHECK(sensor.status == BME68X_OK, "begin: status %d", sensor.status);
+
+	for (profile = 0; (profile < profiles) && !failures; profile++)
+	{
+		forced += checkForced(sensor, profile);
+		parallel += checkFields(sensor, BME68X_PARALLEL_MODE, profile);
+		sequential += checkFields(sensor, BME68X_SEQUENTIAL_MODE, profile);
+		if (profile % 16 == 0)
+			reset += checkReset(sensor, profile);
+	}
+
+	printf("CHECK heater set-points of the register copy against the registers: %u profiles, fields forced=%u "
+		   "parallel=%u sequential=%u after a soft reset=%u\n",
+		   profile, forced, parallel, sequential, reset);
+
+	checkBusTraffic();
+	checkSpiPage(profiles);
+
+	if (failures)
+	{
+		printf("CHECK %u failures\n", failures);
+		return 1;
+	}
+	printf("CHECK passed\n");
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
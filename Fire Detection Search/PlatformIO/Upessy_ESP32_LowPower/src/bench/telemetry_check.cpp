@@ -0,0 +1,234 @@
+/*
+  Check of the LoRa telemetry frame codec, on the host
+
+  - layout     : a known frame encodes to the bytes of the table in
+                 telemetry_frame.h
+  - round trip : --frames frames of random fields decode to the frame
+                 encoded, and the physical values of the BME68x range, scaled
+                 and converted back, come out within half a count
+  - saturation : values beyond the int16 range, the infinities and NaN
+                 scale to the ends of the range or to 0, probabilities out
+                 of 0..1 quantize to 0 or 255, and the scaled value never
+                 decreases when the physical value grows
+  - rejects    : short buffers, a wrong length or version are refused
+
+  Usage: program [--frames N] [--seed N]
+  Exits with 1 on the first failure.
+*/
+
+#ifdef NODE_BENCH
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telemetry_frame.h"
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                               \
+	do                                                                                                                 \
+	{                                                                                                                  \
+		if (!(cond))                                                                                                   \
+		{                                                                                                              \
+			printf("CHECK failed: " __VA_ARGS__);                                                                      \
+			printf("\n");                                                                                              \
+			failures++;                                                                                                \
+		}                                                                                                              \
+	} while (0)
+
+static float randomIn(float low, float high)
+{
+	return low + (high - low) * ((float)rand() / (float)RAND_MAX);
+}
+
+static bool sameFrame(const telemetryFrame &a, const telemetryFrame &b)
+{
+	return a.nodeId == b.nodeId && a.sequence == b.sequence && a.temperature == b.temperature &&
+		   a.humidity == b.humidity && a.pressure == b.pressure &&
+		   memcmp(a.classProb, b.classProb, sizeof(a.classProb)) == 0 && a.accuracy == b.accuracy;
+}
+
+static void checkLayout(void)
+{
+	telemetryFrame frame = {0x1234, 0xABCD, -2550, 4567, 10132, {0, 64, 128, 255}, 3};
+	const uint8_t expected[TELEMETRY_FRAME_SIZE] = {TELEMETRY_FRAME_VERSION, 0x34, 0x12, 0xCD, 0xAB, 0x0A, 0xF6, 0xD7,
+													0x11, 0x94, 0x27, 0, 64, 128, 255, 3};
+	uint8_t buffer[TELEMETRY_FRAME_SIZE];
+
+	CHECK(telemetryEncode(frame, buffer, sizeof(buffer)) == TELEMETRY_FRAME_SIZE, "layout: encode size");
+	CHECK(memcmp(buffer, expected, sizeof(expected)) == 0, "layout: bytes differ from the table");
+}
+
+static void checkRoundTrip(uint32_t frames)
+{
+	uint8_t buffer[TELEMETRY_FRAME_SIZE + 4];
+	float worstTemperature = 0, worstHumidity = 0, worstPressure = 0, worstProbability = 0;
+
+	for (uint32_t i = 0; i < frames; i++)
+	{
+		telemetryFrame frame, decoded;
+
+		frame.nodeId = (uint16_t)rand();
+		frame.sequence = (uint16_t)rand();
+		frame.temperature = (int16_t)rand();
+		frame.humidity = (int16_t)rand();
+		frame.pressure = (int16_t)rand();
+		for (uint8_t c = 0; c < TELEMETRY_NUM_CLASSES; c++)
+			frame.classProb[c] = (uint8_t)rand();
+		frame.accuracy = (uint8_t)(rand() & 3);
+
+		memset(&decoded, 0, sizeof(decoded));
+		if (telemetryEncode(frame, buffer, sizeof(buffer)) != TELEMETRY_FRAME_SIZE ||
+			!telemetryDecode(buffer, TELEMETRY_FRAME_SIZE, decoded) || !sameFrame(frame, decoded))
+		{
+			CHECK(false, "round trip: frame %u", i);
+			return;
+		}
+
+		/* Physical values over the operating range of the BME68x */
+		float temperature = randomIn(-40.0f, 85.0f);
+		float humidity = randomIn(0.0f, 100.0f);
+		float pressure = randomIn(300.0f, 1100.0f);
+		float probability = randomIn(0.0f, 1.0f);
+
+		frame.temperature = telemetryScale(temperature, TELEMETRY_TEMPERATURE_SCALE);
+		frame.humidity = telemetryScale(humidity, TELEMETRY_HUMIDITY_SCALE);
+		frame.pressure = telemetryScale(pressure, TELEMETRY_PRESSURE_SCALE);
+		frame.classProb[0] = telemetryQuantizeProbability(probability);
+		telemetryEncode(frame, buffer, sizeof(buffer));
+		telemetryDecode(buffer, TELEMETRY_FRAME_SIZE, decoded);
+
+		worstTemperature = fmaxf(worstTemperature, fabsf(telemetryTemperature(decoded) - temperature));
+		worstHumidity = fmaxf(worstHumidity, fabsf(telemetryHumidity(decoded) - humidity));
+		worstPressure = fmaxf(worstPressure, fabsf(telemetryPressure(decoded) - pressure));
+		worstProbability = fmaxf(worstProbability, fabsf(telemetryProbability(decoded, 0) - probability));
+	}
+
+	/* Half a count, and the float error of the products */
+	CHECK(worstTemperature <= 0.5f / TELEMETRY_TEMPERATURE_SCALE + 1e-4f, "round trip: temperature error %g",
+		  worstTemperature);
+	CHECK(worstHumidity <= 0.5f / TELEMETRY_HUMIDITY_SCALE + 1e-4f, "round trip: humidity error %g", worstHumidity);
+	CHECK(worstPressure <= 0.5f / TELEMETRY_PRESSURE_SCALE + 1e-4f, "round trip: pressure error %g", worstPressure);
+	CHECK(worstProbability <= 0.5f / TELEMETRY_PROBABILITY_SCALE + 1e-6f, "round trip: probability error %g",
+		  worstProbability);
+
+	printf("CHECK round trip: %u frames, worst error temperature=%.4f degC humidity=%.4f %%rH pressure=%.4f hPa "
+		   "probability=%.5f\n",
+		   frames, worstTemperature, worstHumidity, worstPressure, worstProbability);
+}
+
+static void checkSaturation(void)
+{
+	const float scales[] = {TELEMETRY_TEMPERATURE_SCALE, TELEMETRY_HUMIDITY_SCALE, TELEMETRY_PRESSURE_SCALE};
+
+	for (float scale : scales)
+	{
+		float top = INT16_MAX / scale, bottom = INT16_MIN / scale;
+		int16_t previous = INT16_MIN;
+
+		CHECK(telemetryScale(top, scale) == INT16_MAX, "saturation: top at scale %g", scale);
+		CHECK(telemetryScale(bottom, scale) == INT16_MIN, "saturation: bottom at scale %g", scale);
+		CHECK(telemetryScale(top * 2, scale) == INT16_MAX, "saturation: twice the top at scale %g", scale);
+		CHECK(telemetryScale(bottom * 2, scale) == INT16_MIN, "saturation: twice the bottom at scale %g", scale);
+		CHECK(telemetryScale(1e30f, scale) == INT16_MAX, "saturation: 1e30 at scale %g", scale);
+		CHECK(telemetryScale(-1e30f, scale) == INT16_MIN, "saturation: -1e30 at scale %g", scale);
+		CHECK(telemetryScale(INFINITY, scale) == INT16_MAX, "saturation: +inf at scale %g", scale);
+		CHECK(telemetryScale(-INFINITY, scale) == INT16_MIN, "saturation: -inf at scale %g", scale);
+		CHECK(telemetryScale(NAN, scale) == 0, "saturation: NaN at scale %g", scale);
+		CHECK(telemetryScale(0.0f, scale) == 0, "saturation: 0 at scale %g", scale);
+
+		/* Monotonic from beyond the bottom to beyond the top */
+		for (float value = bottom * 1.01f; value <= top * 1.01f; value += (top - bottom) / 200003.0f)
+		{
+			int16_t scaled = telemetryScale(value, scale);
+
+			if (scaled < previous)
+			{
+				CHECK(false, "saturation: %g scales below %g at scale %g", value, value - (top - bottom) / 200003.0f,
+					  scale);
+				break;
+			}
+			previous = scaled;
+		}
+		CHECK(previous == INT16_MAX, "saturation: sweep ends at %d at scale %g", previous, scale);
+	}
+
+	CHECK(telemetryQuantizeProbability(-0.5f) == 0, "saturation: probability -0.5");
+	CHECK(telemetryQuantizeProbability(0.0f) == 0, "saturation: probability 0");
+	CHECK(telemetryQuantizeProbability(1.0f) == UINT8_MAX, "saturation: probability 1");
+	CHECK(telemetryQuantizeProbability(7.0f) == UINT8_MAX, "saturation: probability 7");
+	CHECK(telemetryQuantizeProbability(INFINITY) == UINT8_MAX, "saturation: probability +inf");
+	CHECK(telemetryQuantizeProbability(NAN) == 0, "saturation: probability NaN");
+
+	uint8_t previous = 0;
+
+	for (uint32_t i = 0; i <= 100000; i++)
+	{
+		uint8_t quantized = telemetryQuantizeProbability(i / 100000.0f);
+
+		if (quantized < previous)
+		{
+			CHECK(false, "saturation: probability %g quantizes below the one before", i / 100000.0f);
+			break;
+		}
+		previous = quantized;
+	}
+
+	printf("CHECK saturation: int16 ends, infinities, NaN and monotonic sweeps at the 3 scales, probabilities\n");
+}
+
+static void checkRejects(void)
+{
+	telemetryFrame frame = {1, 2, 3, 4, 5, {6, 7, 8, 9}, 1}, decoded;
+	uint8_t buffer[TELEMETRY_FRAME_SIZE + 1];
+
+	CHECK(telemetryEncode(frame, buffer, TELEMETRY_FRAME_SIZE - 1) == 0, "rejects: encode into a short buffer");
+	CHECK(telemetryEncode(frame, nullptr, sizeof(buffer)) == 0, "rejects: encode into no buffer");
+
+	telemetryEncode(frame, buffer, sizeof(buffer));
+	CHECK(!telemetryDecode(buffer, TELEMETRY_FRAME_SIZE - 1, decoded), "rejects: decode of a short frame");
+	CHECK(!telemetryDecode(buffer, TELEMETRY_FRAME_SIZE + 1, decoded), "rejects: decode of a long frame");
+	CHECK(!telemetryDecode(nullptr, TELEMETRY_FRAME_SIZE, decoded), "rejects: decode of no buffer");
+	buffer[0] = TELEMETRY_FRAME_VERSION + 1;
+	CHECK(!telemetryDecode(buffer, TELEMETRY_FRAME_SIZE, decoded), "rejects: decode of another version");
+
+	printf("CHECK rejects: short, long and missing buffers, other version\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t frames = 1000000;
+	uint32_t seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+			frames = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--frames N] [--seed N]\n", argv[0]);
+			return 1;
+		}
+	}
+	srand(seed);
+
+	checkLayout();
+	checkRoundTrip(frames);
+	checkSaturation();
+	checkRejects();
+
+	if (failures)
+	{
+		printf("CHECK %u failures\n", failures);
+		return 1;
+	}
+	printf("CHECK passed\n");
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,191 @@
+/*
+  Per-read cost of the BME68x register access on the host
+
+  Compares Bme68x, which reaches the bus through the function pointers of
+  bme68x_dev, with Bme68xT bound to the same transport at compile time.
+  Both read the 17 byte field 0 block with readReg, and fetch the 3 fields
+  of parallel mode with fetchData, the burst read and the compensation of
+  the fields. Each runs once on the RAM register map of Bme68xMockTransport
+  and once on the fake BME688 on the native I2C bus.
+
+  Usage: program [--reads N]
+    --reads : Reads per case, 1000000 by default, fetches are a tenth of it
+  Exits with 1 if the fields fetched by Bme68x and Bme68xT differ.
+*/
+
+#ifdef NODE_BENCH
+
+#include <chrono>
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+#include <Wire.h>
+
+#include "bme68xT.h"
+
+#define BENCH_BME688_ADDR 0x77
+
+static FakeBme688 bme688;
+
+static BME68X_INTF_RET_TYPE mockRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	return ((Bme68xMockTransport *)intfPtr)->read(regAddr, regData, length);
+}
+
+static BME68X_INTF_RET_TYPE mockWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+	return ((Bme68xMockTransport *)intfPtr)->write(regAddr, regData, length);
+}
+
+static void mockDelay(uint32_t periodUs, void *intfPtr)
+{
+	((Bme68xMockTransport *)intfPtr)->delayUs(periodUs);
+}
+
+/**
+ * @brief : Reads the field 0 block a number of times
+ * @return Time per read in nanoseconds
+ */
+template <typename Sensor>
+static double timeReads(Sensor &sensor, uint32_t reads, uint32_t &checksum)
+{
+	uint8_t field[BME68X_LEN_FIELD];
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < reads; i++)
+	{
+		sensor.readReg(BME68X_REG_FIELD0, field, BME68X_LEN_FIELD);
+		checksum += field[i % BME68X_LEN_FIELD];
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / reads;
+}
+
+/**
+ * @brief : Fetches the parallel mode fields a number of times
+ * @return Time per fetch in nanoseconds
+ */
+template <typename Sensor>
+static double timeFetches(Sensor &sensor, uint32_t fetches, uint32_t &checksum)
+{
+	bme68xData data = {};
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < fetches; i++)
+	{
+		checksum += sensor.fetchData();
+		sensor.getData(data);
+		checksum += data.meas_index;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / fetches;
+}
+
+static void report(const char *name, const char *unit, Bme68x &sensor, double nsPerCall)
+{
+	bme68xBusStats stats = sensor.getCallStats();
+
+	printf("BENCH %-30s %9.1f ns/%s status=%d transactions/%s=%u\n", name, nsPerCall, unit, sensor.status, unit,
+		   stats.transactions);
+}
+
+/**
+ * @brief : Fills the 3 fields of the mock register map with new parallel mode data
+ */
+static void fillMockFields(Bme68xMockTransport &mock)
+{
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		uint8_t *field = &mock.regs[BME68X_REG_FIELD0 + i * BME68X_LEN_FIELD];
+
+		field[0] = BME68X_NEW_DATA_MSK | i;
+		field[1] = i + 1;
+		field[2] = 0x50;
+		field[5] = 0x80;
+		field[8] = 0x60;
+		field[15] = 0x40;
+		field[16] = BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK | 0x04;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t reads = 1000000;
+	uint32_t checksum = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--reads") && i + 1 < argc)
+			reads = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--reads N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (reads == 0)
+		reads = 1;
+
+	uint32_t fetches = (reads >= 10) ? reads / 10 : 1;
+
+	Bme68xMockTransport mock;
+	Bme68x mockC;
+	mockC.begin(BME68X_I2C_INTF, mockRead, mockWrite, mockDelay, &mock);
+	report("mock, function pointers", "read", mockC, timeReads(mockC, reads, checksum));
+
+	Bme68xT<Bme68xMockTransport> mockT;
+	mockT.begin();
+	report("mock, Bme68xT", "read", mockT, timeReads(mockT, reads, checksum));
+
+	/* The mock keeps the fields, every fetch finds 3 new ones */
+	mockC.setOpMode(BME68X_PARALLEL_MODE);
+	mockT.setOpMode(BME68X_PARALLEL_MODE);
+	fillMockFields(mock);
+	fillMockFields(mockT.getTransport());
+	report("mock, function pointers", "fetch", mockC, timeFetches(mockC, fetches, checksum));
+	report("mock, Bme68xT", "fetch", mockT, timeFetches(mockT, fetches, checksum));
+
+	/* Both compensate the same registers */
+	bme68xData fieldC, fieldT;
+	uint8_t leftC, leftT;
+	mockC.fetchData();
+	mockT.fetchData();
+	do
+	{
+		leftC = mockC.getData(fieldC);
+		leftT = mockT.getData(fieldT);
+		if ((leftC != leftT) || (fieldC.status != fieldT.status) || (fieldC.gas_index != fieldT.gas_index) ||
+			(fieldC.meas_index != fieldT.meas_index) || (fieldC.temperature != fieldT.temperature) ||
+			(fieldC.pressure != fieldT.pressure) || (fieldC.humidity != fieldT.humidity) ||
+			(fieldC.gas_resistance != fieldT.gas_resistance))
+		{
+			printf("BENCH fetchData of Bme68xT differs from Bme68x\n");
+			return 1;
+		}
+	} while (leftC);
+
+	Wire.attach(BENCH_BME688_ADDR, bme688);
+	Wire.begin();
+
+	Bme68x i2cC;
+	i2cC.begin(BENCH_BME688_ADDR, Wire);
+	report("fake BME688, function pointers", "read", i2cC, timeReads(i2cC, reads, checksum));
+
+	Bme68xT<Bme68xI2cTransport> i2cT(Bme68xI2cTransport(BENCH_BME688_ADDR, Wire));
+	i2cT.begin();
+	report("fake BME688, Bme68xT", "read", i2cT, timeReads(i2cT, reads, checksum));
+
+	i2cC.setOpMode(BME68X_PARALLEL_MODE);
+	i2cT.setOpMode(BME68X_PARALLEL_MODE);
+	report("fake BME688, function pointers", "fetch", i2cC, timeFetches(i2cC, fetches, checksum));
+	report("fake BME688, Bme68xT", "fetch", i2cT, timeFetches(i2cT, fetches, checksum));
+
+	/* Keeps the reads from being optimized out */
+	printf("BENCH checksum=%u\n", checksum);
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -0,0 +1,153 @@
+/*
+  CPU-active time of the BME68x forced mode wait strategies, on the host
+
+  Runs forced mode cycles against the fake BME688, which holds back the data
+  for the TPH and heater durations as the sensor does. Each cycle triggers a
+  measurement and fetches it. The delay callback given to begin decides where
+  the wait goes:
+
+  - bme68xDelayUs           : busy-waits, the CPU stays active
+  - bme68xYieldDelayUs      : delay(), the task blocks and the CPU may idle
+  - bme68xLightSleepDelayUs : light sleep woken by the timer
+
+  Every I2C transaction takes its transfer time on the virtual clock, the
+  CPU waits for the bus as Wire does on the target. The CPU-active time is
+  the cycle time minus the time spent in delay() and in light sleep, the bus
+  time is part of it. Times are virtual, so the run is reproducible and needs
+  no hardware.
+
+  Usage: program [--cycles N] [--heater-ms N] [--poll-us N] [--i2c-hz N]
+    --i2c-hz : I2C clock of the transfer time, 100000 by default
+*/
+
+#ifdef NODE_BENCH
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+#include <Wire.h>
+
+#include "bme68xLibrary.h"
+
+#define BENCH_BME688_ADDR 0x77
+
+typedef struct
+{
+	const char *name;
+	bme68xWaitStrategy strategy;
+	bme68x_delay_us_fptr_t idleTask;
+	bool waitInCaller;
+} benchCase;
+
+typedef struct
+{
+	uint64_t cycleUs;
+	uint64_t activeUs;
+	uint64_t yieldUs;
+	uint64_t lightSleepUs;
+	uint64_t busUs;
+	uint32_t transactions;
+	uint32_t samples;
+} benchResult;
+
+static FakeBme688 bme688;
+
+/**
+ * @brief : Runs the measurement cycles of one case on a fresh sensor object
+ */
+static benchResult runCycles(const benchCase &c, uint32_t cycles, uint16_t heaterMs, uint32_t pollUs)
+{
+	Bme68x sensor;
+	bme68xData data;
+	benchResult result = {0, 0, 0, 0, 0, 0, 0};
+
+	sensor.begin(BENCH_BME688_ADDR, Wire, c.idleTask);
+	sensor.setTPH();
+	sensor.setHeaterProf(300, heaterMs);
+	sensor.setWaitStrategy(c.strategy, pollUs);
+
+	uint64_t startUs = nativeNowUs();
+	uint64_t yieldStartUs = nativeYieldUs();
+	uint64_t sleepStartUs = nativeLightSleepUs();
+	uint64_t busStartUs = Wire.busyUs;
+	for (uint32_t i = 0; i < cycles; i++)
+	{
+		sensor.setOpMode(BME68X_FORCED_MODE);
+
+		/* The pattern of the library examples, the caller busy-waits the measurement */
+		if (c.waitInCaller)
+			delayMicroseconds(sensor.getMeasDur() + (uint32_t)heaterMs * 1000);
+
+		if (sensor.fetchData())
+		{
+			sensor.getData(data);
+			if (data.status & BME68X_NEW_DATA_MSK)
+				result.samples++;
+		}
+		result.transactions += sensor.getCallStats().transactions;
+	}
+
+	result.cycleUs = (nativeNowUs() - startUs) / cycles;
+	result.yieldUs = (nativeYieldUs() - yieldStartUs) / cycles;
+	result.lightSleepUs = (nativeLightSleepUs() - sleepStartUs) / cycles;
+	result.activeUs = result.cycleUs - result.yieldUs - result.lightSleepUs;
+	result.busUs = (Wire.busyUs - busStartUs) / cycles;
+	result.transactions /= cycles;
+
+	return result;
+}
+
+static void report(const char *name, const benchResult &result, uint32_t cycles)
+{
+	printf("BENCH %-30s cycle=%6llu us cpu_active=%6llu us yield=%6llu us light_sleep=%6llu us i2c=%5llu us "
+		   "fetch_transactions=%u samples=%u/%u\n",
+		   name, (unsigned long long)result.cycleUs, (unsigned long long)result.activeUs,
+		   (unsigned long long)result.yieldUs, (unsigned long long)result.lightSleepUs,
+		   (unsigned long long)result.busUs, result.transactions, result.samples, cycles);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t cycles = 100;
+	uint16_t heaterMs = 30;
+	uint32_t pollUs = 5000;
+	uint32_t i2cHz = 100000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--cycles") && i + 1 < argc)
+			cycles = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--heater-ms") && i + 1 < argc)
+			heaterMs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--poll-us") && i + 1 < argc)
+			pollUs = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--i2c-hz") && i + 1 < argc)
+			i2cHz = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--cycles N] [--heater-ms N] [--poll-us N] [--i2c-hz N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (cycles == 0)
+		cycles = 1;
+
+	bme688.setForcedTiming(true);
+	Wire.attach(BENCH_BME688_ADDR, bme688);
+	Wire.begin();
+	Wire.setTransferTiming(i2cHz);
+
+	static const benchCase cases[] = {
+		{"caller busy-wait", BME68X_WAIT_DRIVER, bme68xDelayUs, true},
+		{"scheduled, busy-wait", BME68X_WAIT_SCHEDULED, bme68xDelayUs, false},
+		{"poll, yield", BME68X_WAIT_POLL, bme68xYieldDelayUs, false},
+		{"scheduled, yield", BME68X_WAIT_SCHEDULED, bme68xYieldDelayUs, false},
+		{"scheduled, light sleep", BME68X_WAIT_SCHEDULED, bme68xLightSleepDelayUs, false},
+	};
+
+	for (const benchCase &c : cases)
+		report(c.name, runCycles(c, cycles, heaterMs, pollUs), cycles);
+
+	return 0;
+}
+
+#endif /* NODE_BENCH */
@@ -20,19 +20,27 @@
 // include the library
 #include <Arduino.h>
 #include <RadioLib.h>
-#define uS_TO_S_FACTOR 1000000
-#define TIME_TO_SLEEP 2
+#include "telemetry_frame.h"
+#include "sleep_planner.h"
 
 // SX1262 has the following connections:
 // NSS pin:   (default 10) 5
 // DIO1 pin:  (default 2) 2
 // NRST pin:  (default 3) 14
 // BUSY pin:  (default 9) 0
-SX1262 radio = new Module(5, 2, 14, 4);
+#define LORA_NSS 5
+#define LORA_DIO1 2
+#define LORA_NRST 14
+#define LORA_BUSY 4
+SX1262 radio = new Module(LORA_NSS, LORA_DIO1, LORA_NRST, LORA_BUSY);
 
 // save transmission state between loops
 int transmissionState = RADIOLIB_ERR_NONE;
 
+// start of the current transmission and the time DIO1 is given to complete it
+int64_t transmissionStartUs = 0;
+uint32_t transmissionTimeoutUs = 0;
+
 // flag to indicate that a packet was sent
 volatile bool transmittedFlag = false;
 
@@ -49,16 +57,72 @@ void setFlag(void)
 	transmittedFlag = true;
 }
 
-void lora_setup();
-void lora_send(String str);
+/* Outcome of an uplink, as reported by lora_send_wait() */
+typedef struct
+{
+	int16_t state;		/* RadioLib status code */
+	uint32_t airtimeUs; /* Time between the start of the transmission and the DIO1 interrupt */
+} loraTxResult;
+
+/* Extra time allowed on top of the computed time on air before giving up on DIO1 */
+#define LORA_TX_TIMEOUT_MARGIN_US 50000
+
+/* LoRa modem settings */
+typedef struct
+{
+	float frequency;
+	float bandwidth;
+	uint8_t spreadingFactor;
+	uint8_t codingRate;
+	int8_t outputPower;
+	uint16_t preambleLength;
+} loraSettings;
+
+const loraSettings defaultLoraSettings = {868.0, 125.0, 10, 6, 14, 4};
+
+/**
+ * @brief : Initializes the radio and checks every setting one by one, used on cold boot
+ * @param[in] settings : Settings to apply
+ */
+void lora_setup(const loraSettings &settings);
+
+/**
+ * @brief : Configures the radio in a single call with settings already validated by lora_setup()
+ * @param[in] settings : Settings to apply
+ */
+void lora_resume(const loraSettings &settings);
+
+/**
+ * @brief : Starts an interrupt driven transmission and returns immediately
+ * @param[in] data : Payload to send
+ * @param[in] len  : Payload length, up to 256 bytes
+ * @return RadioLib status code of startTransmit
+ */
+int16_t lora_send_start(const uint8_t *data, size_t len);
+
+/**
+ * @brief : Light sleeps until the DIO1 interrupt signals the end of the transmission
+ * @return Transmission status and measured airtime
+ */
+loraTxResult lora_send_wait();
+
+/**
+ * @brief : Sends a payload and sleeps until it has left the radio
+ * @param[in] data : Payload to send
+ * @param[in] len  : Payload length, up to 256 bytes
+ * @return Transmission status and measured airtime
+ */
+loraTxResult lora_send(const uint8_t *data, size_t len);
 
 // counter to keep track of transmitted packets
 int count = 0;
 
-/* Use the Espressif EEPROM library. Skip otherwise */
-#if defined(ARDUINO_ARCH_ESP32) || (ARDUINO_ARCH_ESP8266)
+/* Keep the BSEC state in the wear-leveled journal on the "bsecstate" partition. Skip otherwise.
+   The firmware before the journal kept it in EEPROM, which is imported on the first boot */
+#if defined(ARDUINO_ARCH_ESP32)
 #include <EEPROM.h>
-#define USE_EEPROM
+#include "state_journal.h"
+#define USE_STATE_JOURNAL
 #endif
 
 #include <bsec2.h>
@@ -90,37 +154,90 @@ const uint8_t bsec_config[] = {
  * @brief : This function updates/saves BSEC state
  * @param[in] bsec  : Bsec2 class object
  */
-void updateBsecState(Bsec2 bsec);
+void updateBsecState(Bsec2 &bsec);
 
 /**
  * @brief : This function is called by the BSEC library when a new output is available
  * @param[in] input     : BME68X sensor data before processing
  * @param[in] outputs   : Processed BSEC BSEC output data
  * @param[in] bsec      : Instance of BSEC2 calling the callback
+ * @param[in] userCtx   : Context given to attachCallback, unused
  */
-void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec);
+void newDataCallback(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx);
 
 /**
  * @brief : This function retrieves the existing state
  * @param : Bsec2 class object
  */
-bool loadState(Bsec2 bsec);
+bool loadState(Bsec2 &bsec);
 
 /**
- * @brief : This function writes the state into EEPROM
+ * @brief : This function writes the state into the state journal
  * @param : Bsec2 class object
  */
-bool saveState(Bsec2 bsec);
+bool saveState(Bsec2 &bsec);
+
+/**
+ * @brief : This function moves the state kept in EEPROM by the firmware before the state journal into the journal
+ * @return true if bsecState holds the state read from EEPROM
+ */
+bool importEepromState(void);
+
+/**
+ * @brief : Saves the BSEC instance, its schedule and the radio settings to RTC memory and enters deep sleep
+ * @param[in] sleepUs : Sleep duration in microseconds
+ */
+void enterDeepSleep(uint64_t sleepUs);
 
 /* Create an object of the class Bsec2 */
 Bsec2 envSensor;
-#ifdef USE_EEPROM
+uint8_t bsecInstance[BSEC_INSTANCE_SIZE];
+
+/* Everything needed to resume after deep sleep without initializing the algorithm and the radio again */
+#define WARM_BOOT_MAGIC UINT32_C(0x5741524D)
+
+typedef struct
+{
+	uint32_t magic;
+	bsec_bme_settings_t bmeConf; /* BSEC sensor settings, including the next_call schedule */
+	loraSettings lora;
+} warmBootContext;
+
+RTC_DATA_ATTR warmBootContext warmBoot;
+RTC_DATA_ATTR uint8_t rtcBsecInstance[BSEC_INSTANCE_SIZE];
+bool warmStart = false;
+
+/* Awake time instrumentation, esp_timer starts counting at boot */
+int64_t wakeToFirstSampleUs = -1;
+int64_t wakeToTxUs = -1;
+#ifdef USE_STATE_JOURNAL
 static uint8_t bsecState[BSEC_MAX_STATE_BLOB_SIZE];
+PartitionFlash stateFlash("bsecstate");
+StateJournal stateJournal(stateFlash, BSEC_MAX_STATE_BLOB_SIZE);
 #endif
 /* Gas estimate names will be according to the configuration classes used */
 const String gasName[] = {"Field Air", "Hand sanitizer", "Undefined 3", "Undefined 4"};
 
-int counter = 0;
+/* Number of classification outputs since the last uplink, kept through deep sleep */
+RTC_DATA_ATTR int counter = 0;
+
+/* Sleep until the next heater step BSEC scheduled, deep sleep only for gaps worth a reboot */
+const sleepPlannerConfig sleepConfig = {
+	2,	  /* lightSleepMarginMs */
+	400,  /* deepSleepMarginMs */
+	10,	  /* minLightSleepMs */
+	3000, /* minDeepSleepMs */
+};
+
+/* Identifier of this node in the uplink frames */
+#define NODE_ID 1
+
+/* Sequence number survives deep sleep so the receiver can detect lost frames */
+RTC_DATA_ATTR uint16_t frameSequence = 0;
+
+/* Latest sample, sent once per wake cycle before going back to sleep */
+telemetryFrame latestFrame;
+bool framePending = false;
 
 #define GPIO32_3V3 32
 #define GPIO33_AIR 33
@@ -138,49 +255,129 @@ void setup()
 		BSEC_OUTPUT_GAS_ESTIMATE_2,
 		BSEC_OUTPUT_GAS_ESTIMATE_3,
 		BSEC_OUTPUT_GAS_ESTIMATE_4};
+
+	/* State that does not live in RTC memory starts over on every boot. The target clears it at
+	   reset, the native build runs setup() again with the globals of the previous boot */
+	transmissionState = RADIOLIB_ERR_NONE;
+	transmittedFlag = false;
+	wakeToFirstSampleUs = -1;
+	wakeToTxUs = -1;
+	framePending = false;
+
 	Serial.begin(115200);
 	pinMode(GPIO32_3V3, OUTPUT);
 	pinMode(GPIO33_AIR, OUTPUT);
 	pinMode(GPIO25_FIRE, OUTPUT);
 	digitalWrite(GPIO32_3V3, HIGH);
-  #ifdef USE_EEPROM
-    EEPROM.begin(BSEC_MAX_STATE_BLOB_SIZE + 1);
-  #endif
     Wire.begin();
-	esp_sleep_enable_timer_wakeup(TIME_TO_SLEEP * uS_TO_S_FACTOR);
 	delay(100);
-	/* Initialize the library and interfaces */
-	envSensor.begin(BME68X_I2C_ADDR_HIGH, Wire);
 
-	/* Load the configuration string that stores information on how to classify the detected gas */
-	envSensor.setConfig(bsec_config);
+	warmStart = (esp_reset_reason() == ESP_RST_DEEPSLEEP) && (warmBoot.magic == WARM_BOOT_MAGIC);
+	warmBoot.magic = 0;
+	if (warmStart)
+	{
+		/* Continue with the algorithm instance as it was before deep sleep. Timestamps come
+		   from the RTC backed clock of Bsec2, which keeps counting while in deep sleep */
+		memcpy(bsecInstance, rtcBsecInstance, BSEC_INSTANCE_SIZE);
+		envSensor.resumeInstance(warmBoot.bmeConf);
+	}
+	else
+	{
+		warmBoot.lora = defaultLoraSettings;
+	}
+	envSensor.allocateMemory(bsecInstance);
+
+	/* Initialize the library and interfaces, the sensor waits in light sleep rather than busy-waiting */
+	envSensor.begin(BME68X_I2C_ADDR_HIGH, Wire, bme68xLightSleepDelayUs);
+	envSensor.sensor.setWaitStrategy(BME68X_WAIT_SCHEDULED);
 
-	/* Copy state from the EEPROM to the algorithm */
-	loadState(envSensor);
+	if (!warmStart)
+	{
+		/* Load the configuration string that stores information on how to classify the detected gas */
+		envSensor.setConfig(bsec_config);
+
+		/* Copy state from the state journal to the algorithm */
+		loadState(envSensor);
 
-	/* Subscribe for the desired BSEC2 outputs */
-	envSensor.updateSubscription(sensorList, ARRAY_LEN(sensorList), BSEC_SAMPLE_RATE_SCAN);
+		/* Subscribe for the desired BSEC2 outputs */
+		envSensor.updateSubscription(sensorList, ARRAY_LEN(sensorList), BSEC_SAMPLE_RATE_SCAN);
+	}
 
 	/* Whenever new data is available call the newDataCallback function */
 	envSensor.attachCallback(newDataCallback);
-	lora_setup();
+
+	if (warmStart)
+		lora_resume(warmBoot.lora);
+	else
+		lora_setup(warmBoot.lora);
 }
 
 void loop()
 {
 	envSensor.run();
-	if (counter == 2)
+	if (counter >= 2)
 	{
-		delay(2000);
-		printf("GOING TO SLEEP for 0.5min\n");
-		esp_sleep_enable_timer_wakeup(1000000 * 1);
-		esp_deep_sleep_start();
+		if (framePending)
+		{
+			uint8_t payload[TELEMETRY_FRAME_SIZE];
+
+			latestFrame.nodeId = NODE_ID;
+			latestFrame.sequence = frameSequence++;
+			lora_send(payload, telemetryEncode(latestFrame, payload, sizeof(payload)));
+			wakeToTxUs = esp_timer_get_time();
+			framePending = false;
+		}
+
+		printf("%s boot: wake to first sample %lld us, wake to TX %lld us\n", warmStart ? "Warm" : "Cold",
+			   (long long)wakeToFirstSampleUs, (long long)wakeToTxUs);
 
 		counter = 0;
 	}
+
+	sleepPlan plan = planSleep(sleepConfig, envSensor.getTimeToNextCallMs());
+	switch (plan.mode)
+	{
+	case SLEEP_DEEP:
+		printf("GOING TO DEEP SLEEP for %llu ms\n", (unsigned long long)(plan.durationUs / 1000));
+		Serial.flush();
+		enterDeepSleep(plan.durationUs);
+		break;
+	case SLEEP_LIGHT:
+		Serial.flush();
+		esp_sleep_enable_timer_wakeup(plan.durationUs);
+		esp_light_sleep_start();
+		break;
+	default:
+		break;
+	}
+}
+
+void enterDeepSleep(uint64_t sleepUs)
+{
+	memcpy(rtcBsecInstance, bsecInstance, BSEC_INSTANCE_SIZE);
+	warmBoot.bmeConf = envSensor.getBmeSettings();
+	warmBoot.magic = WARM_BOOT_MAGIC;
+
+	// keep the radio in its lowest power state until the next uplink
+	radio.sleep();
+
+	esp_sleep_enable_timer_wakeup(sleepUs);
+	esp_deep_sleep_start();
+}
+
+void lora_resume(const loraSettings &settings)
+{
+	int state = radio.begin(settings.frequency, settings.bandwidth, settings.spreadingFactor, settings.codingRate,
+							RADIOLIB_SX126X_SYNC_WORD_PRIVATE, settings.outputPower, settings.preambleLength);
+	if (state != RADIOLIB_ERR_NONE)
+	{
+		Serial.print(F("[SX1262] Resume failed, code "));
+		Serial.println(state);
+		lora_setup(settings);
+	}
 }
 
-void lora_setup()
+void lora_setup(const loraSettings &settings)
 {
 
 	// initialize SX1262 with default settings
@@ -202,7 +399,7 @@ void lora_setup()
 	// and check if the configuration was changed successfully
 
 	// set carrier frequency to 433.5 MHz
-	if (radio.setFrequency(868.0) == RADIOLIB_ERR_INVALID_FREQUENCY)
+	if (radio.setFrequency(settings.frequency) == RADIOLIB_ERR_INVALID_FREQUENCY)
 	{
 		Serial.println(F("Selected frequency is invalid for this module!"));
 		while (true)
@@ -210,7 +407,7 @@ void lora_setup()
 	}
 
 	// set bandwidth to 250 kHz
-	if (radio.setBandwidth(125.0) == RADIOLIB_ERR_INVALID_BANDWIDTH)
+	if (radio.setBandwidth(settings.bandwidth) == RADIOLIB_ERR_INVALID_BANDWIDTH)
 	{
 		Serial.println(F("Selected bandwidth is invalid for this module!"));
 		while (true)
@@ -218,7 +415,7 @@ void lora_setup()
 	}
 
 	// set spreading factor to 10
-	if (radio.setSpreadingFactor(10) == RADIOLIB_ERR_INVALID_SPREADING_FACTOR)
+	if (radio.setSpreadingFactor(settings.spreadingFactor) == RADIOLIB_ERR_INVALID_SPREADING_FACTOR)
 	{
 		Serial.println(F("Selected spreading factor is invalid for this module!"));
 		while (true)
@@ -226,7 +423,7 @@ void lora_setup()
 	}
 
 	// set coding rate to 6
-	if (radio.setCodingRate(6) == RADIOLIB_ERR_INVALID_CODING_RATE)
+	if (radio.setCodingRate(settings.codingRate) == RADIOLIB_ERR_INVALID_CODING_RATE)
 	{
 		Serial.println(F("Selected coding rate is invalid for this module!"));
 		while (true)
@@ -240,7 +437,7 @@ void lora_setup()
 	//}
 
 	// set output power to 10 dBm (accepted range is -17 - 22 dBm)
-	if (radio.setOutputPower(14) == RADIOLIB_ERR_INVALID_OUTPUT_POWER)
+	if (radio.setOutputPower(settings.outputPower) == RADIOLIB_ERR_INVALID_OUTPUT_POWER)
 	{
 		Serial.println(F("Selected output power is invalid for this module!"));
 		while (true)
@@ -255,7 +452,7 @@ void lora_setup()
 	//}
 
 	// set LoRa preamble length to 15 symbols (accepted range is 0 - 65535)
-	if (radio.setPreambleLength(4) == RADIOLIB_ERR_INVALID_PREAMBLE_LENGTH)
+	if (radio.setPreambleLength(settings.preambleLength) == RADIOLIB_ERR_INVALID_PREAMBLE_LENGTH)
 	{
 		Serial.println(F("Selected preamble length is invalid for this module!"));
 		while (true)
@@ -263,58 +460,101 @@ void lora_setup()
 	}
 }
 
-void lora_send(String str)
+int16_t lora_send_start(const uint8_t *data, size_t len)
 {
 	// set the function that will be called
 	// when packet transmission is finished
 	radio.setPacketSentAction(setFlag);
+	transmittedFlag = false;
 
-	// start transmitting the first packet
-	Serial.print(F("[SX1262] Sending first packet ... "));
+	transmissionTimeoutUs = radio.getTimeOnAir(len) + LORA_TX_TIMEOUT_MARGIN_US;
+	transmissionStartUs = esp_timer_get_time();
 
-	// you can transmit C-string or Arduino string up to
-	// 256 characters long
-	transmissionState = radio.startTransmit(str);
+	// transmit the binary telemetry frame, up to 256 bytes long
+	transmissionState = radio.startTransmit(data, len);
+
+	return transmissionState;
+}
+
+loraTxResult lora_send_wait()
+{
+	loraTxResult result = {(int16_t)transmissionState, 0};
 
-	// you can also transmit byte array up to 256 bytes long
-	/*
-	  byte byteArr[] = {0x01, 0x23, 0x45, 0x67,
-						0x89, 0xAB, 0xCD, 0xEF};
-	  state = radio.startTransmit(byteArr, 8);
-	*/
-	while (transmittedFlag == false)
+	if (transmissionState == RADIOLIB_ERR_NONE)
 	{
+		// DIO1 stays high until finishTransmit() clears the IRQ, so a level
+		// wakeup also catches a transmission that completed before sleeping.
+		// The level wakeup makes the pin interrupt level triggered too, setFlag
+		// would fire for as long as DIO1 is high: it is detached and the loop
+		// reads the pin instead
+		radio.clearPacketSentAction();
+		gpio_wakeup_enable((gpio_num_t)LORA_DIO1, GPIO_INTR_HIGH_LEVEL);
+		esp_sleep_enable_gpio_wakeup();
+
+		Serial.flush();
+		while (!transmittedFlag && digitalRead(LORA_DIO1) == LOW)
+		{
+			int64_t elapsedUs = esp_timer_get_time() - transmissionStartUs;
+			if (elapsedUs >= transmissionTimeoutUs)
+			{
+				result.state = RADIOLIB_ERR_TX_TIMEOUT;
+				break;
+			}
+
+			esp_sleep_enable_timer_wakeup(transmissionTimeoutUs - elapsedUs);
+			esp_light_sleep_start();
+		}
+
+		// esp_timer keeps counting through light sleep
+		result.airtimeUs = (uint32_t)(esp_timer_get_time() - transmissionStartUs);
+
+		esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+		esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+		gpio_wakeup_disable((gpio_num_t)LORA_DIO1);
+		// gpio_wakeup_disable() leaves the level type, back to the rising edge of setPacketSentAction()
+		gpio_set_intr_type((gpio_num_t)LORA_DIO1, GPIO_INTR_POSEDGE);
 	}
+
 	// reset flag
 	transmittedFlag = false;
 
-	if (transmissionState == RADIOLIB_ERR_NONE)
-	{
-		// packet was successfully sent
-		Serial.println(F("transmission finished!"));
+	// clean up after transmission is finished
+	// this will ensure transmitter is disabled,
+	// RF switch is powered down etc.
+	radio.finishTransmit();
+
+	return result;
+}
+
+loraTxResult lora_send(const uint8_t *data, size_t len)
+{
+	Serial.print(F("[SX1262] Sending packet ... "));
+
+	lora_send_start(data, len);
+	loraTxResult result = lora_send_wait();
 
-		// NOTE: when using interrupt-driven transmit method,
-		//       it is not possible to automatically measure
-		//       transmission data rate using getDataRate()
+	if (result.state == RADIOLIB_ERR_NONE)
+	{
+		Serial.print(F("transmission finished in "));
+		Serial.print(result.airtimeUs);
+		Serial.println(F(" us"));
 	}
 	else
 	{
 		Serial.print(F("failed, code "));
-		Serial.println(transmissionState);
+		Serial.println(result.state);
 	}
 
-	// clean up after transmission is finished
-	// this will ensure transmitter is disabled,
-	// RF switch is powered down etc.
-	radio.finishTransmit();
+	return result;
 }
 
-void updateBsecState(Bsec2 bsec)
+void updateBsecState(Bsec2 &bsec)
 {
-	static uint16_t stateUpdateCounter = 0;
+	/* Counted on the BSEC clock, which keeps running through deep sleep */
+	RTC_DATA_ATTR static uint16_t stateUpdateCounter = 0;
 	bool update = false;
 
-	if (!stateUpdateCounter || (stateUpdateCounter * STATE_SAVE_PERIOD) < millis())
+	if (!stateUpdateCounter || (stateUpdateCounter * STATE_SAVE_PERIOD) < bsec.getTimeMs())
 	{
 		/* Update every STATE_SAVE_PERIOD minutes */
 		update = true;
@@ -326,36 +566,35 @@ void updateBsecState(Bsec2 bsec)
 	}
 }
 
-void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec)
+void newDataCallback(const bme68xData &data, const bsecOutputs &outputs, Bsec2 &bsec, void *userCtx)
 {
 	if (!outputs.nOutputs)
 	{
 		return;
 	}
 
+	if (wakeToFirstSampleUs < 0)
+		wakeToFirstSampleUs = esp_timer_get_time();
+
 	// Serial.println("BSEC outputs:\n\ttimestamp = " + String((int) (outputs.output[0].time_stamp / INT64_C(1000000))));
 	uint8_t index = 0;
-	String message="";
 
 	for (uint8_t i = 0; i < outputs.nOutputs; i++)
 	{
-		const bsecData output = outputs.output[i];
+		const bsecData &output = outputs.output[i];
 		switch (output.sensor_id)
 		{
 		case BSEC_OUTPUT_RAW_TEMPERATURE:
 			// Serial.println("\ttemperature = " + String(output.signal));
-			//Add to message the temperature
-			message+=String(output.signal)+" ";
+			latestFrame.temperature = telemetryScale(output.signal, TELEMETRY_TEMPERATURE_SCALE);
 			break;
 		case BSEC_OUTPUT_RAW_PRESSURE:
 			// Serial.println("\tpressure = " + String(output.signal));
-			//Add to message the pressure
-			message+=String(output.signal)+" ";
+			latestFrame.pressure = telemetryScale(output.signal, TELEMETRY_PRESSURE_SCALE);
 			break;
 		case BSEC_OUTPUT_RAW_HUMIDITY:
 			// Serial.println("\thumidity = " + String(output.signal));
-			//Add to message the humidity
-			message+=String(output.signal)+" ";
+			latestFrame.humidity = telemetryScale(output.signal, TELEMETRY_HUMIDITY_SCALE);
 			break;
 		case BSEC_OUTPUT_RAW_GAS:
 			// Serial.println("\tgas resistance = " + String(output.signal));
@@ -372,16 +611,17 @@ void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bse
 		case BSEC_OUTPUT_GAS_ESTIMATE_1:
 		case BSEC_OUTPUT_GAS_ESTIMATE_2:
 			index = (output.sensor_id - BSEC_OUTPUT_GAS_ESTIMATE_1);
+			latestFrame.classProb[index] = telemetryQuantizeProbability(output.signal);
 			if (index == 0) // The four classes are updated from BSEC with same accuracy, thus printing is done just once.
 			{
 				// Serial.println("\taccuracy = " + String(output.accuracy));
+				latestFrame.accuracy = output.accuracy;
+				framePending = true;
 				counter++;
 			}
 			if (index == 0)
 			{
 				Serial.println("\tFIRE" + String(index + 1) + " probability : " + String(output.signal * 100) + "%");
-				//Add to message the fire probability
-				//message+=String(output.signal * 100)+" ";
 				if(counter==2 && output.signal*100>70){
 					//Set gpio FIRE to HIGH
 					digitalWrite(GPIO25_FIRE, HIGH);
@@ -389,8 +629,6 @@ void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bse
 			}
 			if (index == 1){
 				Serial.println("\tAMBIENT AIR" + String(index + 1) + " probability : " + String(output.signal * 100) + "%");
-				//Add to message the ambient air probability
-				//message+=String(output.signal * 100)+" ";
 				if(counter==2 && output.signal*100>70){
 					//Set gpio AIR to HIGH
 					digitalWrite(GPIO33_AIR, HIGH);
@@ -399,66 +637,70 @@ void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bse
 			break;
 		case BSEC_OUTPUT_GAS_ESTIMATE_3:
 		case BSEC_OUTPUT_GAS_ESTIMATE_4:
+			index = (output.sensor_id - BSEC_OUTPUT_GAS_ESTIMATE_1);
+			latestFrame.classProb[index] = telemetryQuantizeProbability(output.signal);
 			break;
 		default:
 			break;
 		}
 	}
 
-	updateBsecState(envSensor);
+	updateBsecState(bsec);
 }
 
-bool loadState(Bsec2 bsec)
+bool loadState(Bsec2 &bsec)
 {
-#ifdef USE_EEPROM
+#ifdef USE_STATE_JOURNAL
+	size_t length = 0;
 
-	if (EEPROM.read(0) == BSEC_MAX_STATE_BLOB_SIZE)
+	/* Start from a fresh algorithm state if neither the journal nor the EEPROM hold a valid state */
+	if ((stateJournal.load(bsecState, sizeof(bsecState), length) && length == BSEC_MAX_STATE_BLOB_SIZE) ||
+		importEepromState())
 	{
-		/* Existing state in EEPROM */
-		// Serial.println("Reading state from EEPROM");
-		// Serial.print("State file: ");
-		for (uint8_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
-		{
-			bsecState[i] = EEPROM.read(i + 1);
-			// Serial.print(String(bsecState[i], HEX) + ", ");
-		}
-		// Serial.println();
-
 		if (!bsec.setState(bsecState))
 			return false;
 	}
-	else
-	{
-		/* Erase the EEPROM with zeroes */
-		// Serial.println("Erasing EEPROM");
-
-		for (uint8_t i = 0; i <= BSEC_MAX_STATE_BLOB_SIZE; i++)
-			EEPROM.write(i, 0);
-
-		EEPROM.commit();
-	}
 #endif
 	return true;
 }
 
-bool saveState(Bsec2 bsec)
+bool importEepromState(void)
 {
-#ifdef USE_EEPROM
-	if (!bsec.getState(bsecState))
-		return false;
+	bool found = false;
 
-	// Serial.println("Writing state to EEPROM");
-	// Serial.print("State file: ");
+#ifdef USE_STATE_JOURNAL
+	/* The nvs partition keeps its place in partitions.csv, the EEPROM data survives the new table */
+	if (!EEPROM.begin(BSEC_MAX_STATE_BLOB_SIZE + 1))
+		return false;
 
-	for (uint8_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
+	if (EEPROM.read(0) == BSEC_MAX_STATE_BLOB_SIZE)
 	{
-		EEPROM.write(i + 1, bsecState[i]);
-		// Serial.print(String(bsecState[i], HEX) + ", ");
+		/* Existing state in EEPROM */
+		for (uint8_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
+			bsecState[i] = EEPROM.read(i + 1);
+		found = true;
+
+		/* Imported once, the journal holds the state from now on */
+		if (stateJournal.save(bsecState, BSEC_MAX_STATE_BLOB_SIZE))
+		{
+			EEPROM.write(0, 0);
+			EEPROM.commit();
+		}
 	}
-	// Serial.println();
+	EEPROM.end();
+#endif
+	return found;
+}
+
+bool saveState(Bsec2 &bsec)
+{
+#ifdef USE_STATE_JOURNAL
+	if (!bsec.getState(bsecState))
+		return false;
 
-	EEPROM.write(0, BSEC_MAX_STATE_BLOB_SIZE);
-	EEPROM.commit();
+	/* Nothing is written if the state did not change since the last save */
+	if (!stateJournal.save(bsecState, BSEC_MAX_STATE_BLOB_SIZE))
+		return false;
 #endif
 	return true;
 }
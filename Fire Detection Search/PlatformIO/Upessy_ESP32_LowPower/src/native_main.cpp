@@ -0,0 +1,142 @@
+/*
+  Entry point of the native environment
+
+  Runs the node firmware of main.cpp on the host against the shims of
+  lib/NativeShims: a fake BME688 on the I2C bus, the BSEC stand-in and an
+  SX1262 whose packets are decoded here as the gateway would. Time is
+  virtual, so hours of duty cycling run in seconds and every run with the
+  same script prints the same frames.
+
+  Usage: program [--seconds N] [--loops N] [--script FILE]
+    --seconds : Virtual time to run, 600 by default
+    --loops   : Stop after this many calls of loop(), no limit by default
+    --script  : Sample timeline of the fake BME688, see FakeBme688::loadScript()
+*/
+
+#ifdef NODE_NATIVE
+
+#include <chrono>
+
+#include <Arduino.h>
+#include <FakeBme688.h>
+#include <RadioLib.h>
+#include <Wire.h>
+
+#include "telemetry_frame.h"
+
+#define NATIVE_BME688_ADDR 0x77
+
+/* A loop() that neither sleeps nor waits still takes time on the target */
+#define NATIVE_LOOP_COST_US 1000
+
+void setup();
+void loop();
+
+extern SX1262 radio;
+
+static FakeBme688 bme688;
+
+typedef struct
+{
+	uint32_t frames;
+	uint32_t badFrames;
+} gatewayStats;
+
+/**
+ * @brief : Decodes every uplink, as the LoRa gateway would
+ */
+static void gatewayReceive(const uint8_t *data, size_t length, void *ctx)
+{
+	gatewayStats *stats = (gatewayStats *)ctx;
+	telemetryFrame frame;
+
+	if (!telemetryDecode(data, length, frame))
+	{
+		stats->badFrames++;
+		printf("FRAME t=%.3f invalid, %u bytes\n", nativeNowUs() / 1e6, (unsigned)length);
+		return;
+	}
+
+	stats->frames++;
+	printf("FRAME t=%.3f node=%u seq=%u T=%.2f H=%.2f P=%.1f class=%.3f/%.3f/%.3f/%.3f acc=%u\n", nativeNowUs() / 1e6,
+		   frame.nodeId, frame.sequence, telemetryTemperature(frame), telemetryHumidity(frame), telemetryPressure(frame),
+		   telemetryProbability(frame, 0), telemetryProbability(frame, 1), telemetryProbability(frame, 2),
+		   telemetryProbability(frame, 3), frame.accuracy);
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t runUs = UINT64_C(600) * 1000000;
+	uint64_t maxLoops = 0;
+	gatewayStats stats = {0, 0};
+	uint64_t loops = 0, boots = 1, deepSleeps = 0;
+	double hostTotalUs = 0, hostMaxUs = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+			runUs = strtoull(argv[++i], nullptr, 10) * 1000000;
+		else if (!strcmp(argv[i], "--loops") && i + 1 < argc)
+			maxLoops = strtoull(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--script") && i + 1 < argc)
+		{
+			const char *path = argv[++i];
+			if (bme688.loadScript(path) == 0)
+			{
+				fprintf(stderr, "No sample in %s\n", path);
+				return 1;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--seconds N] [--loops N] [--script FILE]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Wire.attach(NATIVE_BME688_ADDR, bme688);
+	nativeRadioSetTxHook(gatewayReceive, &stats);
+
+	nativeBoot(false);
+	setup();
+
+	while (nativeNowUs() < runUs && (maxLoops == 0 || loops < maxLoops))
+	{
+		uint64_t virtualStartUs = nativeNowUs();
+		auto hostStart = std::chrono::steady_clock::now();
+
+		try
+		{
+			loop();
+		}
+		catch (const nativeDeepSleep &sleep)
+		{
+			/* The target resets on wake, run setup() again as a deep sleep boot */
+			nativeAdvanceUs(sleep.durationUs);
+			nativeBoot(true);
+			deepSleeps++;
+			boots++;
+			setup();
+		}
+
+		double hostUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - hostStart).count();
+		hostTotalUs += hostUs;
+		if (hostUs > hostMaxUs)
+			hostMaxUs = hostUs;
+		loops++;
+
+		if (nativeNowUs() == virtualStartUs)
+			nativeAdvanceUs(NATIVE_LOOP_COST_US);
+	}
+
+	printf("SUMMARY virtual=%.3f s loops=%llu boots=%llu deep_sleeps=%llu frames=%u bad_frames=%u\n", nativeNowUs() / 1e6,
+		   (unsigned long long)loops, (unsigned long long)boots, (unsigned long long)deepSleeps, stats.frames,
+		   stats.badFrames);
+	printf("SUMMARY host_loop_mean=%.2f us host_loop_max=%.2f us measurements=%u i2c_transactions=%u i2c_bytes=%u\n",
+		   loops ? hostTotalUs / loops : 0.0, hostMaxUs, bme688.measurements, Wire.transactions, Wire.bytes);
+	printf("SUMMARY packets=%u airtime=%.3f s\n", radio.packetsSent, radio.airtimeUs / 1e6);
+
+	return stats.badFrames ? 2 : 0;
+}
+
+#endif /* NODE_NATIVE */
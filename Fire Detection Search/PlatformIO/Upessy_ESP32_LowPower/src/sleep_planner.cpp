@@ -0,0 +1,21 @@
+#include "sleep_planner.h"
+
+sleepPlan planSleep(const sleepPlannerConfig &config, int64_t timeToNextCallMs)
+{
+	sleepPlan plan = {SLEEP_NONE, 0};
+
+	if (timeToNextCallMs >= (int64_t)config.minDeepSleepMs &&
+		timeToNextCallMs > (int64_t)config.deepSleepMarginMs)
+	{
+		plan.mode = SLEEP_DEEP;
+		plan.durationUs = (uint64_t)(timeToNextCallMs - config.deepSleepMarginMs) * 1000;
+	}
+	else if (timeToNextCallMs >= (int64_t)config.minLightSleepMs &&
+			 timeToNextCallMs > (int64_t)config.lightSleepMarginMs)
+	{
+		plan.mode = SLEEP_LIGHT;
+		plan.durationUs = (uint64_t)(timeToNextCallMs - config.lightSleepMarginMs) * 1000;
+	}
+
+	return plan;
+}
@@ -0,0 +1,305 @@
+#include <string.h>
+
+#include "state_journal.h"
+
+#define JOURNAL_ERASED_MAGIC UINT16_C(0xFFFF)
+#define JOURNAL_SLOT_ALIGN 16
+
+uint32_t journalCrc32(const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+		for (uint8_t bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+
+	return ~crc;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+PartitionFlash::PartitionFlash(const char *label) : label(label), partition(nullptr)
+{
+}
+
+bool PartitionFlash::find()
+{
+	if (partition == nullptr)
+		partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+
+	return partition != nullptr;
+}
+
+uint32_t PartitionFlash::sectorSize()
+{
+	return SPI_FLASH_SEC_SIZE;
+}
+
+uint32_t PartitionFlash::sectorCount()
+{
+	return find() ? partition->size / SPI_FLASH_SEC_SIZE : 0;
+}
+
+bool PartitionFlash::read(uint32_t offset, void *data, size_t length)
+{
+	return find() && esp_partition_read(partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionFlash::write(uint32_t offset, const void *data, size_t length)
+{
+	return find() && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionFlash::eraseSector(uint32_t sector)
+{
+	return find() && esp_partition_erase_range(partition, sector * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE) == ESP_OK;
+}
+#endif
+
+SimulatedFlash::SimulatedFlash(uint32_t sectorSize, uint32_t sectorCount)
+	: violations(0), size(sectorSize), count(sectorCount)
+{
+	memory = new uint8_t[size * count];
+	erases = new uint32_t[count];
+	memset(memory, 0xFF, size * count);
+	memset(erases, 0, count * sizeof(uint32_t));
+}
+
+SimulatedFlash::~SimulatedFlash()
+{
+	delete[] memory;
+	delete[] erases;
+}
+
+uint32_t SimulatedFlash::sectorSize()
+{
+	return size;
+}
+
+uint32_t SimulatedFlash::sectorCount()
+{
+	return count;
+}
+
+bool SimulatedFlash::read(uint32_t offset, void *data, size_t length)
+{
+	if (offset + length > size * count)
+		return false;
+
+	memcpy(data, &memory[offset], length);
+	return true;
+}
+
+bool SimulatedFlash::write(uint32_t offset, const void *data, size_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	if (offset + length > size * count)
+		return false;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		/* NOR flash can only clear bits */
+		if (bytes[i] & ~memory[offset + i])
+			violations++;
+		memory[offset + i] &= bytes[i];
+	}
+
+	return true;
+}
+
+bool SimulatedFlash::eraseSector(uint32_t sector)
+{
+	if (sector >= count)
+		return false;
+
+	memset(&memory[sector * size], 0xFF, size);
+	erases[sector]++;
+	return true;
+}
+
+uint32_t SimulatedFlash::eraseCount(uint32_t sector)
+{
+	return sector < count ? erases[sector] : 0;
+}
+
+uint32_t SimulatedFlash::maxEraseCount()
+{
+	uint32_t maxCount = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+		if (erases[i] > maxCount)
+			maxCount = erases[i];
+
+	return maxCount;
+}
+
+StateJournal::StateJournal(JournalFlash &flash, size_t slotPayload)
+	: skippedWrites(0), flash(flash), slotsPerSector(0), mounted(false), hasRecord(false), lastSequence(0),
+	  lastOffset(0), lastCrc(0), lastLength(0), currentSector(0), nextSlot(0)
+{
+	if (slotPayload > JOURNAL_MAX_PAYLOAD)
+		slotPayload = JOURNAL_MAX_PAYLOAD;
+
+	slotSize = (sizeof(journalRecordHeader) + slotPayload + JOURNAL_SLOT_ALIGN - 1) & ~(JOURNAL_SLOT_ALIGN - 1);
+}
+
+uint32_t StateJournal::slotOffset(uint32_t sector, uint32_t slot)
+{
+	return sector * flash.sectorSize() + slot * slotSize;
+}
+
+bool StateJournal::mount()
+{
+	journalRecordHeader header;
+	uint8_t payload[JOURNAL_MAX_PAYLOAD];
+	uint32_t sectors = flash.sectorCount();
+
+	mounted = false;
+	hasRecord = false;
+	slotsPerSector = flash.sectorSize() / slotSize;
+	/* Rotation erases a sector, at least one more is needed to keep the newest record */
+	if (sectors < 2 || slotsPerSector == 0)
+		return false;
+
+	for (uint32_t sector = 0; sector < sectors; sector++)
+	{
+		for (uint32_t slot = 0; slot < slotsPerSector; slot++)
+		{
+			uint32_t offset = slotOffset(sector, slot);
+
+			if (!flash.read(offset, &header, sizeof(header)))
+				return false;
+
+			/* Slots are filled in order, the rest of the sector is blank */
+			if (header.magic == JOURNAL_ERASED_MAGIC)
+				break;
+
+			if (header.magic != JOURNAL_RECORD_MAGIC || header.version != JOURNAL_RECORD_VERSION ||
+				header.length > slotSize - sizeof(header))
+				continue;
+
+			if (!flash.read(offset + sizeof(header), payload, header.length))
+				return false;
+
+			if (journalCrc32(payload, header.length) != header.crc)
+				continue;
+
+			if (!hasRecord || (int32_t)(header.sequence - lastSequence) > 0)
+			{
+				hasRecord = true;
+				lastSequence = header.sequence;
+				lastOffset = offset;
+				lastCrc = header.crc;
+				lastLength = header.length;
+				currentSector = sector;
+				nextSlot = slot + 1;
+			}
+		}
+	}
+
+	if (!hasRecord)
+	{
+		/* Unknown content, the first save starts over with an erased first sector */
+		currentSector = sectors - 1;
+		nextSlot = slotsPerSector;
+	}
+	else
+	{
+		/* Skip torn slots following the newest record */
+		while (nextSlot < slotsPerSector)
+		{
+			if (!flash.read(slotOffset(currentSector, nextSlot), &header, sizeof(header)))
+				return false;
+			if (header.magic == JOURNAL_ERASED_MAGIC)
+				break;
+			nextSlot++;
+		}
+	}
+
+	mounted = true;
+	return true;
+}
+
+bool StateJournal::load(uint8_t *data, size_t maxLen, size_t &length)
+{
+	if (!mounted && !mount())
+		return false;
+
+	if (!hasRecord || lastLength > maxLen)
+		return false;
+
+	if (!flash.read(lastOffset + sizeof(journalRecordHeader), data, lastLength))
+		return false;
+
+	length = lastLength;
+	return true;
+}
+
+bool StateJournal::sameAsLast(const uint8_t *data, size_t length, uint32_t crc)
+{
+	uint8_t stored[JOURNAL_MAX_PAYLOAD];
+
+	if (!hasRecord || length != lastLength || crc != lastCrc)
+		return false;
+
+	if (!flash.read(lastOffset + sizeof(journalRecordHeader), stored, length))
+		return false;
+
+	return memcmp(stored, data, length) == 0;
+}
+
+bool StateJournal::save(const uint8_t *data, size_t length)
+{
+	uint8_t record[sizeof(journalRecordHeader) + JOURNAL_MAX_PAYLOAD];
+	journalRecordHeader header;
+	uint32_t crc;
+	uint32_t offset;
+
+	if (!mounted && !mount())
+		return false;
+
+	if (length > slotSize - sizeof(journalRecordHeader))
+		return false;
+
+	crc = journalCrc32(data, length);
+	if (sameAsLast(data, length, crc))
+	{
+		skippedWrites++;
+		return true;
+	}
+
+	if (nextSlot >= slotsPerSector)
+	{
+		currentSector = (currentSector + 1) % flash.sectorCount();
+		if (!flash.eraseSector(currentSector))
+			return false;
+		nextSlot = 0;
+	}
+
+	memset(&header, 0xFF, sizeof(header));
+	header.magic = JOURNAL_RECORD_MAGIC;
+	header.version = JOURNAL_RECORD_VERSION;
+	header.sequence = hasRecord ? lastSequence + 1 : 0;
+	header.length = (uint16_t)length;
+	header.crc = crc;
+
+	/* Header first, so a torn write can only leave a record failing its CRC */
+	memcpy(record, &header, sizeof(header));
+	memcpy(&record[sizeof(header)], data, length);
+
+	offset = slotOffset(currentSector, nextSlot);
+	nextSlot++;
+	if (!flash.write(offset, record, sizeof(header) + length))
+		return false;
+
+	hasRecord = true;
+	lastSequence = header.sequence;
+	lastOffset = offset;
+	lastCrc = crc;
+	lastLength = header.length;
+
+	return true;
+}
@@ -0,0 +1,72 @@
+#include "telemetry_frame.h"
+
+static void putU16(uint8_t *buffer, uint16_t value)
+{
+	buffer[0] = (uint8_t)(value & 0xFF);
+	buffer[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t getU16(const uint8_t *buffer)
+{
+	return (uint16_t)(buffer[0] | ((uint16_t)buffer[1] << 8));
+}
+
+int16_t telemetryScale(float value, float scale)
+{
+	float scaled = value * scale;
+
+	/* NaN, a failed reading, has no place in the range */
+	if (scaled != scaled)
+		return 0;
+	if (scaled >= INT16_MAX)
+		return INT16_MAX;
+	if (scaled <= INT16_MIN)
+		return INT16_MIN;
+
+	return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+uint8_t telemetryQuantizeProbability(float probability)
+{
+	if (!(probability > 0.0f))
+		return 0;
+	if (probability >= 1.0f)
+		return UINT8_MAX;
+
+	return (uint8_t)(probability * TELEMETRY_PROBABILITY_SCALE + 0.5f);
+}
+
+size_t telemetryEncode(const telemetryFrame &frame, uint8_t *buffer, size_t length)
+{
+	if (buffer == nullptr || length < TELEMETRY_FRAME_SIZE)
+		return 0;
+
+	buffer[0] = TELEMETRY_FRAME_VERSION;
+	putU16(&buffer[1], frame.nodeId);
+	putU16(&buffer[3], frame.sequence);
+	putU16(&buffer[5], (uint16_t)frame.temperature);
+	putU16(&buffer[7], (uint16_t)frame.humidity);
+	putU16(&buffer[9], (uint16_t)frame.pressure);
+	for (uint8_t i = 0; i < TELEMETRY_NUM_CLASSES; i++)
+		buffer[11 + i] = frame.classProb[i];
+	buffer[15] = frame.accuracy;
+
+	return TELEMETRY_FRAME_SIZE;
+}
+
+bool telemetryDecode(const uint8_t *buffer, size_t length, telemetryFrame &frame)
+{
+	if (buffer == nullptr || length != TELEMETRY_FRAME_SIZE || buffer[0] != TELEMETRY_FRAME_VERSION)
+		return false;
+
+	frame.nodeId = getU16(&buffer[1]);
+	frame.sequence = getU16(&buffer[3]);
+	frame.temperature = (int16_t)getU16(&buffer[5]);
+	frame.humidity = (int16_t)getU16(&buffer[7]);
+	frame.pressure = (int16_t)getU16(&buffer[9]);
+	for (uint8_t i = 0; i < TELEMETRY_NUM_CLASSES; i++)
+		frame.classProb[i] = buffer[11 + i];
+	frame.accuracy = buffer[15];
+
+	return true;
+}
@@ -0,0 +1,198 @@
+/*
+  Converter of the binary raw data logs of the bme68x_demo_sample datalogger
+
+  The datalogger writes .bmerawbin files, see raw_data_format.h of the
+  example: a header, the JSON text of the .bmerawdata file up to its first
+  data row, then one binary record per sample. This program prints the JSON
+  text and the records as the dataBlock rows, formatted as the datalogger
+  formatted them before, so the output is a .bmerawdata file for the tools
+  that read them.
+
+  A record cut short at the end of the file, after a power loss while
+  writing, is dropped with a warning. The datalogger preallocates its files
+  and cuts them at the size written when it closes them, a file that was
+  not closed ends with the unwritten preallocation: a length byte of 0x00
+  or 0xFF, as erased card sectors read, ends the records there.
+
+  Usage: program <file.bmerawbin> [<file.bmerawdata>]
+  Writes to stdout without an output file. Exits with 1 on a file that is
+  not a raw data log or has a corrupt record.
+*/
+
+#ifdef NODE_TOOL
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raw_data_format.h"
+
+/* End of the JSON document, as the dataloggers wrote it after the last row or without rows */
+#define BME68X_ROWS_END "\n\t    ]\n\t}\n}\r\n"
+#define BSEC_ROWS_END "\n\t\t]\n\t}\n}"
+#define NO_ROWS_END "\t\t]\r\n\t}\r\n}\r\n"
+
+/**
+ * @brief : Prints a record as a dataBlock row, bme68xDataLogger formatting
+ */
+static void printBme68xRow(FILE *out, const raw_data_record &r)
+{
+	bool hasData = r.present & RAW_DATA_HAS_DATA;
+
+	fputs("\t\t\t[\n\t\t\t\t", out);
+	(r.present & RAW_DATA_HAS_NUM) ? fprintf(out, "%u", (unsigned)r.sensor_num) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	(r.present & RAW_DATA_HAS_SENSOR_ID) ? fprintf(out, "%u", (unsigned)r.sensor_id) : fputs("null", out);
+	fprintf(out, ",\n\t\t\t\t%u,\n\t\t\t\t%u,\n\t\t\t\t", (unsigned)r.time_since_power_on, (unsigned)r.rtc);
+	hasData ? fprintf(out, "%f", r.temperature) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%f", r.pressure) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%f", r.humidity) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%f", r.gas_resistance) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%u", (unsigned)r.gas_index) : fputs("null", out);
+	fputs(",\n\t\t\t\t1,\n\t\t\t\t", out);
+	(r.present & RAW_DATA_HAS_SCAN_CYCLE) ? fprintf(out, "%u", (unsigned)r.scan_cycle_index) : fputs("null", out);
+	fprintf(out, ",\n\t\t\t\t%u,\n\t\t\t\t%u\n\t\t\t]", (unsigned)r.label, (unsigned)r.code);
+}
+
+/**
+ * @brief : Prints a record as a dataBlock row, bsecDataLogger formatting
+ */
+static void printBsecRow(FILE *out, const raw_data_record &r)
+{
+	bool hasData = r.present & RAW_DATA_HAS_DATA;
+
+	fputs("\t\t\t[\n\t\t\t\t", out);
+	(r.present & RAW_DATA_HAS_NUM) ? fprintf(out, "%d", (int)r.sensor_num) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	(r.present & RAW_DATA_HAS_SENSOR_ID) ? fprintf(out, "%d", (int)(int32_t)r.sensor_id) : fputs("null", out);
+	fprintf(out, ",\n\t\t\t\t%u,\n\t\t\t\t%u,\n\t\t\t\t", (unsigned)r.time_since_power_on, (unsigned)r.rtc);
+	hasData ? fprintf(out, "%g", r.temperature) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%g", r.pressure) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%g", r.humidity) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%g", r.gas_resistance) : fputs("null", out);
+	fputs(",\n\t\t\t\t", out);
+	hasData ? fprintf(out, "%d", (int)r.gas_index) : fputs("null", out);
+	fputs(",\n\t\t\t\t1,\n\t\t\t\t", out);
+	(r.present & RAW_DATA_HAS_SCAN_CYCLE) ? fprintf(out, "%d", (int)(int32_t)r.scan_cycle_index) : fputs("null", out);
+	fprintf(out, ",\n\t\t\t\t%u,\n\t\t\t\t%d\n\t\t\t]", (unsigned)r.label, (int)r.code);
+}
+
+/**
+ * @brief : Copies the JSON text after the header
+ */
+static bool copyText(FILE *in, FILE *out, uint32_t length)
+{
+	char buff[4096];
+
+	while (length)
+	{
+		size_t chunk = (length < sizeof(buff)) ? length : sizeof(buff);
+
+		if (fread(buff, 1, chunk, in) != chunk)
+			return false;
+		fwrite(buff, 1, chunk, out);
+		length -= (uint32_t)chunk;
+	}
+
+	return true;
+}
+
+/**
+ * @brief : Converts one file
+ * @return 0 on success, 1 on a file that cannot be converted
+ */
+static int convert(FILE *in, FILE *out, const char *name)
+{
+	uint8_t buff[UINT8_MAX];
+	raw_data_header header;
+	raw_data_record record;
+	uint32_t rows = 0;
+
+	if ((fread(buff, 1, RAW_DATA_HEADER_SIZE, in) != RAW_DATA_HEADER_SIZE) || !raw_data_decode_header(buff, header) ||
+		(header.kind > RAW_DATA_KIND_BSEC))
+	{
+		fprintf(stderr, "%s: not a raw data log of a known version\n", name);
+		return 1;
+	}
+	if (!copyText(in, out, header.text_len))
+	{
+		fprintf(stderr, "%s: JSON text cut short\n", name);
+		return 1;
+	}
+
+	for (int len; (len = fgetc(in)) != EOF;)
+	{
+		if ((len == 0) || (len == UINT8_MAX))
+		{
+			fprintf(stderr, "%s: warning, file was not closed, %u rows\n", name, rows);
+			break;
+		}
+		if (fread(buff, 1, (size_t)len, in) != (size_t)len)
+		{
+			fprintf(stderr, "%s: warning, last record cut short, dropped after %u rows\n", name, rows);
+			break;
+		}
+		if (!raw_data_decode_record(buff, (uint8_t)len, record))
+		{
+			fprintf(stderr, "%s: corrupt record after %u rows\n", name, rows);
+			return 1;
+		}
+
+		if (rows++)
+			fputs(",\n", out);
+		if (header.kind == RAW_DATA_KIND_BSEC)
+			printBsecRow(out, record);
+		else
+			printBme68xRow(out, record);
+	}
+
+	if (rows == 0)
+		fputs(NO_ROWS_END, out);
+	else
+		fputs((header.kind == RAW_DATA_KIND_BSEC) ? BSEC_ROWS_END : BME68X_ROWS_END, out);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "Usage: %s <file.bmerawbin> [<file.bmerawdata>]\n", argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen(argv[1], "rb");
+	if (in == nullptr)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	FILE *out = (argc == 3) ? fopen(argv[2], "wb") : stdout;
+	if (out == nullptr)
+	{
+		perror(argv[2]);
+		fclose(in);
+		return 1;
+	}
+
+	int ret = convert(in, out, argv[1]);
+
+	fclose(in);
+	if ((out != stdout) && (fclose(out) != 0))
+	{
+		perror(argv[2]);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+#endif /* NODE_TOOL */